@@ -569,7 +569,7 @@ namespace device {
 
 
 		// EDMA interrupt task
-		static void ether_task_() __attribute__ ((interrupt))
+		static INTERRUPT_FUNC void ether_task_()
 		{
 			uint32_t status_ecsr = ETHRC::ECSR();
 			uint32_t status_eesr = EDMAC::EESR();
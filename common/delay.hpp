@@ -60,6 +60,8 @@ namespace utils {
 				for(uint32_t n = 0; n < (F_ICLK / 5333333); ++n) {
 					asm("nop");
 				}
+#elif defined(IO_UTILS_SIM)
+				// ホスト・シミュレーションでは待たない
 #else
 #  error "delay.hpp requires tune dummy operations"
 #endif
@@ -3,7 +3,11 @@
 /*!	@file
 	@brief	ファイル・入出力クラス @n
 			※ fopen 系の機能を提供するクラス。@n
-			※ FATFS が必要
+			※ FATFS が必要 @n
+			※ _USE_FASTSEEK が有効なら、大きなファイルを読み出しで開いた場合、@n
+			最初のシークで、クラスター・リンク・マップ（CLMT）を作り、シークを @n
+			ファイル位置に依らない時間で行う。CLMT は、全ての file_io で共有する @n
+			固定数のスロットに置き、足りなければ、最も古く使われたものを捨てる。
     @author 平松邦仁 (hira@rvf-rc45.net)
 	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
 				Released under the MIT license @n
@@ -14,9 +18,22 @@
 #  error "file_io.hpp requires FAT_FS to be defined and include FATFS module"
 #endif
 
+#include <cstring>
 #include "ff12b/src/diskio.h"
 #include "ff12b/src/ff.h"
 
+#if _USE_FASTSEEK
+#ifndef FILE_IO_CLMT_NUM
+#define FILE_IO_CLMT_NUM	4			///< CLMT スロット数
+#endif
+#ifndef FILE_IO_CLMT_SIZE
+#define FILE_IO_CLMT_SIZE	128			///< CLMT スロットの大きさ（DWORD 数、断片数は (SIZE - 2) / 2）
+#endif
+#ifndef FILE_IO_CLMT_MIN
+#define FILE_IO_CLMT_MIN	(64 * 1024)	///< CLMT を作る最小のファイル・サイズ
+#endif
+#endif
+
 extern "C" {
 	int make_full_path(const char* src, char* dst, uint16_t dsz);
 	void utf8_to_sjis(const char* src, char* dst, uint32_t dsz);
@@ -47,6 +64,71 @@ namespace utils {
 		FIL			fp_;
 		bool		open_;
 
+#if _USE_FASTSEEK
+		struct clmt_t {
+			file_io*	owner;
+			uint32_t	stamp;
+			DWORD		tbl[FILE_IO_CLMT_SIZE];
+		};
+
+		struct clmt_pool_t {
+			clmt_t		slot[FILE_IO_CLMT_NUM];
+			uint32_t	stamp;
+		};
+
+		static clmt_pool_t& clmt_pool_() noexcept {
+			static clmt_pool_t pool;
+			return pool;
+		}
+
+		int8_t		clmt_idx_;	///< 使用中のスロット（-1 なら無し）
+		bool		clmt_try_;	///< CLMT を作る対象
+
+		void clmt_release_() noexcept
+		{
+			if(clmt_idx_ < 0) return;
+			clmt_pool_().slot[clmt_idx_].owner = nullptr;
+			fp_.cltbl = nullptr;
+			clmt_idx_ = -1;
+		}
+
+		void clmt_service_() noexcept
+		{
+			auto& pool = clmt_pool_();
+			if(clmt_idx_ >= 0) {
+				pool.slot[clmt_idx_].stamp = ++pool.stamp;
+				return;
+			}
+			if(!clmt_try_) return;
+			clmt_try_ = false;
+
+			// 作れた場合だけ、スロットを取る（失敗で、他のファイルの CLMT を捨てない）
+			DWORD tbl[FILE_IO_CLMT_SIZE];
+			tbl[0] = FILE_IO_CLMT_SIZE;
+			fp_.cltbl = tbl;
+			auto ret = f_lseek(&fp_, CREATE_LINKMAP);
+			fp_.cltbl = nullptr;
+			if(ret != FR_OK) return;  // 断片が多過ぎる場合など
+
+			int8_t idx = 0;
+			for(int8_t i = 0; i < FILE_IO_CLMT_NUM; ++i) {
+				if(pool.slot[i].owner == nullptr) { idx = i; break; }
+				if(pool.slot[i].stamp < pool.slot[idx].stamp) idx = i;
+			}
+			auto& s = pool.slot[idx];
+			if(s.owner != nullptr) {  // 追い出されたファイルは、次のシークで作り直す
+				auto owner = s.owner;  // clmt_release_ で、s.owner は nullptr になる
+				owner->clmt_release_();
+				owner->clmt_try_ = true;
+			}
+			std::memcpy(s.tbl, tbl, tbl[0] * sizeof(DWORD));
+			fp_.cltbl = s.tbl;
+			s.owner = this;
+			s.stamp = ++pool.stamp;
+			clmt_idx_ = idx;
+		}
+#endif
+
 	public:
 		//-------------------------------------------------------------//
 		/*!
@@ -56,6 +138,9 @@ namespace utils {
 		file_io() noexcept :
 			fp_(),
 			open_(false)
+#if _USE_FASTSEEK
+			, clmt_idx_(-1), clmt_try_(false)
+#endif
 		{ }
 
 
@@ -104,6 +189,9 @@ namespace utils {
 				return false;
 			}
 			open_ = true;
+#if _USE_FASTSEEK
+			clmt_try_ = mdf == (FA_READ | FA_OPEN_EXISTING) && f_size(&fp_) >= FILE_IO_CLMT_MIN;
+#endif
 			return true;
 		}
 
@@ -138,6 +226,10 @@ namespace utils {
 				return false;
 			}
 			open_ = false;
+#if _USE_FASTSEEK
+			clmt_release_();
+			clmt_try_ = false;
+#endif
 			return f_close(&fp_) == FR_OK;
 		}
 
@@ -228,6 +320,9 @@ namespace utils {
 		bool seek(SEEK seek, int32_t ofs) noexcept
 		{
 			if(!open_) return false;
+#if _USE_FASTSEEK
+			clmt_service_();
+#endif
 			FRESULT ret;
 			switch(seek) {
 			case SEEK::SET:
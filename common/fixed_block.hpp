@@ -2,7 +2,7 @@
 //=====================================================================//
 /*!	@file
 	@brief	固定サイズ・ブロック管理・クラス @n
-			※最大３２個までのブロックを管理 @n
+			※利用フラグ、ロック・ビットは、３２ビット単位のビットマップ @n
 			※排他制御用ロック・ビットを含んでいる
     @author 平松邦仁 (hira@rvf-rc45.net)
 	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
@@ -10,6 +10,7 @@
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
 //=====================================================================//
+#include <cstdint>
 
 namespace utils {
 
@@ -17,26 +18,52 @@ namespace utils {
 	/*!
 		@brief  固定サイズ・ブロック管理・クラス
 		@param[in]	UNIT	格納形
-		@param[in]	SIZE	サイズ（最大３２個）
+		@param[in]	SIZE	サイズ
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	template <class UNIT, uint32_t SIZE>
 	class fixed_block {
 
-		volatile uint32_t	flags_;
-		volatile uint32_t	lock_;
+		static_assert(SIZE > 0, "fixed_block SIZE must be 1 or more");
+
+		static const uint32_t WORDS = (SIZE + 31) / 32;
+
+		// 最後のワードの有効ビット
+		static const uint32_t LAST_MASK = (SIZE % 32) == 0 ? 0xffffffff : ((static_cast<uint32_t>(1) << (SIZE % 32)) - 1);
+
+		volatile uint32_t	flags_[WORDS];
+		volatile uint32_t	lock_[WORDS];
 
 		uint32_t	idx_;
 
 		UNIT		unit_[SIZE];
 
+		static uint32_t valid_(uint32_t w) noexcept {
+			return w == (WORDS - 1) ? LAST_MASK : 0xffffffff;
+		}
+
+		// idx 以降で、ビットが立っている位置（無ければ SIZE）
+		template <class MAP>
+		static uint32_t scan_(const MAP& map, uint32_t idx) noexcept
+		{
+			if(idx >= SIZE) return SIZE;
+			uint32_t w = idx / 32;
+			uint32_t m = map(w) & (0xffffffff << (idx % 32));
+			while(m == 0) {
+				++w;
+				if(w >= WORDS) return SIZE;
+				m = map(w);
+			}
+			return w * 32 + __builtin_ctz(m);
+		}
+
 	public:
 		//-----------------------------------------------------------------//
 		/*!
 			@brief  コンストラクタ
 		*/
 		//-----------------------------------------------------------------//
-		fixed_block() noexcept : flags_(0), lock_(-1), idx_(0) { }
+		fixed_block() noexcept : idx_(0) { clear(); }
 
 
 		//-----------------------------------------------------------------//
@@ -54,7 +81,13 @@ namespace utils {
 			@return 空の場合「true」
 		*/
 		//-----------------------------------------------------------------//
-		bool empty() const noexcept { return flags_ == 0; }
+		bool empty() const noexcept
+		{
+			for(uint32_t w = 0; w < WORDS; ++w) {
+				if(flags_[w] != 0) return false;
+			}
+			return true;
+		}
 
 
 		//-----------------------------------------------------------------//
@@ -62,7 +95,13 @@ namespace utils {
 			@brief  全体クリア
 		*/
 		//-----------------------------------------------------------------//
-		void clear() { flags_ = 0; lock_ = -1; }
+		void clear() noexcept
+		{
+			for(uint32_t w = 0; w < WORDS; ++w) {
+				flags_[w] = 0;
+				lock_[w] = 0xffffffff;
+			}
+		}
 
 
 		//-----------------------------------------------------------------//
@@ -74,12 +113,8 @@ namespace utils {
 		uint32_t size() const noexcept
 		{
 			uint32_t n = 0;
-			uint32_t tmp = 1;
-			for(uint32_t i = 0; i < SIZE; ++i) {
-				if(tmp & flags_) {
-					++n;
-				}
-				tmp <<= 1;
+			for(uint32_t w = 0; w < WORDS; ++w) {
+				n += __builtin_popcount(flags_[w]);
 			}
 			return n;
 		}
@@ -87,26 +122,29 @@ namespace utils {
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief  領域を確保して、インデックスを返す
+			@brief  領域を確保して、インデックスを返す @n
+					※前回確保した位置の次から探す（直ぐに再利用しない）
 			@return 空きが無い場合、「SIZE」となる。
 		*/
 		//-----------------------------------------------------------------//
 		uint32_t alloc() noexcept
 		{
-			uint32_t idx = idx_;
-			for(uint32_t i = 0; i < SIZE; ++i) {
-				uint32_t mask = 1 << idx;
-				if(!(mask & flags_)) {
-					lock_  |= mask;  // ロックした状態にする
-					flags_ |= mask;
-					++idx_;
-					if(idx_ >= SIZE) idx_ = 0;
-					return idx;
-				}
-				++idx;
-				if(idx >= SIZE) idx = 0;
+			uint32_t w = idx_ / 32;
+			uint32_t m = ~flags_[w] & valid_(w) & (0xffffffff << (idx_ % 32));
+			for(uint32_t i = 0; i <= WORDS && m == 0; ++i) {
+				++w;
+				if(w >= WORDS) w = 0;
+				m = ~flags_[w] & valid_(w);
 			}
-			return SIZE;
+			if(m == 0) return SIZE;
+
+			uint32_t idx = w * 32 + __builtin_ctz(m);
+			uint32_t mask = 1 << (idx % 32);
+			lock_[w]  |= mask;  // ロックした状態にする
+			flags_[w] |= mask;
+			idx_ = idx + 1;
+			if(idx_ >= SIZE) idx_ = 0;
+			return idx;
 		}
 
 
@@ -122,7 +160,7 @@ namespace utils {
 			if(idx >= SIZE) {
 				return false;
 			}
-			return (flags_ & (1 << idx)) != 0;
+			return (flags_[idx / 32] & (1 << (idx % 32))) != 0;
 		}
 
 
@@ -139,7 +177,7 @@ namespace utils {
 				return false;
 			}
 			if(!is_alloc(idx)) return false; 
-			return (lock_ & (1 << idx)) != 0;
+			return (lock_[idx / 32] & (1 << (idx % 32))) != 0;
 		}
 
 
@@ -157,9 +195,9 @@ namespace utils {
 			}
 			if(!is_alloc(idx)) return false; 
 			if(lock) {
-				lock_ |=  (1 << idx);
+				lock_[idx / 32] |=  (1 << (idx % 32));
 			} else {
-				lock_ &= ~(1 << idx);
+				lock_[idx / 32] &= ~(1 << (idx % 32));
 			}
 			return true;
 		}
@@ -188,15 +226,34 @@ namespace utils {
 			if(idx >= SIZE) {
 				return false;
 			}
-			uint32_t f = 1 << idx;
-			if(flags_ & f) {
-				flags_ &= ~f;
+			uint32_t f = 1 << (idx % 32);
+			if(flags_[idx / 32] & f) {
+				flags_[idx / 32] &= ~f;
 				return true;
 			}
 			return false;
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  利用中の領域を探す @n
+					for(auto i = b.next(0); i < b.capacity(); i = b.next(i + 1)) { ... }
+			@param[in]	idx		検索開始位置
+			@param[in]	active	ロックされていない領域だけなら「true」
+			@return 見つからない場合、「SIZE」となる。
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t next(uint32_t idx, bool active = false) const noexcept
+		{
+			if(active) {
+				return scan_([this](uint32_t w) { return flags_[w] & ~lock_[w]; }, idx);
+			} else {
+				return scan_([this](uint32_t w) { return flags_[w]; }, idx);
+			}
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief  ユニットの参照
@@ -1,7 +1,18 @@
 #pragma once
 //=====================================================================//
 /*!	@file
-	@brief	Fixed FIFO (first in first out) テンプレート
+	@brief	Fixed FIFO (first in first out) テンプレート @n
+			put 側（put_at, put_go, put, put_span）を一つのタスク（又は割り込み）、@n
+			get 側（get_at, get_go, get, get_span）を一つのタスク（又は割り込み）@n
+			から呼ぶ場合（single-producer/single-consumer）、割り込み禁止は不要。@n
+			データを書き終えてから、インデックスを更新するので、相手側は @n
+			常に完成したデータだけを参照する。@n
+			SIZE が２のＮ乗の場合、インデックスを３２ビットのフリーランとし、@n
+			マスクで位置を求める（SIZE 個全てを格納出来る）。@n
+			それ以外の場合は、比較でラップする（格納出来るのは SIZE - 1 個）。@n
+			満杯の時の put は、値を捨てる（インデックスは進めない）。@n
+			満杯の時の put_at は、データと重ならない領域を返す（２のＮ乗の場合は @n
+			予備の一要素、それ以外は空きスロット）ので、書き込んでも壊れない。
     @author 平松邦仁 (hira@rvf-rc45.net)
 	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
 				Released under the MIT license @n
@@ -9,6 +20,7 @@
 */
 //=====================================================================//
 #include <cstdint>
+#include <algorithm>
 
 namespace utils {
 
@@ -16,18 +28,49 @@ namespace utils {
     /*!
         @brief  fifo クラス
 		@param[in]	UNIT	基本形
-		@param[in]	SIZE	バッファサイズ（最大６５５３６）
+		@param[in]	SIZE	バッファサイズ
     */
     //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	template <class UNIT, uint32_t SIZE>
 	class fixed_fifo {
 
-		volatile uint16_t	get_;
-		volatile uint16_t	put_;
+		static_assert(SIZE >= 2, "fixed_fifo SIZE must be 2 or more");
 
-		UNIT	buff_[SIZE];
+		static const bool pow2_ = (SIZE & (SIZE - 1)) == 0;
+
+		volatile uint32_t	get_;
+		volatile uint32_t	put_;
+
+		// ２のＮ乗の場合、最後の一要素は、満杯の時の put_at 用
+		UNIT	buff_[pow2_ ? (SIZE + 1) : SIZE];
+
+		// データの読み書きを、インデックス更新の前に完了させる（コンパイラ・バリア）
+		static inline void barrier_() noexcept { asm volatile ("" : : : "memory"); }
+
+		static inline uint32_t pos_(uint32_t idx) noexcept {
+			return pow2_ ? (idx & (SIZE - 1)) : idx;
+		}
+
+		static inline uint32_t next_(uint32_t idx, uint32_t n) noexcept {
+			idx += n;
+			if(!pow2_ && idx >= SIZE) {
+				idx -= SIZE;
+			}
+			return idx;
+		}
 
 	public:
+        //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+        /*!
+            @brief  連続領域
+        */
+        //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct span_t {
+			UNIT*		org;	///< 先頭
+			uint32_t	len;	///< 要素数
+		};
+
+
         //-----------------------------------------------------------------//
         /*!
             @brief  コンストラクター
@@ -52,8 +95,22 @@ namespace utils {
         */
         //-----------------------------------------------------------------//
 		uint32_t length() const noexcept {
-			if(put_ >= get_) return (put_ - get_);
-			else return (SIZE + put_ - get_);
+			uint32_t put = put_;
+			uint32_t get = get_;
+			if(pow2_) return put - get;
+			if(put >= get) return (put - get);
+			else return (SIZE + put - get);
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  空きを返す
+			@return	空き
+        */
+        //-----------------------------------------------------------------//
+		uint32_t space() const noexcept {
+			return (pow2_ ? SIZE : (SIZE - 1)) - length();
 		}
 
 
@@ -67,24 +124,27 @@ namespace utils {
 
         //-----------------------------------------------------------------//
         /*!
-            @brief  値の格納参照を得る
+            @brief  値の格納参照を得る @n
+					満杯の時は、捨てる為の領域を返す（続く put_go は何もしない）
 			@return 値の格納参照
         */
         //-----------------------------------------------------------------//
-		inline UNIT& put_at() noexcept { return buff_[put_]; }
+		inline UNIT& put_at() noexcept {
+			if(pow2_ && space() == 0) return buff_[SIZE];
+			return buff_[pos_(put_)];
+		}
 
 
         //-----------------------------------------------------------------//
         /*!
-            @brief  値の格納ポイントの移動
+            @brief  値の格納ポイントの移動（空きを超える分は捨てる）
+			@param[in]	n	移動数
         */
         //-----------------------------------------------------------------//
-		inline void put_go() noexcept {
-			volatile uint16_t put = put_;
-			++put;
-			if(put >= SIZE) {
-				put = 0;
-			}
+		inline void put_go(uint32_t n = 1) noexcept {
+			n = std::min(n, space());
+			uint32_t put = next_(put_, n);
+			barrier_();
 			put_ = put;
 		}
 
@@ -93,11 +153,53 @@ namespace utils {
         /*!
             @brief  値の格納
 			@param[in]	v	値
+			@return 満杯で格納出来ない場合「false」（値は捨てる）
         */
         //-----------------------------------------------------------------//
-		void put(const UNIT& v) noexcept {
-			buff_[put_] = v;
+		bool put(const UNIT& v) noexcept {
+			if(space() == 0) return false;
+			buff_[pos_(put_)] = v;
 			put_go();
+			return true;
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  格納可能な連続領域を得る（ラップする場合は２つ）@n
+					書き込んだ後、put_go(n) で確定する
+			@param[out]	a	前半の領域
+			@param[out]	b	後半の領域（ラップしない場合 len = 0）
+			@return 格納可能な総数
+        */
+        //-----------------------------------------------------------------//
+		uint32_t put_span(span_t& a, span_t& b) noexcept {
+			uint32_t n = space();
+			uint32_t pos = pos_(put_);
+			a.org = &buff_[pos];
+			a.len = std::min(n, SIZE - pos);
+			b.org = &buff_[0];
+			b.len = n - a.len;
+			return n;
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  値の一括格納（空きが足りない場合は、入る分だけ）
+			@param[in]	src	転送元
+			@param[in]	n	個数
+			@return 格納した個数
+        */
+        //-----------------------------------------------------------------//
+		uint32_t put(const UNIT* src, uint32_t n) noexcept {
+			span_t a, b;
+			n = std::min(n, put_span(a, b));
+			uint32_t l = std::min(n, a.len);
+			std::copy(src, src + l, a.org);
+			std::copy(src + l, src + n, b.org);
+			put_go(n);
+			return n;
 		}
 
 
@@ -107,20 +209,19 @@ namespace utils {
 			@return	値の取得参照
         */
         //-----------------------------------------------------------------//
-		const UNIT& get_at() const noexcept { return buff_[get_]; }
+		const UNIT& get_at() const noexcept { return buff_[pos_(get_)]; }
 
 
         //-----------------------------------------------------------------//
         /*!
-            @brief  値の取得
+            @brief  値の取得ポイントの移動（格納数を超えては進まない）
+			@param[in]	n	移動数
         */
         //-----------------------------------------------------------------//
-		inline void get_go() noexcept {
-			volatile uint16_t get = get_;
-			++get;
-			if(get >= SIZE) {
-				get = 0;
-			}
+		inline void get_go(uint32_t n = 1) noexcept {
+			n = std::min(n, length());
+			uint32_t get = next_(get_, n);
+			barrier_();
 			get_ = get;
 		}
 
@@ -132,19 +233,58 @@ namespace utils {
         */
         //-----------------------------------------------------------------//
 		UNIT get() noexcept {
-			UNIT v = buff_[get_];
+			UNIT v = buff_[pos_(get_)];
 			get_go();
 			return v;
 		}
 
 
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  取得可能な連続領域を得る（ラップする場合は２つ）@n
+					読み出した後、get_go(n) で確定する
+			@param[out]	a	前半の領域
+			@param[out]	b	後半の領域（ラップしない場合 len = 0）
+			@return 取得可能な総数
+        */
+        //-----------------------------------------------------------------//
+		uint32_t get_span(span_t& a, span_t& b) noexcept {
+			uint32_t n = length();
+			uint32_t pos = pos_(get_);
+			a.org = &buff_[pos];
+			a.len = std::min(n, SIZE - pos);
+			b.org = &buff_[0];
+			b.len = n - a.len;
+			return n;
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  値の一括取得（足りない場合は、ある分だけ）
+			@param[out]	dst	転送先
+			@param[in]	n	個数
+			@return 取得した個数
+        */
+        //-----------------------------------------------------------------//
+		uint32_t get(UNIT* dst, uint32_t n) noexcept {
+			span_t a, b;
+			n = std::min(n, get_span(a, b));
+			uint32_t l = std::min(n, a.len);
+			std::copy(a.org, a.org + l, dst);
+			std::copy(b.org, b.org + (n - l), dst + l);
+			get_go(n);
+			return n;
+		}
+
+
         //-----------------------------------------------------------------//
         /*!
             @brief  get 位置を返す
 			@return	位置
         */
         //-----------------------------------------------------------------//
-		uint16_t pos_get() const noexcept { return get_; }
+		uint32_t pos_get() const noexcept { return pos_(get_); }
 
 
         //-----------------------------------------------------------------//
@@ -153,6 +293,6 @@ namespace utils {
 			@return	位置
         */
         //-----------------------------------------------------------------//
-		uint16_t pos_put() const noexcept { return put_; }
+		uint32_t pos_put() const noexcept { return pos_(put_); }
 	};
 }
@@ -1,13 +1,20 @@
 #pragma once
 //=====================================================================//
 /*!	@file
-	@brief	固定サイズ・メモリー・クラス
+	@brief	固定サイズ・メモリー・クラス @n
+			静的領域を、２のＮ乗サイズのブロックで管理する（バディ方式）@n
+			・空きリストは、サイズ・クラス毎の双方向リスト（ブロック内に格納）@n
+			・空きのあるクラスは、ビットマップで管理し、ビット検索で求める @n
+			・alloc/free は、クラス数（log2(DNUM) + 1）以内の固定ステップで終わる @n
+			・LOCK に intr_lock を指定すると、割り込みと共有出来る
     @author 平松邦仁 (hira@rvf-rc45.net)
 	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
 //=====================================================================//
+#include <cstdint>
+#include "common/intr_utils.hpp"
 
 namespace utils {
 
@@ -15,28 +22,129 @@ namespace utils {
 	/*!
 		@brief  固定サイズ・メモリー・クラス
 		@param[in]	SIZE	格納サイズ（バイト）
-		@param[in]	DNUM	分割最大数
+		@param[in]	DNUM	分割最大数（２のＮ乗、最小ブロックは SIZE / DNUM）
+		@param[in]	LOCK	排他制御（スコープ・ロック）
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	template <uint32_t SIZE, uint32_t DNUM>
+	template <uint32_t SIZE, uint32_t DNUM, class LOCK = null_lock>
 	class fixed_memory {
 
-		uint8_t	buff_[SIZE];
+		static constexpr uint32_t log2_(uint32_t n) {
+			uint32_t l = 0;
+			while(n > 1) { n >>= 1; ++l; }
+			return l;
+		}
+
+		static const uint32_t UNIT = SIZE / DNUM;		///< 最小ブロック・サイズ
+		static const uint32_t LEVEL = log2_(DNUM) + 1;	///< サイズ・クラス数
+
+		static_assert(DNUM >= 1 && DNUM <= 0x8000 && (DNUM & (DNUM - 1)) == 0,
+			"fixed_memory DNUM must be power of two (max 32768)");
+		static_assert((SIZE % DNUM) == 0 && UNIT >= 8 && (UNIT & (UNIT - 1)) == 0,
+			"fixed_memory SIZE / DNUM must be power of two (8 or more)");
+
+		static const uint16_t NIL = 0xffff;
+		static const uint8_t FREE = 0x80;	///< order_ の空きフラグ
+		static const uint8_t NONE = 0xff;	///< ブロック先頭ではない
 
-		struct head {
-			uint16_t	pos_;
-			uint16_t	size_;
+		// 空きブロックに格納するリンク
+		struct link_t {
+			uint16_t	next_;
+			uint16_t	prev_;
 		};
 
-		head	head_[DNUM];
+		alignas(8) uint8_t	buff_[SIZE];
+
+		uint8_t		order_[DNUM];	///< ブロック先頭のクラス（空きなら FREE 付き）
+		uint16_t	list_[LEVEL];	///< クラス毎の空きリスト
+		uint32_t	avail_;			///< 空きのあるクラスのビットマップ
+
+		uint32_t	used_;
+		uint32_t	peak_;
+		uint32_t	count_;
+		uint32_t	fail_;
+
+		link_t& link_(uint16_t idx) noexcept {
+			return *reinterpret_cast<link_t*>(&buff_[idx * UNIT]);
+		}
+
+		void push_(uint16_t idx, uint32_t k) noexcept {
+			auto& l = link_(idx);
+			l.next_ = list_[k];
+			l.prev_ = NIL;
+			if(list_[k] != NIL) link_(list_[k]).prev_ = idx;
+			list_[k] = idx;
+			order_[idx] = k | FREE;
+			avail_ |= 1 << k;
+		}
+
+		void remove_(uint16_t idx, uint32_t k) noexcept {
+			const auto& l = link_(idx);
+			if(l.prev_ != NIL) link_(l.prev_).next_ = l.next_;
+			else list_[k] = l.next_;
+			if(l.next_ != NIL) link_(l.next_).prev_ = l.prev_;
+			if(list_[k] == NIL) avail_ &= ~(1 << k);
+		}
+
+		// サイズに合うクラス（最小ブロックの 2^k 倍）
+		static uint32_t order_of_(uint32_t size) noexcept {
+			uint32_t n = (size + UNIT - 1) / UNIT;
+			if(n <= 1) return 0;
+			return 32 - __builtin_clz(n - 1);
+		}
 
 	public:
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief  統計情報
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct stat_t {
+			uint32_t	used;		///< 使用中（バイト）
+			uint32_t	peak;		///< 使用中の最大値（ハイ・ウォーター・マーク）
+			uint32_t	free;		///< 空き（バイト）
+			uint32_t	largest;	///< 確保可能な最大サイズ
+			uint32_t	count;		///< 確保中のブロック数
+			uint32_t	fail;		///< 確保に失敗した回数
+
+			//-------------------------------------------------------------//
+			/*!
+				@brief  断片化率を返す（空きの内、最大ブロック以外の割合）
+				@return 断片化率（％）
+			*/
+			//-------------------------------------------------------------//
+			uint32_t fragmentation() const noexcept {
+				if(free == 0) return 0;
+				return 100 - (largest * 100 / free);
+			}
+		};
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief  コンストラクタ
 		*/
 		//-----------------------------------------------------------------//
-		fixed_memory() noexcept { }
+		fixed_memory() noexcept { clear(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  全て開放する
+		*/
+		//-----------------------------------------------------------------//
+		void clear() noexcept
+		{
+			LOCK lock;
+			for(uint32_t i = 0; i < DNUM; ++i) order_[i] = NONE;
+			for(uint32_t i = 0; i < LEVEL; ++i) list_[i] = NIL;
+			avail_ = 0;
+			push_(0, LEVEL - 1);
+			used_ = 0;
+			peak_ = 0;
+			count_ = 0;
+			fail_ = 0;
+		}
 
 
 		//-----------------------------------------------------------------//
@@ -48,30 +156,130 @@ namespace utils {
 		uint32_t capacity() const noexcept { return SIZE; }
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  最小ブロック・サイズを返す
+			@return 最小ブロック・サイズ
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t unit_size() const noexcept { return UNIT; }
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief  メモリー・アロケーション
 			@param[in]	size	アロケーション・サイズ
-			@return メモリー・ポインター
+			@return メモリー・ポインター（確保出来ない場合「nullptr」）
+		*/
+		//-----------------------------------------------------------------//
+		void* alloc(uint32_t size) noexcept
+		{
+			LOCK lock;
+			// 丸めで溢れる大きさは、order_of_ の前に除く
+			if(size == 0 || size > SIZE) {
+				++fail_;
+				return nullptr;
+			}
+			uint32_t k = order_of_(size);
+			uint32_t m = k < LEVEL ? (avail_ & ~((1 << k) - 1)) : 0;
+			if(m == 0) {
+				++fail_;
+				return nullptr;
+			}
+			uint32_t j = __builtin_ctz(m);
+			uint16_t idx = list_[j];
+			remove_(idx, j);
+			while(j > k) {  // 余りを分割して、下のクラスに戻す
+				--j;
+				push_(idx + (1 << j), j);
+			}
+			order_[idx] = k;
+			used_ += UNIT << k;
+			if(peak_ < used_) peak_ = used_;
+			++count_;
+			return &buff_[idx * UNIT];
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  メモリーの開放
+			@param[in]	ptr	alloc で得たポインター
+			@return 不正なポインター（範囲外、二重開放）の場合「false」
 		*/
 		//-----------------------------------------------------------------//
-		void* alloc(uint16_t size)
+		bool free(void* ptr) noexcept
 		{
-			uint8_t* ptr = nullptr;
+			if(ptr == nullptr) return true;
+			uint32_t ofs = static_cast<uint8_t*>(ptr) - buff_;
+			if(static_cast<uint8_t*>(ptr) < buff_ || ofs >= SIZE || (ofs % UNIT) != 0) {
+				return false;
+			}
 
-			return ptr;
+			LOCK lock;
+			uint16_t idx = ofs / UNIT;
+			uint32_t k = order_[idx];
+			if(k & FREE) return false;  // 開放済み、又は、ブロック先頭ではない
+			used_ -= UNIT << k;
+			--count_;
+			while(k < (LEVEL - 1)) {  // 空いているバディと結合
+				uint16_t buddy = idx ^ (1 << k);
+				if(order_[buddy] != (k | FREE)) break;
+				remove_(buddy, k);
+				order_[buddy] = NONE;
+				order_[idx] = NONE;
+				idx &= ~(1 << k);
+				++k;
+			}
+			push_(idx, k);
+			return true;
 		}
 
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief  最大サイズを返す
-			@return 最大サイズ
+			@brief  確保したブロックのサイズを返す
+			@param[in]	ptr	alloc で得たポインター
+			@return ブロック・サイズ（不正なポインターの場合「０」）
 		*/
 		//-----------------------------------------------------------------//
-		void free(void* ptr)
+		uint32_t block_size(const void* ptr) const noexcept
 		{
+			uint32_t ofs = static_cast<const uint8_t*>(ptr) - buff_;
+			if(static_cast<const uint8_t*>(ptr) < buff_ || ofs >= SIZE || (ofs % UNIT) != 0) {
+				return 0;
+			}
+			uint32_t k = order_[ofs / UNIT];
+			if(k & FREE) return 0;
+			return UNIT << k;
+		}
 
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  統計情報を取得
+			@return 統計情報
+		*/
+		//-----------------------------------------------------------------//
+		stat_t get_stat() const noexcept
+		{
+			LOCK lock;
+			stat_t t;
+			t.used = used_;
+			t.peak = peak_;
+			t.free = SIZE - used_;
+			t.largest = avail_ != 0 ? (UNIT << (31 - __builtin_clz(avail_))) : 0;
+			t.count = count_;
+			t.fail = fail_;
+			return t;
 		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  ハイ・ウォーター・マークをリセット
+		*/
+		//-----------------------------------------------------------------//
+		void reset_peak() noexcept { LOCK lock; peak_ = used_; }
 	};
 }
@@ -1,83 +1,349 @@
 #pragma once
 //=====================================================================//
 /*!	@file
-	@brief	Flash memory マネージャー
+	@brief	Flash memory マネージャー @n
+			データ・フラッシュを、ログ構造のキー（ID）／値ストアとして使う。@n
+			・起動時（start）に全レコードを走査し、RAM にインデックスを作る @n
+			・書き込みは、アクティブ・セクターの後ろにレコードを追記する @n
+			・空きが無くなると、一番古いセクターの有効レコードを移して消去 @n
+			  （ガベージ・コレクション）、空きは消去回数の少ないセクターから使う @n
+			・レコードは CRC で検証し、電源断で途中まで書かれたものは無視する
     @author 平松邦仁 (hira@rvf-rc45.net)
 	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
 //=====================================================================//
-#include "common/renesas.hpp"
+#include <cstdint>
+#include <cstring>
 
 namespace utils {
 
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	/*!
 		@brief  flash_man class @n
-				データ列の構造：@n
+				セクターの構造：@n
+				+0: MAGIC (2 bytes) @n
+				+2: ER (2 bytes) 消去回数 @n
+				+4: SEQ (4 bytes) 通し番号（数値が一番大きいものが最新）@n
+				+8: レコード... @n
+				レコードの構造（４バイト境界）：@n
 				+0: ID (2 bytes) @n
-				+2: TM (2 bytes) タイムスタンプ（数値が一番大きいものが最新）@n
-				+4: SZ (2 bytes) サイズ
-		@param[in]	FIO		フラッシュ I/O
-		@param[in]	OMAX	オープン最大
+				+2: SZ (2 bytes) サイズ（B15:1 削除レコード）@n
+				+4: CRC (2 bytes) ID、SZ、データの CRC16 @n
+				+6: 0x0000 (2 bytes) @n
+				+8: データ（４バイト境界まで 0xFF）
+		@param[in]	FIO		フラッシュ I/O（data_flash_block、data_flash_size、@n
+							erase_check、erase、read、write）
+		@param[in]	SECTOR	セクター・サイズ（data_flash_block の整数倍）
+		@param[in]	KMAX	インデックス最大数（ID の種類）
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	template <class FIO, uint32_t OMAX = 4>
+	template <class FIO, uint32_t SECTOR = 1024, uint32_t KMAX = 64>
 	class flash_man {
 
-		FIO&	fio_;
+		static const uint32_t SNUM = FIO::data_flash_size / SECTOR;	///< セクター数
 
-		// 制限：　１ファイル、最大３２Ｋバイトまで
-		struct head_t {
-			uint16_t	id;		///< file ID
-			uint16_t	nx_sz;	///< (B15:1)next block, (B15:0)total size
+		static_assert((SECTOR % FIO::data_flash_block) == 0, "flash_man SECTOR must be multiple of data_flash_block");
+		static_assert(SECTOR <= 32768, "flash_man SECTOR must be 32K or less");
+		static_assert(SNUM >= 2, "flash_man needs 2 or more sectors");
+
+		static const uint16_t MAGIC = 0x4D46;		///< 'F', 'M'
+		static const uint16_t DELETE = 0x8000;		///< 削除レコード
+
+		struct sect_head_t {
+			uint16_t	magic;
+			uint16_t	erase;
+			uint32_t	seq;
+		};
+
+		struct rec_head_t {
+			uint16_t	id;
+			uint16_t	sz;
+			uint16_t	crc;
+			uint16_t	zero;
+		};
+
+		enum class state : uint8_t {
+			FREE,	///< 消去済み
+			VALID,	///< 使用中
+			DIRTY,	///< 消去が必要
+		};
+
+		struct sector_t {
+			uint32_t	seq;
+			uint16_t	erase;
+			uint16_t	used;	///< 追記位置
+			uint16_t	live;	///< 有効レコードのバイト数
+			state		st;
 		};
 
+		struct index_t {
+			uint16_t	id;
+			uint16_t	sz;
+			uint32_t	org;	///< レコードの位置
+		};
+
+		FIO&		fio_;
+
+		sector_t	sector_[SNUM];
+		index_t		index_[KMAX];
+		uint32_t	inum_;
+		uint32_t	active_;
+		uint32_t	seq_;
+		uint32_t	gc_count_;
+
+		static uint32_t align_(uint32_t sz) { return (sz + 3) & ~3; }
+
+		static uint32_t rec_size_(uint32_t sz) { return sizeof(rec_head_t) + align_(sz & ~DELETE); }
+
+		static uint16_t crc16_(uint16_t crc, const void* src, uint32_t len)
+		{
+			static const uint16_t tbl[16] = {
+				0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+				0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+			};
+			const uint8_t* p = static_cast<const uint8_t*>(src);
+			for(uint32_t i = 0; i < len; ++i) {
+				crc = (crc << 4) ^ tbl[(crc >> 12) ^ (p[i] >> 4)];
+				crc = (crc << 4) ^ tbl[(crc >> 12) ^ (p[i] & 15)];
+			}
+			return crc;
+		}
+
+		static uint16_t head_crc_(uint16_t id, uint16_t sz)
+		{
+			uint16_t t[2] = { id, sz };
+			return crc16_(0xFFFF, t, sizeof(t));
+		}
 
-		uint32_t free_()
+		// インデックスの検索（ID 順、二分探索）
+		uint32_t find_(uint16_t id) const
 		{
-			uint32_t pos = 0;
-			while(pos < FIO::data_flash_size) {
-				if(fio_.erase_check(pos)) {
-					return pos;
+			uint32_t l = 0;
+			uint32_t h = inum_;
+			while(l < h) {
+				uint32_t m = (l + h) / 2;
+				if(index_[m].id < id) l = m + 1;
+				else h = m;
+			}
+			return l;
+		}
+
+		// インデックスの更新（削除レコードなら取り除く）
+		bool update_(uint16_t id, uint16_t sz, uint32_t org)
+		{
+			uint32_t i = find_(id);
+			bool match = i < inum_ && index_[i].id == id;
+			if(match) {
+				sector_[index_[i].org / SECTOR].live -= rec_size_(index_[i].sz);
+			}
+			if(sz & DELETE) {
+				if(match) {
+					--inum_;
+					for(uint32_t j = i; j < inum_; ++j) index_[j] = index_[j + 1];
 				}
-				pos += FIO::data_flash_block;
+				return true;
 			}
-			return FIO::data_flash_size;
+			if(!match) {
+				if(inum_ >= KMAX) return false;
+				for(uint32_t j = inum_; j > i; --j) index_[j] = index_[j - 1];
+				++inum_;
+				index_[i].id = id;
+			}
+			index_[i].sz = sz;
+			index_[i].org = org;
+			sector_[org / SECTOR].live += rec_size_(sz);
+			return true;
 		}
 
+		bool blank_(uint32_t sec)
+		{
+			for(uint32_t ofs = 0; ofs < SECTOR; ofs += FIO::data_flash_block) {
+				if(!fio_.erase_check(sec * SECTOR + ofs, FIO::data_flash_block)) return false;
+			}
+			return true;
+		}
 
-		uint32_t scan_(uint16_t id) const
+		bool erase_sector_(uint32_t sec)
 		{
-			uint32_t pos = 0;
-			uint32_t match = FIO::data_flash_size;
-			while(pos < FIO::data_flash_size) {
-				uint32_t d = FIO::data_flash_block;
-				if(!fio_.erase_check(pos)) {
-					head_t h;
-					fio_.read(pos, &h, sizeof(head_t));
-					if(h.id == id) {
-						match = pos;
-						uint16_t s = h.size;
-						d = s / (FIO::data_flash_block - sizeof(head_t));
-						if(d == 0) ++d;
-						d *= FIO::data_flash_block;
+			auto& s = sector_[sec];
+			uint32_t org = sec * SECTOR;
+			// ヘッダーのあるブロックを最初に消去する（途中で電源断でも、未使用とならない）
+			for(uint32_t ofs = 0; ofs < SECTOR; ofs += FIO::data_flash_block) {
+				if(!fio_.erase_check(org + ofs, FIO::data_flash_block)) {
+					if(!fio_.erase(org + ofs)) {
+						s.st = state::DIRTY;
+						return false;
 					}
 				}
-				pos += d;
 			}
-			return match;
+			++s.erase;
+			s.st = state::FREE;
+			s.used = 0;
+			s.live = 0;
+			return true;
+		}
+
+		// 消去回数の一番少ない空きセクターを開く
+		bool open_(bool reserve)
+		{
+			uint32_t sec = SNUM;
+			uint32_t nfree = 0;
+			for(uint32_t i = 0; i < SNUM; ++i) {
+				if(sector_[i].st == state::DIRTY) erase_sector_(i);
+				if(sector_[i].st != state::FREE) continue;
+				++nfree;
+				if(sec >= SNUM || sector_[i].erase < sector_[sec].erase) sec = i;
+			}
+			// ガベージ・コレクション用に、１セクターを残す
+			if(sec >= SNUM || (!reserve && nfree <= 1)) return false;
+
+			auto& s = sector_[sec];
+			sect_head_t h;
+			h.magic = MAGIC;
+			h.erase = s.erase;
+			h.seq = ++seq_;
+			if(!fio_.write(sec * SECTOR, &h, sizeof(h))) {
+				s.st = state::DIRTY;
+				return false;
+			}
+			s.seq = h.seq;
+			s.used = sizeof(h);
+			s.live = 0;
+			s.st = state::VALID;
+			active_ = sec;
+			return true;
+		}
+
+		// アクティブ・セクターに追記
+		bool append_(uint16_t id, uint16_t sz, const void* src)
+		{
+			auto& s = sector_[active_];
+			uint32_t org = active_ * SECTOR + s.used;
+			uint32_t len = sz & ~DELETE;
+			rec_head_t h;
+			h.id = id;
+			h.sz = sz;
+			h.crc = crc16_(head_crc_(id, sz), src, len);
+			h.zero = 0;
+			s.used += rec_size_(sz);
+			if(!fio_.write(org, &h, sizeof(h))) return false;
+			uint32_t body = len & ~3;
+			if(body > 0 && !fio_.write(org + sizeof(h), src, body)) return false;
+			if(len > body) {
+				uint8_t tmp[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+				std::memcpy(tmp, static_cast<const uint8_t*>(src) + body, len - body);
+				if(!fio_.write(org + sizeof(h) + body, tmp, 4)) return false;
+			}
+			return update_(id, sz, org);
+		}
+
+		// 一番古いセクターの有効レコードを移して、セクターを空ける @n
+		// ※古い順に回収するので、削除レコードより古い実体は先に消えている
+		bool gc_()
+		{
+			uint32_t sec = SNUM;
+			for(uint32_t i = 0; i < SNUM; ++i) {
+				const auto& s = sector_[i];
+				if(s.st != state::VALID || i == active_) continue;
+				if(sec >= SNUM || s.seq < sector_[sec].seq) sec = i;
+			}
+			if(sec >= SNUM) return false;
+
+			if(!open_(true)) return false;
+			++gc_count_;
+			for(uint32_t i = 0; i < inum_; ++i) {
+				auto t = index_[i];
+				if((t.org / SECTOR) != sec) continue;
+				// レコードは位置に依存しないので、そのまま複写する
+				auto& d = sector_[active_];
+				uint32_t org = active_ * SECTOR + d.used;
+				uint32_t len = rec_size_(t.sz);
+				d.used += len;
+				for(uint32_t ofs = 0; ofs < len; ofs += 32) {
+					uint32_t tmp[8];
+					uint32_t l = len - ofs;
+					if(l > sizeof(tmp)) l = sizeof(tmp);
+					if(!fio_.read(t.org + ofs, tmp, l)) return false;
+					if(!fio_.write(org + ofs, tmp, l)) return false;
+				}
+				update_(t.id, t.sz, org);
+			}
+			return erase_sector_(sec);
+		}
+
+
+		// 追記出来る様に、セクターを用意する
+		bool reserve_(uint32_t need)
+		{
+			// 古いセクターに有効レコードしか無い場合、空くまで複数回の回収が必要
+			uint32_t n = 0;
+			while((sector_[active_].used + need) > SECTOR) {
+				if(n > SNUM) return false;
+				if(!open_(false) && !gc_()) return false;
+				++n;
+			}
+			return true;
 		}
 
 
+		// セクターのレコードを走査して、インデックスに登録
+		void scan_(uint32_t sec)
+		{
+			auto& s = sector_[sec];
+			uint32_t org = sec * SECTOR;
+			uint32_t pos = sizeof(sect_head_t);
+			while((pos + sizeof(rec_head_t)) <= SECTOR) {
+				rec_head_t h;
+				fio_.read(org + pos, &h, sizeof(h));
+				if(h.id == 0xFFFF && h.sz == 0xFFFF) break;  // 未使用
+				uint32_t len = h.sz & ~DELETE;
+				if((pos + rec_size_(h.sz)) > SECTOR) {  // 壊れたヘッダー
+					pos = SECTOR;
+					break;
+				}
+				uint16_t crc = head_crc_(h.id, h.sz);
+				uint32_t ofs = 0;
+				while(ofs < len) {
+					uint8_t tmp[32];
+					uint32_t l = len - ofs;
+					if(l > sizeof(tmp)) l = sizeof(tmp);
+					fio_.read(org + pos + sizeof(h) + ofs, tmp, l);
+					crc = crc16_(crc, tmp, l);
+					ofs += l;
+				}
+				if(h.zero == 0 && crc == h.crc) {
+					update_(h.id, h.sz, org + pos);
+				}
+				pos += rec_size_(h.sz);
+			}
+			s.used = pos;
+		}
+
 	public:
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief  統計情報
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct stat_t {
+			uint32_t	keys;		///< 登録数
+			uint32_t	live;		///< 有効レコードのバイト数
+			uint32_t	free;		///< 書き込み可能なバイト数
+			uint32_t	erase_min;	///< 消去回数の最小
+			uint32_t	erase_max;	///< 消去回数の最大
+			uint32_t	gc;			///< ガベージ・コレクションの回数
+		};
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief  コンストラクタ
+			@param[in]	fio	フラッシュ I/O
 		*/
 		//-----------------------------------------------------------------//
-		flash_man(FIO& fio) : fio_(fio) { }
+		flash_man(FIO& fio) : fio_(fio), inum_(0), active_(SNUM), seq_(0), gc_count_(0) { }
 
 
 		//-----------------------------------------------------------------//
@@ -89,6 +355,74 @@ namespace utils {
 		FIO& at_fio() { return fio_; }
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  開始（全セクターを走査して、インデックスを作る）
+			@return エラーなら「false」
+		*/
+		//-----------------------------------------------------------------//
+		bool start()
+		{
+			inum_ = 0;
+			active_ = SNUM;
+			seq_ = 0;
+			uint32_t order[SNUM];
+			uint32_t n = 0;
+			for(uint32_t i = 0; i < SNUM; ++i) {
+				auto& s = sector_[i];
+				sect_head_t h;
+				fio_.read(i * SECTOR, &h, sizeof(h));
+				s.used = 0;
+				s.live = 0;
+				if(h.magic == MAGIC && h.seq != 0xFFFFFFFF) {
+					s.st = state::VALID;
+					s.seq = h.seq;
+					s.erase = h.erase;
+					if(seq_ < h.seq) seq_ = h.seq;
+					// 通し番号順に並べる
+					uint32_t j = n;
+					while(j > 0 && sector_[order[j - 1]].seq > h.seq) {
+						order[j] = order[j - 1];
+						--j;
+					}
+					order[j] = i;
+					++n;
+				} else {
+					s.erase = 0;
+					s.st = blank_(i) ? state::FREE : state::DIRTY;
+				}
+			}
+			// 消去回数の分からないセクターは、使用中の最小値とする
+			uint16_t emin = 0xFFFF;
+			for(uint32_t i = 0; i < n; ++i) {
+				if(emin > sector_[order[i]].erase) emin = sector_[order[i]].erase;
+				scan_(order[i]);
+			}
+			for(uint32_t i = 0; i < SNUM; ++i) {
+				if(n > 0 && sector_[i].st != state::VALID) sector_[i].erase = emin;
+			}
+			if(n > 0) active_ = order[n - 1];
+			else if(!open_(false)) return false;
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  全消去
+			@return エラーなら「false」
+		*/
+		//-----------------------------------------------------------------//
+		bool format()
+		{
+			for(uint32_t i = 0; i < SNUM; ++i) {
+				sector_[i].erase = 0;
+				if(!erase_sector_(i)) return false;
+			}
+			return start();
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief  フリー領域の取得
@@ -97,12 +431,13 @@ namespace utils {
 		//-----------------------------------------------------------------//
 		uint32_t get_free() const {
 			uint32_t space = 0;
-			for(uint32_t i = 0; i < FIO::data_flash_bank; ++i) {
-				if(fio_.erase_check(i)) {
-					space += FIO::data_flash_block - sizeof(head_t);
-				}
+			for(uint32_t i = 0; i < SNUM; ++i) {
+				const auto& s = sector_[i];
+				if(s.st == state::VALID) space += SECTOR - s.used + (s.used - sizeof(sect_head_t) - s.live);
+				else space += SECTOR - sizeof(sect_head_t);
 			}
-			return space;
+			// ガベージ・コレクション用の１セクター
+			return space > SECTOR ? space - SECTOR : 0;
 		}
 
 
@@ -115,14 +450,30 @@ namespace utils {
 		//-----------------------------------------------------------------//
 		bool probe(uint16_t id) const
 		{
-			return scan_(id) < FIO::data_flash_size;
+			uint32_t i = find_(id);
+			return i < inum_ && index_[i].id == id;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  サイズの取得
+			@param[in]	id	ファイルＩＤ
+			@return サイズ（無い場合「０」）
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_size(uint16_t id) const
+		{
+			uint32_t i = find_(id);
+			if(i < inum_ && index_[i].id == id) return index_[i].sz;
+			return 0;
 		}
 
 
 		//-----------------------------------------------------------------//
 		/*!
 			@brief  書き込み
-			@param[in]	id		ＩＤ
+			@param[in]	id		ＩＤ（0xFFFF は使えない）
 			@param[in]	src		ソース
 			@param[in]	size	サイズ（バイト）
 			@return エラーなら「false」
@@ -130,23 +481,29 @@ namespace utils {
 		//-----------------------------------------------------------------//
 		bool write(uint16_t id, const void* src, uint32_t size)
 		{
-			uint32_t pos = free_();
-			if(pos >= FIO::data_flash_size) {
-				return false;
-			}
-			uint32_t fsb = (FIO::data_flash_size - pos) / FIO::data_flash_block;
-			uint32_t fs  = fsb * (FIO::data_flash_block - sizeof(head_t));
-			if(fs < size) {
+			if(id == 0xFFFF || active_ >= SNUM) return false;
+			if((sizeof(sect_head_t) + rec_size_(size)) > SECTOR || (size & DELETE) != 0) {
 				return false;
 			}
+			if(!probe(id) && inum_ >= KMAX) return false;
 
-			head_t t;
-			t.id = id;
-//			t.size = 
-
+			if(!reserve_(rec_size_(size))) return false;
+			return append_(id, size, src);
+		}
 
 
-			return false;
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  削除
+			@param[in]	id		ＩＤ
+			@return エラーなら「false」
+		*/
+		//-----------------------------------------------------------------//
+		bool remove(uint16_t id)
+		{
+			if(!probe(id)) return false;
+			if(!reserve_(rec_size_(0))) return false;
+			return append_(id, DELETE, nullptr);
 		}
 
 
@@ -159,9 +516,37 @@ namespace utils {
 			@return エラーなら「false」
 		*/
 		//-----------------------------------------------------------------//
-		bool read(int desc, void* dst, uint32_t size)
+		bool read(uint16_t id, void* dst, uint32_t size)
+		{
+			uint32_t i = find_(id);
+			if(i >= inum_ || index_[i].id != id) return false;
+			if(size > index_[i].sz) size = index_[i].sz;
+			return fio_.read(index_[i].org + sizeof(rec_head_t), dst, size);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  統計情報を取得
+			@return 統計情報
+		*/
+		//-----------------------------------------------------------------//
+		stat_t get_stat() const
 		{
-			return false;
+			stat_t t;
+			t.keys = inum_;
+			t.live = 0;
+			t.erase_min = 0xFFFFFFFF;
+			t.erase_max = 0;
+			for(uint32_t i = 0; i < SNUM; ++i) {
+				const auto& s = sector_[i];
+				t.live += s.live;
+				if(t.erase_min > s.erase) t.erase_min = s.erase;
+				if(t.erase_max < s.erase) t.erase_max = s.erase;
+			}
+			t.free = get_free();
+			t.gc = gc_count_;
+			return t;
 		}
 	};
 }
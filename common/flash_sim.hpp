@@ -0,0 +1,271 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	データ・フラッシュ・シミュレーター @n
+			flash_io（RX64M/RX71M）と同じインターフェースを RAM 上に実装し、@n
+			flash_man などを、ホスト（Linux）で検証する為に使う。@n
+			・書き込みは４バイト単位、消去済みのワード以外への書き込みはエラー @n
+			・消去、書き込み、消去チェックの時間（最大値）を積算する @n
+			・指定回数の書き込みの後、電源断（以降の書き込み、消去を無視）を模擬
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdint>
+#include <cstring>
+
+namespace utils {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  データ・フラッシュ・シミュレーター・クラス
+		@param[in]	SIZE	容量
+		@param[in]	BLOCK	消去ブロック・サイズ
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <uint32_t SIZE = 65536, uint32_t BLOCK = 64>
+	class flash_sim {
+	public:
+		static const uint32_t data_flash_block = BLOCK;			///< データ・フラッシュのブロックサイズ
+		static const uint32_t data_flash_size  = SIZE;			///< データ・フラッシュの容量
+		static const uint32_t data_flash_bank  = SIZE / BLOCK;	///< データ・フラッシュのバンク数
+
+		static const uint32_t write_us       = 1700;	///< ４バイト書き込み時間
+		static const uint32_t erase_us       = 10000;	///< ブロック消去時間
+		static const uint32_t erase_check_us = 30;		///< ４バイト消去チェック時間
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  エラー型
+		*/
+		//-----------------------------------------------------------------//
+		enum class error : uint8_t {
+			NONE,		///< エラー無し
+			ADDRESS,	///< アドレス・エラー
+			OVERWRITE,	///< 消去されていないワードへの書き込み
+			POWER,		///< 電源断
+		};
+
+	private:
+		uint8_t		mem_[SIZE];
+		uint32_t	erase_cnt_[SIZE / BLOCK];
+		error		error_;
+		uint64_t	time_us_;
+		uint32_t	write_num_;
+		uint32_t	erase_num_;
+		uint32_t	fail_;		///< 電源断までの書き込み数（０なら無効）
+
+		bool power_() noexcept
+		{
+			if(fail_ == 0) return true;
+			--fail_;
+			if(fail_ == 0) {
+				error_ = error::POWER;
+				fail_ = 1;  // 以降も断のまま
+				return false;
+			}
+			return true;
+		}
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	コンストラクター（全て消去された状態）
+		 */
+		//-----------------------------------------------------------------//
+		flash_sim() noexcept : error_(error::NONE), time_us_(0), write_num_(0), erase_num_(0), fail_(0)
+		{
+			std::memset(mem_, 0xFF, sizeof(mem_));
+			std::memset(erase_cnt_, 0, sizeof(erase_cnt_));
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	エラー・ステータスを取得
+			@return エラー・ステータス
+		 */
+		//-----------------------------------------------------------------//
+		error get_last_error() const noexcept { return error_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	開始
+			@return エラーが無ければ「true」
+		 */
+		//-----------------------------------------------------------------//
+		bool start() noexcept { return true; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  読み出し
+			@param[in]	org		開始アドレス
+			@param[out]	dst		転送先
+			@param[in]	len		長さ
+			@return 成功なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool read(uint32_t org, void* dst, uint32_t len) noexcept
+		{
+			if(org >= SIZE) {
+				error_ = error::ADDRESS;
+				return false;
+			}
+			if((org + len) > SIZE) {
+				len = SIZE - org;
+			}
+			std::memcpy(dst, &mem_[org], len);
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  消去チェック
+			@param[in]	org		開始アドレス
+			@param[in]	len		検査長（バイト単位）
+			@return 消去されていれば「true」（エラーは「false」）
+		*/
+		//-----------------------------------------------------------------//
+		bool erase_check(uint32_t org, uint32_t len = BLOCK) noexcept
+		{
+			if(org >= SIZE || (org + len) > SIZE) {
+				error_ = error::ADDRESS;
+				return false;
+			}
+			time_us_ += erase_check_us * ((len + 3) / 4);
+			for(uint32_t i = 0; i < len; ++i) {
+				if(mem_[org + i] != 0xFF) return false;
+			}
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  消去
+			@param[in]	org		開始アドレス
+			@return エラーがあれば「false」
+		*/
+		//-----------------------------------------------------------------//
+		bool erase(uint32_t org) noexcept
+		{
+			if(org >= SIZE) {
+				error_ = error::ADDRESS;
+				return false;
+			}
+			if(!power_()) return false;
+			org &= ~(BLOCK - 1);
+			std::memset(&mem_[org], 0xFF, BLOCK);
+			++erase_cnt_[org / BLOCK];
+			++erase_num_;
+			time_us_ += erase_us;
+			error_ = error::NONE;
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  全消去
+			@return エラーがあれば「false」
+		*/
+		//-----------------------------------------------------------------//
+		bool erase_all() noexcept
+		{
+			for(uint32_t pos = 0; pos < SIZE; pos += BLOCK) {
+				if(!erase_check(pos)) {
+					if(!erase(pos)) return false;
+				}
+			}
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  書き込み @n
+					※４バイト単位で書き込まれ、端数は０ｘＦＦとなる
+			@param[in]	org	開始オフセット
+			@param[in]	src ソース
+			@param[in]	len	バイト数
+			@return エラーがあれば「false」
+		*/
+		//-----------------------------------------------------------------//
+		bool write(uint32_t org, const void* src, uint32_t len) noexcept
+		{
+			if(org >= SIZE || (org & 3) != 0) {
+				error_ = error::ADDRESS;
+				return false;
+			}
+			if((org + len) > SIZE) {
+				len = SIZE - org;
+			}
+			const uint8_t* p = static_cast<const uint8_t*>(src);
+			while(len > 0) {
+				uint8_t w[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+				uint32_t l = len < 4 ? len : 4;
+				std::memcpy(w, p, l);
+				for(uint32_t i = 0; i < 4; ++i) {
+					if(mem_[org + i] != 0xFF) {
+						error_ = error::OVERWRITE;
+						return false;
+					}
+				}
+				if(!power_()) return false;
+				std::memcpy(&mem_[org], w, 4);
+				++write_num_;
+				time_us_ += write_us;
+				org += 4;
+				p += l;
+				len -= l;
+			}
+			error_ = error::NONE;
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  電源断の設定
+			@param[in]	n	n 回目の書き込み（消去）で断とする（０で解除）
+		*/
+		//-----------------------------------------------------------------//
+		void set_power_fail(uint32_t n) noexcept { fail_ = n; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  積算時間を取得
+			@return 積算時間（マイクロ秒）
+		*/
+		//-----------------------------------------------------------------//
+		uint64_t get_time() const noexcept { return time_us_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  書き込み（４バイト）回数を取得
+			@return 書き込み回数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_write_count() const noexcept { return write_num_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  消去回数を取得
+			@param[in]	bank	バンク（範囲外なら全体）
+			@return 消去回数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_erase_count(uint32_t bank = SIZE / BLOCK) const noexcept {
+			if(bank < (SIZE / BLOCK)) return erase_cnt_[bank];
+			return erase_num_;
+		}
+	};
+}
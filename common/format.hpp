@@ -9,6 +9,10 @@
 			※ N には、小数点、符号が含まれる @n
 			Ex: %1.2:8y ---> 256 で 1.00、128 で 0.50、384 で 1.50 と @n
 			と表示される。@n
+			・文字列リテラルの書式を、コンパイル時に解析する static_format @n
+			（UTILS_FORMAT、UTILS_SFORMAT マクロ）@n
+			・ブロック・バッファ付き出力ファンクタ（buffer_chaout、ring_chaout）@n
+			※ format は、バッファして、改行と format 文の終わりで書き出す @n
 			+ 2017/06/11 20:00- 標準文字出力クラスの再定義、実装 @n 
 			+ 2017/06/11 21:00- 固定文字列クラス向け chaout、実装 @n
 			+ 2017/06/12 14:50- memory_chaoutと、専用コンストラクター実装 @n
@@ -22,6 +26,7 @@
 #include <type_traits>
 #include <unistd.h>
 #include <cstring>
+#include "common/fixed_fifo.hpp"
 
 /* 
   e, E
@@ -52,6 +57,31 @@
 
 namespace utils {
 
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  バッファ付き出力ファンクタの書き出しポリシー
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	enum class flush_policy : uint8_t {
+		full,	///< バッファが一杯になった時だけ（後は flush() を呼ぶ）
+		line,	///< 改行毎
+		format,	///< 改行毎と、format 文の終わり毎
+	};
+
+
+	namespace format_detail {
+
+		// 出力ファンクタが format_end() を持つ場合だけ、format 文の終わりで呼ぶ
+		template <class CHAOUT>
+		inline auto format_end(CHAOUT& out, int) noexcept -> decltype(out.format_end(), void()) {
+			out.format_end();
+		}
+
+		template <class CHAOUT>
+		inline void format_end(CHAOUT& out, long) noexcept { }
+	}
+
+
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	/*!
 		@brief  無効出力ファンクタ @n
@@ -204,7 +234,219 @@ namespace utils {
 
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	/*!
-		@brief  メモリー文字列クラス
+		@brief  ブロック・バッファ出力ファンクタ @n
+				文字をバッファに溜め、ポリシーに従い TERM でまとめて書き出す。
+		@param[in]	SIZE	バッファ・サイズ
+		@param[in]	TERM	ターミネーター・ファンクタ
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <uint16_t SIZE, class TERM = stdout_term>
+	class buffer_chaout {
+
+		static_assert(SIZE > 0, "buffer_chaout SIZE must be 1 or more");
+
+		char		buff_[SIZE];
+		uint16_t	pos_;
+		flush_policy	policy_;
+		uint32_t	size_;
+		uint32_t	count_;
+		TERM		term_;
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  コンストラクター
+			@param[in]	policy	書き出しポリシー
+		*/
+		//-----------------------------------------------------------------//
+		buffer_chaout(flush_policy policy = flush_policy::format) :
+			pos_(0), policy_(policy), size_(0), count_(0), term_() { }
+
+		void operator() (char ch) {
+			buff_[pos_] = ch;
+			++pos_;
+			++size_;
+			if(pos_ >= SIZE || (ch == '\n' && policy_ != flush_policy::full)) {
+				flush();
+			}
+		}
+
+		void clear() { size_ = 0; };
+
+		uint32_t size() const { return size_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  書き出し
+		*/
+		//-----------------------------------------------------------------//
+		void flush() {
+			if(pos_ > 0) {
+				term_(buff_, pos_);
+				pos_ = 0;
+				++count_;
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  format 文の終わり（basic_format から呼ばれる）
+		*/
+		//-----------------------------------------------------------------//
+		void format_end() {
+			if(policy_ == flush_policy::format) flush();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  書き出しポリシーの設定
+			@param[in]	policy	書き出しポリシー
+		*/
+		//-----------------------------------------------------------------//
+		void set_policy(flush_policy policy) { policy_ = policy; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  書き出しポリシーの取得
+			@return 書き出しポリシー
+		*/
+		//-----------------------------------------------------------------//
+		flush_policy get_policy() const { return policy_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  TERM を呼んだ回数を返す
+			@return 書き出し回数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_flush_count() const { return count_; }
+
+
+		TERM& at_term() { return term_; }
+	};
+
+	/// 標準出力（改行と、format 文の終わりで書き出す）
+	typedef buffer_chaout<128, stdout_term> stdout_buffer_chaout;
+
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  リング・バッファ出力ファンクタ @n
+				文字を fixed_fifo に格納し、ポリシーに従い DRAIN を起動する。@n
+				DRAIN は「void operator() (FIFO& fifo)」で、get_span()、get_go() @n
+				を使い、FIFO を送出する（SCI 送信割り込みの許可、DMA の起動など）。@n
+				FIFO が一杯の場合、wait なら DRAIN を呼びながら空きを待ち、@n
+				そうでなければ、文字を捨てて、溢れとして数える。
+		@param[in]	SIZE	FIFO のサイズ（２のＮ乗を推奨）
+		@param[in]	DRAIN	送出ファンクタ
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <uint32_t SIZE, class DRAIN>
+	class ring_chaout {
+	public:
+		typedef fixed_fifo<char, SIZE> FIFO;
+
+	private:
+		FIFO		fifo_;
+		DRAIN		drain_;
+		flush_policy	policy_;
+		bool		wait_;
+		uint32_t	size_;
+		uint32_t	lost_;
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  コンストラクター
+			@param[in]	policy	書き出しポリシー
+			@param[in]	wait	FIFO が一杯の場合に待つなら「true」
+		*/
+		//-----------------------------------------------------------------//
+		ring_chaout(flush_policy policy = flush_policy::format, bool wait = true) :
+			fifo_(), drain_(), policy_(policy), wait_(wait), size_(0), lost_(0) { }
+
+		void operator() (char ch) {
+			while(fifo_.space() == 0) {
+				if(!wait_) {
+					++lost_;
+					return;
+				}
+				drain_(fifo_);
+			}
+			fifo_.put(ch);
+			++size_;
+			if(fifo_.space() == 0 || (ch == '\n' && policy_ != flush_policy::full)) {
+				flush();
+			}
+		}
+
+		void clear() { size_ = 0; };
+
+		uint32_t size() const { return size_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  送出の起動
+		*/
+		//-----------------------------------------------------------------//
+		void flush() {
+			if(fifo_.length() > 0) drain_(fifo_);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  format 文の終わり（basic_format から呼ばれる）
+		*/
+		//-----------------------------------------------------------------//
+		void format_end() {
+			if(policy_ == flush_policy::format) flush();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  書き出しポリシーの設定
+			@param[in]	policy	書き出しポリシー
+		*/
+		//-----------------------------------------------------------------//
+		void set_policy(flush_policy policy) { policy_ = policy; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  FIFO が一杯の場合の動作を設定
+			@param[in]	wait	空きを待つなら「true」、捨てるなら「false」
+		*/
+		//-----------------------------------------------------------------//
+		void set_wait(bool wait) { wait_ = wait; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  溢れて捨てた文字数を返す
+			@return 溢れた文字数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_lost() const { return lost_; }
+
+
+		FIFO& at_fifo() { return fifo_; }
+
+		DRAIN& at_drain() { return drain_; }
+	};
+
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  メモリー文字列クラス @n
+				バッファに入りきらない文字は捨て、その数を数える。
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	class memory_chaout {
@@ -212,6 +454,7 @@ namespace utils {
 		char*		dst_;
 		uint32_t	limit_;
 		uint32_t	pos_;
+		uint32_t	lost_;
 
 	public:
 		//-----------------------------------------------------------------//
@@ -219,28 +462,44 @@ namespace utils {
 			@brief  コンストラクター
 		*/
 		//-----------------------------------------------------------------//
-		memory_chaout() : dst_(nullptr), limit_(0), pos_(0) { }
+		memory_chaout() : dst_(nullptr), limit_(0), pos_(0), lost_(0) { }
 
 		void set(char* dst, uint32_t limit)
 		{
 			if(dst_ != dst || limit_ != limit) {  // ポインター、サイズ、どちらか異なる場合は常にリセット
 				pos_ = 0;
+				lost_ = 0;
 			}
 			dst_ = dst;
 			limit_ = limit;
 		}
 
 		void operator () (char ch) {
-			if(pos_ < (limit_ - 1)) {
+			if((pos_ + 1) < limit_) {
 				dst_[pos_] = ch;
 				++pos_;
 				dst_[pos_] = 0;
+			} else {
+				++lost_;
 			}
 		}
 
-		void clear() { pos_ = 0; }
+		void clear() {
+			pos_ = 0;
+			lost_ = 0;
+			if(limit_ > 0) dst_[0] = 0;  // 何も出力しない場合も、空文字列にする
+		}
 
 		uint32_t size() const { return pos_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  入りきらずに捨てた文字数を返す
+			@return 溢れた文字数（「０」なら切り詰め無し）
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_lost() const { return lost_; }
 	};
 
 
@@ -453,38 +712,75 @@ namespace utils {
 		}
 
 
-		void out_udec_(uint32_t v, char sign) {
-			char* p = &buff_[sizeof(buff_) - 1];
-			*p = 0;
-			uint8_t n = 0;
-			do {
+		// ２桁変換テーブル「00」～「99」
+		static const char* dec2_() {
+			static const char tbl[201] = {
+				"00010203040506070809"
+				"10111213141516171819"
+				"20212223242526272829"
+				"30313233343536373839"
+				"40414243444546474849"
+				"50515253545556575859"
+				"60616263646566676869"
+				"70717273747576777879"
+				"80818283848586878889"
+				"90919293949596979899"
+			};
+			return tbl;
+		}
+
+
+		// 10 進変換（p の手前に逆順で格納し、先頭を返す）@n
+		// ※ 定数 100 の除算は、コンパイラが乗算に置き換える
+		static char* udec_(char* p, uint32_t v) {
+			const char* t = dec2_();
+			while(v >= 100) {
+				uint32_t q = v / 100;
+				uint32_t r = (v - q * 100) * 2;
+				p -= 2;
+				p[0] = t[r];
+				p[1] = t[r + 1];
+				v = q;
+			}
+			if(v >= 10) {
+				p -= 2;
+				p[0] = t[v * 2];
+				p[1] = t[v * 2 + 1];
+			} else {
 				--p;
-				*p = (v % 10) + '0';
-				v /= 10;
-				++n;
-			} while(v != 0) ;
-			out_str_(p, sign, n);
+				*p = v + '0';
+			}
+			return p;
+		}
+
+
+		void out_udec_(uint32_t v, char sign) {
+			char* e = &buff_[sizeof(buff_) - 1];
+			*e = 0;
+			char* p = udec_(e, v);
+			out_str_(p, sign, e - p);
 		}
 
 
 		void out_dec_(int32_t v) {
 			char sign = 0;
-			if(v < 0) { v = -v; sign = '-'; }
+			if(v < 0) { sign = '-'; }
 			else if(sign_) { sign = '+'; }
-			out_udec_(v, sign);
+			// INT_MIN でも溢れないように、符号無しで反転する
+			uint32_t u = v < 0 ? 0u - static_cast<uint32_t>(v) : v;
+			out_udec_(u, sign);
 		}
 
 
 		void out_hex_(uint32_t v, char top) {
+			static const char tbl[] = { "0123456789abcdef0123456789ABCDEF" };
+			const char* t = top == 'A' ? &tbl[16] : tbl;
 			char* p = &buff_[sizeof(buff_) - 1];
 			*p = 0;
 			uint8_t n = 0;
 			do {
 				--p;
-				char ch = v & 15;
-				if(ch >= 10) ch += top - 10;
-				else ch += '0';
-				*p = ch;
+				*p = t[v & 15];
 				v >>= 4;
 				++n;
 			} while(v != 0) ;
@@ -513,12 +809,19 @@ namespace utils {
 				out_hex_(static_cast<uint32_t>(val), 'A');
 				break;
 			case mode::FIXED_REAL:
-				if(num_ == 0) num_ = 6;
-				if(val < 0) {
-					sign = true;
-					val = -val;
+				{
+					if(num_ == 0) num_ = 6;
+					// sign は、引数が符号付きの型か（負の値は、符号無しで反転する）
+					uint32_t u = val;
+					bool neg = sign && val < 0;
+					if(neg) u = 0u - u;
+					// 小数部が 28 ビット未満なら、32 ビット演算で足りる
+					if(bitlen_ < 28) {
+						out_fixed_point_<uint32_t>(u, bitlen_, neg);
+					} else {
+						out_fixed_point_<uint64_t>(u, bitlen_, neg);
+					}
 				}
-				out_fixed_point_<uint64_t>(val, bitlen_, sign);
 				break;
 			default:
 				error_ = error::different;
@@ -527,14 +830,11 @@ namespace utils {
 		}
 
 
-		uint64_t make_mask_(uint8_t num) {
-			uint64_t m = 0;
-			while(num > 0) {
-				m += m;
-				++m;
-				--num;
-			}
-			return m;
+		static uint32_t pow10_(uint8_t n) {
+			static const uint32_t tbl[10] = {
+				1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+			};
+			return tbl[n];
 		}
 
 
@@ -546,10 +846,11 @@ namespace utils {
 			if(fixpoi < (sizeof(VAL) * 8 - 4)) {
 				m = static_cast<VAL>(5) << fixpoi;
 				uint8_t n = point_ + 1;
-				while(n > 0) {
-					m /= 10;
-					--n;
+				while(n > 9) {
+					m /= pow10_(9);
+					n -= 9;
 				}
+				m /= pow10_(n);
 			}
 			char sch = 0;
 			if(sign) sch = '-';
@@ -571,7 +872,7 @@ namespace utils {
 
 			uint8_t l = 0;
 			if(fixpoi < (sizeof(VAL) * 8 - 4)) {
-				VAL dec = v & make_mask_(fixpoi);
+				VAL dec = v & ((static_cast<VAL>(1) << fixpoi) - 1);
 				while(dec > 0) {
 					dec *= 10;
 					VAL n = dec >> fixpoi;
@@ -588,104 +889,363 @@ namespace utils {
 		}
 
 
-		void out_real_(float v, char e) {
-			void* p = &v;
-			uint32_t fpv = *(uint32_t*)p;
-			bool sign = fpv >> 31;
-			int16_t exp = (fpv >> 23) & 0xff;
-			if(exp == 0xff) {
-				if(sign) chaout_('-');
-				str_("inf");
-				return;
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief	float の 10 進展開 @n
+					値「man * 2^exp2」を、整数部の文字列と、小数部の @n
+					２進固定小数点（f / 2^s）に分け、上位から１桁づつ取り出す。@n
+					小数部は「×10」とシフトだけで求め、64 ビットの除算は使わない。
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct real_digits_t {
+			char		ibuf_[48];	///< 整数部（float の最大値 39 桁が入る）
+			const char*	ip_;		///< 整数部の残り
+			uint32_t	il_;		///< 整数部の残り桁数
+			uint32_t	lz_;		///< 小数部の先行ゼロ数
+			uint64_t	f_;			///< 小数部
+			uint32_t	s_;			///< 小数部のビット数（60 以下）
+			bool		sticky_;	///< 切り捨てたビットがある場合「true」
+
+			real_digits_t(uint32_t man, int32_t exp2) : lz_(0), f_(0), s_(0), sticky_(false)
+			{
+				char* e = &ibuf_[sizeof(ibuf_)];
+				if(exp2 >= 0) {
+					if(exp2 <= 8) {
+						ip_ = udec_(e, man << exp2);
+					} else {  // 10^9 基数の多倍長で、２倍を繰り返す
+						static const uint32_t base = 1000000000;
+						uint32_t limb[5] = { man, 0, 0, 0, 0 };
+						uint32_t n = 1;
+						for(int32_t i = 0; i < exp2; ++i) {
+							uint32_t c = 0;
+							for(uint32_t j = 0; j < n; ++j) {
+								uint32_t t = (limb[j] << 1) + c;
+								c = t >= base;
+								if(c) t -= base;
+								limb[j] = t;
+							}
+							if(c) limb[n++] = 1;
+						}
+						char* p = e;
+						for(uint32_t j = 0; j < (n - 1); ++j) {
+							char* q = udec_(p, limb[j]);
+							while(q > (p - 9)) { --q; *q = '0'; }
+							p = q;
+						}
+						ip_ = udec_(p, limb[n - 1]);
+					}
+				} else {
+					s_ = -exp2;
+					uint32_t ipart = 0;
+					if(s_ < 24) {
+						ipart = man >> s_;
+						f_ = man & ((static_cast<uint32_t>(1) << s_) - 1);
+					} else {
+						f_ = man;
+					}
+					ip_ = udec_(e, ipart);
+					if(f_ == 0) {
+						s_ = 0;
+					}
+					// 小数部を 60 ビット以下に収める（先行ゼロを数え、余分な下位ビットを落とす）
+					while(s_ > 60) {
+						if(f_ < (static_cast<uint64_t>(1) << 57)) {
+							f_ *= 10;
+							++lz_;
+						} else {
+							sticky_ |= (f_ & 1) != 0;
+							f_ >>= 1;
+							--s_;
+						}
+					}
+				}
+				il_ = e - ip_;
 			}
 
-			exp -= 127;	// bias (-127)
-			int32_t val = fpv & 0x7fffff;	// 23 bits
-			int16_t shift = 23;
-			if(val == 0 && exp == -127) ; // [0.0]
-			else {
-				val |= 0x800000; // add offset 1.0
+			uint32_t next() {
+				if(il_ > 0) {
+					--il_;
+					return *ip_++ - '0';
+				}
+				if(lz_ > 0) {
+					--lz_;
+					return 0;
+				}
+				if(f_ == 0) return 0;
+				f_ *= 10;
+				uint32_t d = f_ >> s_;
+				f_ &= (static_cast<uint64_t>(1) << s_) - 1;
+				return d;
 			}
-			shift -= exp;
 
-			// 64 ビットに拡張
-			uint64_t v64 = static_cast<uint64_t>(val);
-			if(shift < 28) {
-				shift += 32;
-				v64 <<= 32;
+			bool rest() const {
+				for(uint32_t i = 0; i < il_; ++i) {
+					if(ip_[i] != '0') return true;
+				}
+				return f_ != 0 || sticky_;
 			}
+		};
 
-			// エキスポーネント表記の場合
-			int8_t dexp = 0;
-			if(e != 0) {
-				if(v64 > (static_cast<uint64_t>(2) << shift)) {  // 2.0 以上の場合
-					while(v64 > (static_cast<uint64_t>(2) << shift)) {
-						v64 /= 10;
-						++dexp;
-					}
-				} else if(v64 < (static_cast<uint64_t>(1) << shift)) {  // 1.0 以下
-					while(v64 < (static_cast<uint64_t>(1) << shift)) {
-						v64 *= 10;
-						--dexp;
-					}
+
+		// 最近接偶数への丸め（桁上がりが溢れた場合「true」）
+		static bool round_digits_(char* top, uint32_t n, real_digits_t& rd) {
+			uint32_t d = rd.next();
+			bool odd = n > 0 && ((top[n - 1] - '0') & 1) != 0;
+			if(d < 5 || (d == 5 && !odd && !rd.rest())) return false;
+			while(n > 0) {
+				--n;
+				if(top[n] != '9') {
+					++top[n];
+					return false;
 				}
+				top[n] = '0';
 			}
+			return true;
+		}
 
-			out_fixed_point_<uint64_t>(v64, shift, sign);
 
-			if(e) {
-				chaout_(e);
-				zerosupp_ = true;
-				sign_ = true;
-				num_ = 3;
-				out_dec_(dexp);
+		void out_real_digits_(char* top, uint32_t il, const char* fp, uint32_t fl, char sch) {
+			if(num_ >= point_) num_ -= point_;
+			if(num_ > 0 && sch != 0) --num_;
+			if(num_ > 0 && point_ != 0) {
+				--num_;
 			}
-		}
+			char tmp = top[il];
+			top[il] = 0;
+			out_str_(top, sch, il);
+			top[il] = tmp;
 
-	public:
-		//-----------------------------------------------------------------//
-		/*!
-			@brief  コンストラクター
-			@param[in]	form	フォーマット式
-		*/
-		//-----------------------------------------------------------------//
-		basic_format(const char* form) noexcept :
-			form_(form),
-			error_(error::none),
-			num_(0), point_(0),
-			bitlen_(0),
-			mode_(mode::NONE), zerosupp_(false), sign_(false)
-		{
-			next_();
+			if(point_ == 0) return;
+			chaout_('.');
+			uint32_t l = 0;
+			while(l < point_) {
+				chaout_(l < fl ? fp[l] : '0');
+				++l;
+			}
 		}
 
 
-		//-----------------------------------------------------------------//
-		/*!
-			@brief  コンストラクター
-			@param[in]	form	フォーマット式
-			@param[in]	buff	文字バッファ
-			@param[in]	size	文字バッファサイズ
-			@param[in]	append	文字バッファに追加する場合「true」
-		*/
-		//-----------------------------------------------------------------//
-		basic_format(const char* form, char* buff, uint32_t size, bool append = false) noexcept :
-			form_(form),
-			error_(error::none),
-			num_(0), point_(0),
-			bitlen_(0),
-			mode_(mode::NONE), zerosupp_(false), sign_(false)
-		{
-			chaout_.set(buff, size);
-			if(!append) {
-				chaout_.clear();
-
+		void out_real_(float v, char e) {
+			uint32_t fpv;
+			std::memcpy(&fpv, &v, sizeof(fpv));
+			bool sign = fpv >> 31;
+			uint32_t bexp = (fpv >> 23) & 0xff;
+			uint32_t man = fpv & 0x7fffff;	// 23 bits
+			if(bexp == 0xff) {
+				if(sign) chaout_('-');
+				str_(man != 0 ? "nan" : "inf");
+				return;
 			}
-			next_();
-		}
+			if(bexp != 0) man |= 0x800000; // add offset 1.0
+			else bexp = 1;  // 非正規化数
+			real_digits_t rd(man, static_cast<int32_t>(bexp) - 150);
 
+			char sch = 0;
+			if(sign) sch = '-';
+			else if(sign_) sch = '+';
 
-		//-----------------------------------------------------------------//
+			// 小数部は、最大 64 桁まで求め、それ以降は「0」で埋める
+			static const uint32_t frac_max = 64;
+			char buf[1 + sizeof(rd.ibuf_) + frac_max];
+			char* top = &buf[1];
+			uint32_t fl = point_ < frac_max ? point_ : frac_max;
+			if(e == 0) {
+				uint32_t il = rd.il_;
+				for(uint32_t i = 0; i < (il + fl); ++i) {
+					top[i] = rd.next() + '0';
+				}
+				if(round_digits_(top, il + fl, rd)) {
+					--top;
+					*top = '1';
+					++il;
+				}
+				out_real_digits_(top, il, top + il, fl, sch);
+				return;
+			}
+
+			// エキスポーネント表記の場合
+			int32_t dexp = 0;
+			uint32_t d = 0;
+			if(man != 0) {
+				dexp = static_cast<int32_t>(rd.il_) - 1;
+				d = rd.next();
+				while(d == 0) {
+					--dexp;
+					d = rd.next();
+				}
+			}
+			top[0] = d + '0';
+			for(uint32_t i = 1; i <= fl; ++i) {
+				top[i] = rd.next() + '0';
+			}
+			if(round_digits_(top, fl + 1, rd)) {
+				top[0] = '1';
+				++dexp;
+			}
+			out_real_digits_(top, 1, top + 1, fl, sch);
+
+			chaout_(e);
+			if(dexp < 0) {
+				chaout_('-');
+				dexp = -dexp;
+			} else {
+				chaout_('+');
+			}
+			char* x = &buff_[sizeof(buff_) - 1];
+			*x = 0;
+			char* p = udec_(x, dexp);
+			if(dexp < 10) {
+				--p;
+				*p = '0';
+			}
+			str_(p);
+		}
+
+		void apply_(const char* val) {
+			if(mode_ == mode::STR) {
+				if(val == nullptr) {
+					static const char* nullstr = { "(nullptr)" };
+					out_str_(nullstr, 0, std::strlen(nullstr));
+				} else {
+					zerosupp_ = false;
+					uint8_t n = 0;
+					const char* p = val;
+					while((*p++) != 0) { ++n; }
+					out_str_(val, 0, n);
+				}
+			} else {
+				error_ = error::different;
+			}
+		}
+
+
+		void apply_(char* val) { apply_(static_cast<const char*>(val)); }
+
+
+		template <typename T>
+		void apply_(T val) {
+			if(std::is_integral<T>::value) {
+				if(mode_ == mode::CHA && sizeof(T) == 1) {
+					chaout_(val);
+				} else {
+					decimal_(static_cast<int32_t>(val), std::is_signed<T>::value);
+				}
+			} else if(std::is_floating_point<T>::value) {
+				if(num_ == 0 && !zerosupp_ && point_ == 0) {
+					num_ = 6;
+					point_ = 6;
+				}
+				switch(mode_) {
+				case mode::REAL:
+					out_real_(val, 0);
+					break;
+				case mode::EXPONENT_CAPS:
+					out_real_(val, 'E');
+					break;
+				case mode::EXPONENT:
+					out_real_(val, 'e');
+					break;
+				case mode::REAL_AUTO:
+					out_real_(val, 0);
+					break;
+				default:
+					error_ = error::different;
+					break;
+				}
+			} else {
+				error_ = error::unknown;
+			}
+		}
+
+
+		// static_format 向け（書式の解析は行わず、変換だけを行う）
+		template <class C, class F, uint32_t I> friend class static_format;
+
+		struct spec_tag { };
+
+		basic_format(spec_tag, char type, uint8_t num, uint8_t point, uint8_t bitlen,
+			bool zerosupp, bool sign) noexcept :
+			form_(nullptr), error_(error::none),
+			num_(num), point_(point), bitlen_(bitlen),
+			mode_(mode::NONE), zerosupp_(zerosupp), sign_(sign)
+		{
+			switch(type) {
+			case 's': mode_ = mode::STR; break;
+			case 'c': mode_ = mode::CHA; break;
+			case 'b': mode_ = mode::BINARY; break;
+			case 'o': mode_ = mode::OCTAL; break;
+			case 'd': mode_ = mode::DECIMAL; break;
+			case 'u': mode_ = mode::U_DECIMAL; break;
+			case 'x': mode_ = mode::HEX; break;
+			case 'X': mode_ = mode::HEX_CAPS; break;
+			case 'y': mode_ = mode::FIXED_REAL; break;
+			case 'f':
+			case 'F': mode_ = mode::REAL; break;
+			case 'e': mode_ = mode::EXPONENT; break;
+			case 'E': mode_ = mode::EXPONENT_CAPS; break;
+			case 'g':
+			case 'G': mode_ = mode::REAL_AUTO; break;
+			default: break;
+			}
+		}
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  コンストラクター
+			@param[in]	form	フォーマット式
+		*/
+		//-----------------------------------------------------------------//
+		basic_format(const char* form) noexcept :
+			form_(form),
+			error_(error::none),
+			num_(0), point_(0),
+			bitlen_(0),
+			mode_(mode::NONE), zerosupp_(false), sign_(false)
+		{
+			next_();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  コンストラクター
+			@param[in]	form	フォーマット式
+			@param[in]	buff	文字バッファ
+			@param[in]	size	文字バッファサイズ
+			@param[in]	append	文字バッファに追加する場合「true」
+		*/
+		//-----------------------------------------------------------------//
+		basic_format(const char* form, char* buff, uint32_t size, bool append = false) noexcept :
+			form_(form),
+			error_(error::none),
+			num_(0), point_(0),
+			bitlen_(0),
+			mode_(mode::NONE), zerosupp_(false), sign_(false)
+		{
+			chaout_.set(buff, size);
+			if(!append) {
+				chaout_.clear();
+
+			}
+			next_();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  デストラクター（format 文の終わり）
+		*/
+		//-----------------------------------------------------------------//
+		~basic_format() noexcept
+		{
+			if(form_ != nullptr) {  // static_format の変換用は除く
+				format_detail::format_end(chaout_, 0);
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
 		/*!
 			@brief  出力ファンクタの参照
 			@return 出力ファンクタ
@@ -734,20 +1294,7 @@ namespace utils {
 				return *this;
 			}
 
-			if(mode_ == mode::STR) {
-				if(val == nullptr) {
-					static const char* nullstr = { "(nullptr)" };
-					out_str_(nullstr, 0, std::strlen(nullstr));					
-				} else {
-					zerosupp_ = false;
-					uint8_t n = 0;
-					const char* p = val;
-					while((*p++) != 0) { ++n; }
-					out_str_(val, 0, n);
-				}
-			} else {
-				error_ = error::different;
-			}
+			apply_(val);
 
 			reset_();
 			next_();
@@ -757,35 +1304,14 @@ namespace utils {
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief  オペレーター「%」(const char*)
+			@brief  オペレーター「%」(char*)
 			@param[in]	val	値
 			@return	自分の参照
 		*/
 		//-----------------------------------------------------------------//
 		basic_format& operator % (char* val) noexcept
 		{
-			if(error_ != error::none) {
-				return *this;
-			}
-
-			if(mode_ == mode::STR) {
-				if(val == nullptr) {
-					static const char* nullstr = { "(nullptr)" };
-					out_str_(nullstr, 0, strlen(nullstr));					
-				} else {
-					zerosupp_ = false;
-					uint8_t n = 0;
-					const char* p = val;
-					while((*p++) != 0) { ++n; }
-					out_str_(val, 0, n);
-				}
-			} else {
-				error_ = error::different;
-			}
-
-			reset_();
-			next_();
-			return *this;
+			return operator % (static_cast<const char*>(val));
 		}
 
 
@@ -803,37 +1329,7 @@ namespace utils {
 				return *this;
 			}
 
-			if(std::is_integral<T>::value) {
-				if(mode_ == mode::CHA && sizeof(T) == 1) {
-					chaout_(val);
-				} else {
-					decimal_(static_cast<int32_t>(val), std::is_signed<T>::value);
-				}
-			} else if(std::is_floating_point<T>::value) {
-				if(num_ == 0 && !zerosupp_ && point_ == 0) {
-					num_ = 6;
-					point_ = 6;
-				}
-				switch(mode_) {
-				case mode::REAL:
-					out_real_(val, 0);
-					break;
-				case mode::EXPONENT_CAPS:
-					out_real_(val, 'E');
-					break;
-				case mode::EXPONENT:
-					out_real_(val, 'e');
-					break;
-				case mode::REAL_AUTO:
-					out_real_(val, 0);
-					break;
-				default:
-					error_ = error::different;
-					break;
-				}
-			} else {
-				error_ = error::unknown;
-			}
+			apply_(val);
 
 			reset_();
 			next_();
@@ -843,8 +1339,364 @@ namespace utils {
 
 	template <class CHAOUT> CHAOUT basic_format<CHAOUT>::chaout_;
 
-	typedef basic_format<stdout_chaout> format;
+	/// 標準出力（stdout_buffer_chaout）@n
+	/// ※バッファ（buff_、pos_）は全ての format で共有し、排他しないので、メイン・ループの @n
+	/// format 中に、割り込みから format を呼んではならない（割り込みからは sformat を使う）
+	typedef basic_format<stdout_buffer_chaout> format;
 	typedef basic_format<memory_chaout> sformat;
 	typedef basic_format<null_chaout> null_format;
 	typedef basic_format<size_chaout> size_format;
+
+
+	namespace format_detail {
+
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief  変換指定（コンパイル時に解析）
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct spec_t {
+			uint32_t	org;		///< 直前のリテラル開始位置
+			uint32_t	end;		///< 直前のリテラル終了位置
+			char		type;		///< 変換文字（「０」なら終端）
+			uint8_t		num;
+			uint8_t		point;
+			uint8_t		bitlen;
+			bool		zerosupp;
+			bool		sign;
+			bool		error;		///< 書式エラー
+		};
+
+
+		constexpr bool is_type(char ch) {
+			return ch == 's' || ch == 'c' || ch == 'b' || ch == 'o' || ch == 'd' || ch == 'u'
+				|| ch == 'x' || ch == 'X' || ch == 'y' || ch == 'f' || ch == 'F'
+				|| ch == 'e' || ch == 'E' || ch == 'g' || ch == 'G';
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  idx 番目の変換指定を解析 @n
+					idx が変換数と同じ場合、末尾のリテラル（type = 0）を返す
+			@param[in]	form	フォーマット式
+			@param[in]	idx		変換指定の番号
+			@return 変換指定
+		*/
+		//-----------------------------------------------------------------//
+		constexpr spec_t scan(const char* form, uint32_t idx) {
+			uint32_t pos = 0;
+			uint32_t n = 0;
+			while(1) {
+				spec_t t { pos, pos, 0, 0, 0, 0, false, false, false };
+				// リテラル（「%%」を含む）
+				while(form[pos] != 0) {
+					if(form[pos] == '%') {
+						if(form[pos + 1] != '%') break;
+						++pos;
+					}
+					++pos;
+				}
+				t.end = pos;
+				if(form[pos] == 0) return t;
+				++pos;
+				// 変換指定
+				int md = 0;  // 0: 桁数、1: 小数部桁数、2: 小数部ビット数
+				while(1) {
+					char ch = form[pos];
+					if(ch == 0) {
+						t.error = true;
+						return t;
+					}
+					++pos;
+					if(ch == '+') {
+						t.sign = true;
+					} else if(ch >= '0' && ch <= '9') {
+						uint8_t v = ch - '0';
+						if(md == 0) {
+							if(t.num == 0 && v == 0) t.zerosupp = true;
+							t.num = t.num * 10 + v;
+						} else if(md == 1) {
+							t.point = t.point * 10 + v;
+						} else {
+							t.bitlen = t.bitlen * 10 + v;
+						}
+					} else if(ch == '.') {
+						md = 1;
+					} else if(ch == ':') {
+						md = 2;
+					} else if(ch == '-') {  // 無視する
+					} else if(is_type(ch)) {
+						t.type = ch;
+						break;
+					} else {
+						t.error = true;
+						return t;
+					}
+				}
+				if(n == idx) return t;
+				++n;
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  フォーマット式の検査
+			@param[in]	form	フォーマット式
+			@return 正常なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		constexpr bool check(const char* form) {
+			uint32_t i = 0;
+			while(1) {
+				auto t = scan(form, i);
+				if(t.error) return false;
+				if(t.type == 0) return true;
+				++i;
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  変換指定の数
+			@param[in]	form	フォーマット式
+			@return 変換指定の数
+		*/
+		//-----------------------------------------------------------------//
+		constexpr uint32_t count(const char* form) {
+			uint32_t i = 0;
+			while(scan(form, i).type != 0) ++i;
+			return i;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  変換文字と引数の型の検査
+			@param[in]	type	変換文字
+			@return 適合するなら「true」
+		*/
+		//-----------------------------------------------------------------//
+		template <typename T>
+		constexpr bool match(char type) {
+			return type == 's' ? (std::is_same<T, const char*>::value || std::is_same<T, char*>::value)
+				: type == 'c' ? (std::is_integral<T>::value && sizeof(T) == 1)
+				: (type == 'f' || type == 'F' || type == 'e' || type == 'E' || type == 'g' || type == 'G')
+					? std::is_floating_point<T>::value
+				: std::is_integral<T>::value;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  リテラルの出力（範囲内の「%」は、全て「%%」）
+		*/
+		//-----------------------------------------------------------------//
+		template <class CHAOUT>
+		inline void emit(CHAOUT& out, const char* form, uint32_t org, uint32_t end) noexcept {
+			while(org < end) {
+				char ch = form[org++];
+				out(ch);
+				if(ch == '%') ++org;
+			}
+		}
+	}
+
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  コンパイル時解析 format クラス @n
+				フォーマット式（文字列リテラル）をコンパイル時に解析し、@n
+				リテラルの出力と、型付きの変換だけを実行時に行う。@n
+				書式エラー、引数の型の不一致、引数の過多はコンパイル・エラーとなる。@n
+				引数の不足は、「%」の連鎖では検出出来ない（以降のリテラルが出力されない）@n
+				ので、直接使わず、引数の数も検査する UTILS_FORMAT、UTILS_SFORMAT マクロを使う。@n
+				Ex: UTILS_FORMAT("%d: %5.2:8y\n", idx, fixed);
+		@param[in]	CHAOUT	文字出力ファンクタ（basic_format と共有）
+		@param[in]	FMT		フォーマット式を返す型（static constexpr const char* str()）
+		@param[in]	IDX		次に変換する引数の番号
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <class CHAOUT, class FMT, uint32_t IDX>
+	class static_format {
+
+		static_assert(format_detail::check(FMT::str()), "utils::static_format: format string error");
+
+		template <class C, class F, uint32_t I> friend class static_format;
+
+		typedef basic_format<CHAOUT> base;
+
+		struct next_tag { };
+
+		explicit static_format(next_tag) noexcept { }
+
+		static void literal_() noexcept {
+			constexpr auto t = format_detail::scan(FMT::str(), IDX);
+			format_detail::emit(base::chaout(), FMT::str(), t.org, t.end);
+		}
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  コンストラクター
+		*/
+		//-----------------------------------------------------------------//
+		static_format() noexcept {
+			static_assert(IDX == 0, "utils::static_format: invalid construction");
+			literal_();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  コンストラクター
+			@param[in]	buff	文字バッファ
+			@param[in]	size	文字バッファサイズ
+			@param[in]	append	文字バッファに追加する場合「true」
+		*/
+		//-----------------------------------------------------------------//
+		static_format(char* buff, uint32_t size, bool append = false) noexcept {
+			static_assert(IDX == 0, "utils::static_format: invalid construction");
+			base::chaout().set(buff, size);
+			if(!append) {
+				base::chaout().clear();
+			}
+			literal_();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  デストラクター（format 文の終わり） @n
+					※一時オブジェクトは、文の終わりで全て破棄される
+		*/
+		//-----------------------------------------------------------------//
+		~static_format() noexcept
+		{
+			format_detail::format_end(base::chaout(), 0);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  出力ファンクタの参照
+			@return 出力ファンクタ
+		*/
+		//-----------------------------------------------------------------//
+		static CHAOUT& chaout() { return base::chaout(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  出力サイズを返す
+			@return 出力サイズ
+		*/
+		//-----------------------------------------------------------------//
+		int size() const noexcept { return base::chaout().size(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  オペレーター「%」
+			@param[in]	val	値
+			@return	次の引数用の format
+		*/
+		//-----------------------------------------------------------------//
+		template <typename T>
+		static_format<CHAOUT, FMT, IDX + 1> operator % (T val) noexcept
+		{
+			typedef static_format<CHAOUT, FMT, IDX + 1> next_type;
+			constexpr auto t = format_detail::scan(FMT::str(), IDX);
+			static_assert(t.type != 0, "utils::static_format: too many arguments");
+			static_assert(format_detail::match<T>(t.type), "utils::static_format: argument type mismatch");
+
+			base f(typename base::spec_tag(), t.type, t.num, t.point, t.bitlen, t.zerosupp, t.sign);
+			f.apply_(val);
+			next_type::literal_();
+			return next_type(typename next_type::next_tag());
+		}
+	};
+
+
+	template <class CHAOUT, class FMT>
+	inline static_format<CHAOUT, FMT, 0> make_static_format(FMT) noexcept
+	{
+		return static_format<CHAOUT, FMT, 0>();
+	}
+
+
+	template <class CHAOUT, class FMT>
+	inline static_format<CHAOUT, FMT, 0> make_static_format(FMT, char* buff, uint32_t size,
+		bool append = false) noexcept
+	{
+		return static_format<CHAOUT, FMT, 0>(buff, size, append);
+	}
+
+
+	namespace format_detail {
+
+		template <class SF>
+		inline void apply(SF&& f) noexcept { }
+
+
+		template <class SF, typename T, typename... Args>
+		inline void apply(SF&& f, T val, Args... args) noexcept
+		{
+			apply(f % val, args...);
+		}
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  static_format による出力（引数の数をコンパイル時に検査）
+		@param[in]	args	引数
+	*/
+	//-----------------------------------------------------------------//
+	template <class CHAOUT, class FMT, typename... Args>
+	inline void static_print(FMT, Args... args) noexcept
+	{
+		static_assert(format_detail::count(FMT::str()) == sizeof...(Args),
+			"utils::static_format: argument count mismatch");
+		format_detail::apply(static_format<CHAOUT, FMT, 0>(), args...);
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief  static_format によるメモリー出力（引数の数をコンパイル時に検査）
+		@param[in]	buff	文字バッファ
+		@param[in]	size	文字バッファサイズ
+		@param[in]	args	引数
+		@return 出力サイズ
+	*/
+	//-----------------------------------------------------------------//
+	template <class FMT, typename... Args>
+	inline int static_sprint(FMT, char* buff, uint32_t size, Args... args) noexcept
+	{
+		static_assert(format_detail::count(FMT::str()) == sizeof...(Args),
+			"utils::static_format: argument count mismatch");
+		format_detail::apply(static_format<memory_chaout, FMT, 0>(buff, size), args...);
+		return basic_format<memory_chaout>::chaout().size();
+	}
 }
+
+/// フォーマット式（文字列リテラル）を、型として static_format に渡す
+#define UTILS_FORMAT_STR_(form) \
+	[]() noexcept { struct fmt_ { static constexpr const char* str() noexcept { return form; } }; \
+		return fmt_(); }()
+
+/// 標準出力（utils::format のコンパイル時解析版）：UTILS_FORMAT(form, args...)
+#define UTILS_FORMAT(form, ...) \
+	utils::static_print<utils::stdout_buffer_chaout>(UTILS_FORMAT_STR_(form), ##__VA_ARGS__)
+
+/// メモリー出力（utils::sformat のコンパイル時解析版）：UTILS_SFORMAT(form, buff, size, args...) @n
+/// 出力サイズを返す
+#define UTILS_SFORMAT(form, buff, size, ...) \
+	utils::static_sprint(UTILS_FORMAT_STR_(form), buff, size, ##__VA_ARGS__)
+
+/// 任意の出力ファンクタ：UTILS_BASIC_FORMAT(CHAOUT, form, args...)
+#define UTILS_BASIC_FORMAT(CHAOUT, form, ...) \
+	utils::static_print<CHAOUT>(UTILS_FORMAT_STR_(form), ##__VA_ARGS__)
@@ -29,5 +29,35 @@ namespace utils {
 		}
 	};
 
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  null ロック（排他制御しない）
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	class null_lock {
+	public:
+		null_lock() noexcept { }
+	};
+
+
+#ifdef __RX__
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  割り込みロック @n
+				スコープの間、割り込みを禁止し、抜ける時に PSW を戻す。
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	class intr_lock {
+		uint32_t	psw_;
+	public:
+		intr_lock() noexcept {
+			asm volatile ("mvfc psw,%0\n\tclrpsw i" : "=r"(psw_) : : "memory");
+		}
+		~intr_lock() noexcept {
+			asm volatile ("mvtc %0,psw" : : "r"(psw_) : "memory", "cc");
+		}
+	};
+#endif
 }
 
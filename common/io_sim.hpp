@@ -0,0 +1,310 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	I/O レジスター・シミュレーター @n
+			IO_UTILS_SIM を定義してコンパイルすると、io_utils.hpp の @n
+			rd8_/wr8_ などのアクセスが、このレジスター・ファイルに向く。@n
+			ドライバーを、ホスト（Linux）でテスト、計測する為に使う。@n
+			・アドレス毎の読み出し、書き込みフック @n
+			・アドレス毎、全体のアクセス回数 @n
+			・領域毎のアクセス・サイクル（見積もり）の積算
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace device {
+
+	typedef uint32_t address_type;
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  I/O レジスター・シミュレーター・クラス
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	class io_sim {
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  読み出しフック @n
+					「cur」はレジスター・ファイルの値、戻り値が読み出し値となる
+		*/
+		//-----------------------------------------------------------------//
+		typedef std::function<uint32_t (address_type adr, uint32_t cur)> read_hook;
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  書き込みフック @n
+					「true」を返すと、値をレジスター・ファイルに格納する
+		*/
+		//-----------------------------------------------------------------//
+		typedef std::function<bool (address_type adr, uint32_t data)> write_hook;
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  アクセス回数
+		*/
+		//-----------------------------------------------------------------//
+		struct count_t {
+			uint32_t	read;	///< 読み出し回数
+			uint32_t	write;	///< 書き込み回数
+			uint64_t	cycle;	///< サイクル（見積もり）
+
+			count_t() noexcept : read(0), write(0), cycle(0) { }
+		};
+
+	private:
+		static const uint32_t PAGE = 4096;
+
+		struct page_t {
+			uint8_t	data[PAGE];
+			page_t() noexcept { std::memset(data, 0, sizeof(data)); }
+		};
+
+		struct hook_t {
+			read_hook	rd;
+			write_hook	wr;
+		};
+
+		struct region_t {
+			address_type	org;
+			address_type	end;
+			uint16_t		rd_cyc;
+			uint16_t		wr_cyc;
+		};
+
+		std::unordered_map<address_type, page_t>	page_;
+		std::unordered_map<address_type, hook_t>	hook_;
+		std::unordered_map<address_type, count_t>	count_;
+		std::vector<region_t>	region_;
+
+		count_t		total_;
+		bool		count_enable_;
+
+		uint8_t* byte_(address_type adr) noexcept {
+			return &page_[adr / PAGE].data[adr % PAGE];
+		}
+
+		uint32_t peek_(address_type adr, uint32_t width) noexcept {
+			uint32_t v = 0;
+			for(uint32_t i = 0; i < width; ++i) {  // リトル・エンディアン
+				v |= static_cast<uint32_t>(*byte_(adr + i)) << (i * 8);
+			}
+			return v;
+		}
+
+		void poke_(address_type adr, uint32_t v, uint32_t width) noexcept {
+			for(uint32_t i = 0; i < width; ++i) {
+				*byte_(adr + i) = v >> (i * 8);
+			}
+		}
+
+		uint32_t cycle_(address_type adr, bool wr) const noexcept {
+			// 後から登録した領域を優先
+			for(auto it = region_.rbegin(); it != region_.rend(); ++it) {
+				if(it->org <= adr && adr < it->end) return wr ? it->wr_cyc : it->rd_cyc;
+			}
+			return 1;
+		}
+
+		void add_count_(address_type adr, bool wr) noexcept {
+			if(!count_enable_) return;
+			auto c = cycle_(adr, wr);
+			auto& t = count_[adr];
+			if(wr) { ++t.write; ++total_.write; }
+			else { ++t.read; ++total_.read; }
+			t.cycle += c;
+			total_.cycle += c;
+		}
+
+		io_sim() noexcept : total_(), count_enable_(true) { }
+
+	public:
+		io_sim(const io_sim&) = delete;
+		io_sim& operator = (const io_sim&) = delete;
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  インスタンスを取得
+			@return インスタンス
+		*/
+		//-----------------------------------------------------------------//
+		static io_sim& get() noexcept {
+			static io_sim sim;
+			return sim;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  全てを初期状態にする（レジスター、フック、領域、回数）
+		*/
+		//-----------------------------------------------------------------//
+		void reset() noexcept
+		{
+			page_.clear();
+			hook_.clear();
+			region_.clear();
+			clear_count();
+			count_enable_ = true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  読み出し（レジスター・テンプレートから呼ばれる）
+			@param[in]	adr		アドレス
+			@param[in]	width	幅（バイト）
+			@return 読み出し値
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t read(address_type adr, uint32_t width) noexcept
+		{
+			add_count_(adr, false);
+			auto v = peek_(adr, width);
+			auto it = hook_.find(adr);
+			if(it != hook_.end() && it->second.rd) {
+				v = it->second.rd(adr, v);
+			}
+			return v;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  書き込み（レジスター・テンプレートから呼ばれる）
+			@param[in]	adr		アドレス
+			@param[in]	data	書き込み値
+			@param[in]	width	幅（バイト）
+		*/
+		//-----------------------------------------------------------------//
+		void write(address_type adr, uint32_t data, uint32_t width) noexcept
+		{
+			add_count_(adr, true);
+			auto it = hook_.find(adr);
+			if(it != hook_.end() && it->second.wr) {
+				if(!it->second.wr(adr, data)) return;
+			}
+			poke_(adr, data, width);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  レジスター・ファイルを直接読む（フック、回数は無関係）
+			@param[in]	adr		アドレス
+			@param[in]	width	幅（バイト）
+			@return 値
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t peek(address_type adr, uint32_t width = 1) noexcept { return peek_(adr, width); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  レジスター・ファイルに直接書く（フック、回数は無関係）@n
+					※フックの中から、ステータスを更新する場合などに使う
+			@param[in]	adr		アドレス
+			@param[in]	data	値
+			@param[in]	width	幅（バイト）
+		*/
+		//-----------------------------------------------------------------//
+		void poke(address_type adr, uint32_t data, uint32_t width = 1) noexcept { poke_(adr, data, width); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  読み出しフックを設定（nullptr で解除）
+			@param[in]	adr		アドレス
+			@param[in]	hook	フック
+		*/
+		//-----------------------------------------------------------------//
+		void set_read_hook(address_type adr, read_hook hook) noexcept { hook_[adr].rd = hook; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  書き込みフックを設定（nullptr で解除）
+			@param[in]	adr		アドレス
+			@param[in]	hook	フック
+		*/
+		//-----------------------------------------------------------------//
+		void set_write_hook(address_type adr, write_hook hook) noexcept { hook_[adr].wr = hook; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  領域のアクセス・サイクルを設定（未設定の領域は１サイクル）
+			@param[in]	org		開始アドレス
+			@param[in]	end		終了アドレス（含まない）
+			@param[in]	rd_cyc	読み出しサイクル
+			@param[in]	wr_cyc	書き込みサイクル
+		*/
+		//-----------------------------------------------------------------//
+		void set_cycle(address_type org, address_type end, uint16_t rd_cyc, uint16_t wr_cyc) noexcept
+		{
+			region_t t;
+			t.org = org;
+			t.end = end;
+			t.rd_cyc = rd_cyc;
+			t.wr_cyc = wr_cyc;
+			region_.push_back(t);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  アクセス回数の計測を許可、禁止
+			@param[in]	ena	「false」で禁止
+		*/
+		//-----------------------------------------------------------------//
+		void enable_count(bool ena = true) noexcept { count_enable_ = ena; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  アクセス回数をクリア
+		*/
+		//-----------------------------------------------------------------//
+		void clear_count() noexcept
+		{
+			count_.clear();
+			total_ = count_t();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  アクセス回数を取得
+			@param[in]	adr		アドレス
+			@return アクセス回数
+		*/
+		//-----------------------------------------------------------------//
+		count_t get_count(address_type adr) const noexcept
+		{
+			auto it = count_.find(adr);
+			if(it == count_.end()) return count_t();
+			return it->second;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  全体のアクセス回数を取得 @n
+					※処理の前後の差で、処理毎のアクセス回数が判る
+			@return アクセス回数
+		*/
+		//-----------------------------------------------------------------//
+		const count_t& get_total() const noexcept { return total_; }
+	};
+}
@@ -1,7 +1,8 @@
 #pragma once
 //=====================================================================//
 /*!	@file
-	@brief	I/O ユーティリティー
+	@brief	I/O ユーティリティー @n
+			IO_UTILS_SIM を定義すると、レジスター・アクセスは io_sim に向く
     @author 平松邦仁 (hira@rvf-rc45.net)
 	@copyright	Copyright (C) 2013, 2017 Kunihito Hiramatsu @n
 				Released under the MIT license @n
@@ -9,6 +10,9 @@
 */
 //=====================================================================//
 #include <cstdint>
+#ifdef IO_UTILS_SIM
+#include "common/io_sim.hpp"
+#endif
 
 namespace device {
 
@@ -22,7 +26,11 @@ namespace device {
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	inline void wr8_(address_type adr, uint8_t data) {
+#ifdef IO_UTILS_SIM
+		io_sim::get().write(adr, data, sizeof(data));
+#else
 		*reinterpret_cast<volatile uint8_t*>(adr) = data;
+#endif
 	}
 
 
@@ -34,7 +42,11 @@ namespace device {
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	inline uint8_t rd8_(address_type adr) {
+#ifdef IO_UTILS_SIM
+		return io_sim::get().read(adr, sizeof(uint8_t));
+#else
 		return *reinterpret_cast<volatile uint8_t*>(adr);
+#endif
 	}
 
 
@@ -46,7 +58,11 @@ namespace device {
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	inline void wr16_(address_type adr, uint16_t data) {
+#ifdef IO_UTILS_SIM
+		io_sim::get().write(adr, data, sizeof(data));
+#else
 		*reinterpret_cast<volatile uint16_t*>(adr) = data;
+#endif
 	}
 
 
@@ -58,7 +74,11 @@ namespace device {
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	inline uint16_t rd16_(address_type adr) {
+#ifdef IO_UTILS_SIM
+		return io_sim::get().read(adr, sizeof(uint16_t));
+#else
 		return *reinterpret_cast<volatile uint16_t*>(adr);
+#endif
 	}
 
 
@@ -70,7 +90,11 @@ namespace device {
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	inline void wr32_(address_type adr, uint32_t data) {
+#ifdef IO_UTILS_SIM
+		io_sim::get().write(adr, data, sizeof(data));
+#else
 		*reinterpret_cast<volatile uint32_t*>(adr) = data;
+#endif
 	}
 
 
@@ -82,7 +106,11 @@ namespace device {
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	inline uint32_t rd32_(address_type adr) {
+#ifdef IO_UTILS_SIM
+		return io_sim::get().read(adr, sizeof(uint32_t));
+#else
 		return *reinterpret_cast<volatile uint32_t*>(adr);
+#endif
 	}
 
 
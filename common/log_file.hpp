@@ -0,0 +1,315 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	リング・ログ・ファイル・クラス @n
+			・作成時に f_expand で連続した領域を確保し、以後は、セクター単位で @n
+			  disk_write により直接書き込む（FAT、ディレクトリーの更新が無い）@n
+			・領域の最後まで書くと先頭に戻るリング構造で、ファイル先頭の @n
+			  ヘッダー・セクターに、書き込み位置を持つ @n
+			・ヘッダーは、CHECK セクター毎、又は sync、close で更新する @n
+			  ※最後のチェックポイントより後のデータは、電源断で失われる事がある @n
+			・ファイル・サイズは、確保した大きさ（ヘッダー＋記録領域）で固定 @n
+			※ FATFS（_USE_EXPAND）が必要
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#ifndef FAT_FS
+#  error "log_file.hpp requires FAT_FS to be defined and include FATFS module"
+#endif
+
+#include <cstring>
+#include "ff12b/src/diskio.h"
+#include "ff12b/src/ff.h"
+
+#if _USE_EXPAND == 0
+#  error "log_file.hpp requires _USE_EXPAND (ff12b/src/ffconf.h)"
+#endif
+
+extern "C" {
+	int make_full_path(const char* src, char* dst, uint16_t dsz);
+	void utf8_to_sjis(const char* src, char* dst, uint32_t dsz);
+};
+
+namespace utils {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief	リング・ログ・ファイル・クラス
+		@param[in]	CHECK	ヘッダーを更新する間隔（セクター数）
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <uint32_t CHECK = 32>
+	class log_file {
+	public:
+		static const uint32_t SECTOR_SIZE = _MAX_SS;
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	ヘッダー（ファイルの先頭セクター）
+		*/
+		//-------------------------------------------------------------//
+		struct header_t {
+			static const uint32_t MAGIC = 0x474f4c52;	///< "RLOG"
+
+			uint32_t	magic;
+			uint32_t	num;	///< 記録領域のセクター数
+			uint32_t	head;	///< 書き込み中のセクター（記録領域の先頭から）
+			uint32_t	fill;	///< 書き込み中のセクターの有効バイト数
+			uint32_t	wrap;	///< 周回数
+			uint32_t	check;	///< ヘッダーの更新回数
+		};
+
+	private:
+		BYTE		drv_;
+		DWORD		base_;		///< ヘッダー・セクター（LBA）
+		header_t	head_;
+		uint32_t	count_;		///< 前回のヘッダー更新からのセクター数
+		bool		open_;
+
+		BYTE		buff_[SECTOR_SIZE];	///< 書き込み中のセクター
+		BYTE		hdr_[SECTOR_SIZE];
+
+		bool write_header_() noexcept
+		{
+			count_ = 0;
+			++head_.check;
+			std::memcpy(hdr_, &head_, sizeof(header_t));
+			return disk_write(drv_, hdr_, base_, 1) == RES_OK;
+		}
+
+		void set_base_(const FIL& fp) noexcept
+		{
+			const FATFS* fs = fp.obj.fs;
+			drv_ = fs->drv;
+			base_ = fs->database + (fp.obj.sclust - 2) * fs->csize;
+		}
+
+		bool resume_(FIL& fp, uint32_t num) noexcept
+		{
+			if(f_size(&fp) != static_cast<FSIZE_t>(num + 1) * SECTOR_SIZE) return false;
+#if _USE_FASTSEEK
+			DWORD tbl[4];  // 断片が一つなら収まる
+			tbl[0] = 4;
+			fp.cltbl = tbl;
+			auto ret = f_lseek(&fp, CREATE_LINKMAP);
+			fp.cltbl = nullptr;
+			if(ret != FR_OK) return false;
+#endif
+			set_base_(fp);
+			if(disk_read(drv_, hdr_, base_, 1) != RES_OK) return false;
+			std::memcpy(&head_, hdr_, sizeof(header_t));
+			if(head_.magic != header_t::MAGIC || head_.num != num || head_.head >= num
+				|| head_.fill >= SECTOR_SIZE) return false;
+			if(head_.fill > 0) {
+				if(disk_read(drv_, buff_, base_ + 1 + head_.head, 1) != RES_OK) return false;
+			}
+			count_ = 0;
+			return true;
+		}
+
+	public:
+		//-------------------------------------------------------------//
+		/*!
+			@brief	コンストラクター
+		*/
+		//-------------------------------------------------------------//
+		log_file() noexcept : drv_(0), base_(0), head_(), count_(0), open_(false) {
+			std::memset(hdr_, 0, sizeof(hdr_));
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	デストラクター
+		*/
+		//-------------------------------------------------------------//
+		~log_file() { close(); }
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	ログ・ファイルを開く @n
+					同じ大きさの有効なログ・ファイルがあれば、続きから書く。@n
+					無ければ、連続した領域を確保して、新規に作成する。
+			@param[in]	filename	ファイル名
+			@param[in]	size		記録領域の大きさ（バイト）
+			@return 成功なら「true」
+		*/
+		//-------------------------------------------------------------//
+		bool open(const char* filename, uint32_t size) noexcept
+		{
+			close();
+			if(filename == nullptr) return false;
+
+			uint32_t num = (size + SECTOR_SIZE - 1) / SECTOR_SIZE;
+			if(num == 0) return false;
+
+			char tmp[_MAX_LFN + 1];
+			if(!make_full_path(filename, tmp, sizeof(tmp))) {
+				return false;
+			}
+			utf8_to_sjis(tmp, tmp, sizeof(tmp));
+
+			FIL fp;
+			bool ok = false;
+			if(f_open(&fp, tmp, FA_READ | FA_WRITE | FA_OPEN_EXISTING) == FR_OK) {
+				ok = resume_(fp, num);
+				f_close(&fp);
+			}
+			if(!ok) {
+				if(f_open(&fp, tmp, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+					return false;
+				}
+				ok = f_expand(&fp, static_cast<FSIZE_t>(num + 1) * SECTOR_SIZE, 1) == FR_OK;
+				if(ok) set_base_(fp);
+				if(f_close(&fp) != FR_OK) ok = false;  // FAT とディレクトリーを確定
+				if(!ok) {  // 連続した空きが無い場合など
+					f_unlink(tmp);
+					return false;
+				}
+				std::memset(&head_, 0, sizeof(header_t));
+				head_.magic = header_t::MAGIC;
+				head_.num = num;
+				if(!write_header_()) return false;
+			}
+			open_ = true;
+			return true;
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	オープンの確認
+			@return オープンなら「true」
+		*/
+		//-------------------------------------------------------------//
+		bool is_open() const noexcept { return open_; }
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	ヘッダーを取得
+			@return ヘッダー
+		*/
+		//-------------------------------------------------------------//
+		const header_t& get_header() const noexcept { return head_; }
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	ライト @n
+					セクターが一杯になる毎に、そのセクターだけを書き込む。
+			@param[in]	src		ソース
+			@param[in]	len		書き込みサイズ
+			@return 書き込みサイズ
+		*/
+		//-------------------------------------------------------------//
+		uint32_t write(const void* src, uint32_t len) noexcept
+		{
+			if(!open_) return 0;
+
+			const BYTE* p = static_cast<const BYTE*>(src);
+			uint32_t n = 0;
+			while(n < len) {
+				uint32_t l = SECTOR_SIZE - head_.fill;
+				if(l > (len - n)) l = len - n;
+				std::memcpy(&buff_[head_.fill], p + n, l);
+				head_.fill += l;
+				if(head_.fill < SECTOR_SIZE) return len;
+
+				if(disk_write(drv_, buff_, base_ + 1 + head_.head, 1) != RES_OK) {
+					head_.fill -= l;
+					return n;
+				}
+				n += l;
+				head_.fill = 0;
+				++head_.head;
+				if(head_.head >= head_.num) {
+					head_.head = 0;
+					++head_.wrap;
+				}
+				++count_;
+				if(count_ >= CHECK) {
+					if(!write_header_()) return n;
+				}
+			}
+			return n;
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	書き込み中のセクターとヘッダーを書き込む（チェックポイント）
+			@return 成功なら「true」
+		*/
+		//-------------------------------------------------------------//
+		bool sync() noexcept
+		{
+			if(!open_) return false;
+
+			if(head_.fill > 0) {
+				std::memset(&buff_[head_.fill], 0, SECTOR_SIZE - head_.fill);
+				if(disk_write(drv_, buff_, base_ + 1 + head_.head, 1) != RES_OK) return false;
+			}
+			if(!write_header_()) return false;
+			return disk_ioctl(drv_, CTRL_SYNC, nullptr) == RES_OK;
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	ログ・ファイルを閉じる
+			@return 成功なら「true」
+		*/
+		//-------------------------------------------------------------//
+		bool close() noexcept
+		{
+			if(!open_) return false;
+			bool ret = sync();
+			open_ = false;
+			return ret;
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	記録されているセクター数（古い順に読める数） @n
+					※一周した後は、書き込み中のセクターの次が最も古い
+			@return セクター数（書き込み中のセクターを含む）
+		*/
+		//-------------------------------------------------------------//
+		uint32_t get_sectors() const noexcept
+		{
+			if(!open_) return 0;
+			uint32_t n = head_.wrap ? (head_.num - 1) : head_.head;
+			return head_.fill > 0 ? (n + 1) : n;
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	古い順にセクターを読み出す @n
+					※書き込み中のセクターは、有効バイト数以降が０
+			@param[in]	idx		インデックス（０が最も古い）
+			@param[out]	dst		読込先（SECTOR_SIZE バイト）
+			@return 成功なら「true」
+		*/
+		//-------------------------------------------------------------//
+		bool read_sector(uint32_t idx, void* dst) noexcept
+		{
+			if(idx >= get_sectors()) return false;
+
+			uint32_t org = head_.wrap ? (head_.head + 1) : 0;
+			uint32_t sec = (org + idx) % head_.num;
+			if(sec == head_.head) {
+				std::memcpy(dst, buff_, head_.fill);
+				std::memset(static_cast<BYTE*>(dst) + head_.fill, 0, SECTOR_SIZE - head_.fill);
+				return true;
+			}
+			return disk_read(drv_, static_cast<BYTE*>(dst), base_ + 1 + sec, 1) == RES_OK;
+		}
+	};
+}
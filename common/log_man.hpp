@@ -2,7 +2,11 @@
 //=====================================================================//
 /*!	@file
 	@brief	ログ・マネージャー・クラス @n
-			・バックアップ可能な、領域を使ったログメモリー
+			・バックアップ可能な、領域を使ったログメモリー @n
+			・BUFF を指定すると、RAM に溜めて、改行（又はバッファ一杯）毎に @n
+			  本文と管理領域を、まとめて書き込む @n
+			・バイナリー・レコード（タイムスタンプ、ID、ペイロード）の記録と、@n
+			  メモリー・イメージからの読み出し（log_reader、ホストでも使える）
     @author 平松邦仁 (hira@rvf-rc45.net)
 	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
 				Released under the MIT license @n
@@ -10,36 +14,102 @@
 */
 //=====================================================================//
 #include <cstdint>
+#include <cstring>
 
 namespace utils {
 
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  バイナリー・レコード @n
+				記録形式：SYNC(0xA5), LEN, ID(2), TIME(4), SUM, ペイロード(LEN) @n
+				SUM は、SUM 以外の全バイトの和の補数
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	struct log_record_t {
+		static const uint8_t SYNC = 0xA5;
+		static const uint32_t HEAD = 9;	///< ヘッダーのバイト数
+
+		uint32_t	time;		///< タイムスタンプ
+		uint16_t	id;			///< ID
+		uint8_t		len;		///< ペイロード長
+		uint8_t		data[255];	///< ペイロード
+
+		static uint8_t sum(const uint8_t* head, const void* src, uint32_t len) noexcept
+		{
+			uint8_t s = 0;
+			for(uint32_t i = 0; i < (HEAD - 1); ++i) s += head[i];
+			const uint8_t* p = static_cast<const uint8_t*>(src);
+			for(uint32_t i = 0; i < len; ++i) s += p[i];
+			return ~s;
+		}
+	};
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  ログ管理領域（MEMIO の先頭）
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	struct log_area_t {
+		static const uint32_t uniq_id = 0x1a3c5976;  // 初期化判定ユニークコード
+
+		uint32_t	id_;
+		uint16_t	pos_;
+		uint16_t	len_;
+	};
+
+
     //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
     /*!
         @brief  log_man クラス
 		@param[in]	MEMIO	メモリー入出力
+		@param[in]	BUFF	書き込みバッファのサイズ（０ならバッファしない）
     */
     //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	template <class MEMIO>
+	template <class MEMIO, uint32_t BUFF = 0>
 	class log_man {
+	public:
+		typedef log_area_t area_t;
 
-		static const uint32_t offset_ = 8;
-		static const uint32_t uniq_id_ = 0x1a3c5976;  // 初期化判定ユニークコード
+	private:
+		static const uint32_t uniq_id_ = area_t::uniq_id;
 
-		struct area_t {
-			uint32_t	id_;
-			uint16_t	pos_;
-			uint16_t	len_;
-		};
+		static const uint32_t limit_ = MEMIO::SIZE - sizeof(area_t);
 
 		area_t		area_;
 
+		char		buff_[BUFF > 0 ? BUFF : 1];
+		uint32_t	bpos_;
+
+		// 本文の書き込み（管理領域は更新しない）
+		void write_(const void* src, uint32_t len) noexcept
+		{
+			const uint8_t* p = static_cast<const uint8_t*>(src);
+			while(len > 0) {
+				uint32_t l = limit_ - area_.pos_;
+				if(l > len) l = len;
+				MEMIO::copy(p, l, sizeof(area_t) + area_.pos_);
+				area_.pos_ += l;
+				if(area_.pos_ >= limit_) area_.pos_ = 0;
+				uint32_t n = area_.len_ + l;
+				area_.len_ = n > limit_ ? limit_ : n;
+				p += l;
+				len -= l;
+			}
+		}
+
+		// 管理領域の書き込み（本文を書いた後で確定させる）
+		void commit_() noexcept
+		{
+			MEMIO::copy(&area_, sizeof(area_t), 0x0000);
+		}
+
 	public:
         //-----------------------------------------------------------------//
         /*!
             @brief  コンストラクター
         */
         //-----------------------------------------------------------------//
-		log_man() noexcept { }
+		log_man() noexcept : bpos_(0) { }
 
 
         //-----------------------------------------------------------------//
@@ -49,6 +119,7 @@ namespace utils {
         //-----------------------------------------------------------------//
 		void clear() noexcept
 		{
+			bpos_ = 0;
 			area_.id_ = uniq_id_;
 			area_.pos_ = 0;
 			area_.len_ = 0;
@@ -83,13 +154,77 @@ namespace utils {
         //-----------------------------------------------------------------//
 		void putch(char ch) noexcept
 		{
+			if(BUFF > 0) {
+				buff_[bpos_] = ch;
+				++bpos_;
+				if(ch == '\n' || bpos_ >= BUFF) flush();
+				return;
+			}
 			MEMIO::put8(sizeof(area_t) + area_.pos_, ch);
 			++area_.pos_;
-			uint16_t limit = MEMIO::SIZE - sizeof(area_t);
-			if(area_.pos_ >= limit) area_.pos_ = 0;
+			if(area_.pos_ >= limit_) area_.pos_ = 0;
 			++area_.len_;
-			if(area_.len_ > limit) area_.len_ = limit;
-			MEMIO::copy(&area_, sizeof(area_t), 0x0000);
+			if(area_.len_ > limit_) area_.len_ = limit_;
+			commit_();
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  バッファの書き出し（BUFF > 0 の場合）
+        */
+        //-----------------------------------------------------------------//
+		void flush() noexcept
+		{
+			if(bpos_ == 0) return;
+			write_(buff_, bpos_);
+			bpos_ = 0;
+			commit_();
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  データ列の追加（管理領域の書き込みは一回）
+			@param[in]	src	データ列
+			@param[in]	len	長さ
+        */
+        //-----------------------------------------------------------------//
+		void write(const void* src, uint32_t len) noexcept
+		{
+			if(src == nullptr || len == 0) return;
+			flush();
+			write_(src, len);
+			commit_();
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  バイナリー・レコードの追加
+			@param[in]	time	タイムスタンプ
+			@param[in]	id		ID
+			@param[in]	src		ペイロード
+			@param[in]	len		ペイロード長（最大２５５）
+        */
+        //-----------------------------------------------------------------//
+		void put_record(uint32_t time, uint16_t id, const void* src, uint8_t len) noexcept
+		{
+			if(src == nullptr) len = 0;
+			flush();
+			uint8_t h[log_record_t::HEAD];
+			h[0] = log_record_t::SYNC;
+			h[1] = len;
+			h[2] = id;
+			h[3] = id >> 8;
+			h[4] = time;
+			h[5] = time >> 8;
+			h[6] = time >> 16;
+			h[7] = time >> 24;
+			h[8] = log_record_t::sum(h, src, len);
+			write_(h, sizeof(h));
+			if(len > 0) write_(src, len);
+			commit_();
 		}
 
 
@@ -103,6 +238,11 @@ namespace utils {
 		{
 			if(s == nullptr) return;
 
+			if(BUFF == 0) {
+				write_(s, std::strlen(s));
+				commit_();
+				return;
+			}
 			char ch;
 			while((ch = *s) != 0) {
 				putch(ch);
@@ -120,6 +260,15 @@ namespace utils {
 		uint16_t get_length() const noexcept { return area_.len_; }
 
 
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  管理領域の取得
+			@return 管理領域
+        */
+        //-----------------------------------------------------------------//
+		const area_t& get_area() const noexcept { return area_; }
+
+
         //-----------------------------------------------------------------//
         /*!
             @brief  文字の取得
@@ -131,14 +280,95 @@ namespace utils {
 		{
 			if(area_.len_ == 0) return 0;
 
-			pos += area_.pos_ - area_.len_;
-			pos %= MEMIO::SIZE - sizeof(area_t);
+			uint32_t p = area_.pos_ + limit_ - area_.len_ + pos;
+			p %= limit_;
 			uint8_t data;
-			if(MEMIO::get8(pos + sizeof(area_t), data)) {
+			if(MEMIO::get8(p + sizeof(area_t), data)) {
 				return static_cast<char>(data);
 			} else {
 				return 0;
 			}
 		}
 	};
+
+
+    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+    /*!
+        @brief  log_reader クラス @n
+				log_man のメモリー・イメージ（管理領域を含む MEMIO 全体）から、@n
+				バイナリー・レコードを古い順に取り出す。@n
+				リングの先頭で切れたレコードや、テキストは読み飛ばす。
+    */
+    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	class log_reader {
+
+		const uint8_t*	ring_;
+		uint32_t		size_;
+		uint32_t		org_;
+		uint32_t		len_;
+		uint32_t		pos_;
+
+		uint8_t at_(uint32_t i) const noexcept { return ring_[(org_ + i) % size_]; }
+
+	public:
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  コンストラクター
+        */
+        //-----------------------------------------------------------------//
+		log_reader() noexcept : ring_(nullptr), size_(0), org_(0), len_(0), pos_(0) { }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  イメージを開く
+			@param[in]	image	メモリー・イメージ
+			@param[in]	size	イメージのサイズ（MEMIO::SIZE）
+			@return 有効なイメージなら「true」
+        */
+        //-----------------------------------------------------------------//
+		bool open(const void* image, uint32_t size) noexcept
+		{
+			if(image == nullptr || size <= sizeof(log_area_t)) return false;
+			log_area_t a;
+			std::memcpy(&a, image, sizeof(a));
+			size_ = size - sizeof(log_area_t);
+			if(a.id_ != log_area_t::uniq_id || a.pos_ >= size_ || a.len_ > size_) return false;
+			ring_ = static_cast<const uint8_t*>(image) + sizeof(log_area_t);
+			org_ = (a.pos_ + size_ - a.len_) % size_;
+			len_ = a.len_;
+			pos_ = 0;
+			return true;
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  次のレコードを取得
+			@param[out]	rec	レコード
+			@return レコードが無ければ「false」
+        */
+        //-----------------------------------------------------------------//
+		bool next(log_record_t& rec) noexcept
+		{
+			while((pos_ + log_record_t::HEAD) <= len_) {
+				uint8_t h[log_record_t::HEAD];
+				for(uint32_t i = 0; i < sizeof(h); ++i) h[i] = at_(pos_ + i);
+				uint32_t len = h[1];
+				if(h[0] == log_record_t::SYNC && (pos_ + sizeof(h) + len) <= len_) {
+					for(uint32_t i = 0; i < len; ++i) rec.data[i] = at_(pos_ + sizeof(h) + i);
+					if(log_record_t::sum(h, rec.data, len) == h[8]) {
+						rec.len = len;
+						rec.id = h[2] | (static_cast<uint16_t>(h[3]) << 8);
+						rec.time = h[4] | (static_cast<uint32_t>(h[5]) << 8)
+							| (static_cast<uint32_t>(h[6]) << 16) | (static_cast<uint32_t>(h[7]) << 24);
+						pos_ += sizeof(h) + len;
+						return true;
+					}
+				}
+				++pos_;
+			}
+			return false;
+		}
+	};
 }
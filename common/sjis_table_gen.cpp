@@ -0,0 +1,121 @@
+//=====================================================================//
+/*!	@file
+	@brief	Shift-JIS/UTF-16 変換テーブル生成（ホスト用） @n
+			FatFs の cc932.c（ff_convert）から、直接インデックスの @n
+			二段テーブル（ff12b/src/option/cc932_table.h）を生成する。@n
+			テーブルは、cc932t.c の ff_convert が引く。@n
+			ビルド： @n
+			  g++ -std=c++14 -I.. -o sjis_table_gen sjis_table_gen.cpp @n
+			  ./sjis_table_gen > ../ff12b/src/option/cc932_table.h
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdio>
+#include <vector>
+#include <map>
+#include "ff12b/src/option/cc932.c"
+
+namespace {
+
+	static const unsigned TRAIL_ORG = 0x40;		///< 二バイト目の開始
+	static const unsigned TRAIL_NUM = 0x100 - TRAIL_ORG;
+	static const unsigned UNI_SHIFT = 6;
+	static const unsigned UNI_NUM = 1 << UNI_SHIFT;
+
+	typedef std::vector<WCHAR> block;
+
+	// 同じブロックは共有（０番は全て０のブロック）
+	unsigned add_block_(std::vector<block>& blocks, std::map<block, unsigned>& idx, const block& b)
+	{
+		auto it = idx.find(b);
+		if(it != idx.end()) return it->second;
+		unsigned n = blocks.size();
+		blocks.push_back(b);
+		idx[b] = n;
+		return n;
+	}
+
+	void out_blocks_(const char* name, const std::vector<block>& blocks, unsigned num)
+	{
+		printf("static const WCHAR %s[%u][%u] = {\r\n",
+			name, static_cast<unsigned>(blocks.size()), num);
+		for(const auto& b : blocks) {
+			printf("\t{");
+			for(unsigned i = 0; i < b.size(); ++i) {
+				if((i % 16) == 0) printf("\r\n\t\t");
+				printf("0x%04X,", b[i]);
+			}
+			printf("\r\n\t},\r\n");
+		}
+		printf("};\r\n\r\n");
+	}
+}
+
+
+int main()
+{
+	// Shift-JIS -> UTF-16
+	std::vector<block> sblocks;
+	std::map<block, unsigned> sidx;
+	add_block_(sblocks, sidx, block(TRAIL_NUM, 0));
+	unsigned smap[256];
+	for(unsigned up = 0; up < 256; ++up) {
+		smap[up] = 0;
+		if(up < 0x81 || (0xa0 <= up && up <= 0xdf) || up > 0xfc) continue;
+		block b(TRAIL_NUM);
+		for(unsigned lo = 0; lo < TRAIL_NUM; ++lo) {
+			b[lo] = ff_convert((up << 8) | (lo + TRAIL_ORG), 1);
+		}
+		smap[up] = add_block_(sblocks, sidx, b);
+	}
+	// 一バイト（0x80 ～ 0xFF）
+	block single(128);
+	for(unsigned i = 0; i < 128; ++i) {
+		single[i] = ff_convert(0x80 + i, 1);
+	}
+
+	// UTF-16 -> Shift-JIS
+	std::vector<block> ublocks;
+	std::map<block, unsigned> uidx;
+	add_block_(ublocks, uidx, block(UNI_NUM, 0));
+	std::vector<unsigned> umap(0x10000 >> UNI_SHIFT);
+	for(unsigned i = 0; i < umap.size(); ++i) {
+		block b(UNI_NUM);
+		for(unsigned j = 0; j < UNI_NUM; ++j) {
+			b[j] = ff_convert((i << UNI_SHIFT) | j, 0);
+		}
+		umap[i] = add_block_(ublocks, uidx, b);
+	}
+
+	// FatFs の option と同じ CRLF で出力
+	printf("/*------------------------------------------------------------------------*/\r\n");
+	printf("/* CP932 (Japanese Shift-JIS) <-> Unicode direct-indexed tables           */\r\n");
+	printf("/* Generated by common/sjis_table_gen.cpp from cc932.c, do not edit.      */\r\n");
+	printf("/*------------------------------------------------------------------------*/\r\n\r\n");
+	printf("#define SJIS_TRAIL_ORG\t0x%02X\t/* First trail byte */\r\n", TRAIL_ORG);
+	printf("#define SJIS_UNI_SHIFT\t%u\t\t/* Bits of a Unicode block */\r\n\r\n", UNI_SHIFT);
+
+	printf("static const BYTE sjis_map[256] = {");
+	for(unsigned i = 0; i < 256; ++i) {
+		if((i % 16) == 0) printf("\r\n\t");
+		printf("%u,", smap[i]);
+	}
+	printf("\r\n};\r\n\r\n");
+	out_blocks_("sjis_block", sblocks, TRAIL_NUM);
+	printf("static const WCHAR sjis_single[128] = {");
+	for(unsigned i = 0; i < 128; ++i) {
+		if((i % 16) == 0) printf("\r\n\t");
+		printf("0x%04X,", single[i]);
+	}
+	printf("\r\n};\r\n\r\n");
+	printf("static const WCHAR uni_map[%u] = {", static_cast<unsigned>(umap.size()));
+	for(unsigned i = 0; i < umap.size(); ++i) {
+		if((i % 16) == 0) printf("\r\n\t");
+		printf("%u,", umap[i]);
+	}
+	printf("\r\n};\r\n\r\n");
+	out_blocks_("uni_block", ublocks, UNI_NUM);
+}
@@ -1,7 +1,9 @@
 #pragma once
 //=====================================================================//
 /*!	@file
-	@brief	文字列操作ユーティリティー
+	@brief	文字列操作ユーティリティー @n
+			Shift-JIS の変換は、FatFs の ff_convert（ff12b/src/option/cc932t.c の @n
+			二段テーブル）を使う
     @author 平松邦仁 (hira@rvf-rc45.net)
 	@copyright	Copyright (C) 2016, 2017 Kunihito Hiramatsu @n
 				Released under the MIT license @n
@@ -161,6 +163,60 @@ namespace utils {
 		}
 
 #if _USE_LFN != 0
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  sjis から UTF-16 への変換（１文字）
+			@param[in]	sjis	sjis コード（１バイト、又は２バイト）
+			@return UTF-16 コード（変換出来ない場合「０」）
+		*/
+		//-----------------------------------------------------------------//
+		static uint16_t sjis_to_utf16(uint16_t sjis) noexcept
+		{
+			return ff_convert(sjis, 1);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  UTF-16 から sjis への変換（１文字）
+			@param[in]	code	UTF-16 コード
+			@return sjis コード（変換出来ない場合「０」）
+		*/
+		//-----------------------------------------------------------------//
+		static uint16_t utf16_to_sjis(uint16_t code) noexcept
+		{
+			return ff_convert(code, 0);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  ASCII の連続をまとめてコピー @n
+					判定は１バイト毎（比較１回）、コピーは４バイト毎に行う。@n
+					※終端を越えて読まないように、ワード単位では読まない
+			@param[in]	src	ソース
+			@param[out]	dst	変換先
+			@param[in]	dsz	変換先のサイズ
+			@return コピーしたバイト数
+		*/
+		//-----------------------------------------------------------------//
+		static uint32_t copy_ascii_(const char* src, char* dst, uint32_t dsz) noexcept
+		{
+			// 0x01 ～ 0x7F の時だけ「true」
+			auto asc = [](char ch) { return static_cast<uint8_t>(ch - 1) < 0x7f; };
+			uint32_t n = 0;
+			while((n + 4) < dsz) {
+				if(!asc(src[n])) break;
+				if(!asc(src[n + 1])) { dst[n] = src[n]; return n + 1; }
+				if(!asc(src[n + 2])) { std::memcpy(dst + n, src + n, 2); return n + 2; }
+				if(!asc(src[n + 3])) { std::memcpy(dst + n, src + n, 3); return n + 3; }
+				std::memcpy(dst + n, src + n, 4);
+				n += 4;
+			}
+			return n;
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief  sjis から UTF-8 への変換
@@ -174,37 +230,28 @@ namespace utils {
 		{
 			if(src == nullptr) return false;
 
-			uint16_t wc = 0;
-			char ch;
-			while((ch = *src++) != 0 && dsz > 1) {
-				uint8_t c = static_cast<uint8_t>(ch);
-				if(wc) {
-					if(0x40 <= c && c <= 0x7e) {
-						wc <<= 8;
-						wc |= c;
-						auto len = utf16_to_utf8(ff_convert(wc, 1), dst, dsz);
-						if(len == 0) break;
-						dst += len;
-						dsz -= len;
-					} else if(0x80 <= c && c <= 0xfc) {
-						wc <<= 8;
-						wc |= c;
-						auto len = utf16_to_utf8(ff_convert(wc, 1), dst, dsz);
-						if(len == 0) break;
-						dst += len;
-						dsz -= len;
-					}
-					wc = 0;
+			while(dsz > 1) {
+				auto n = copy_ascii_(src, dst, dsz);
+				src += n;
+				dst += n;
+				dsz -= n;
+				if(dsz <= 1) break;
+				uint8_t c = static_cast<uint8_t>(*src++);
+				if(c == 0) break;
+				uint16_t code;
+				if((0x81 <= c && c <= 0x9f) || (0xe0 <= c && c <= 0xfc)) {
+					uint8_t lo = static_cast<uint8_t>(*src);
+					if(lo == 0) break;
+					++src;
+					code = sjis_to_utf16((static_cast<uint16_t>(c) << 8) | lo);
 				} else {
-					if(0x81 <= c && c <= 0x9f) wc = c;
-					else if(0xe0 <= c && c <= 0xfc) wc = c;
-					else {
-						auto len = utf16_to_utf8(ff_convert(c, 1), dst, dsz);
-						if(len == 0) break;
-						dst += len;
-						dsz -= len;
-					}
+					code = sjis_to_utf16(c);
 				}
+				if(code == 0) continue;  // 変換出来ない文字は無視
+				auto len = utf16_to_utf8(code, dst, dsz - 1);
+				if(len == 0) break;
+				dst += len;
+				dsz -= len;
 			}
 			*dst = 0;
 			return dsz > 0;
@@ -224,45 +271,131 @@ namespace utils {
 		{
 			int8_t cnt = 0;
 			uint16_t code = 0;
-			char tc;
-			while((tc = *src++) != 0) {
-				uint8_t c = static_cast<uint8_t>(tc);
-				if(c < 0x80) {
+			while(dsz > 1) {
+				if(cnt == 0) {
+					auto n = copy_ascii_(src, dst, dsz);
+					src += n;
+					dst += n;
+					dsz -= n;
 					if(dsz <= 1) break;
-					*dst++ = tc;
+				}
+				uint8_t c = static_cast<uint8_t>(*src++);
+				if(c == 0) break;
+				if(c < 0x80) {
+					*dst++ = c;
 					code = 0;
+					cnt = 0;
 					--dsz;
+					continue;
 				} else if((c & 0xf0) == 0xe0) {
 					code = (c & 0x0f);
 					cnt = 2;
+					continue;
 				} else if((c & 0xe0) == 0xc0) {
 					code = (c & 0x1f);
 					cnt = 1;
+					continue;
 				} else if((c & 0xc0) == 0x80) {
+					if(cnt <= 0) continue;
 					code <<= 6;
 					code |= c & 0x3f;
-					cnt--;
-					if(cnt == 0 && code < 0x80) {
-						code = 0;	// 不正なコードとして無視
-						break;
-					} else if(cnt < 0) {
-						code = 0;
-					}
+					--cnt;
+					if(cnt > 0) continue;
+					if(code < 0x80) break;	// 不正なコード
+				} else {
+					continue;
 				}
-				if(cnt == 0 && code != 0) {
-					if(dsz <= 3) break;
-					auto wc = ff_convert(code, 0);
+				auto wc = utf16_to_sjis(code);
+				code = 0;
+				if(wc == 0) continue;  // 変換出来ない文字は無視
+				if(wc < 0x100) {  // 半角カナ
+					*dst++ = static_cast<char>(wc);
+					--dsz;
+				} else {
+					if(dsz <= 2) break;
 					*dst++ = static_cast<char>(wc >> 8);
 					*dst++ = static_cast<char>(wc & 0xff);
 					dsz -= 2;
-					code = 0;
-				}			
+				}
+			}
+			*dst = 0;
+			return dsz > 0;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  sjis から UTF-16 への変換
+			@param[in]	src	ソース
+			@param[out]	dst	変換先
+			@param[in]	dsz	変換先のサイズ（バイトサイズ）
+			@return 正常終了なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		static bool sjis_to_utf16(const char* src, WCHAR* dst, uint32_t dsz)
+		{
+			uint32_t len = dsz / 2;
+			if(src == nullptr || len == 0) return false;
+
+			while(len > 1) {
+				uint8_t c = static_cast<uint8_t>(*src++);
+				if(c == 0) break;
+				if(c < 0x80) {
+					*dst++ = c;
+					--len;
+					continue;
+				}
+				uint16_t code;
+				if((0x81 <= c && c <= 0x9f) || (0xe0 <= c && c <= 0xfc)) {
+					uint8_t lo = static_cast<uint8_t>(*src);
+					if(lo == 0) break;
+					++src;
+					code = sjis_to_utf16((static_cast<uint16_t>(c) << 8) | lo);
+				} else {
+					code = sjis_to_utf16(c);
+				}
+				if(code == 0) continue;
+				*dst++ = code;
+				--len;
+			}
+			*dst = 0;
+			return len >= 1;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  UTF-16 から sjis への変換
+			@param[in]	src	ソース
+			@param[out]	dst	変換先
+			@param[in]	dsz	変換先のサイズ
+			@return 正常終了なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		static bool utf16_to_sjis(const WCHAR* src, char* dst, uint32_t dsz)
+		{
+			if(src == nullptr || dsz == 0) return false;
+
+			uint16_t code;
+			while(dsz > 1 && (code = static_cast<uint16_t>(*src++)) != 0) {
+				auto wc = utf16_to_sjis(code);
+				if(wc == 0) continue;
+				if(wc < 0x100) {
+					*dst++ = static_cast<char>(wc);
+					--dsz;
+				} else {
+					if(dsz <= 2) break;
+					*dst++ = static_cast<char>(wc >> 8);
+					*dst++ = static_cast<char>(wc & 0xff);
+					dsz -= 2;
+				}
 			}
 			*dst = 0;
 			return dsz > 0;
 		}
 #endif
 
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	FatFS が使う時間取得関数
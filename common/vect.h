@@ -10,7 +10,12 @@
 //=====================================================================//
 #include <stdint.h>
 
+#ifdef IO_UTILS_SIM
+// ホスト・シミュレーションでは、通常の関数として扱う
+#define INTERRUPT_FUNC
+#else
 #define INTERRUPT_FUNC __attribute__ ((interrupt))
+#endif
 
 #ifdef __cplusplus
 extern "C" {
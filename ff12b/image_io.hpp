@@ -0,0 +1,334 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	ディスク・イメージ FatFS ドライバー（ホスト用） @n
+			FAT イメージ・ファイルを、mmc_io/sdhi_io と同じ diskio API で扱い、@n
+			sdc_man、file_io などを、ホスト（Linux）で動かす為に使う。@n
+			・SD カードの遅延（コマンド、セクター転送、シングル／マルチ・ブロック）を積算 @n
+			・セクターの読み出し、書き込み回数を計測
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdio>
+#include <cstdint>
+#ifndef _WIN32
+#include <sys/types.h>
+#endif
+#include "ff12b/src/diskio.h"
+#include "ff12b/src/ff.h"
+
+namespace fatfs {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  ディスク・イメージ・クラス
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	class image_io {
+	public:
+		static const uint32_t SECTOR_SIZE = 512;
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  遅延モデル（マイクロ秒） @n
+					※初期値は、SPI 25MHz 程度の SD カードを想定
+		*/
+		//-----------------------------------------------------------------//
+		struct timing_t {
+			uint32_t	cmd_us;			///< コマンド／レスポンス
+			uint32_t	access_us;		///< 読み出し、最初のブロックまでの待ち
+			uint32_t	next_us;		///< マルチ・ブロック読み出し、次のブロックまでの待ち
+			uint32_t	xfer_us;		///< １セクターの転送
+			uint32_t	busy_us;		///< 書き込みの完了待ち（シングル、又は、マルチの最後）
+			uint32_t	multi_busy_us;	///< マルチ・ブロック書き込み、１ブロック毎の完了待ち
+
+			timing_t() noexcept : cmd_us(20), access_us(100), next_us(10), xfer_us(170),
+				busy_us(800), multi_busy_us(150) { }
+		};
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  統計
+		*/
+		//-----------------------------------------------------------------//
+		struct stat_t {
+			uint32_t	read_cmd;		///< 読み出しコマンド数（disk_read の呼び出し）
+			uint32_t	write_cmd;		///< 書き込みコマンド数（disk_write の呼び出し）
+			uint32_t	read_sector;	///< 読み出しセクター数
+			uint32_t	write_sector;	///< 書き込みセクター数
+			uint64_t	time_us;		///< 積算時間（マイクロ秒）
+
+			stat_t() noexcept : read_cmd(0), write_cmd(0), read_sector(0), write_sector(0),
+				time_us(0) { }
+		};
+
+	private:
+		FATFS		fatfs_;
+		std::FILE*	fp_;
+		uint32_t	sectors_;
+		DSTATUS		stat_;
+		bool		mount_;
+
+		timing_t	timing_;
+		stat_t		count_;
+
+		// long は、MinGW などでは 32 ビットなので、2G バイトを越えるイメージは
+		// 64 ビットのオフセットで扱う（32 ビットの Linux では _FILE_OFFSET_BITS=64 が必要）
+		static bool fseek_(std::FILE* fp, uint64_t ofs, int org) noexcept
+		{
+#ifdef _WIN32
+			return _fseeki64(fp, static_cast<__int64>(ofs), org) == 0;
+#else
+			return fseeko(fp, static_cast<off_t>(ofs), org) == 0;
+#endif
+		}
+
+		static uint64_t ftell_(std::FILE* fp) noexcept
+		{
+#ifdef _WIN32
+			auto pos = _ftelli64(fp);
+#else
+			auto pos = ftello(fp);
+#endif
+			return pos < 0 ? 0 : static_cast<uint64_t>(pos);
+		}
+
+		bool seek_(DWORD sector, UINT count) noexcept
+		{
+			// sector + count は、桁あふれするので、引き算で比較する
+			if(fp_ == nullptr || sector > sectors_ || count > (sectors_ - sector)) return false;
+			return fseek_(fp_, static_cast<uint64_t>(sector) * SECTOR_SIZE, SEEK_SET);
+		}
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	コンストラクター
+		 */
+		//-----------------------------------------------------------------//
+		image_io() noexcept : fatfs_(), fp_(nullptr), sectors_(0), stat_(STA_NOINIT),
+			mount_(false) { }
+
+
+		~image_io() { close(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	イメージ・ファイルを開く
+			@param[in]	path	イメージ・ファイル
+			@param[in]	wr		書き込みを許可する場合「true」
+			@return 成功なら「true」
+		 */
+		//-----------------------------------------------------------------//
+		bool open(const char* path, bool wr = true) noexcept
+		{
+			close();
+			fp_ = std::fopen(path, wr ? "r+b" : "rb");
+			if(fp_ == nullptr) return false;
+			fseek_(fp_, 0, SEEK_END);
+			sectors_ = ftell_(fp_) / SECTOR_SIZE;
+			stat_ = wr ? 0 : STA_PROTECT;
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	イメージ・ファイルを閉じる（アンマウント）
+		 */
+		//-----------------------------------------------------------------//
+		void close() noexcept
+		{
+			if(mount_) {
+				f_mount(nullptr, "", 0);
+				mount_ = false;
+			}
+			if(fp_ != nullptr) {
+				std::fclose(fp_);
+				fp_ = nullptr;
+			}
+			sectors_ = 0;
+			stat_ = STA_NOINIT;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	遅延モデルの参照
+			@return 遅延モデル
+		 */
+		//-----------------------------------------------------------------//
+		timing_t& at_timing() noexcept { return timing_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	統計を取得
+			@return 統計
+		 */
+		//-----------------------------------------------------------------//
+		const stat_t& get_stat() const noexcept { return count_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	統計をクリア
+		 */
+		//-----------------------------------------------------------------//
+		void clear_stat() noexcept { count_ = stat_t(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ステータス
+			@param[in]	drv		Physical drive nmuber (0)
+		 */
+		//-----------------------------------------------------------------//
+		DSTATUS disk_status(BYTE drv) const noexcept
+		{
+			if(drv) return STA_NOINIT;
+			return stat_;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	初期化
+			@param[in]	drv		Physical drive nmuber (0)
+			@return ステータス
+		 */
+		//-----------------------------------------------------------------//
+		DSTATUS disk_initialize(BYTE drv) noexcept
+		{
+			if(drv) return STA_NOINIT;
+			return stat_;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	リード・セクター
+			@param[in]	drv		Physical drive nmuber (0)
+			@param[out]	buff	Pointer to the data buffer to store read data
+			@param[in]	sector	Start sector number (LBA)
+			@param[in]	count	Sector count (1..128)
+			@return リザルト
+		 */
+		//-----------------------------------------------------------------//
+		DRESULT disk_read(BYTE drv, BYTE* buff, DWORD sector, UINT count) noexcept
+		{
+			if(disk_status(drv) & STA_NOINIT) return RES_NOTRDY;
+			if(count == 0) return RES_PARERR;
+			if(!seek_(sector, count)) return RES_ERROR;
+			if(std::fread(buff, SECTOR_SIZE, count, fp_) != count) return RES_ERROR;
+
+			++count_.read_cmd;
+			count_.read_sector += count;
+			// CMD17/CMD18 + 最初のブロック + 後続ブロック（+ CMD12）
+			count_.time_us += timing_.cmd_us + timing_.access_us + timing_.xfer_us;
+			if(count > 1) {
+				count_.time_us += (count - 1) * (timing_.next_us + timing_.xfer_us) + timing_.cmd_us;
+			}
+			return RES_OK;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ライト・セクター
+			@param[in]	drv		Physical drive nmuber (0)
+			@param[in]	buff	Pointer to the data to be written
+			@param[in]	sector	Start sector number (LBA)
+			@param[in]	count	Sector count (1..128)
+			@return リザルト
+		 */
+		//-----------------------------------------------------------------//
+		DRESULT disk_write(BYTE drv, const BYTE* buff, DWORD sector, UINT count) noexcept
+		{
+			if(disk_status(drv) & STA_NOINIT) return RES_NOTRDY;
+			if(disk_status(drv) & STA_PROTECT) return RES_WRPRT;
+			if(count == 0) return RES_PARERR;
+			if(!seek_(sector, count)) return RES_ERROR;
+			if(std::fwrite(buff, SECTOR_SIZE, count, fp_) != count) return RES_ERROR;
+
+			++count_.write_cmd;
+			count_.write_sector += count;
+			if(count == 1) {  // CMD24
+				count_.time_us += timing_.cmd_us + timing_.xfer_us + timing_.busy_us;
+			} else {  // ACMD23 + CMD25 + ブロック毎 + STOP_TRAN
+				count_.time_us += timing_.cmd_us * 2 + count * (timing_.xfer_us + timing_.multi_busy_us)
+					+ timing_.busy_us;
+			}
+			return RES_OK;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	I/O コントロール
+			@param[in]	drv		Physical drive nmuber (0)
+			@param[in]	ctrl	Control code
+			@param[in]	buff	Buffer to send/receive control data
+			@return リザルト
+		 */
+		//-----------------------------------------------------------------//
+		DRESULT disk_ioctl(BYTE drv, BYTE ctrl, void* buff) noexcept
+		{
+			if(disk_status(drv) & STA_NOINIT) return RES_NOTRDY;
+
+			DRESULT res = RES_ERROR;
+			switch(ctrl) {
+			case CTRL_SYNC:
+				if(std::fflush(fp_) == 0) res = RES_OK;
+				break;
+
+			case GET_SECTOR_COUNT:
+				*static_cast<DWORD*>(buff) = sectors_;
+				res = RES_OK;
+				break;
+
+			case GET_SECTOR_SIZE:
+				*static_cast<WORD*>(buff) = SECTOR_SIZE;
+				res = RES_OK;
+				break;
+
+			case GET_BLOCK_SIZE:
+				*static_cast<DWORD*>(buff) = 128;
+				res = RES_OK;
+				break;
+
+			default:
+				res = RES_PARERR;
+				break;
+			}
+			return res;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	サービス @n
+					※イメージが開かれていれば、最初の呼び出しでマウントする
+			@return マウントされていれば「true」
+		 */
+		//-----------------------------------------------------------------//
+		bool service() noexcept
+		{
+			if(fp_ != nullptr && !mount_) {
+				auto st = f_mount(&fatfs_, "", 1);
+				if(st == FR_OK) {
+					mount_ = true;
+				} else {
+					std::fprintf(stderr, "f_mount NG: %d\n", static_cast<int>(st));
+					close();
+				}
+			}
+			return mount_;
+		}
+	};
+}
@@ -1,7 +1,9 @@
 #pragma once
 //=====================================================================//
 /*!	@file
-	@brief	MMC（SD カード）FatFS ドライバー
+	@brief	MMC（SD カード）FatFS ドライバー @n
+			STREAM を「true」にすると、CMD18 を開いたままにして、連続した読み出しを @n
+			コマンド無しで継続する（ストリーム・モード、先読みバッファは持たない）。
     @author 平松邦仁 (hira@rvf-rc45.net)
 	@copyright	Copyright (C) 2016, 2017 Kunihito Hiramatsu @n
 				Released under the MIT license @n
@@ -24,9 +26,10 @@ namespace fatfs {
 		@param[in]	SEL	デバイス選択クラス
 		@param[in]	POW	電源操作クラス
 		@param[in]	CDT	カード検出クラス
+		@param[in]	STREAM	ストリーム・モードを使う場合「true」
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	template <class SPI, class SEL, class POW, class CDT>
+	template <class SPI, class SEL, class POW, class CDT, bool STREAM = false>
 	class mmc_io {
 
 		// MMC card type flags (MMC_GET_TYPE)
@@ -51,6 +54,10 @@ namespace fatfs {
 		bool		mount_;
 		bool		init_port_;
 
+		bool		stream_open_;	///< CMD18 を開いている
+		DWORD		stream_next_;	///< ストリームの次のセクター（閉じた後も保持）
+		DWORD		last_end_;		///< 前回の読み出しの次のセクター
+
 		// MMC/SD command (SPI mode)
 		enum class command : uint8_t {
 			CMD0 = 0,			/* GO_IDLE_STATE */
@@ -207,6 +214,13 @@ namespace fatfs {
 			return d;			/* Return with the response value */
 		}
 
+		void stop_stream_() {
+			if(!stream_open_) return;
+			send_cmd_(command::CMD12, 0);	/* STOP_TRANSMISSION */
+			deselect_();
+			stream_open_ = false;
+		}
+
 		void start_spi_(bool fast)
 		{
 			uint32_t speed;
@@ -232,7 +246,8 @@ namespace fatfs {
 		mmc_io(SPI& spi, uint32_t limitc) noexcept :
 			spi_(spi), limitc_(limitc), Stat_(STA_NOINIT), CardType_(0),
 			select_wait_(0), mount_delay_(0), cd_(false), mount_(false),
-			init_port_(false) { }
+			init_port_(false), stream_open_(false), stream_next_(0xffffffff),
+			last_end_(0xffffffff) { }
 
 
 		//-----------------------------------------------------------------//
@@ -299,6 +314,10 @@ namespace fatfs {
 		{
 			if (drv) return RES_NOTRDY;
 
+			stream_open_ = false;
+			stream_next_ = 0xffffffff;
+			last_end_ = 0xffffffff;
+
 			SEL::P = 1;
 			SEL::PU = 0;
 
@@ -362,6 +381,62 @@ namespace fatfs {
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ストリーム・リード @n
+					CMD18 を開いたまま読み、次の読み出しが続きなら、コマンド無しで継続する。@n
+					単発の１セクターは CMD17、前回、又は、閉じたストリームの続きは CMD18 で読む。@n
+					※ストリーム中は、カードを選択したままになる（stop_stream で閉じる）
+			@param[out]	buff	読み込み先
+			@param[in]	sector	開始セクター（LBA）
+			@param[in]	count	セクター数
+			@return 成功なら「true」
+		 */
+		//-----------------------------------------------------------------//
+		bool stream_read(BYTE* buff, DWORD sector, UINT count) noexcept
+		{
+			if (Stat_ & STA_NOINIT) return false;
+
+			if (count == 0) return false;
+			/* FAT などの参照で閉じても、続きなら CMD18 で開き直す */
+			bool seq = sector == last_end_ || sector == stream_next_;
+			last_end_ = sector + count;
+
+			if (!stream_open_ || sector != stream_next_) {
+				stop_stream_();
+				DWORD adr = (CardType_ & CT_BLOCK) ? sector : sector * 512;
+				if (!seq && count == 1) {	/* 単発の読み出しは、ストリームを開かない */
+					bool ok = send_cmd_(command::CMD17, adr) == 0 && rcvr_datablock_(buff, 512);
+					deselect_();
+					return ok;
+				}
+				if (send_cmd_(command::CMD18, adr) != 0) {	/* READ_MULTIPLE_BLOCK */
+					deselect_();
+					return false;
+				}
+				stream_open_ = true;
+				stream_next_ = sector;
+			}
+			do {
+				if (!rcvr_datablock_(buff, 512)) {
+					stop_stream_();
+					return false;
+				}
+				buff += 512;
+				++stream_next_;
+			} while (--count) ;
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ストリームを閉じる（カードの選択を解除）
+		 */
+		//-----------------------------------------------------------------//
+		void stop_stream() noexcept { stop_stream_(); }
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	リード・セクター
@@ -375,6 +450,7 @@ namespace fatfs {
 		DRESULT disk_read(BYTE drv, BYTE* buff, DWORD sector, UINT count) noexcept
 		{
 			if (disk_status(drv) & STA_NOINIT) return RES_NOTRDY;
+			if (STREAM) return stream_read(buff, sector, count) ? RES_OK : RES_ERROR;
 			if (!(CardType_ & CT_BLOCK)) sector *= 512;	/* Convert LBA to byte address if needed */
 
 			/*  READ_MULTIPLE_BLOCK : READ_SINGLE_BLOCK */
@@ -405,6 +481,9 @@ namespace fatfs {
 		DRESULT disk_write(BYTE drv, const BYTE* buff, DWORD sector, UINT count) noexcept
 		{
 			if (disk_status(drv) & STA_NOINIT) return RES_NOTRDY;
+			stop_stream_();
+			stream_next_ = 0xffffffff;
+			last_end_ = 0xffffffff;
 			if (!(CardType_ & CT_BLOCK)) sector *= 512;	/* Convert LBA to byte address if needed */
 
 			if (count == 1) {	/* Single block write */
@@ -442,6 +521,7 @@ namespace fatfs {
 		DRESULT disk_ioctl(BYTE drv, BYTE ctrl, void* buff) noexcept
 		{
 			if (disk_status(drv) & STA_NOINIT) return RES_NOTRDY;	/* Check if card is in the socket */
+			stop_stream_();
 
 			DRESULT res = RES_ERROR;
 			switch (ctrl) {
@@ -512,6 +592,8 @@ namespace fatfs {
 				}
 //				utils::format("Card ditect\n");
 			} else if(cd_ && select_wait_ == 0) {
+				stream_open_ = false;
+				stream_next_ = 0xffffffff;
 				f_mount(&fatfs_, "", 0);
 				spi_.destroy();
 				if(POW::BIT_POS < 32) {
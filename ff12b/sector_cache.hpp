@@ -0,0 +1,416 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	セクター・キャッシュ（FatFS diskio 用） @n
+			mmc_io、sdhi_io、image_io などの前に置き、セクターを LRU でキャッシュする。@n
+			・FAT 領域（FAT12/16 では、ルート・ディレクトリを含む）は、専用スロット @n
+			  （ピン）に置き、ファイル・データの読み出しで追い出されないようにする @n
+			  ※FAT32 のルート、サブ・ディレクトリは、データ領域にあるので、@n
+			  ファイル・データと同じ LRU で扱う @n
+			・セクターの検索は、ハッシュ（NUM 以上の２のＮ乗のバケット）で行う @n
+			・書き込みはライト・バック（CTRL_SYNC、sync() で書き出す）@n
+			・マルチ・セクターの読み書き（ストリーム）はキャッシュを通さない @n
+			使い方： @n
+			  typedef fatfs::sector_cache<MMC, 16> CACHE; @n
+			  CACHE cache_(mmc_); @n
+			  DRESULT disk_read(...) { return cache_.disk_read(drv, buff, sector, count); }
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdint>
+#include <cstring>
+#include "ff12b/src/diskio.h"
+#include "ff12b/src/ff.h"
+
+namespace fatfs {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  セクター・キャッシュ・テンプレートクラス
+		@param[in]	IO		ディスク I/O クラス（disk_read などを持つ）
+		@param[in]	NUM		キャッシュするセクター数（１セクター 512 バイト）
+		@param[in]	PIN		NUM の内、FAT（+FAT12/16 のルート・ディレクトリ）専用のセクター数
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <class IO, uint32_t NUM, uint32_t PIN = NUM / 4>
+	class sector_cache {
+
+		static_assert(NUM >= 2 && NUM < 0xffff, "sector_cache NUM out of range");
+		static_assert(PIN < NUM, "sector_cache PIN must be less than NUM");
+
+		static const uint32_t SECTOR_SIZE = 512;
+		static const uint16_t NIL = 0xffff;
+		static const DWORD NONE = 0xffffffff;
+
+		// ハッシュのバケット数（NUM 以上の２のＮ乗）
+		static const uint32_t HASH = NUM <= 16 ? 16 : NUM <= 64 ? 64 : NUM <= 256 ? 256
+			: NUM <= 1024 ? 1024 : NUM <= 4096 ? 4096 : NUM <= 16384 ? 16384 : 65536;
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  統計
+		*/
+		//-----------------------------------------------------------------//
+		struct stat_t {
+			uint32_t	hit;		///< ヒット（セクター数）
+			uint32_t	miss;		///< ミス（セクター数）
+			uint32_t	meta_hit;	///< FAT（+FAT12/16 のルート・ディレクトリ）のヒット
+			uint32_t	bypass;		///< キャッシュを通さないセクター数
+			uint32_t	write_back;	///< 書き戻したセクター数
+
+			stat_t() noexcept : hit(0), miss(0), meta_hit(0), bypass(0), write_back(0) { }
+		};
+
+	private:
+		struct slot_t {
+			DWORD		sector;
+			uint16_t	prev;
+			uint16_t	next;
+			uint16_t	link;	///< ハッシュの次
+			bool		dirty;
+		};
+
+		// LRU リスト（head: 最近、tail: 最も古い）
+		struct list_t {
+			uint16_t	head;
+			uint16_t	tail;
+		};
+
+		IO&			io_;
+
+		alignas(4) BYTE	buff_[NUM][SECTOR_SIZE];
+		slot_t		slot_[NUM];
+		list_t		list_[2];	///< 0: データ、1: FAT（+FAT12/16 のルート・ディレクトリ）
+		uint16_t	hash_[HASH];
+
+		DWORD		meta_org_;
+		DWORD		meta_end_;
+
+		stat_t		stat_;
+
+		static uint32_t group_(uint16_t idx) noexcept { return idx < PIN ? 1 : 0; }
+
+		bool meta_(DWORD sector) const noexcept {
+			return PIN > 0 && meta_org_ <= sector && sector < meta_end_;
+		}
+
+		void unlink_(uint16_t idx) noexcept
+		{
+			auto& l = list_[group_(idx)];
+			auto& s = slot_[idx];
+			if(s.prev != NIL) slot_[s.prev].next = s.next;
+			else l.head = s.next;
+			if(s.next != NIL) slot_[s.next].prev = s.prev;
+			else l.tail = s.prev;
+		}
+
+		void push_front_(uint16_t idx) noexcept
+		{
+			auto& l = list_[group_(idx)];
+			auto& s = slot_[idx];
+			s.prev = NIL;
+			s.next = l.head;
+			if(l.head != NIL) slot_[l.head].prev = idx;
+			l.head = idx;
+			if(l.tail == NIL) l.tail = idx;
+		}
+
+		void touch_(uint16_t idx) noexcept
+		{
+			if(list_[group_(idx)].head == idx) return;
+			unlink_(idx);
+			push_front_(idx);
+		}
+
+		uint16_t find_(DWORD sector) const noexcept
+		{
+			for(auto i = hash_[sector & (HASH - 1)]; i != NIL; i = slot_[i].link) {
+				if(slot_[i].sector == sector) return i;
+			}
+			return NIL;
+		}
+
+		// スロットのセクターを変え、ハッシュを付け替える
+		void assign_(uint16_t idx, DWORD sector) noexcept
+		{
+			auto& s = slot_[idx];
+			if(s.sector != NONE) {
+				auto* p = &hash_[s.sector & (HASH - 1)];
+				while(*p != idx) p = &slot_[*p].link;
+				*p = s.link;
+			}
+			s.sector = sector;
+			if(sector != NONE) {
+				auto& h = hash_[sector & (HASH - 1)];
+				s.link = h;
+				h = idx;
+			}
+		}
+
+		bool flush_(uint16_t idx) noexcept
+		{
+			auto& s = slot_[idx];
+			if(!s.dirty) return true;
+			if(io_.disk_write(0, buff_[idx], s.sector, 1) != RES_OK) return false;
+			s.dirty = false;
+			++stat_.write_back;
+			return true;
+		}
+
+		// 最も古いスロットを空けて返す
+		uint16_t evict_(DWORD sector) noexcept
+		{
+			auto idx = list_[meta_(sector) ? 1 : 0].tail;
+			if(!flush_(idx)) return NIL;
+			assign_(idx, NONE);
+			touch_(idx);
+			return idx;
+		}
+
+		// FAT のブート・セクターなら、FAT（+FAT12/16 のルート・ディレクトリ）の領域を記録
+		void check_boot_(DWORD sector, const BYTE* p) noexcept
+		{
+			if(p[510] != 0x55 || p[511] != 0xAA) return;
+			if(ld16_(&p[11]) != SECTOR_SIZE) return;
+			if(std::memcmp(&p[54], "FAT", 3) != 0 && std::memcmp(&p[82], "FAT32", 5) != 0) return;
+			DWORD fsz = ld16_(&p[22]);
+			if(fsz == 0) fsz = ld32_(&p[36]);
+			meta_org_ = sector + ld16_(&p[14]);
+			meta_end_ = meta_org_ + p[16] * fsz + ld16_(&p[17]) * 32 / SECTOR_SIZE;
+		}
+
+		static uint32_t ld16_(const BYTE* p) noexcept { return p[0] | (p[1] << 8); }
+		static uint32_t ld32_(const BYTE* p) noexcept { return ld16_(p) | (ld16_(p + 2) << 16); }
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	コンストラクター
+			@param[in]	io	ディスク I/O
+		 */
+		//-----------------------------------------------------------------//
+		sector_cache(IO& io) noexcept : io_(io), meta_org_(0), meta_end_(0) { invalidate(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	キャッシュを破棄（書き戻さない、カードの交換など）
+		 */
+		//-----------------------------------------------------------------//
+		void invalidate() noexcept
+		{
+			for(uint32_t i = 0; i < 2; ++i) {
+				list_[i].head = NIL;
+				list_[i].tail = NIL;
+			}
+			for(uint32_t i = 0; i < HASH; ++i) hash_[i] = NIL;
+			for(uint16_t i = 0; i < NUM; ++i) {
+				slot_[i].sector = NONE;
+				slot_[i].link = NIL;
+				slot_[i].dirty = false;
+				push_front_(i);
+			}
+			meta_org_ = 0;
+			meta_end_ = 0;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	書き戻し（セクター順）
+			@return 成功なら「true」
+		 */
+		//-----------------------------------------------------------------//
+		bool sync() noexcept
+		{
+			DWORD last = 0;
+			while(1) {
+				uint16_t idx = NIL;
+				for(uint16_t i = 0; i < NUM; ++i) {
+					if(!slot_[i].dirty || slot_[i].sector < last) continue;
+					if(idx == NIL || slot_[i].sector < slot_[idx].sector) idx = i;
+				}
+				if(idx == NIL) break;
+				last = slot_[idx].sector;
+				if(!flush_(idx)) return false;
+			}
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	統計を取得
+			@return 統計
+		 */
+		//-----------------------------------------------------------------//
+		const stat_t& get_stat() const noexcept { return stat_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	統計をクリア
+		 */
+		//-----------------------------------------------------------------//
+		void clear_stat() noexcept { stat_ = stat_t(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ステータス
+			@param[in]	drv		Physical drive nmuber (0)
+		 */
+		//-----------------------------------------------------------------//
+		DSTATUS disk_status(BYTE drv) noexcept { return io_.disk_status(drv); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	初期化（キャッシュは破棄される）
+			@param[in]	drv		Physical drive nmuber (0)
+			@return ステータス
+		 */
+		//-----------------------------------------------------------------//
+		DSTATUS disk_initialize(BYTE drv) noexcept
+		{
+			invalidate();
+			return io_.disk_initialize(drv);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	リード・セクター
+			@param[in]	drv		Physical drive nmuber (0)
+			@param[out]	buff	Pointer to the data buffer to store read data
+			@param[in]	sector	Start sector number (LBA)
+			@param[in]	count	Sector count (1..128)
+			@return リザルト
+		 */
+		//-----------------------------------------------------------------//
+		DRESULT disk_read(BYTE drv, BYTE* buff, DWORD sector, UINT count) noexcept
+		{
+			if(io_.disk_status(drv) & STA_NOINIT) return RES_NOTRDY;
+
+			if(count == 1) {
+				auto idx = find_(sector);
+				if(idx != NIL) {
+					++stat_.hit;
+					if(meta_(sector)) ++stat_.meta_hit;
+				} else {
+					++stat_.miss;
+					idx = evict_(sector);
+					if(idx == NIL) return RES_ERROR;
+					auto ret = io_.disk_read(drv, buff_[idx], sector, 1);
+					if(ret != RES_OK) return ret;
+					assign_(idx, sector);
+					check_boot_(sector, buff_[idx]);
+				}
+				touch_(idx);
+				std::memcpy(buff, buff_[idx], SECTOR_SIZE);
+				return RES_OK;
+			}
+
+			// ストリーム：キャッシュに無い連続部分は、まとめて読む
+			while(count > 0) {
+				auto idx = find_(sector);
+				if(idx != NIL) {
+					++stat_.hit;
+					std::memcpy(buff, buff_[idx], SECTOR_SIZE);
+					++sector;
+					buff += SECTOR_SIZE;
+					--count;
+					continue;
+				}
+				UINT n = 1;
+				while(n < count && find_(sector + n) == NIL) ++n;
+				auto ret = io_.disk_read(drv, buff, sector, n);
+				if(ret != RES_OK) return ret;
+				stat_.bypass += n;
+				sector += n;
+				buff += n * SECTOR_SIZE;
+				count -= n;
+			}
+			return RES_OK;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ライト・セクター
+			@param[in]	drv		Physical drive nmuber (0)
+			@param[in]	buff	Pointer to the data to be written
+			@param[in]	sector	Start sector number (LBA)
+			@param[in]	count	Sector count (1..128)
+			@return リザルト
+		 */
+		//-----------------------------------------------------------------//
+		DRESULT disk_write(BYTE drv, const BYTE* buff, DWORD sector, UINT count) noexcept
+		{
+			auto st = io_.disk_status(drv);
+			if(st & STA_NOINIT) return RES_NOTRDY;
+			if(st & STA_PROTECT) return RES_WRPRT;
+
+			if(count == 1) {
+				auto idx = find_(sector);
+				if(idx != NIL) {
+					++stat_.hit;
+				} else {
+					++stat_.miss;
+					idx = evict_(sector);
+					if(idx == NIL) return RES_ERROR;
+					assign_(idx, sector);
+				}
+				touch_(idx);
+				std::memcpy(buff_[idx], buff, SECTOR_SIZE);
+				slot_[idx].dirty = true;
+				return RES_OK;
+			}
+
+			// ストリーム：キャッシュにあるセクターは更新、無い連続部分は、まとめて書く
+			while(count > 0) {
+				auto idx = find_(sector);
+				if(idx != NIL) {
+					++stat_.hit;
+					std::memcpy(buff_[idx], buff, SECTOR_SIZE);
+					slot_[idx].dirty = true;
+					++sector;
+					buff += SECTOR_SIZE;
+					--count;
+					continue;
+				}
+				UINT n = 1;
+				while(n < count && find_(sector + n) == NIL) ++n;
+				auto ret = io_.disk_write(drv, buff, sector, n);
+				if(ret != RES_OK) return ret;
+				stat_.bypass += n;
+				sector += n;
+				buff += n * SECTOR_SIZE;
+				count -= n;
+			}
+			return RES_OK;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	I/O コントロール（CTRL_SYNC で書き戻す）
+			@param[in]	drv		Physical drive nmuber (0)
+			@param[in]	ctrl	Control code
+			@param[in]	buff	Buffer to send/receive control data
+			@return リザルト
+		 */
+		//-----------------------------------------------------------------//
+		DRESULT disk_ioctl(BYTE drv, BYTE ctrl, void* buff) noexcept
+		{
+			if(ctrl == CTRL_SYNC) {
+				if(!sync()) return RES_ERROR;
+			}
+			return io_.disk_ioctl(drv, ctrl, buff);
+		}
+	};
+}
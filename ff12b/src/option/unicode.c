@@ -3,7 +3,7 @@
 #if _USE_LFN != 0
 
 #if   _CODE_PAGE == 932	/* Japanese Shift_JIS */
-#include "cc932.c"
+#include "cc932t.c"	/* Direct-indexed tables (cc932.c is the generator source) */
 #elif _CODE_PAGE == 936	/* Simplified Chinese GBK */
 #include "cc936.c"
 #elif _CODE_PAGE == 949	/* Korean */
@@ -10,6 +10,7 @@
 //=====================================================================//
 #include <cstdint>
 #include "ff12b/src/ff.h"
+#include "common/string_utils.hpp"
 
 // 漢字フォントデータをＳＤカード上に置いて、キャッシュアクセスする場合有効にする
 // #define CASH_KFONT
@@ -144,7 +145,7 @@ namespace graphics {
 
 			if(fatfs_get_mount() == 0) return nullptr;
 #endif
-			uint32_t lin = sjis_to_liner_(ff_convert(code, 0));
+			uint32_t lin = sjis_to_liner_(utils::str::utf16_to_sjis(code));
 
 			if(lin == 0xffff) {
 				return nullptr;
@@ -0,0 +1,85 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	テスト用 FAT16 イメージの作成 @n
+			ffconf.h は _USE_MKFS が無効なので、f_mkfs の代わりに使う。@n
+			パーティション無し（SFD）、FAT×２、ルート・ディレクトリ 512 エントリー
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+namespace host {
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief	空の FAT16 イメージ・ファイルを作成
+		@param[in]	path	イメージ・ファイル
+		@param[in]	sectors	セクター数（４M バイト～２G バイト）
+		@return 成功なら「true」
+	*/
+	//-----------------------------------------------------------------//
+	inline bool make_fat16(const char* path, uint32_t sectors)
+	{
+		static const uint32_t SECTOR_SIZE = 512;
+		static const uint32_t RSV = 1;
+		static const uint32_t ROOT = 512;
+		static const uint32_t ROOT_SECTORS = ROOT * 32 / SECTOR_SIZE;
+
+		uint32_t csize = 1;
+		while(((sectors - RSV - ROOT_SECTORS) / csize) > 65524) csize <<= 1;
+		if(csize > 64) return false;
+		uint32_t fatsz = (((sectors - RSV - ROOT_SECTORS) / csize + 2) * 2 + SECTOR_SIZE - 1)
+			/ SECTOR_SIZE;
+		uint32_t clst = (sectors - RSV - fatsz * 2 - ROOT_SECTORS) / csize;
+		if(clst < 4085) return false;
+
+		auto fp = std::fopen(path, "wb");
+		if(fp == nullptr) return false;
+
+		uint8_t bs[SECTOR_SIZE];
+		std::memset(bs, 0, sizeof(bs));
+		auto w16 = [&](uint32_t ofs, uint32_t v) { bs[ofs] = v; bs[ofs + 1] = v >> 8; };
+		auto w32 = [&](uint32_t ofs, uint32_t v) { w16(ofs, v); w16(ofs + 2, v >> 16); };
+		bs[0] = 0xEB; bs[1] = 0x3C; bs[2] = 0x90;
+		std::memcpy(&bs[3], "MSDOS5.0", 8);
+		w16(11, SECTOR_SIZE);
+		bs[13] = csize;
+		w16(14, RSV);
+		bs[16] = 2;				// FAT の数
+		w16(17, ROOT);
+		if(sectors < 0x10000) w16(19, sectors);
+		else w32(32, sectors);
+		bs[21] = 0xF8;
+		w16(22, fatsz);
+		w16(24, 63);
+		w16(26, 255);
+		bs[36] = 0x80;
+		bs[38] = 0x29;
+		w32(39, 0x12345678);
+		std::memcpy(&bs[43], "NO NAME    FAT16   ", 19);
+		w16(510, 0xAA55);
+		bool ok = std::fwrite(bs, SECTOR_SIZE, 1, fp) == 1;
+
+		// FAT の先頭（メディア・タイプ、クリーン・シャットダウン）
+		std::memset(bs, 0, sizeof(bs));
+		w16(0, 0xFFF8);
+		w16(2, 0xFFFF);
+		for(uint32_t i = 0; i < 2; ++i) {
+			std::fseek(fp, (RSV + fatsz * i) * SECTOR_SIZE, SEEK_SET);
+			if(std::fwrite(bs, SECTOR_SIZE, 1, fp) != 1) ok = false;
+		}
+
+		// 残りは０（疎なファイル）
+		std::memset(bs, 0, sizeof(bs));
+		std::fseek(fp, static_cast<long>(sectors - 1) * SECTOR_SIZE, SEEK_SET);
+		if(std::fwrite(bs, SECTOR_SIZE, 1, fp) != 1) ok = false;
+		if(std::fclose(fp) != 0) ok = false;
+		return ok;
+	}
+}
@@ -0,0 +1,223 @@
+//=====================================================================//
+/*!	@file
+	@brief	file_io のテスト（CLMT、image_io 上で動かす） @n
+			・CLMT を作れない（断片が多過ぎる）ファイルのシークで、他のファイルの @n
+			  CLMT スロットを追い出さない事 @n
+			・スロットが足りない場合は、最も古いものを追い出し、追い出されたファイルは @n
+			  次のシークで作り直す事 @n
+			・乱数のシーク（SET、CUR、END）と読み出しが、CLMT の有無に依らず @n
+			  内容と一致する事
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#define FAT_FS
+#define FILE_IO_CLMT_NUM	2
+#define FILE_IO_CLMT_SIZE	32	///< 断片は 15 まで
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include "ff12b/image_io.hpp"
+#include "common/file_io.hpp"
+#include "fat_image.hpp"
+
+namespace {
+
+	static const char* IMAGE = "file_io_test.img";
+	static const uint32_t SECTORS = 16384;	///< 8M バイト（１クラスター、512 バイト）
+
+	// a, b, d: ４断片、c: 40 断片（CLMT を作れない）
+	static const char* NAME[] = { "a.bin", "b.bin", "c.bin", "d.bin" };
+	static const uint32_t FILES = 4;
+	static const uint32_t GOOD_CHUNK = 32 * 1024;
+	static const uint32_t GOOD_NUM = 4;
+	static const uint32_t BAD_CHUNK = 2048;
+	static const uint32_t BAD_NUM = 40;
+
+	fatfs::image_io	img_;
+	int		error_ = 0;
+
+	void error_out_(const char* msg, uint32_t v)
+	{
+		if(error_ < 10) std::printf("%s: %u\n", msg, v);
+		++error_;
+	}
+
+
+	uint8_t data_(uint32_t id, uint32_t pos)
+	{
+		uint32_t v = (pos + 1) * 2654435761u + id * 40503;
+		return v >> 24;
+	}
+
+
+	uint32_t size_(uint32_t id) { return id == 2 ? BAD_CHUNK * BAD_NUM : GOOD_CHUNK * GOOD_NUM; }
+
+
+	void append_(FIL& fp, uint32_t id, uint32_t len)
+	{
+		static uint8_t tmp[GOOD_CHUNK];
+		auto pos = f_tell(&fp);
+		for(uint32_t i = 0; i < len; ++i) tmp[i] = data_(id, pos + i);
+		UINT bw = 0;
+		f_write(&fp, tmp, len, &bw);
+		if(bw != len) error_out_("f_write", id);
+	}
+
+
+	// 交互に書いて、断片化したファイルを作る
+	bool make_files_()
+	{
+		FIL fp[FILES];
+		for(uint32_t i = 0; i < FILES; ++i) {
+			if(f_open(&fp[i], NAME[i], FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) return false;
+		}
+		for(uint32_t n = 0; n < GOOD_NUM; ++n) {
+			append_(fp[0], 0, GOOD_CHUNK);
+			append_(fp[1], 1, GOOD_CHUNK);
+			append_(fp[3], 3, GOOD_CHUNK);
+		}
+		FIL pad;
+		f_open(&pad, "pad.bin", FA_WRITE | FA_CREATE_ALWAYS);
+		for(uint32_t n = 0; n < BAD_NUM; ++n) {
+			append_(fp[2], 2, BAD_CHUNK);
+			append_(pad, 9, 512);
+		}
+		f_close(&pad);
+		for(uint32_t i = 0; i < FILES; ++i) f_close(&fp[i]);
+		return true;
+	}
+
+
+	bool clmt_(utils::file_io& f) { return f.at_fd().cltbl != nullptr; }
+
+
+	void check_read_(utils::file_io& f, uint32_t id, uint32_t len)
+	{
+		uint8_t tmp[1024];
+		uint32_t pos = f.tell();
+		uint32_t n = f.read(tmp, len);
+		uint32_t expect = size_(id) - pos;
+		if(expect > len) expect = len;
+		if(n != expect) {
+			error_out_("read size", id);
+			return;
+		}
+		for(uint32_t i = 0; i < n; ++i) {
+			if(tmp[i] != data_(id, pos + i)) {
+				error_out_("read data", id);
+				return;
+			}
+		}
+	}
+
+
+	void slot_(utils::file_io* f)
+	{
+		for(uint32_t i = 0; i < FILES; ++i) {
+			if(!f[i].open(NAME[i], "r")) error_out_("open", i);
+		}
+		f[0].seek(utils::file_io::SEEK::SET, 1000);
+		f[1].seek(utils::file_io::SEEK::SET, 1000);
+		if(!clmt_(f[0]) || !clmt_(f[1])) error_out_("CLMT (a, b)", 0);
+
+		// c は作れない、a、b はそのまま
+		if(!f[2].seek(utils::file_io::SEEK::SET, 70000)) error_out_("seek (c)", 0);
+		check_read_(f[2], 2, 100);
+		if(clmt_(f[2])) error_out_("CLMT (c)", 0);
+		if(!clmt_(f[0]) || !clmt_(f[1])) error_out_("CLMT evicted by c", 0);
+
+		// d は、最も古い a を追い出す、a は次のシークで b を追い出す
+		f[1].seek(utils::file_io::SEEK::SET, 2000);
+		f[3].seek(utils::file_io::SEEK::SET, 3000);
+		if(!clmt_(f[3]) || clmt_(f[0]) || !clmt_(f[1])) error_out_("CLMT LRU (d)", 0);
+		f[0].seek(utils::file_io::SEEK::SET, 4000);
+		if(!clmt_(f[0]) || clmt_(f[1]) || !clmt_(f[3])) error_out_("CLMT LRU (a)", 0);
+		check_read_(f[0], 0, 1000);
+		check_read_(f[3], 3, 1000);
+	}
+
+
+	void random_(utils::file_io* f, std::mt19937& rng)
+	{
+		for(int i = 0; i < 20000; ++i) {
+			uint32_t id = rng() % FILES;
+			auto& fio = f[id];
+			uint32_t size = size_(id);
+			int32_t pos = rng() % (size + 1);
+			bool ok;
+			switch(rng() % 3) {
+			case 0:
+				ok = fio.seek(utils::file_io::SEEK::SET, pos);
+				break;
+			case 1:
+				ok = fio.seek(utils::file_io::SEEK::CUR, pos - static_cast<int32_t>(fio.tell()));
+				break;
+			default:
+				ok = fio.seek(utils::file_io::SEEK::END, size - pos);
+				break;
+			}
+			if(!ok || fio.tell() != static_cast<uint32_t>(pos)) {
+				error_out_("seek", id);
+				continue;
+			}
+			check_read_(fio, id, 1 + rng() % 1024);
+			if(id == 2 && clmt_(fio)) error_out_("CLMT (c)", i);
+			if(id != 2 && !clmt_(fio)) error_out_("CLMT", id);
+		}
+	}
+}
+
+extern "C" {
+
+	DSTATUS disk_initialize(BYTE drv) { return img_.disk_initialize(drv); }
+	DSTATUS disk_status(BYTE drv) { return img_.disk_status(drv); }
+	DRESULT disk_read(BYTE drv, BYTE* buff, DWORD sector, UINT count) {
+		return img_.disk_read(drv, buff, sector, count);
+	}
+	DRESULT disk_write(BYTE drv, const BYTE* buff, DWORD sector, UINT count) {
+		return img_.disk_write(drv, buff, sector, count);
+	}
+	DRESULT disk_ioctl(BYTE drv, BYTE ctrl, void* buff) { return img_.disk_ioctl(drv, ctrl, buff); }
+	DWORD get_fattime(void) { return 0x4c210000; }
+
+	int make_full_path(const char* src, char* dst, uint16_t dsz)
+	{
+		std::strncpy(dst, src, dsz);
+		dst[dsz - 1] = 0;
+		return 1;
+	}
+
+	void utf8_to_sjis(const char* src, char* dst, uint32_t dsz)
+	{
+		if(src != dst) std::strncpy(dst, src, dsz);
+	}
+};
+
+int main()
+{
+	if(!host::make_fat16(IMAGE, SECTORS) || !img_.open(IMAGE) || !img_.service()) {
+		std::printf("image fail\n");
+		return 1;
+	}
+	if(!make_files_()) {
+		std::printf("make files fail\n");
+		return 1;
+	}
+
+	{
+		std::mt19937 rng(11);
+		utils::file_io f[FILES];
+		slot_(f);
+		random_(f, rng);
+	}
+
+	img_.close();
+	std::remove(IMAGE);
+
+	if(error_ == 0) std::printf("OK\n");
+	else std::printf("%d errors\n", error_);
+	return error_ == 0 ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+//=====================================================================//
+/*!	@file
+	@brief	fixed_block のテスト @n
+			ワード境界の前後（1、31、32、33、63、64、65、100）のサイズで、乱数の @n
+			alloc、lock/unlock、erase を、モデルと比較する。@n
+			・alloc は、前回の次から探し、末尾でラップする（ラウンド・ロビン）@n
+			・満杯の alloc は SIZE、確保直後はロックされている @n
+			・next(i)、next(i, true)（ロックを除く）の列挙が、モデルと一致する @n
+			・size()（popcount）、empty() が一致する
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdio>
+#include <vector>
+#include <random>
+#include "common/fixed_block.hpp"
+
+namespace {
+
+	int error_ = 0;
+
+	void error_out_(const char* msg, uint32_t size, uint32_t v)
+	{
+		if(error_ < 10) std::printf("%s (SIZE %u): %u\n", msg, size, v);
+		++error_;
+	}
+
+
+	struct model_t {
+		std::vector<bool>	use;
+		std::vector<bool>	lock;
+		uint32_t			rr;		///< 次の alloc の探索開始位置
+
+		explicit model_t(uint32_t size) : use(size, false), lock(size, false), rr(0) { }
+
+		uint32_t alloc() {
+			uint32_t n = use.size();
+			for(uint32_t i = 0; i < n; ++i) {
+				uint32_t idx = (rr + i) % n;
+				if(!use[idx]) {
+					use[idx] = true;
+					lock[idx] = true;
+					rr = (idx + 1) % n;
+					return idx;
+				}
+			}
+			return n;
+		}
+
+		uint32_t next(uint32_t idx, bool active) const {
+			for(uint32_t i = idx; i < use.size(); ++i) {
+				if(use[i] && (!active || !lock[i])) return i;
+			}
+			return use.size();
+		}
+
+		uint32_t size() const {
+			uint32_t n = 0;
+			for(auto b : use) n += b;
+			return n;
+		}
+	};
+
+
+	template <uint32_t SIZE>
+	void check_(const utils::fixed_block<int, SIZE>& b, const model_t& m, std::mt19937& rng)
+	{
+		if(b.size() != m.size()) error_out_("size", SIZE, b.size());
+		if(b.empty() != (m.size() == 0)) error_out_("empty", SIZE, b.size());
+		for(uint32_t i = 0; i <= SIZE; ++i) {
+			if(b.is_alloc(i) != (i < SIZE && m.use[i])) error_out_("is_alloc", SIZE, i);
+			if(b.is_lock(i) != (i < SIZE && m.use[i] && m.lock[i])) error_out_("is_lock", SIZE, i);
+		}
+		// 全体の列挙と、途中からの列挙
+		for(int a = 0; a < 2; ++a) {
+			bool active = a != 0;
+			uint32_t org = (rng() & 1) ? 0 : rng() % (SIZE + 2);
+			uint32_t i = b.next(org, active);
+			uint32_t j = m.next(org, active);
+			while(true) {
+				if(i != j) {
+					error_out_(active ? "next (active)" : "next", SIZE, i);
+					break;
+				}
+				if(i >= SIZE) break;
+				i = b.next(i + 1, active);
+				j = m.next(j + 1, active);
+			}
+		}
+	}
+
+
+	template <uint32_t SIZE>
+	void run_(std::mt19937& rng)
+	{
+		static utils::fixed_block<int, SIZE> b;
+		model_t m(SIZE);
+
+		// 満杯まで確保（0 から順番）、満杯の alloc
+		for(uint32_t i = 0; i < SIZE; ++i) {
+			uint32_t idx = b.alloc();
+			if(idx != m.alloc()) error_out_("alloc (fill)", SIZE, i);
+			if(idx < SIZE) b.at(idx) = idx;
+		}
+		if(b.alloc() != SIZE || b.size() != SIZE) error_out_("alloc (full)", SIZE, b.size());
+		check_(b, m, rng);
+
+		// 先頭を空けると、ラップしてそこを使う
+		b.erase(0);
+		m.use[0] = false;
+		if(b.alloc() != 0) error_out_("alloc (wrap)", SIZE, 0);
+		m.alloc();
+		if(b.erase(SIZE) || b.lock(SIZE) || b.is_alloc(SIZE)) error_out_("range", SIZE, SIZE);
+
+		for(int n = 0; n < 20000; ++n) {
+			uint32_t idx = rng() % (SIZE + 1);
+			switch(rng() % 5) {
+			case 0:
+			case 1:
+				{
+					uint32_t i = b.alloc();
+					uint32_t j = m.alloc();
+					if(i != j) error_out_("alloc", SIZE, i);
+					if(i < SIZE) b.at(i) = i;
+				}
+				break;
+			case 2:
+				{
+					bool ret = b.unlock(idx);
+					if(ret != (idx < SIZE && m.use[idx])) error_out_("unlock", SIZE, idx);
+					if(ret) m.lock[idx] = false;
+				}
+				break;
+			case 3:
+				{
+					bool ret = b.lock(idx);
+					if(ret != (idx < SIZE && m.use[idx])) error_out_("lock", SIZE, idx);
+					if(ret) m.lock[idx] = true;
+				}
+				break;
+			default:
+				{
+					bool ret = b.erase(idx);
+					if(ret != (idx < SIZE && m.use[idx])) error_out_("erase", SIZE, idx);
+					if(ret) m.use[idx] = false;
+				}
+				break;
+			}
+			if((n % 16) == 0) check_(b, m, rng);
+		}
+		check_(b, m, rng);
+
+		for(uint32_t i = b.next(0); i < b.capacity(); i = b.next(i + 1)) {
+			if(b.get(i) != static_cast<int>(i)) error_out_("unit", SIZE, i);
+			b.erase(i);
+		}
+		if(!b.empty() || b.size() != 0) error_out_("erase all", SIZE, b.size());
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(9);
+	run_<1>(rng);
+	run_<31>(rng);
+	run_<32>(rng);
+	run_<33>(rng);
+	run_<63>(rng);
+	run_<64>(rng);
+	run_<65>(rng);
+	run_<100>(rng);
+
+	if(error_ == 0) std::printf("OK\n");
+	else std::printf("%d errors\n", error_);
+	return error_ == 0 ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+//=====================================================================//
+/*!	@file
+	@brief	fixed_fifo のベンチマーク @n
+			１バイト当たりの時間（ns）を、以前の実装（１６ビット・インデックス、@n
+			比較でラップ、一個ずつ）と比べる。@n
+			・一個ずつの put/get（SCI の割り込みと同じ使い方）@n
+			・一括の put/get（sound_out、バッファ付き出力と同じ使い方）
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdio>
+#include <chrono>
+#include "common/fixed_fifo.hpp"
+
+namespace {
+
+	// 以前の fixed_fifo（比較用）
+	template <class UNIT, uint32_t SIZE>
+	class old_fifo {
+
+		volatile uint16_t	get_;
+		volatile uint16_t	put_;
+
+		UNIT	buff_[SIZE];
+
+	public:
+		old_fifo() noexcept : get_(0), put_(0) { }
+
+		uint32_t length() const noexcept {
+			if(put_ >= get_) return (put_ - get_);
+			else return (SIZE + put_ - get_);
+		}
+
+		inline void put_go() noexcept {
+			volatile uint16_t put = put_;
+			++put;
+			if(put >= SIZE) {
+				put = 0;
+			}
+			put_ = put;
+		}
+
+		void put(const UNIT& v) noexcept {
+			buff_[put_] = v;
+			put_go();
+		}
+
+		inline void get_go() noexcept {
+			volatile uint16_t get = get_;
+			++get;
+			if(get >= SIZE) {
+				get = 0;
+			}
+			get_ = get;
+		}
+
+		UNIT get() noexcept {
+			UNIT v = buff_[get_];
+			get_go();
+			return v;
+		}
+	};
+
+
+	static const uint32_t BYTES = 64 * 1024 * 1024;
+	static const uint32_t BLOCK = 64;
+
+	volatile uint8_t sink_;
+
+	template <class FUNC>
+	double run_(FUNC f)
+	{
+		auto t0 = std::chrono::steady_clock::now();
+		for(uint32_t i = 0; i < (BYTES / BLOCK); ++i) f(i);
+		auto t = std::chrono::steady_clock::now() - t0;
+		return std::chrono::duration<double, std::nano>(t).count() / BYTES;
+	}
+
+
+	template <class FIFO>
+	double single_(FIFO& f)
+	{
+		return run_([&](uint32_t i) {
+			for(uint32_t j = 0; j < BLOCK; ++j) f.put(static_cast<uint8_t>(i + j));
+			uint8_t s = 0;
+			while(f.length() > 0) s += f.get();
+			sink_ = s;
+		});
+	}
+
+
+	template <class FIFO>
+	double old_block_(FIFO& f)
+	{
+		uint8_t src[BLOCK];
+		uint8_t dst[BLOCK];
+		for(uint32_t j = 0; j < BLOCK; ++j) src[j] = j;
+		return run_([&](uint32_t i) {
+			for(uint32_t j = 0; j < BLOCK; ++j) f.put(src[j]);
+			for(uint32_t j = 0; j < BLOCK; ++j) dst[j] = f.get();
+			sink_ = dst[i % BLOCK];
+		});
+	}
+
+
+	template <class FIFO>
+	double block_(FIFO& f)
+	{
+		uint8_t src[BLOCK];
+		uint8_t dst[BLOCK];
+		for(uint32_t j = 0; j < BLOCK; ++j) src[j] = j;
+		return run_([&](uint32_t i) {
+			f.put(src, BLOCK);
+			f.get(dst, BLOCK);
+			sink_ = dst[i % BLOCK];
+		});
+	}
+}
+
+int main()
+{
+	static old_fifo<uint8_t, 256> o256;
+	static old_fifo<uint8_t, 250> o250;
+	static utils::fixed_fifo<uint8_t, 256> n256;
+	static utils::fixed_fifo<uint8_t, 250> n250;
+
+	std::printf("%-14s %10s %10s %10s\n", "", "old", "fixed_fifo", "ratio");
+	auto a = single_(o256);
+	auto b = single_(n256);
+	std::printf("%-14s %8.2fns %8.2fns %9.2f\n", "single (256)", a, b, a / b);
+	a = single_(o250);
+	b = single_(n250);
+	std::printf("%-14s %8.2fns %8.2fns %9.2f\n", "single (250)", a, b, a / b);
+	a = old_block_(o256);
+	b = block_(n256);
+	std::printf("%-14s %8.2fns %8.2fns %9.2f\n", "block (256)", a, b, a / b);
+	a = old_block_(o250);
+	b = block_(n250);
+	std::printf("%-14s %8.2fns %8.2fns %9.2f\n", "block (250)", a, b, a / b);
+}
@@ -0,0 +1,209 @@
+//=====================================================================//
+/*!	@file
+	@brief	fixed_fifo のテスト @n
+			・２のＮ乗と、それ以外のサイズで、乱数の put/get（一個、一括、span）が @n
+			  モデル（std::deque）と一致し、ラップしても壊れない事 @n
+			・３２ビット・インデックスのラップ（２のＮ乗）@n
+			・put_span/get_span の、ラップする場合の２つの領域 @n
+			・満杯の put は捨て、空の get は進まない事、満杯の put_at に書いても @n
+			  格納済みのデータが壊れない事
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdio>
+#include <deque>
+#include <random>
+#include "common/fixed_fifo.hpp"
+
+namespace {
+
+	int error_ = 0;
+
+	void error_out_(const char* msg, uint32_t v)
+	{
+		if(error_ < 10) std::printf("%s: %u\n", msg, v);
+		++error_;
+	}
+
+
+	template <class FIFO>
+	uint32_t capa_(const FIFO& f)
+	{
+		return (f.size() & (f.size() - 1)) == 0 ? f.size() : (f.size() - 1);
+	}
+
+
+	template <class FIFO>
+	void check_(const FIFO& f, const std::deque<uint16_t>& model, const char* msg)
+	{
+		if(f.length() != model.size() || f.space() != (capa_(f) - model.size())) {
+			error_out_(msg, f.length());
+		}
+	}
+
+
+	// 乱数の操作を、モデルと比較
+	template <class FIFO>
+	void random_(FIFO& f, std::mt19937& rng, uint32_t loop, const char* msg)
+	{
+		std::deque<uint16_t> model;
+		uint16_t val = 0;
+		uint16_t tmp[64];
+		for(uint32_t i = 0; i < loop; ++i) {
+			switch(rng() % 6) {
+			case 0:  // 一個
+				if(f.put(val) != (model.size() < capa_(f))) error_out_(msg, i);
+				if(model.size() < capa_(f)) model.push_back(val);
+				++val;
+				break;
+			case 1:  // 一括
+				{
+					uint32_t n = rng() % 64;
+					for(uint32_t j = 0; j < n; ++j) tmp[j] = val + j;
+					uint32_t m = f.put(tmp, n);
+					uint32_t e = std::min<uint32_t>(n, capa_(f) - model.size());
+					if(m != e) error_out_(msg, i);
+					for(uint32_t j = 0; j < m; ++j) model.push_back(val++);
+				}
+				break;
+			case 2:  // put_span
+				{
+					typename FIFO::span_t a, b;
+					uint32_t n = f.put_span(a, b);
+					if(n != (capa_(f) - model.size()) || (a.len + b.len) != n) error_out_(msg, i);
+					n = std::min<uint32_t>(n, rng() % 64);
+					for(uint32_t j = 0; j < n; ++j) {
+						uint16_t v = val++;
+						if(j < a.len) a.org[j] = v;
+						else b.org[j - a.len] = v;
+						model.push_back(v);
+					}
+					f.put_go(n);
+				}
+				break;
+			case 3:  // 一個
+				if(model.empty()) break;
+				if(f.get() != model.front()) error_out_(msg, i);
+				model.pop_front();
+				break;
+			case 4:  // 一括
+				{
+					uint32_t n = rng() % 64;
+					uint32_t m = f.get(tmp, n);
+					if(m != std::min<uint32_t>(n, model.size())) error_out_(msg, i);
+					for(uint32_t j = 0; j < m; ++j) {
+						if(tmp[j] != model.front()) error_out_(msg, i);
+						model.pop_front();
+					}
+				}
+				break;
+			default:  // get_span
+				{
+					typename FIFO::span_t a, b;
+					uint32_t n = f.get_span(a, b);
+					if(n != model.size() || (a.len + b.len) != n) error_out_(msg, i);
+					n = std::min<uint32_t>(n, rng() % 64);
+					for(uint32_t j = 0; j < n; ++j) {
+						uint16_t v = j < a.len ? a.org[j] : b.org[j - a.len];
+						if(v != model.front()) error_out_(msg, i);
+						model.pop_front();
+					}
+					f.get_go(n);
+				}
+				break;
+			}
+			check_(f, model, msg);
+		}
+	}
+
+
+	// 満杯、空
+	template <class FIFO>
+	void edge_(FIFO& f, const char* msg)
+	{
+		f.get_go(f.length());  // clear() はインデックスを戻すので使わない
+		uint16_t tmp[4];
+		if(f.get(tmp, 4) != 0 || f.length() != 0) error_out_(msg, 0);
+		f.get_go(3);
+		if(f.length() != 0 || f.space() != capa_(f)) error_out_(msg, 1);
+
+		// 途中から始めて、ラップした状態で満杯にする
+		for(uint32_t i = 0; i < 3; ++i) f.put(0);
+		f.get_go(3);
+		uint32_t pos = f.pos_get();
+		for(uint32_t i = 0; i < capa_(f); ++i) {
+			if(!f.put(i)) error_out_(msg, 2);
+		}
+		if(f.put(0xffff) || f.length() != capa_(f) || f.space() != 0) error_out_(msg, 3);
+		if(f.put(tmp, 4) != 0) error_out_(msg, 4);
+		typename FIFO::span_t a, b;
+		if(f.put_span(a, b) != 0 || a.len != 0 || b.len != 0) error_out_(msg, 5);
+		// 満杯の put_at は、格納済みのデータと重ならない
+		f.put_at() = 0xffff;
+		f.put_go();
+		f.put_go(5);
+		if(f.length() != capa_(f)) error_out_(msg, 6);
+
+		// 読み出し（ラップしている）
+		if(f.get_span(a, b) != capa_(f) || a.len != std::min(capa_(f), f.size() - pos) || b.len != (capa_(f) - a.len)) {
+			error_out_(msg, 7);
+		}
+		for(uint32_t i = 0; i < capa_(f); ++i) {
+			if(f.get() != i) {
+				error_out_(msg, 8);
+				break;
+			}
+		}
+		if(f.length() != 0) error_out_(msg, 9);
+	}
+
+
+	// ３２ビット・インデックスのラップ（２のＮ乗）
+	void index_wrap_()
+	{
+		static const uint32_t SIZE = 256;
+		static utils::fixed_fifo<uint16_t, SIZE> f;
+		// インデックスを 0xffffff00 まで進める
+		for(uint32_t i = 0; i < (0xffffffffu / SIZE); ++i) {
+			f.put_go(SIZE);
+			f.get_go(SIZE);
+		}
+		if(f.length() != 0 || f.pos_put() != 0) error_out_("index wrap (go)", f.length());
+		std::mt19937 rng(7);
+		random_(f, rng, 20000, "index wrap");
+		edge_(f, "index wrap (edge)");
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(1);
+	{
+		static utils::fixed_fifo<uint16_t, 64> f;
+		random_(f, rng, 1000000, "pow2");
+		edge_(f, "pow2 (edge)");
+	}
+	{
+		static utils::fixed_fifo<uint16_t, 100> f;
+		random_(f, rng, 1000000, "non pow2");
+		edge_(f, "non pow2 (edge)");
+	}
+	{
+		static utils::fixed_fifo<uint16_t, 2> f;
+		random_(f, rng, 100000, "size 2");
+		edge_(f, "size 2 (edge)");
+	}
+	{
+		static utils::fixed_fifo<uint16_t, 3> f;
+		random_(f, rng, 100000, "size 3");
+		edge_(f, "size 3 (edge)");
+	}
+	index_wrap_();
+
+	if(error_ == 0) std::printf("OK\n");
+	else std::printf("%d errors\n", error_);
+	return error_ == 0 ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+//=====================================================================//
+/*!	@file
+	@brief	fixed_memory のベンチマーク @n
+			同じ乱数のトレース（確保／解放）で、fixed_memory と malloc/free の @n
+			一回当たりの時間（ns）と、終了時の断片化を比べる。@n
+			malloc の断片化は、glibc の mallinfo2 で、空きの内、ヒープ末尾 @n
+			（keepcost）以外の割合とする（fixed_memory の fragmentation() と同じ定義）。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <vector>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include "common/fixed_memory.hpp"
+
+namespace {
+
+	static const uint32_t SIZE = 65536;
+	static const uint32_t DNUM = 2048;
+	static const uint32_t SLOTS = 1024;
+	static const uint32_t OPS = 2000000;
+	static const int LOOP = 10;
+
+	typedef utils::fixed_memory<SIZE, DNUM> MEMORY;
+
+	// slot に size を確保、size が０なら slot を解放
+	struct op_t {
+		uint16_t	slot;
+		uint16_t	size;
+	};
+
+
+	// 要求の合計が SIZE の半分前後になるトレース
+	std::vector<op_t> make_trace_()
+	{
+		std::vector<op_t> ops;
+		std::vector<uint16_t> live(SLOTS, 0);
+		std::vector<uint16_t> used;
+		std::vector<uint16_t> empty;
+		for(uint32_t i = 0; i < SLOTS; ++i) empty.push_back(i);
+		uint32_t total = 0;
+		std::mt19937 rng(5);
+		while(ops.size() < OPS) {
+			uint32_t n = 1 + (rng() % ((rng() % 8) == 0 ? 2048 : 128));
+			if(!empty.empty() && (total + n) < (SIZE / 2) && (used.empty() || (rng() % 100) < 52)) {
+				uint32_t k = rng() % empty.size();
+				uint16_t s = empty[k];
+				empty[k] = empty.back();
+				empty.pop_back();
+				used.push_back(s);
+				live[s] = n;
+				total += n;
+				ops.push_back(op_t { s, static_cast<uint16_t>(n) });
+			} else if(!used.empty()) {
+				uint32_t k = rng() % used.size();
+				uint16_t s = used[k];
+				used[k] = used.back();
+				used.pop_back();
+				empty.push_back(s);
+				total -= live[s];
+				ops.push_back(op_t { s, 0 });
+			}
+		}
+		return ops;
+	}
+
+
+	template <class ALLOC, class FREE>
+	double run_(const std::vector<op_t>& ops, void** slot, uint32_t& fail, ALLOC a, FREE f)
+	{
+		double t = 0.0;
+		for(int n = 0; n < LOOP; ++n) {
+			fail = 0;
+			for(uint32_t i = 0; i < SLOTS; ++i) slot[i] = nullptr;
+			auto t0 = std::chrono::steady_clock::now();
+			for(const auto& o : ops) {
+				if(o.size > 0) {
+					slot[o.slot] = a(o.size);
+					if(slot[o.slot] == nullptr) ++fail;
+				} else if(slot[o.slot] != nullptr) {
+					f(slot[o.slot]);
+					slot[o.slot] = nullptr;
+				}
+			}
+			t += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+			if(n < (LOOP - 1)) {
+				for(uint32_t i = 0; i < SLOTS; ++i) {
+					if(slot[i] != nullptr) f(slot[i]);
+				}
+			}
+		}
+		return t / (static_cast<double>(ops.size()) * LOOP);
+	}
+}
+
+int main()
+{
+	auto ops = make_trace_();
+	static void* slot[SLOTS];
+
+	static MEMORY mem;
+	uint32_t mfail = 0;
+	auto mt = run_(ops, slot, mfail,
+		[&](uint32_t n) { return mem.alloc(n); }, [&](void* p) { mem.free(p); });
+	auto st = mem.get_stat();
+
+	uint32_t cfail = 0;
+	auto ct = run_(ops, slot, cfail,
+		[](uint32_t n) { return std::malloc(n); }, [](void* p) { std::free(p); });
+
+	std::printf("trace: %u ops, requests up to %u bytes live (pool %u bytes)\n",
+		static_cast<uint32_t>(ops.size()), SIZE / 2, SIZE);
+	std::printf("%-14s %10s %10s\n", "", "fixed_memory", "malloc");
+	std::printf("%-14s %8.1fns %8.1fns\n", "alloc/free", mt, ct);
+	std::printf("%-14s %10u %10u\n", "fail", mfail, cfail);
+	// 終了時の状態（要求の合計は同じ）
+	std::vector<uint16_t> live(SLOTS, 0);
+	for(const auto& o : ops) live[o.slot] = o.size;
+	uint32_t req = 0;
+	for(auto n : live) req += n;
+	std::printf("%-14s %10u %10u\n", "live request", req, req);
+	std::printf("%-14s %10u %10s\n", "used (peak)", st.peak, "-");
+#ifdef __GLIBC__
+	// tcache の中のブロックは、mallinfo2 では使用中に数えられる
+	auto mi = mallinfo2();
+	uint32_t cfrag = mi.fordblks > 0 ? (100 - mi.keepcost * 100 / mi.fordblks) : 0;
+	std::printf("%-14s %9u%% %9u%%\n", "fragmentation", st.fragmentation(), cfrag);
+	std::printf("%-14s %10u %10u\n", "heap", SIZE, static_cast<uint32_t>(mi.arena));
+#else
+	std::printf("%-14s %9u%% %10s\n", "fragmentation", st.fragmentation(), "-");
+#endif
+	for(uint32_t i = 0; i < SLOTS; ++i) {
+		if(slot[i] != nullptr) std::free(slot[i]);
+	}
+}
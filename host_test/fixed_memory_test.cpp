@@ -0,0 +1,99 @@
+//=====================================================================//
+/*!	@file
+	@brief	fixed_memory のテスト @n
+			乱数で確保、解放を繰り返し、内容の破壊、二重解放、統計の整合を確認する。@n
+			大き過ぎるサイズ（丸めで溢れる値を含む）は、確保に失敗する事
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "common/fixed_memory.hpp"
+
+namespace {
+
+	static const uint32_t SIZE = 65536;
+	static const uint32_t DNUM = 2048;
+
+	utils::fixed_memory<SIZE, DNUM> mem_;
+
+	int error_ = 0;
+
+	void error_out_(const char* msg, uint32_t v = 0)
+	{
+		if(error_ < 10) std::printf("%s (%u)\n", msg, v);
+		++error_;
+	}
+
+
+	void edge_()
+	{
+		static const uint32_t ng[] = { 0, SIZE + 1, 0x7fffffff, 0xffffffff - SIZE / DNUM + 2, 0xffffffff };
+		for(auto n : ng) {
+			if(mem_.alloc(n) != nullptr) error_out_("alloc must fail", n);
+		}
+		void* p = mem_.alloc(SIZE);
+		if(p == nullptr) error_out_("alloc(SIZE) fail");
+		if(mem_.alloc(1) != nullptr) error_out_("alloc on full");
+		if(!mem_.free(p)) error_out_("free(SIZE) fail");
+	}
+
+
+	void random_()
+	{
+		struct blk_t {
+			uint8_t*	p;
+			uint32_t	n;
+			uint8_t		tag;
+		};
+		std::vector<blk_t> bs;
+		std::mt19937 rng(5);
+		for(int i = 0; i < 1000000; ++i) {
+			if(bs.empty() || (rng() % 100) < 52) {
+				uint32_t n = 1 + (rng() % ((rng() % 4) == 0 ? 4096 : 256));
+				uint8_t* p = static_cast<uint8_t*>(mem_.alloc(n));
+				if(p == nullptr) continue;
+				if(mem_.block_size(p) < n) error_out_("block_size", n);
+				blk_t b { p, n, static_cast<uint8_t>(rng()) };
+				std::memset(p, b.tag, n);
+				bs.push_back(b);
+			} else {
+				uint32_t idx = rng() % bs.size();
+				auto b = bs[idx];
+				for(uint32_t j = 0; j < b.n; ++j) {
+					if(b.p[j] != b.tag) {
+						error_out_("broken", j);
+						break;
+					}
+				}
+				if(!mem_.free(b.p)) error_out_("free fail");
+				if(mem_.free(b.p)) error_out_("double free accepted");
+				bs[idx] = bs.back();
+				bs.pop_back();
+			}
+		}
+		for(auto& b : bs) mem_.free(b.p);
+
+		auto st = mem_.get_stat();
+		if(st.used != 0 || st.count != 0 || st.largest != SIZE) {
+			error_out_("stat after free all", st.used);
+		}
+	}
+
+}
+
+int main()
+{
+	edge_();
+	random_();
+	edge_();
+
+	if(error_ == 0) std::printf("OK\n");
+	else std::printf("%d errors\n", error_);
+	return error_ == 0 ? 0 : 1;
+}
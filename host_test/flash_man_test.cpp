@@ -0,0 +1,233 @@
+//=====================================================================//
+/*!	@file
+	@brief	flash_man のテスト（flash_sim 上で動かす） @n
+			・乱数で書き込み、削除を繰り返し、モデル（std::map）と比較する @n
+			・途中で再マウント（start）して、内容が復元される事 @n
+			・書き込み中の電源断を模擬し、再マウント後、そのキーは新旧どちらかの値、@n
+			  他のキーは変化しない事 @n
+			・flash_sim の積算時間で、probe/read は０、ガベージ・コレクションの無い @n
+			  write はレコードの書き込み時間だけである事（時間は表示する）@n
+			  以前の flash_man の scan_（全ブロックの消去チェック）の probe と比べる
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <vector>
+#include <random>
+#include "common/flash_sim.hpp"
+#include "common/flash_man.hpp"
+
+namespace {
+
+	typedef utils::flash_sim<65536, 64> SIM;
+	typedef utils::flash_man<SIM, 1024, 64> MAN;
+
+	typedef std::vector<uint8_t> data_t;
+	typedef std::map<uint16_t, data_t> model_t;
+
+	static const uint16_t KEY_NUM = 60;
+
+	SIM		sim_;
+	int		error_ = 0;
+
+	void error_out_(const char* msg, uint32_t id)
+	{
+		if(error_ < 10) std::printf("%s: %u\n", msg, id);
+		++error_;
+	}
+
+
+	data_t random_data_(std::mt19937& rng)
+	{
+		data_t d(rng() % 100);
+		for(auto& c : d) c = rng();
+		return d;
+	}
+
+
+	bool read_(MAN& man, uint16_t id, data_t& d)
+	{
+		if(!man.probe(id)) return false;
+		d.resize(man.get_size(id));
+		return man.read(id, d.data(), d.size());
+	}
+
+
+	void check_(MAN& man, const model_t& model, const char* msg)
+	{
+		for(uint16_t id = 0; id < KEY_NUM; ++id) {
+			auto it = model.find(id);
+			data_t d;
+			bool have = read_(man, id, d);
+			if(it == model.end()) {
+				if(have) error_out_(msg, id);
+			} else if(!have || d != it->second) {
+				error_out_(msg, id);
+			}
+		}
+	}
+
+
+	void random_(MAN*& man, model_t& model, std::mt19937& rng)
+	{
+		for(int i = 0; i < 200000; ++i) {
+			uint16_t id = rng() % KEY_NUM;
+			if((rng() % 10) == 0) {
+				bool ret = man->remove(id);
+				if(ret != (model.count(id) != 0)) error_out_("remove", id);
+				model.erase(id);
+			} else {
+				auto d = random_data_(rng);
+				if(man->write(id, d.data(), d.size())) model[id] = d;
+				else error_out_("write", id);
+			}
+			if((i % 5000) == 0) {
+				delete man;
+				man = new MAN(sim_);
+				if(!man->start()) error_out_("start", i);
+				check_(*man, model, "remount");
+			}
+		}
+		check_(*man, model, "random");
+	}
+
+
+	// 以前の flash_man の probe（scan_）：ブロック毎に消去チェックして、ヘッダーを読む
+	bool old_probe_(uint16_t id)
+	{
+		struct head_t {
+			uint16_t	id;
+			uint16_t	nx_sz;
+		};
+		uint32_t pos = 0;
+		uint32_t match = SIM::data_flash_size;
+		while(pos < SIM::data_flash_size) {
+			if(!sim_.erase_check(pos)) {
+				head_t h;
+				sim_.read(pos, &h, sizeof(head_t));
+				if(h.id == id) match = pos;
+			}
+			pos += SIM::data_flash_block;
+		}
+		return match < SIM::data_flash_size;
+	}
+
+
+	void timing_(MAN*& man, model_t& model, std::mt19937& rng)
+	{
+		uint64_t probe = 0;
+		uint64_t read = 0;
+		uint64_t write = 0;
+		uint64_t write_max = 0;
+		uint64_t gc_max = 0;
+		uint32_t nw = 0;
+		static const int NUM = 20000;
+		for(int i = 0; i < NUM; ++i) {
+			uint16_t id = rng() % KEY_NUM;
+			auto t = sim_.get_time();
+			man->probe(id);
+			probe += sim_.get_time() - t;
+
+			t = sim_.get_time();
+			data_t d;
+			read_(*man, id, d);
+			read += sim_.get_time() - t;
+
+			d = random_data_(rng);
+			auto gc = man->get_stat().gc;
+			t = sim_.get_time();
+			if(man->write(id, d.data(), d.size())) model[id] = d;
+			else error_out_("write (timing)", id);
+			t = sim_.get_time() - t;
+			if(man->get_stat().gc == gc) {
+				// ヘッダー（８バイト）とデータ、４バイト単位
+				uint64_t expect = SIM::write_us * ((8 + d.size() + 3) / 4);
+				if(t != expect) error_out_("write time", t);
+				write += t;
+				++nw;
+				if(write_max < t) write_max = t;
+			} else {
+				if(gc_max < t) gc_max = t;
+			}
+		}
+		if(probe != 0 || read != 0) error_out_("probe/read time", probe + read);
+
+		auto t = sim_.get_time();
+		delete man;
+		man = new MAN(sim_);
+		if(!man->start()) error_out_("start (timing)", 0);
+		auto st = sim_.get_time() - t;
+		check_(*man, model, "timing");
+
+		t = sim_.get_time();
+		old_probe_(0);
+		auto old = sim_.get_time() - t;
+
+		std::printf("sim time: probe %.1fus, read %.1fus, write %.0fus (max %uus), "
+			"write with gc max %uus\n",
+			static_cast<double>(probe) / NUM, static_cast<double>(read) / NUM,
+			nw > 0 ? static_cast<double>(write) / nw : 0.0,
+			static_cast<uint32_t>(write_max), static_cast<uint32_t>(gc_max));
+		std::printf("sim time: start %uus, old scan_ probe %uus\n",
+			static_cast<uint32_t>(st), static_cast<uint32_t>(old));
+	}
+
+
+	void power_fail_(MAN*& man, model_t& model, std::mt19937& rng)
+	{
+		for(int i = 0; i < 3000; ++i) {
+			uint16_t id = rng() % KEY_NUM;
+			auto d = random_data_(rng);
+			sim_.set_power_fail(1 + rng() % 40);
+			man->write(id, d.data(), d.size());
+			sim_.set_power_fail(0);
+
+			delete man;
+			man = new MAN(sim_);
+			if(!man->start()) error_out_("start", i);
+
+			data_t r;
+			bool have = read_(*man, id, r);
+			auto it = model.find(id);
+			if(have && r == d) {
+				model[id] = d;
+			} else if(it != model.end() && have && r == it->second) {
+			} else if(it == model.end() && !have) {
+			} else {
+				error_out_("power fail (key)", id);
+			}
+			check_(*man, model, "power fail (others)");
+		}
+	}
+
+}
+
+int main()
+{
+	std::mt19937 rng(7);
+	model_t model;
+
+	auto man = new MAN(sim_);
+	if(!man->format()) {
+		std::printf("format fail\n");
+		return 1;
+	}
+
+	random_(man, model, rng);
+	timing_(man, model, rng);
+	power_fail_(man, model, rng);
+
+	auto st = man->get_stat();
+	std::printf("keys: %u, live: %u, free: %u, erase: %u..%u, gc: %u\n",
+		st.keys, st.live, st.free, st.erase_min, st.erase_max, st.gc);
+	delete man;
+
+	if(error_ == 0) std::printf("OK\n");
+	else std::printf("%d errors\n", error_);
+	return error_ == 0 ? 0 : 1;
+}
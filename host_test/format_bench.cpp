@@ -0,0 +1,78 @@
+//=====================================================================//
+/*!	@file
+	@brief	format のベンチマーク @n
+			一回の変換に掛かる時間（ns）を、utils::sformat（実行時解析）、@n
+			UTILS_SFORMAT（コンパイル時解析）、snprintf で比較する。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdio>
+#include <chrono>
+#include "common/format.hpp"
+
+namespace {
+
+	static const int LOOP = 1000000;
+
+	template <class FUNC>
+	double run_(FUNC f)
+	{
+		auto t0 = std::chrono::steady_clock::now();
+		for(int i = 0; i < LOOP; ++i) f(i);
+		auto t = std::chrono::steady_clock::now() - t0;
+		return std::chrono::duration<double, std::nano>(t).count() / LOOP;
+	}
+
+}
+
+int main()
+{
+	char a[128];
+	volatile uint32_t uv = 123456789;
+	volatile int32_t iv = -1234567;
+	volatile int32_t yv = 12345;
+	volatile float fv = 1234.5678f;
+
+	std::printf("%-12s %10s %14s %10s\n", "", "sformat", "UTILS_SFORMAT", "snprintf");
+
+	std::printf("%-12s %8.1fns %12.1fns %8.1fns\n", "%u",
+		run_([&](int i) { utils::sformat("%u", a, sizeof(a)) % (uv + i); }),
+		run_([&](int i) { UTILS_SFORMAT("%u", a, sizeof(a), uv + i); }),
+		run_([&](int i) { std::snprintf(a, sizeof(a), "%u", uv + i); }));
+
+	std::printf("%-12s %8.1fns %12.1fns %8.1fns\n", "%d",
+		run_([&](int i) { utils::sformat("%d", a, sizeof(a)) % (iv + i); }),
+		run_([&](int i) { UTILS_SFORMAT("%d", a, sizeof(a), iv + i); }),
+		run_([&](int i) { std::snprintf(a, sizeof(a), "%d", iv + i); }));
+
+	std::printf("%-12s %8.1fns %12.1fns %8.1fns\n", "%08x",
+		run_([&](int i) { utils::sformat("%08x", a, sizeof(a)) % (uv + i); }),
+		run_([&](int i) { UTILS_SFORMAT("%08x", a, sizeof(a), uv + i); }),
+		run_([&](int i) { std::snprintf(a, sizeof(a), "%08x", uv + i); }));
+
+	std::printf("%-12s %8.1fns %12.1fns %8.1fns\n", "%.3f",
+		run_([&](int i) { utils::sformat("%.3f", a, sizeof(a)) % (fv + i); }),
+		run_([&](int i) { UTILS_SFORMAT("%.3f", a, sizeof(a), fv + i); }),
+		run_([&](int i) { std::snprintf(a, sizeof(a), "%.3f", fv + i); }));
+
+	std::printf("%-12s %8.1fns %12.1fns %8.1fns\n", "%e",
+		run_([&](int i) { utils::sformat("%e", a, sizeof(a)) % (fv + i); }),
+		run_([&](int i) { UTILS_SFORMAT("%e", a, sizeof(a), fv + i); }),
+		run_([&](int i) { std::snprintf(a, sizeof(a), "%e", fv + i); }));
+
+	std::printf("%-12s %8.1fns %12.1fns %10s\n", "%6.3:8y",
+		run_([&](int i) { utils::sformat("%6.3:8y", a, sizeof(a)) % (yv + i); }),
+		run_([&](int i) { UTILS_SFORMAT("%6.3:8y", a, sizeof(a), yv + i); }),
+		"-");
+
+	std::printf("%-12s %8.1fns %12.1fns %8.1fns\n", "mixed",
+		run_([&](int i) { utils::sformat("T: %d, V: %u (%5.2f)\n", a, sizeof(a))
+			% (iv + i) % (uv + i) % (fv + i); }),
+		run_([&](int i) { UTILS_SFORMAT("T: %d, V: %u (%5.2f)\n", a, sizeof(a),
+			iv + i, uv + i, fv + i); }),
+		run_([&](int i) { std::snprintf(a, sizeof(a), "T: %d, V: %u (%5.2f)\n",
+			iv + i, uv + i, fv + i); }));
+}
@@ -0,0 +1,195 @@
+//=====================================================================//
+/*!	@file
+	@brief	format の出力ファンクタのテスト @n
+			・buffer_chaout：書き出しポリシー（full、line、format）毎の、書き出しの @n
+			  区切りと回数、format 文の終わり（デストラクター）での書き出し @n
+			・ring_chaout：一杯の場合に待つ／捨てる、捨てた数（get_lost）@n
+			・memory_chaout：切り詰めと get_lost、limit が０、１の場合
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "common/format.hpp"
+
+namespace {
+
+	int error_ = 0;
+
+	void error_out_(const char* msg, uint32_t v)
+	{
+		if(error_ < 10) std::printf("%s: %u\n", msg, v);
+		++error_;
+	}
+
+
+	// 書き出しを、一回毎に記録する
+	struct rec_term {
+		std::vector<std::string> out;
+		void operator() (const char* s, uint16_t l) { out.emplace_back(s, l); }
+	};
+
+	typedef utils::buffer_chaout<16, rec_term> BUFFER;
+	typedef utils::basic_format<BUFFER> bformat;
+
+
+	// 一回に step 文字だけ送出する（遅い SCI の代わり）
+	struct slow_drain {
+		std::string	out;
+		uint32_t	step = 3;
+		bool		stop = false;
+		uint32_t	calls = 0;
+
+		template <class FIFO>
+		void operator() (FIFO& fifo) {
+			++calls;
+			if(stop) return;
+			typename FIFO::span_t a, b;
+			uint32_t n = std::min(fifo.get_span(a, b), step);
+			for(uint32_t i = 0; i < n; ++i) out += i < a.len ? a.org[i] : b.org[i - a.len];
+			fifo.get_go(n);
+		}
+	};
+
+	typedef utils::ring_chaout<16, slow_drain> RING;
+	typedef utils::basic_format<RING> rformat;
+
+
+	void buffer_()
+	{
+		auto& c = bformat::chaout();
+		auto& out = c.at_term().out;
+
+		// full：一杯の時だけ
+		c.set_policy(utils::flush_policy::full);
+		bformat("ab\ncd %d") % 12;
+		if(!out.empty()) error_out_("full (newline)", out.size());
+		bformat("0123456789");
+		if(out.size() != 1 || out[0] != "ab\ncd 1201234567") error_out_("full (16)", out.size());
+		c.flush();
+		if(out.size() != 2 || out[1] != "89") error_out_("full (flush)", out.size());
+		c.flush();
+		if(out.size() != 2 || c.get_flush_count() != 2) error_out_("full (empty flush)", out.size());
+		out.clear();
+
+		// line：改行毎、format 文の終わりでは書き出さない
+		c.set_policy(utils::flush_policy::line);
+		bformat("ab\ncd");
+		if(out.size() != 1 || out[0] != "ab\n") error_out_("line", out.size());
+		bformat("%d\n") % 5;
+		if(out.size() != 2 || out[1] != "cd5\n") error_out_("line (2)", out.size());
+		out.clear();
+
+		// format：改行と、format 文の終わり（デストラクター）
+		c.set_policy(utils::flush_policy::format);
+		{
+			bformat f("x=%d, ");
+			f % 1;
+			if(!out.empty()) error_out_("format (before end)", out.size());
+		}
+		if(out.size() != 1 || out[0] != "x=1, ") error_out_("format (end)", out.size());
+		bformat("a\nb");
+		if(out.size() != 3 || out[1] != "a\n" || out[2] != "b") error_out_("format (newline)", out.size());
+		UTILS_BASIC_FORMAT(BUFFER, "v=%d", 42);
+		if(out.size() != 4 || out[3] != "v=42") error_out_("format (static_format)", out.size());
+		out.clear();
+
+		// バッファより長い出力は、SIZE 毎に分かれる
+		bformat("%s") % "0123456789abcdefghijklmnopqrstuvwxyzABCD";
+		if(out.size() != 3 || out[0] != "0123456789abcdef" || out[1] != "ghijklmnopqrstuv"
+			|| out[2] != "wxyzABCD") error_out_("format (long)", out.size());
+		out.clear();
+	}
+
+
+	void ring_()
+	{
+		auto& c = rformat::chaout();
+		auto& d = c.at_drain();
+		static const char* text = "0123456789abcdefghijklmnopqrstuvwxyz\nABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+		// 待つ：全て順番通りに送出される
+		rformat("%s") % text;
+		while(c.at_fifo().length() > 0) c.flush();
+		if(d.out != text || c.get_lost() != 0) error_out_("ring (wait)", c.get_lost());
+
+		// 捨てる：FIFO に入った分だけ送出され、残りは数える
+		d.out.clear();
+		d.stop = true;
+		c.set_wait(false);
+		rformat("%s") % text;
+		uint32_t len = std::strlen(text);
+		if(c.at_fifo().length() != 16 || c.get_lost() != (len - 16)) error_out_("ring (drop)", c.get_lost());
+		d.stop = false;
+		d.step = 100;
+		c.flush();
+		if(d.out != std::string(text, 16) || c.at_fifo().length() != 0) error_out_("ring (drop flush)", 0);
+		c.set_wait(true);
+
+		// ポリシー：full は、一杯になるまで DRAIN を呼ばない
+		d.out.clear();
+		d.calls = 0;
+		c.set_policy(utils::flush_policy::full);
+		rformat("a\nb");
+		if(d.calls != 0 || c.at_fifo().length() != 3) error_out_("ring (full)", d.calls);
+		c.set_policy(utils::flush_policy::line);
+		rformat("c\nd");
+		if(d.calls != 1 || d.out != "a\nbc\n") error_out_("ring (line)", d.calls);
+		c.set_policy(utils::flush_policy::format);
+		rformat("e");
+		if(d.calls != 2 || d.out != "a\nbc\nde") error_out_("ring (format)", d.calls);
+	}
+
+
+	void memory_()
+	{
+		auto& c = utils::sformat::chaout();
+		char buff[8];
+
+		// 切り詰め
+		std::memset(buff, 'x', sizeof(buff));
+		auto n = (utils::sformat("%s", buff, sizeof(buff)) % "abcdefghij").size();
+		if(std::strcmp(buff, "abcdefg") != 0 || n != 7 || c.get_lost() != 3) error_out_("memory (truncate)", n);
+
+		// 追加
+		utils::sformat("abc", buff, sizeof(buff));
+		utils::sformat("defgh", buff, sizeof(buff), true);
+		if(std::strcmp(buff, "abcdefg") != 0 || c.get_lost() != 1) error_out_("memory (append)", c.get_lost());
+
+		// 入りきる
+		utils::sformat("%d", buff, sizeof(buff)) % 123456;
+		if(std::strcmp(buff, "123456") != 0 || c.get_lost() != 0) error_out_("memory (fit)", c.get_lost());
+
+		// limit が０：何も書かず、全て捨てる
+		std::memset(buff, 'x', sizeof(buff));
+		utils::sformat("abc", buff, 0);
+		if(buff[0] != 'x' || c.size() != 0 || c.get_lost() != 3) error_out_("memory (limit 0)", c.get_lost());
+		utils::sformat("abc%d", nullptr, 0) % 1;
+		if(c.size() != 0 || c.get_lost() != 4) error_out_("memory (nullptr)", c.get_lost());
+
+		// limit が１：空文字列
+		utils::sformat("abc", buff, 1);
+		if(buff[0] != 0 || c.size() != 0 || c.get_lost() != 3) error_out_("memory (limit 1)", c.get_lost());
+
+		// static_format も同じ
+		std::memset(buff, 'x', sizeof(buff));
+		n = UTILS_SFORMAT("%d-%d", buff, 6, 123, 456);
+		if(std::strcmp(buff, "123-4") != 0 || n != 5 || c.get_lost() != 2) error_out_("memory (static)", n);
+	}
+}
+
+int main()
+{
+	buffer_();
+	ring_();
+	memory_();
+
+	if(error_ == 0) std::printf("OK\n");
+	else std::printf("%d errors\n", error_);
+	return error_ == 0 ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+//=====================================================================//
+/*!	@file
+	@brief	format の変換精度のテスト @n
+			整数、浮動小数点の変換を、乱数で snprintf と比較する。@n
+			固定小数点（%y）は、正負の対称性と、既知の値で確認する。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <climits>
+#include <random>
+#include "common/format.hpp"
+
+namespace {
+
+	int error_ = 0;
+
+	void check_(const char* form, const char* a, const char* b)
+	{
+		if(std::strcmp(a, b) != 0) {
+			if(error_ < 10) std::printf("'%s': '%s' / '%s'\n", form, a, b);
+			++error_;
+		}
+	}
+
+
+	// format の符号付き変換：桁数は数字だけの桁数で、符号は数字の直前に付く
+	void signed_(char* dst, uint32_t size, const char* uform, int32_t v, bool plus = false)
+	{
+		uint32_t u = v < 0 ? 0u - static_cast<uint32_t>(v) : v;
+		char tmp[32];
+		std::snprintf(tmp, sizeof(tmp), uform, u);
+		char sign = v < 0 ? '-' : (plus ? '+' : 0);
+		uint32_t n = 0;
+		for(const char* p = tmp; *p != 0; ++p) {
+			if(sign != 0 && *p != ' ') {
+				if(n < size - 1) dst[n++] = sign;
+				sign = 0;
+			}
+			if(n < size - 1) dst[n++] = *p;
+		}
+		dst[n] = 0;
+	}
+
+
+	void integer_(std::mt19937& rng)
+	{
+		static const int32_t vals[] = { 0, 1, -1, 9, -10, 99, 100, INT_MAX, INT_MIN, INT_MIN + 1 };
+		char a[256];
+		char b[256];
+		char s[4][32];
+		for(int i = 0; i < 1000000; ++i) {
+			int32_t v;
+			if(i < static_cast<int>(sizeof(vals) / sizeof(vals[0]))) v = vals[i];
+			else v = static_cast<int32_t>(rng()) >> (rng() % 32);
+			uint32_t u = v;
+			signed_(s[0], sizeof(s[0]), "%u", v);
+			signed_(s[1], sizeof(s[1]), "%u", v, true);
+			signed_(s[2], sizeof(s[2]), "%8u", v);
+			signed_(s[3], sizeof(s[3]), "%08u", v);
+			std::snprintf(b, sizeof(b), "%s %s %s %s %u %x %X %08x %o",
+				s[0], s[1], s[2], s[3], u, u, u, u, u);
+			utils::sformat("%d %+d %8d %08d %u %x %X %08x %o", a, sizeof(a))
+				% v % v % v % v % u % u % u % u % u;
+			check_("int", a, b);
+		}
+	}
+
+
+	void real_(std::mt19937& rng)
+	{
+		char a[512];
+		char b[512];
+		char form[32];
+		for(int i = 0; i < 1000000; ++i) {
+			uint32_t bits = rng();
+			// 半分は、実用的な指数の範囲に寄せる
+			if(i & 1) bits = (bits & 0x807fffff) | ((100 + rng() % 60) << 23);
+			float v;
+			std::memcpy(&v, &bits, sizeof(v));
+			if(std::isnan(v) || std::isinf(v)) continue;
+			bool ex = rng() & 1;
+			if(!ex && std::fabs(v) > 1e30f) continue;
+			std::snprintf(form, sizeof(form), "%%.%d%c", 1 + static_cast<int>(rng() % 9), ex ? 'e' : 'f');
+			utils::sformat(form, a, sizeof(a)) % v;
+			std::snprintf(b, sizeof(b), form, static_cast<double>(v));
+			check_(form, a, b);
+		}
+	}
+
+
+	void fixed_(std::mt19937& rng)
+	{
+		char a[128];
+		char b[128];
+		char form[32];
+
+		utils::sformat("%1.2:8y %1.2:8y %1.2:8y", a, sizeof(a)) % 256 % 128 % 384;
+		check_("%1.2:8y", a, "1.00 0.50 1.50");
+		utils::sformat("%1.2:8y", a, sizeof(a)) % -384;
+		check_("%1.2:8y", a, "-1.50");
+		utils::sformat("%1.0:0y %1.0:0y", a, sizeof(a)) % INT_MIN % INT_MAX;
+		check_("%1.0:0y", a, "-2147483648 2147483647");
+		utils::sformat("%1.2:8y", a, sizeof(a)) % INT_MIN;
+		check_("%1.2:8y", a, "-8388608.00");
+
+		// 負の値は、絶対値の表示に「-」が付く
+		for(int i = 0; i < 200000; ++i) {
+			int32_t v = static_cast<int32_t>(rng()) >> (rng() % 32);
+			if(v > 0) v = -v;
+			if(v == 0 || v == INT_MIN) continue;
+			std::snprintf(form, sizeof(form), "%%1.%d:%dy", static_cast<int>(rng() % 10),
+				static_cast<int>(rng() % 32));
+			utils::sformat(form, a, sizeof(a)) % v;
+			b[0] = '-';
+			utils::sformat(form, &b[1], sizeof(b) - 1) % -v;
+			check_(form, a, b);
+		}
+	}
+
+}
+
+int main()
+{
+	std::mt19937 rng(1);
+
+	integer_(rng);
+	real_(rng);
+	fixed_(rng);
+
+	if(error_ == 0) std::printf("OK\n");
+	else std::printf("%d errors\n", error_);
+	return error_ == 0 ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+//=====================================================================//
+/*!	@file
+	@brief	image_io のベンチマーク（SD カードの遅延モデル） @n
+			FatFs、file_io の典型的な使い方で、disk_read/disk_write の回数、@n
+			セクター数と、遅延モデルの積算時間（カードの時間）を比べる。@n
+			・ディレクトリのスキャン（ルート、サブ・ディレクトリ、LFN）@n
+			・MP3/WAV の様な、順番の読み出し（読み出し単位を変える）@n
+			・ロガーの様な、追記（レコードの大きさ、f_sync の間隔を変える）
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#define FAT_FS
+#include <cstdio>
+#include <cstring>
+#include "ff12b/image_io.hpp"
+#include "common/file_io.hpp"
+#include "fat_image.hpp"
+
+namespace {
+
+	static const char* IMAGE = "image_io_bench.img";
+	static const uint32_t SECTORS = 2097152;	///< 1G バイト（32K バイトのクラスター、疎なファイル）
+	static const uint32_t DIR_FILES = 100;	///< LFN で４エントリー（FAT16 のルートは 512）
+	static const uint32_t AUDIO_SIZE = 4 * 1024 * 1024;
+	static const uint32_t LOG_SIZE = 512 * 1024;
+
+	fatfs::image_io	img_;
+
+	void print_head_()
+	{
+		std::printf("%-24s %7s %7s %7s %7s %9s %9s\n",
+			"", "rd cmd", "rd sec", "wr cmd", "wr sec", "card ms", "KB/s");
+	}
+
+
+	// bytes が０の場合、KB/s は表示しない
+	void print_(const char* title, uint32_t bytes)
+	{
+		const auto& st = img_.get_stat();
+		double ms = static_cast<double>(st.time_us) / 1000.0;
+		std::printf("%-24s %7u %7u %7u %7u %9.1f", title,
+			st.read_cmd, st.read_sector, st.write_cmd, st.write_sector, ms);
+		if(bytes > 0 && st.time_us > 0) {
+			std::printf(" %9.1f\n", static_cast<double>(bytes) / 1024.0 / (ms / 1000.0));
+		} else {
+			std::printf(" %9s\n", "-");
+		}
+	}
+
+
+	bool make_dir_(const char* dir)
+	{
+		if(dir[0] != 0 && f_mkdir(dir) != FR_OK) return false;
+		for(uint32_t i = 0; i < DIR_FILES; ++i) {
+			char name[64];
+			std::snprintf(name, sizeof(name), "%s/track %03u - long file name.mp3", dir, i);
+			FIL fp;
+			if(f_open(&fp, name, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) return false;
+			f_close(&fp);
+		}
+		return true;
+	}
+
+
+	void scan_(const char* title, const char* dir, uint32_t num)
+	{
+		img_.clear_stat();
+		DIR dp;
+		FILINFO fi;
+		uint32_t n = 0;
+		if(f_opendir(&dp, dir) == FR_OK) {
+			while(f_readdir(&dp, &fi) == FR_OK && fi.fname[0] != 0) ++n;
+			f_closedir(&dp);
+		}
+		if(n != num) std::printf("%s: %u entries\n", title, n);
+		print_(title, 0);
+	}
+
+
+	bool make_file_(const char* name, uint32_t size)
+	{
+		static uint8_t tmp[4096];
+		FIL fp;
+		if(f_open(&fp, name, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) return false;
+		for(uint32_t i = 0; i < size; i += sizeof(tmp)) {
+			UINT bw = 0;
+			std::memset(tmp, i >> 12, sizeof(tmp));
+			f_write(&fp, tmp, sizeof(tmp), &bw);
+			if(bw != sizeof(tmp)) return false;
+		}
+		f_close(&fp);
+		return true;
+	}
+
+
+	void read_(const char* title, const char* name, uint32_t unit)
+	{
+		static uint8_t tmp[16384];
+		img_.clear_stat();
+		utils::file_io fio;
+		uint32_t total = 0;
+		if(fio.open(name, "rb")) {
+			uint32_t n;
+			while((n = fio.read(tmp, unit)) > 0) total += n;
+			fio.close();
+		}
+		if(total != AUDIO_SIZE) std::printf("%s: %u bytes\n", title, total);
+		print_(title, total);
+	}
+
+
+	// sync が０の場合、最後の close だけ
+	void append_(const char* title, const char* name, uint32_t rec, uint32_t sync)
+	{
+		static uint8_t tmp[512];
+		std::memset(tmp, 'L', sizeof(tmp));
+		img_.clear_stat();
+		utils::file_io fio;
+		uint32_t total = 0;
+		if(fio.open(name, "w")) {
+			for(uint32_t i = 0; total < LOG_SIZE; ++i) {
+				total += fio.write(tmp, rec);
+				if(sync > 0 && ((i + 1) % sync) == 0) f_sync(&fio.at_fd());
+			}
+			fio.close();
+		}
+		if(total != LOG_SIZE) std::printf("%s: %u bytes\n", title, total);
+		print_(title, total);
+		f_unlink(name);
+	}
+}
+
+extern "C" {
+
+	DSTATUS disk_initialize(BYTE drv) { return img_.disk_initialize(drv); }
+	DSTATUS disk_status(BYTE drv) { return img_.disk_status(drv); }
+	DRESULT disk_read(BYTE drv, BYTE* buff, DWORD sector, UINT count) {
+		return img_.disk_read(drv, buff, sector, count);
+	}
+	DRESULT disk_write(BYTE drv, const BYTE* buff, DWORD sector, UINT count) {
+		return img_.disk_write(drv, buff, sector, count);
+	}
+	DRESULT disk_ioctl(BYTE drv, BYTE ctrl, void* buff) { return img_.disk_ioctl(drv, ctrl, buff); }
+	DWORD get_fattime(void) { return 0x4c210000; }
+
+	int make_full_path(const char* src, char* dst, uint16_t dsz)
+	{
+		std::strncpy(dst, src, dsz);
+		dst[dsz - 1] = 0;
+		return 1;
+	}
+
+	void utf8_to_sjis(const char* src, char* dst, uint32_t dsz)
+	{
+		if(src != dst) std::strncpy(dst, src, dsz);
+	}
+};
+
+int main()
+{
+	if(!host::make_fat16(IMAGE, SECTORS) || !img_.open(IMAGE) || !img_.service()) {
+		std::printf("image fail\n");
+		return 1;
+	}
+	if(!make_dir_("") || !make_dir_("/music") || !make_file_("audio.wav", AUDIO_SIZE)) {
+		std::printf("make files fail\n");
+		return 1;
+	}
+
+	std::printf("FAT16 %u sectors, %u files per directory, audio %u KB, log %u KB\n",
+		SECTORS, DIR_FILES, AUDIO_SIZE / 1024, LOG_SIZE / 1024);
+	print_head_();
+	scan_("dir scan (root)", "", DIR_FILES + 2);
+	scan_("dir scan (sub)", "/music", DIR_FILES);
+	read_("read 512 (mp3)", "audio.wav", 512);
+	read_("read 1000 (unaligned)", "audio.wav", 1000);
+	read_("read 4096 (wav)", "audio.wav", 4096);
+	read_("read 16384", "audio.wav", 16384);
+	append_("append 64, sync 8", "log.txt", 64, 8);
+	append_("append 64, no sync", "log.txt", 64, 0);
+	append_("append 512, sync 8", "log.txt", 512, 8);
+	append_("append 512, no sync", "log.txt", 512, 0);
+
+	img_.close();
+	std::remove(IMAGE);
+}
@@ -0,0 +1,207 @@
+//=====================================================================//
+/*!	@file
+	@brief	image_io のテスト @n
+			・範囲外のセクター（sector + count の桁あふれを含む）は、@n
+			  エラーになり、イメージ・ファイルが変化しない事 @n
+			・範囲内の読み書きと、統計 @n
+			・2G バイト、4G バイトを越えるオフセット（スパース・ファイル）@n
+			・マウントして、ファイルの書き込み、読み出しが出来る事
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdio>
+#include <cstring>
+#include "ff12b/image_io.hpp"
+#include "fat_image.hpp"
+
+namespace {
+
+	static const char* IMAGE = "image_io_test.img";
+	static const uint32_t SECTORS = 16384;	///< 8M バイト
+	static const char* LARGE = "image_io_test_large.img";
+	static const uint32_t LARGE_SECTORS = 10485760;	///< 5G バイト
+
+	fatfs::image_io	img_;
+	int		error_ = 0;
+
+	void error_out_(const char* msg, uint32_t v)
+	{
+		if(error_ < 10) std::printf("%s: %u\n", msg, v);
+		++error_;
+	}
+
+
+	long file_size_()
+	{
+		auto fp = std::fopen(IMAGE, "rb");
+		if(fp == nullptr) return -1;
+		std::fseek(fp, 0, SEEK_END);
+		long size = std::ftell(fp);
+		std::fclose(fp);
+		return size;
+	}
+
+
+	void range_()
+	{
+		static const struct { DWORD sector; UINT count; } ng[] = {
+			{ SECTORS, 1 }, { SECTORS - 1, 2 }, { SECTORS + 1, 1 },
+			// DWORD が 32 ビット（MSYS2 など）だと、sector + count が桁あふれする
+			{ 0xffffffff, 1 }, { 0xffffffff, 2 }, { 0xfffffff0, 0x20 },
+		};
+		static BYTE big[512 * 0x20];
+		for(const auto& t : ng) {
+			if(img_.disk_write(0, big, t.sector, t.count) != RES_ERROR) error_out_("write range", t.sector);
+			if(img_.disk_read(0, big, t.sector, t.count) != RES_ERROR) error_out_("read range", t.sector);
+		}
+		std::fflush(nullptr);
+		if(file_size_() != static_cast<long>(SECTORS) * 512) error_out_("image size", file_size_());
+
+		auto st = img_.get_stat();
+		if(st.read_cmd != 0 || st.write_cmd != 0) error_out_("stat (error)", st.read_cmd + st.write_cmd);
+
+		// 最後のセクターは読み書き出来る
+		BYTE buff[512 * 2];
+		std::memset(buff, 0xa5, sizeof(buff));
+		if(img_.disk_write(0, buff, SECTORS - 2, 2) != RES_OK) error_out_("write last", SECTORS - 2);
+		BYTE tmp[512 * 2];
+		if(img_.disk_read(0, tmp, SECTORS - 2, 2) != RES_OK) error_out_("read last", SECTORS - 2);
+		if(std::memcmp(buff, tmp, sizeof(buff)) != 0) error_out_("compare last", SECTORS - 2);
+		std::memset(buff, 0, sizeof(buff));
+		img_.disk_write(0, buff, SECTORS - 2, 2);
+
+		st = img_.get_stat();
+		if(st.read_cmd != 1 || st.read_sector != 2 || st.write_cmd != 2 || st.write_sector != 4) {
+			error_out_("stat", st.read_cmd);
+		}
+		if(img_.disk_read(0, tmp, 0, 0) != RES_PARERR) error_out_("count 0", 0);
+
+		DWORD n = 0;
+		if(img_.disk_ioctl(0, GET_SECTOR_COUNT, &n) != RES_OK || n != SECTORS) {
+			error_out_("sector count", n);
+		}
+	}
+
+
+	// long が 32 ビットでも、2G バイトを越える位置を読み書き出来る
+	void large_()
+	{
+		auto fp = std::fopen(LARGE, "wb");
+		if(fp == nullptr || fseeko(fp, static_cast<off_t>(LARGE_SECTORS) * 512 - 1, SEEK_SET) != 0) {
+			error_out_("large create", 0);
+			if(fp != nullptr) std::fclose(fp);
+			return;
+		}
+		std::fputc(0, fp);
+		std::fclose(fp);
+
+		static fatfs::image_io img;
+		if(!img.open(LARGE)) {
+			error_out_("large open", 0);
+			return;
+		}
+		DWORD n = 0;
+		if(img.disk_ioctl(0, GET_SECTOR_COUNT, &n) != RES_OK || n != LARGE_SECTORS) {
+			error_out_("large sector count", n);
+		}
+		// 2G、4G バイトの前後と、最後のセクター
+		static const DWORD sec[] = {
+			0x3fffff, 0x400000, 0x7fffff, 0x800000, LARGE_SECTORS - 1
+		};
+		BYTE buff[512];
+		for(auto s : sec) {
+			std::memset(buff, 0, sizeof(buff));
+			std::memcpy(buff, &s, sizeof(s));
+			if(img.disk_write(0, buff, s, 1) != RES_OK) error_out_("large write", s);
+		}
+		for(auto s : sec) {
+			if(img.disk_read(0, buff, s, 1) != RES_OK || std::memcmp(buff, &s, sizeof(s)) != 0) {
+				error_out_("large read", s);
+			}
+		}
+		if(img.disk_read(0, buff, LARGE_SECTORS, 1) != RES_ERROR) error_out_("large range", LARGE_SECTORS);
+		img.close();
+
+		// ファイルの位置を直接確かめる
+		fp = std::fopen(LARGE, "rb");
+		for(auto s : sec) {
+			DWORD v = 0;
+			if(fseeko(fp, static_cast<off_t>(s) * 512, SEEK_SET) != 0 || std::fread(&v, sizeof(v), 1, fp) != 1
+				|| v != s) error_out_("large offset", s);
+		}
+		std::fclose(fp);
+		std::remove(LARGE);
+	}
+
+
+	void file_()
+	{
+		if(!img_.service()) {
+			error_out_("mount", 0);
+			return;
+		}
+		static const char text[] = "image_io file test\n";
+		FIL fp;
+		UINT bw = 0;
+		if(f_open(&fp, "test.txt", FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) error_out_("f_open", 0);
+		for(int i = 0; i < 1000; ++i) {
+			f_write(&fp, text, sizeof(text) - 1, &bw);
+		}
+		f_close(&fp);
+
+		// 開き直して確認
+		img_.close();
+		if(!img_.open(IMAGE) || !img_.service()) {
+			error_out_("remount", 0);
+			return;
+		}
+		if(f_open(&fp, "test.txt", FA_READ) != FR_OK) error_out_("f_open (read)", 0);
+		if(f_size(&fp) != (sizeof(text) - 1) * 1000) error_out_("f_size", f_size(&fp));
+		char tmp[sizeof(text)];
+		for(int i = 0; i < 1000; ++i) {
+			UINT br = 0;
+			f_read(&fp, tmp, sizeof(text) - 1, &br);
+			if(br != sizeof(text) - 1 || std::memcmp(tmp, text, br) != 0) {
+				error_out_("f_read", i);
+				break;
+			}
+		}
+		f_close(&fp);
+	}
+}
+
+extern "C" {
+
+	DSTATUS disk_initialize(BYTE drv) { return img_.disk_initialize(drv); }
+	DSTATUS disk_status(BYTE drv) { return img_.disk_status(drv); }
+	DRESULT disk_read(BYTE drv, BYTE* buff, DWORD sector, UINT count) {
+		return img_.disk_read(drv, buff, sector, count);
+	}
+	DRESULT disk_write(BYTE drv, const BYTE* buff, DWORD sector, UINT count) {
+		return img_.disk_write(drv, buff, sector, count);
+	}
+	DRESULT disk_ioctl(BYTE drv, BYTE ctrl, void* buff) { return img_.disk_ioctl(drv, ctrl, buff); }
+	DWORD get_fattime(void) { return 0x4c210000; }
+};
+
+int main()
+{
+	if(!host::make_fat16(IMAGE, SECTORS) || !img_.open(IMAGE)) {
+		std::printf("image fail\n");
+		return 1;
+	}
+
+	range_();
+	large_();
+	file_();
+
+	img_.close();
+	std::remove(IMAGE);
+
+	if(error_ == 0) std::printf("OK\n");
+	else std::printf("%d errors\n", error_);
+	return error_ == 0 ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+//=====================================================================//
+/*!	@file
+	@brief	log_file のベンチマーク（SD カード・シミュレーター、mmc_io） @n
+			ロガーの様に、小さなレコードを書き続け、write 一回毎の時間（カードの @n
+			遅延モデル）の平均、p99.9、最大（最悪値）を、f_write と比べる。@n
+			・f_write：ファイルの追記（クラスターの確保で、FAT を読み書きする）@n
+			・f_write + f_sync：log_file のチェックポイントと同じ間隔で f_sync @n
+			・log_file：セクターが一杯になる毎に、そのセクター（とヘッダー）を書く @n
+			※時間は、sd_card_sim.hpp の遅延モデル（SPI 25MHz、書き込み busy 800us）
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#define FAT_FS
+#define F_ICLK 120000000
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+// mmc_io は、ダミー・クロックの読み捨てに、未使用の変数を使う
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#include "ff12b/mmc_io.hpp"
+#pragma GCC diagnostic pop
+#include "common/log_file.hpp"
+#include "sd_card_sim.hpp"
+#include "fat_image.hpp"
+
+namespace {
+
+	static const char* IMAGE = "log_file_bench.img";
+	static const uint32_t SECTORS = 65536;	///< 32M バイト
+	static const uint32_t LOG_SIZE = 1024 * 1024;
+	static const uint32_t CHECK = 32;		///< チェックポイントの間隔（セクター数）
+
+	typedef fatfs::mmc_io<host::sd_spi, host::sd_sel, host::sd_null, host::sd_null> MMC;
+
+	host::sd_card&	card_ = host::sd_card::get();
+	host::sd_spi	spi_;
+	MMC		mmc_(spi_, 25000000);
+	FATFS	fatfs_;
+
+	std::vector<uint32_t>	lat_;	///< write 一回毎の時間（ナノ秒）
+
+	void print_head_()
+	{
+		std::printf("%-24s %7s %7s %9s %9s %9s %9s\n",
+			"", "wr sec", "rd cmd", "mean us", "p99.9 us", "max us", "KB/s");
+	}
+
+
+	void print_(const char* title, uint32_t bytes)
+	{
+		std::sort(lat_.begin(), lat_.end());
+		uint64_t sum = 0;
+		for(auto t : lat_) sum += t;
+		double mean = static_cast<double>(sum) / lat_.size() / 1000.0;
+		double p999 = static_cast<double>(lat_[lat_.size() * 999 / 1000]) / 1000.0;
+		double max = static_cast<double>(lat_.back()) / 1000.0;
+		double sec = static_cast<double>(card_.time_ns) / 1e9;
+		std::printf("%-24s %7u %7u %9.1f %9.1f %9.1f %9.1f\n", title,
+			card_.write_blocks, card_.single_read + card_.multi_read, mean, p999, max,
+			static_cast<double>(bytes) / 1024.0 / sec);
+	}
+
+
+	// sync が０の場合、f_sync はしない（最後の close だけ）
+	void f_write_(const char* title, uint32_t rec, uint32_t sync)
+	{
+		static uint8_t tmp[512];
+		std::memset(tmp, 'F', sizeof(tmp));
+		FIL fp;
+		if(f_open(&fp, "f_write.log", FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+			std::printf("%s: open fail\n", title);
+			return;
+		}
+		lat_.clear();
+		card_.clear_count();
+		uint32_t total = 0;
+		uint32_t next = sync;
+		while(total < LOG_SIZE) {
+			uint32_t l = std::min(rec, LOG_SIZE - total);
+			auto t = card_.time_ns;
+			UINT bw = 0;
+			f_write(&fp, tmp, l, &bw);
+			total += bw;
+			if(sync > 0 && total >= next) {
+				f_sync(&fp);
+				next += sync;
+			}
+			lat_.push_back(card_.time_ns - t);
+			if(bw != l) break;
+		}
+		f_close(&fp);
+		if(total != LOG_SIZE) std::printf("%s: %u bytes\n", title, total);
+		print_(title, total);
+		f_unlink("f_write.log");
+	}
+
+
+	template <uint32_t CHK>
+	void log_file_(const char* title, uint32_t rec)
+	{
+		static uint8_t tmp[512];
+		std::memset(tmp, 'L', sizeof(tmp));
+		utils::log_file<CHK> log;
+		if(!log.open("ring.log", LOG_SIZE)) {
+			std::printf("%s: open fail\n", title);
+			return;
+		}
+		lat_.clear();
+		card_.clear_count();
+		uint32_t total = 0;
+		while(total < LOG_SIZE) {
+			uint32_t l = std::min(rec, LOG_SIZE - total);
+			auto t = card_.time_ns;
+			auto n = log.write(tmp, l);
+			total += n;
+			lat_.push_back(card_.time_ns - t);
+			if(n != l) break;
+		}
+		log.close();
+		if(total != LOG_SIZE) std::printf("%s: %u bytes\n", title, total);
+		print_(title, total);
+		f_unlink("ring.log");
+	}
+
+
+	void run_(uint32_t rec)
+	{
+		char title[32];
+		std::printf("record %u bytes, %u KB\n", rec, LOG_SIZE / 1024);
+		print_head_();
+		f_write_("f_write", rec, 0);
+		std::snprintf(title, sizeof(title), "f_write + f_sync %uK", CHECK * 512 / 1024);
+		f_write_(title, rec, CHECK * 512);
+		std::snprintf(title, sizeof(title), "log_file<%u>", CHECK);
+		log_file_<CHECK>(title, rec);
+		std::snprintf(title, sizeof(title), "log_file<%u>", CHECK / 4);
+		log_file_<CHECK / 4>(title, rec);
+	}
+}
+
+extern "C" {
+
+	DSTATUS disk_initialize(BYTE drv) { return mmc_.disk_initialize(drv); }
+	DSTATUS disk_status(BYTE drv) { return mmc_.disk_status(drv); }
+	DRESULT disk_read(BYTE drv, BYTE* buff, DWORD sector, UINT count) {
+		return mmc_.disk_read(drv, buff, sector, count);
+	}
+	DRESULT disk_write(BYTE drv, const BYTE* buff, DWORD sector, UINT count) {
+		return mmc_.disk_write(drv, buff, sector, count);
+	}
+	DRESULT disk_ioctl(BYTE drv, BYTE ctrl, void* buff) { return mmc_.disk_ioctl(drv, ctrl, buff); }
+	DWORD get_fattime(void) { return 0x4c210000; }
+
+	int make_full_path(const char* src, char* dst, uint16_t dsz)
+	{
+		std::strncpy(dst, src, dsz);
+		dst[dsz - 1] = 0;
+		return 1;
+	}
+
+	void utf8_to_sjis(const char* src, char* dst, uint32_t dsz)
+	{
+		if(src != dst) std::strncpy(dst, src, dsz);
+	}
+
+	void sci_putch(char ch) { std::putchar(ch); }
+};
+
+int main()
+{
+	// FAT16 のイメージを作り、カードに写す
+	card_.reset(SECTORS);
+	bool ok = host::make_fat16(IMAGE, SECTORS);
+	if(ok) {
+		auto fp = std::fopen(IMAGE, "rb");
+		ok = fp != nullptr && std::fread(card_.mem.data(), 512, SECTORS, fp) == SECTORS;
+		if(fp != nullptr) std::fclose(fp);
+	}
+	std::remove(IMAGE);
+	mmc_.start();
+	if(!ok || f_mount(&fatfs_, "", 1) != FR_OK) {
+		std::printf("image fail\n");
+		return 1;
+	}
+
+	run_(64);
+	run_(200);
+
+	f_mount(nullptr, "", 0);
+	if(card_.error != 0) std::printf("protocol error: %u\n", card_.error);
+}
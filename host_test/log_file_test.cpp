@@ -0,0 +1,235 @@
+//=====================================================================//
+/*!	@file
+	@brief	log_file のテスト（image_io 上で動かす） @n
+			・何周も書いて、古い順に読めるセクターが、書いた内容の最後の部分と @n
+			  一致する事（書き込み中のセクターは、有効バイト数以降が０） @n
+			・close して開き直すと、続きから書ける事 @n
+			・close せずに開き直すと（電源断）、最後のチェックポイントから再開し、@n
+			  それより前の内容は残る事 @n
+			・大きさが違う場合は、新規に作り直す事
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#define FAT_FS
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <vector>
+#include <random>
+#include "ff12b/image_io.hpp"
+#include "common/log_file.hpp"
+#include "fat_image.hpp"
+
+namespace {
+
+	static const char* IMAGE = "log_file_test.img";
+	static const char* LOG = "ring.log";
+	static const uint32_t SECTORS = 16384;	///< 8M バイト
+	static const uint32_t SECTOR_SIZE = 512;
+	static const uint32_t NUM = 20;			///< 記録領域のセクター数
+	static const uint32_t CHECK = 4;
+
+	typedef utils::log_file<CHECK> LOG_FILE;
+	typedef std::vector<uint8_t> stream_t;
+
+	fatfs::image_io	img_;
+	int		error_ = 0;
+
+	void error_out_(const char* msg, uint32_t v)
+	{
+		if(error_ < 10) std::printf("%s: %u\n", msg, v);
+		++error_;
+	}
+
+
+	void write_(LOG_FILE& log, stream_t& stream, std::mt19937& rng, uint32_t len)
+	{
+		uint8_t tmp[1000];
+		uint32_t n = 0;
+		while(n < len) {
+			uint32_t l = 1 + rng() % sizeof(tmp);
+			if(l > (len - n)) l = len - n;
+			for(uint32_t i = 0; i < l; ++i) {
+				tmp[i] = rng() | 1;  // ０は、書き込み中のセクターの残りと区別する
+			}
+			if(log.write(tmp, l) != l) error_out_("write", stream.size());
+			stream.insert(stream.end(), tmp, tmp + l);
+			n += l;
+		}
+	}
+
+
+	// 古い順に読んだ内容が、stream の最後の部分と一致する事
+	//   skip: 先頭（最も古い方）の比較しないセクター数
+	void check_(LOG_FILE& log, const stream_t& stream, const char* msg, uint32_t skip = 0)
+	{
+		uint32_t full = stream.size() / SECTOR_SIZE;
+		uint32_t fill = stream.size() % SECTOR_SIZE;
+		uint32_t org = full >= NUM ? (full - (NUM - 1)) : 0;
+		uint32_t num = (full - org) + (fill > 0 ? 1 : 0);
+
+		const auto& h = log.get_header();
+		if(h.head != (full % NUM) || h.fill != fill || h.wrap != (full / NUM)) {
+			error_out_(msg, h.head);
+		}
+		if(log.get_sectors() != num) {
+			error_out_(msg, log.get_sectors());
+			return;
+		}
+		uint8_t tmp[SECTOR_SIZE];
+		uint8_t ref[SECTOR_SIZE];
+		for(uint32_t i = skip; i < num; ++i) {
+			uint32_t pos = (org + i) * SECTOR_SIZE;
+			uint32_t len = stream.size() - pos;
+			if(len > SECTOR_SIZE) len = SECTOR_SIZE;
+			std::memset(ref, 0, sizeof(ref));
+			std::memcpy(ref, &stream[pos], len);
+			if(!log.read_sector(i, tmp) || std::memcmp(tmp, ref, SECTOR_SIZE) != 0) {
+				error_out_(msg, i);
+			}
+		}
+		if(log.read_sector(num, tmp)) error_out_(msg, num);
+	}
+
+
+	// 書き込み、一周以上、閉じて開き直す
+	void wrap_(stream_t& stream, std::mt19937& rng)
+	{
+		LOG_FILE log;
+		if(!log.open(LOG, NUM * SECTOR_SIZE)) {
+			error_out_("open", 0);
+			return;
+		}
+		check_(log, stream, "empty");
+		for(uint32_t i = 0; i < 40; ++i) {
+			write_(log, stream, rng, 1 + rng() % 3000);
+			check_(log, stream, "wrap");
+			if((rng() % 4) == 0 && !log.sync()) error_out_("sync", i);
+		}
+		if(log.get_header().wrap < 2) error_out_("wrap count", log.get_header().wrap);
+
+		auto h = log.get_header();
+		log.close();
+		if(log.is_open() || log.get_sectors() != 0) error_out_("close", 0);
+		for(uint32_t i = 0; i < 3; ++i) {
+			if(!log.open(LOG, NUM * SECTOR_SIZE)) error_out_("resume", i);
+			const auto& r = log.get_header();
+			if(r.head != h.head || r.fill != h.fill || r.wrap != h.wrap) error_out_("resume header", i);
+			check_(log, stream, "resume");
+			write_(log, stream, rng, 1 + rng() % 5000);
+			check_(log, stream, "resume write");
+			h = log.get_header();
+			log.close();
+		}
+	}
+
+
+	// close しない（電源断）
+	void power_fail_(stream_t& stream, std::mt19937& rng)
+	{
+		for(uint32_t n = 0; n < 20; ++n) {
+			// デストラクターで close しないように、領域だけ確保する
+			alignas(LOG_FILE) static uint8_t mem[sizeof(LOG_FILE)];
+			auto lost = new(mem) LOG_FILE;
+			if(!lost->open(LOG, NUM * SECTOR_SIZE)) {
+				error_out_("open (power fail)", n);
+				return;
+			}
+			write_(*lost, stream, rng, 1 + rng() % 2000);
+			lost->sync();
+			stream_t saved = stream;
+			auto h = lost->get_header();
+			// チェックポイントに届かない、追加の書き込み
+			uint32_t extra = rng() % ((CHECK - 1) * SECTOR_SIZE);
+			write_(*lost, stream, rng, extra);
+			uint32_t over = (h.fill + extra) / SECTOR_SIZE;  // 上書きされたセクター数
+			if(lost->get_header().check != h.check) error_out_("checkpoint", n);
+
+			stream = saved;
+			LOG_FILE log;
+			if(!log.open(LOG, NUM * SECTOR_SIZE)) {
+				error_out_("open (resume)", n);
+				return;
+			}
+			const auto& r = log.get_header();
+			if(r.head != h.head || r.fill != h.fill || r.wrap != h.wrap) error_out_("resume header", n);
+			// 上書きされた、古いセクターは比較しない
+			check_(log, stream, "power fail", over);
+			// 続きから書ける
+			write_(log, stream, rng, NUM * SECTOR_SIZE);
+			check_(log, stream, "power fail write");
+			log.close();
+		}
+	}
+
+
+	// 大きさが違う場合は、作り直し
+	void resize_()
+	{
+		LOG_FILE log;
+		if(!log.open(LOG, (NUM + 5) * SECTOR_SIZE)) {
+			error_out_("open (resize)", 0);
+			return;
+		}
+		const auto& h = log.get_header();
+		if(h.num != (NUM + 5) || h.head != 0 || h.fill != 0 || h.wrap != 0 || log.get_sectors() != 0) {
+			error_out_("resize", h.num);
+		}
+		log.close();
+
+		FILINFO fi;
+		if(f_stat(LOG, &fi) != FR_OK || fi.fsize != (NUM + 5 + 1) * SECTOR_SIZE) {
+			error_out_("file size", fi.fsize);
+		}
+	}
+}
+
+extern "C" {
+
+	DSTATUS disk_initialize(BYTE drv) { return img_.disk_initialize(drv); }
+	DSTATUS disk_status(BYTE drv) { return img_.disk_status(drv); }
+	DRESULT disk_read(BYTE drv, BYTE* buff, DWORD sector, UINT count) {
+		return img_.disk_read(drv, buff, sector, count);
+	}
+	DRESULT disk_write(BYTE drv, const BYTE* buff, DWORD sector, UINT count) {
+		return img_.disk_write(drv, buff, sector, count);
+	}
+	DRESULT disk_ioctl(BYTE drv, BYTE ctrl, void* buff) { return img_.disk_ioctl(drv, ctrl, buff); }
+	DWORD get_fattime(void) { return 0x4c210000; }
+
+	int make_full_path(const char* src, char* dst, uint16_t dsz)
+	{
+		std::strncpy(dst, src, dsz);
+		dst[dsz - 1] = 0;
+		return 1;
+	}
+
+	void utf8_to_sjis(const char* src, char* dst, uint32_t dsz)
+	{
+		if(src != dst) std::strncpy(dst, src, dsz);
+	}
+};
+
+int main()
+{
+	if(!host::make_fat16(IMAGE, SECTORS) || !img_.open(IMAGE) || !img_.service()) {
+		std::printf("image fail\n");
+		return 1;
+	}
+
+	std::mt19937 rng(13);
+	stream_t stream;
+	wrap_(stream, rng);
+	power_fail_(stream, rng);
+	resize_();
+
+	img_.close();
+	std::remove(IMAGE);
+
+	if(error_ == 0) std::printf("OK\n");
+	else std::printf("%d errors\n", error_);
+	return error_ == 0 ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+//=====================================================================//
+/*!	@file
+	@brief	log_man のテスト（RAM 上の MEMIO で動かす） @n
+			・putch、puts で書いたテキストの末尾（リングに残る分）が、@n
+			  バッファ有り、無しで同じ事 @n
+			・バッファ有りは、MEMIO への書き込み回数が減る事 @n
+			・再起動（start）で、記録が引き継がれる事 @n
+			・バイナリー・レコードを、log_reader で書いた順に読み出せる事
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "common/log_man.hpp"
+
+namespace {
+
+	struct memio {
+		static const uint32_t SIZE = 8192;
+		static uint8_t	mem_[SIZE];
+		static uint32_t	write_;		///< 書き込み回数
+
+		static void start() { }
+
+		static bool put8(uint32_t pos, uint8_t d) {
+			if(pos >= SIZE) return false;
+			mem_[pos] = d;
+			++write_;
+			return true;
+		}
+
+		static uint32_t copy(const void* src, uint32_t len, uint32_t dst) {
+			if(src == nullptr || dst >= SIZE) return 0;
+			if(len > (SIZE - dst)) len = SIZE - dst;
+			std::memcpy(&mem_[dst], src, len);
+			++write_;
+			return len;
+		}
+
+		static bool get8(uint32_t pos, uint8_t& d) {
+			if(pos >= SIZE) return false;
+			d = mem_[pos];
+			return true;
+		}
+
+		static uint32_t copy(uint32_t src, uint32_t len, void* dst) {
+			if(dst == nullptr || src >= SIZE) return 0;
+			if(len > (SIZE - src)) len = SIZE - src;
+			std::memcpy(dst, &mem_[src], len);
+			return len;
+		}
+	};
+	uint8_t memio::mem_[memio::SIZE];
+	uint32_t memio::write_;
+
+	int error_ = 0;
+
+	void error_out_(const char* msg, uint32_t v = 0)
+	{
+		if(error_ < 10) std::printf("%s (%u)\n", msg, v);
+		++error_;
+	}
+
+
+	template <class LM>
+	std::string get_text_(const LM& lm)
+	{
+		std::string s;
+		for(uint32_t i = 0; i < lm.get_length(); ++i) s += lm.getch(i);
+		return s;
+	}
+
+
+	// テキストを書き、リングに残る末尾を比較する（書き込み回数を返す）
+	template <class LM>
+	uint32_t text_(const char* name, bool ch)
+	{
+		std::memset(memio::mem_, 0, sizeof(memio::mem_));
+		LM lm;
+		lm.start();
+		lm.clear();
+		memio::write_ = 0;
+
+		std::string ref;
+		for(int i = 0; i < 2000; ++i) {
+			char line[64];
+			std::snprintf(line, sizeof(line), "line %d value %d\n", i, i * 7);
+			if(ch) {
+				for(const char* p = line; *p != 0; ++p) lm.putch(*p);
+			} else {
+				lm.puts(line);
+			}
+			ref += line;
+		}
+		lm.flush();
+		uint32_t n = memio::write_;
+
+		auto s = get_text_(lm);
+		if(s.empty() || s != ref.substr(ref.size() - s.size())) error_out_(name);
+
+		// 再起動しても、同じ内容
+		LM re;
+		re.start();
+		if(get_text_(re) != s) error_out_(name, 1);
+
+		std::printf("%-16s %6u writes, length %u\n", name, n, lm.get_length());
+		return n;
+	}
+
+
+	void record_()
+	{
+		utils::log_man<memio, 64> lm;
+		lm.start();
+		lm.clear();
+		lm.puts("text before\n");
+		static const uint32_t NUM = 2000;
+		for(uint32_t i = 0; i < NUM; ++i) {
+			uint8_t d[16];
+			for(uint32_t j = 0; j < sizeof(d); ++j) d[j] = i + j;
+			lm.put_record(i * 10, i & 0xff, d, 1 + i % 16);
+		}
+
+		utils::log_reader rd;
+		if(!rd.open(memio::mem_, memio::SIZE)) {
+			error_out_("log_reader open");
+			return;
+		}
+		utils::log_record_t r;
+		uint32_t n = 0;
+		uint32_t last = 0;
+		while(rd.next(r)) {
+			uint32_t i = r.time / 10;
+			if(n > 0 && i != (last + 1)) error_out_("record order", i);
+			if(r.id != (i & 0xff) || r.len != (1 + i % 16) || r.data[0] != static_cast<uint8_t>(i)) {
+				error_out_("record data", i);
+			}
+			last = i;
+			++n;
+		}
+		if(n == 0 || last != (NUM - 1)) error_out_("record last", last);
+		std::printf("records: %u (last %u)\n", n, last);
+	}
+
+}
+
+int main()
+{
+	auto a = text_<utils::log_man<memio>>("putch", true);
+	text_<utils::log_man<memio>>("puts", false);
+	auto b = text_<utils::log_man<memio, 64>>("buffered putch", true);
+	text_<utils::log_man<memio, 64>>("buffered puts", false);
+	if(b >= a) error_out_("write combining", b);
+
+	record_();
+
+	if(error_ == 0) std::printf("OK\n");
+	else std::printf("%d errors\n", error_);
+	return error_ == 0 ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+//=====================================================================//
+/*!	@file
+	@brief	mmc_io のテスト（SPI 接続の SD カード・シミュレーター（sd_card_sim.hpp）上で動かす） @n
+			・ストリーム無し／有りで、乱数の読み書きを繰り返し、モデルと一致する事 @n
+			  （連続読み出し、ストリームの続きへの書き込み、FAT 参照を挟む読み出しを含む）@n
+			・ストリーム中に、CMD12 以外のコマンドを送らない事 @n
+			・連続読み出しのコマンド数（CMD17、CMD18、CMD12）が、モードで決まる値になり、@n
+			  カードから受け取ったデータ・ブロックが、要求したセクター数と同じ事 @n
+			  （先読み、読み捨ては無い）
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#define F_ICLK 120000000
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <random>
+// mmc_io は、ダミー・クロックの読み捨てに、未使用の変数を使う
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#include "ff12b/mmc_io.hpp"
+#pragma GCC diagnostic pop
+#include "sd_card_sim.hpp"
+
+namespace {
+
+	static const uint32_t SECTORS = 16384;	///< 8M バイト
+	static const uint32_t SECTOR_SIZE = 512;
+
+	int		error_ = 0;
+
+	void error_out_(const char* msg, uint32_t v)
+	{
+		if(error_ < 10) std::printf("%s: %u\n", msg, v);
+		++error_;
+	}
+
+
+	typedef host::sd_spi spi_t;
+	typedef host::sd_sel sel_t;
+	typedef host::sd_null null_t;
+
+	host::sd_card&	card_ = host::sd_card::get();
+	spi_t	spi_;
+
+	typedef std::vector<uint8_t> image_t;
+
+	template <class MMC>
+	void random_(MMC& mmc, image_t& model, std::mt19937& rng, const char* name)
+	{
+		static BYTE buff[SECTOR_SIZE * 16];
+		DWORD next = 0;
+		for(int i = 0; i < 50000; ++i) {
+			UINT count = (rng() % 4) == 0 ? (2 + rng() % 15) : 1;
+			DWORD sector;
+			switch(rng() % 4) {
+			case 0:  // 続き（ストリーム）
+			case 1:
+				sector = next;
+				break;
+			case 2:  // 少し先に飛ばす
+				sector = next + rng() % 12;
+				break;
+			default:
+				sector = rng() % SECTORS;
+				break;
+			}
+			if(sector + count > SECTORS) sector = SECTORS - count;
+			if((rng() % 8) == 0) {
+				for(UINT j = 0; j < count * SECTOR_SIZE; ++j) buff[j] = rng();
+				if(mmc.disk_write(0, buff, sector, count) != RES_OK) error_out_(name, sector);
+				std::memcpy(&model[sector * SECTOR_SIZE], buff, count * SECTOR_SIZE);
+				// 書いた所（閉じたストリームの続き）を、続けて読む
+				if(rng() & 1) {
+					next = sector;
+					continue;
+				}
+			} else {
+				if(mmc.disk_read(0, buff, sector, count) != RES_OK) error_out_(name, sector);
+				if(std::memcmp(buff, &model[sector * SECTOR_SIZE], count * SECTOR_SIZE) != 0) {
+					error_out_(name, sector);
+				}
+			}
+			next = sector + count;
+			if((rng() % 256) == 0) mmc.disk_ioctl(0, CTRL_SYNC, nullptr);
+		}
+		mmc.disk_ioctl(0, CTRL_SYNC, nullptr);
+		if(card_.cs) error_out_("deselect", 0);
+		if(card_.mem != model) error_out_("card memory", 0);
+	}
+
+
+	// ファイルの逐次読み出し（１セクター毎、64 セクター毎に FAT を参照する）
+	template <class MMC>
+	void sequential_(MMC& mmc, const image_t& model, bool stream, const char* name)
+	{
+		card_.clear_count();
+		BYTE buff[SECTOR_SIZE];
+		for(DWORD sector = 1000; sector < 5000; ++sector) {
+			if((sector % 64) == 0) {
+				mmc.disk_read(0, buff, 2 + (sector / 256), 1);  // FAT
+			}
+			if(mmc.disk_read(0, buff, sector, 1) != RES_OK
+				|| std::memcmp(buff, &model[sector * SECTOR_SIZE], SECTOR_SIZE) != 0) {
+				error_out_(name, sector);
+			}
+		}
+		mmc.stop_stream();
+		if(card_.cs) error_out_("deselect", 0);
+		std::printf("%s: sequential 4000 sectors, cmds %u (CMD17 %u, CMD18 %u, CMD12 %u), %u bytes\n",
+			name, card_.cmds, card_.single_read, card_.multi_read, card_.stop, card_.bytes);
+
+		// FAT の参照は 63 回
+		// ストリーム無し：全て CMD17
+		// ストリーム有り：最初の１セクターは CMD17、次から CMD18、FAT の参照毎に @n
+		//   CMD12、CMD17（FAT）、CMD18（閉じたストリームの続き）、最後に CMD12
+		static const uint32_t FAT = 63;
+		static const uint32_t SECS = 4000 + FAT;
+		uint32_t s17 = stream ? (1 + FAT) : SECS;
+		uint32_t s18 = stream ? (1 + FAT) : 0;
+		uint32_t s12 = stream ? (FAT + 1) : 0;
+		if(card_.single_read != s17 || card_.multi_read != s18 || card_.stop != s12
+			|| card_.cmds != (s17 + s18 + s12)) error_out_("sequential cmds", card_.cmds);
+		if(card_.blocks != SECS) error_out_("sequential blocks", card_.blocks);
+	}
+
+
+	// 連続したマルチ・セクターの読み出し（８セクター毎）
+	template <class MMC>
+	void burst_(MMC& mmc, const image_t& model, bool stream, const char* name)
+	{
+		static const uint32_t NUM = 8;
+		static const uint32_t CALLS = 250;
+		card_.clear_count();
+		static BYTE buff[SECTOR_SIZE * NUM];
+		for(DWORD sector = 6000; sector < (6000 + NUM * CALLS); sector += NUM) {
+			if(mmc.disk_read(0, buff, sector, NUM) != RES_OK
+				|| std::memcmp(buff, &model[sector * SECTOR_SIZE], sizeof(buff)) != 0) {
+				error_out_(name, sector);
+			}
+		}
+		mmc.stop_stream();
+		if(card_.cs) error_out_("deselect", 0);
+		std::printf("%s: burst %u x %u sectors, cmds %u (CMD18 %u, CMD12 %u), %u bytes\n",
+			name, CALLS, NUM, card_.cmds, card_.multi_read, card_.stop, card_.bytes);
+
+		// ストリーム無し：呼び出し毎に CMD18、CMD12、ストリーム有り：１回だけ
+		uint32_t n = stream ? 1 : CALLS;
+		if(card_.multi_read != n || card_.stop != n || card_.cmds != (n * 2)) {
+			error_out_("burst cmds", card_.cmds);
+		}
+		if(card_.blocks != (NUM * CALLS)) error_out_("burst blocks", card_.blocks);
+	}
+
+
+	template <bool STREAM>
+	void test_(image_t& model, std::mt19937& rng, const char* name)
+	{
+		typedef fatfs::mmc_io<spi_t, sel_t, null_t, null_t, STREAM> MMC;
+		MMC mmc(spi_, 25000000);
+		mmc.start();
+		if(mmc.disk_initialize(0) != 0) {
+			error_out_("initialize", STREAM);
+			return;
+		}
+		DWORD n = 0;
+		if(mmc.disk_ioctl(0, GET_SECTOR_COUNT, &n) != RES_OK || n != SECTORS) {
+			error_out_("sector count", n);
+		}
+		random_(mmc, model, rng, name);
+		sequential_(mmc, model, STREAM, name);
+		burst_(mmc, model, STREAM, name);
+	}
+}
+
+extern "C" {
+	void sci_putch(char ch) { std::putchar(ch); }
+};
+
+int main()
+{
+	std::mt19937 rng(5);
+	image_t model(SECTORS * SECTOR_SIZE);
+	for(auto& c : model) c = rng();
+	card_.reset(SECTORS);
+	card_.mem = model;
+
+	test_<false>(model, rng, "normal");
+	test_<true>(model, rng, "stream");
+	if(card_.error != 0) error_out_("protocol", card_.error);
+
+	if(error_ == 0) std::printf("OK\n");
+	else std::printf("%d errors\n", error_);
+	return error_ == 0 ? 0 : 1;
+}
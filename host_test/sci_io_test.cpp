@@ -0,0 +1,224 @@
+//=====================================================================//
+/*!	@file
+	@brief	sci_io のテスト（io_sim） @n
+			RX24T の SCI1 を、io_sim のフックで動かし、送受信の結果と、@n
+			レジスター・アクセスの回数、サイクル（見積もり）を確認する。@n
+			・ポーリング：TEND を待って TDR に書く（LF の前に CR）@n
+			・割り込み：putch はバッファに積み、TEI（send_task_）が TDR に書く @n
+			・受信割り込み（recv_task_）：オーバーラン、フレーミング・エラーは捨てる @n
+			※レジスター・オブジェクトの実体は定義していないので、最適化（-O2）が必要
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#define SIG_RX24T
+#define F_ICLK		80000000
+#define F_PCLKA		80000000
+#define F_PCLKB		40000000
+#define F_PCLKD		40000000
+#define F_FCLK		20000000
+
+#include <cstdio>
+#include <string>
+#include "common/fixed_fifo.hpp"
+#include "common/sci_io.hpp"
+
+namespace {
+
+	typedef utils::fixed_fifo<char, 64> BUFF;
+	typedef device::SCI1 SCI;
+	typedef device::sci_io<SCI, BUFF, BUFF> SCI_IO;
+
+	// 周辺バスのアクセス・サイクル（見積もり）
+	static const uint16_t RD_CYC = 3;
+	static const uint16_t WR_CYC = 2;
+	// １文字の送信に掛かる SSR の読み出し回数（TEND が０の間）
+	static const uint32_t TX_BUSY = 4;
+
+	int error_ = 0;
+
+	void error_out_(const char* msg, uint32_t v)
+	{
+		if(error_ < 10) std::printf("%s: %u\n", msg, v);
+		++error_;
+	}
+
+
+	// 割り込みベクター
+	void (*task_[256])(void);
+
+	std::string	out_;
+	uint32_t	busy_;
+
+	void setup_()
+	{
+		auto& sim = device::io_sim::get();
+		sim.reset();
+		sim.set_cycle(SCI::SMR.address(), SCI::SMR.address() + 0x20, RD_CYC, WR_CYC);
+		sim.poke(SCI::SSR.address(), SCI::SSR.TEND.b() | SCI::SSR.TDRE.b());
+		out_.clear();
+		busy_ = 0;
+
+		// TDR に書くと送信を始め、TEND が０になる
+		sim.set_write_hook(SCI::TDR.address(), [](device::address_type adr, uint32_t data) {
+			out_ += static_cast<char>(data);
+			busy_ = TX_BUSY;
+			auto& sim = device::io_sim::get();
+			sim.poke(SCI::SSR.address(), sim.peek(SCI::SSR.address()) & ~SCI::SSR.TEND.b());
+			return true;
+		});
+		// SSR を読む毎に送信が進み、終わると TEND が１になる
+		sim.set_read_hook(SCI::SSR.address(), [](device::address_type adr, uint32_t cur) {
+			if(busy_ > 0) {
+				--busy_;
+				if(busy_ == 0) {
+					cur |= SCI::SSR.TEND.b();
+					device::io_sim::get().poke(adr, cur);
+				}
+			}
+			return cur;
+		});
+	}
+
+
+	// 一文字分の時間が過ぎる：送信が終わり（TEND）、TEIE が１なら TEI を受け付ける
+	bool tick_()
+	{
+		auto& sim = device::io_sim::get();
+		busy_ = 0;
+		sim.poke(SCI::SSR.address(), sim.peek(SCI::SSR.address()) | SCI::SSR.TEND.b());
+		if((sim.peek(SCI::SCR.address()) & SCI::SCR.TEIE.b()) == 0) return false;
+		task_[static_cast<uint32_t>(SCI::get_te_vec())]();
+		return true;
+	}
+
+
+	void check_cycle_(const device::io_sim::count_t& t, const char* msg)
+	{
+		if(t.cycle != (t.read * RD_CYC + t.write * WR_CYC)) error_out_(msg, t.cycle);
+	}
+
+
+	void polling_()
+	{
+		static SCI_IO sci;
+		setup_();
+		auto& sim = device::io_sim::get();
+		if(!sci.start(115200)) error_out_("start (polling)", 0);
+		if(task_[static_cast<uint32_t>(SCI::get_te_vec())] != nullptr) error_out_("vector (polling)", 0);
+		if(sim.peek(SCI::SCR.address()) != (SCI::SCR.TE.b() | SCI::SCR.RE.b())) {
+			error_out_("SCR (polling)", sim.peek(SCI::SCR.address()));
+		}
+
+		sim.clear_count();
+		sci.puts("abc\n");
+		if(out_ != "abc\r\n") error_out_("puts (polling)", out_.size());
+		// 一文字毎に TDR を一回書き、TEND を待つ（初回は待たない）
+		auto tdr = sim.get_count(SCI::TDR.address());
+		auto ssr = sim.get_count(SCI::SSR.address());
+		if(tdr.write != 5 || tdr.read != 0) error_out_("TDR (polling)", tdr.write);
+		if(ssr.read != (1 + 4 * TX_BUSY) || ssr.write != 0) error_out_("SSR (polling)", ssr.read);
+		auto& t = sim.get_total();
+		if(t.read != ssr.read || t.write != tdr.write) error_out_("total (polling)", t.read + t.write);
+		check_cycle_(t, "cycle (polling)");
+		std::printf("polling:   %u chars, read %u, write %u, %u cycles\n",
+			static_cast<uint32_t>(out_.size()), t.read, t.write, static_cast<uint32_t>(t.cycle));
+	}
+
+
+	void interrupt_()
+	{
+		static SCI_IO sci;
+		setup_();
+		auto& sim = device::io_sim::get();
+		if(!sci.start(115200, 2)) error_out_("start (intr)", 0);
+		if(task_[static_cast<uint32_t>(SCI::get_te_vec())] == nullptr
+			|| task_[static_cast<uint32_t>(SCI::get_rx_vec())] == nullptr) error_out_("vector (intr)", 0);
+		if(sim.peek(SCI::SCR.address()) != (SCI::SCR.RIE.b() | SCI::SCR.TE.b() | SCI::SCR.RE.b())) {
+			error_out_("SCR (intr)", sim.peek(SCI::SCR.address()));
+		}
+
+		// 送信：putch はバッファに積むだけで、TDR には書かない
+		sim.clear_count();
+		static const char* text = "0123456789\nabcdefghij";
+		sci.puts(text);
+		std::string ref = "0123456789\r\nabcdefghij";
+		uint32_t len = ref.size();
+		if(!out_.empty() || sci.send_length() != len) error_out_("puts (intr)", out_.size());
+		auto tdr = sim.get_count(SCI::TDR.address());
+		auto ssr = sim.get_count(SCI::SSR.address());
+		auto scr = sim.get_count(SCI::SCR.address());
+		// SSR：文字毎に ORER を読む
+		// SCR：文字毎に TEIE を読み、最初だけ TEIE=1（ビット書き込みは、読んで書く）
+		if(tdr.write != 0) error_out_("TDR (intr put)", tdr.write);
+		if(ssr.read != len || ssr.write != 0) error_out_("SSR (intr put)", ssr.read);
+		if(scr.read != (len + 1) || scr.write != 1) error_out_("SCR (intr put)", scr.read);
+		auto& t = sim.get_total();
+		if(t.read != (ssr.read + scr.read) || t.write != (tdr.write + scr.write)) {
+			error_out_("total (intr put)", t.read + t.write);
+		}
+		check_cycle_(t, "cycle (intr put)");
+		std::printf("intr put:  %u chars, read %u, write %u, %u cycles\n",
+			len, t.read, t.write, static_cast<uint32_t>(t.cycle));
+
+		// TEI：一回毎に一文字、最後に TEIE=0
+		sim.clear_count();
+		uint32_t n = 0;
+		while(tick_()) ++n;
+		if(out_ != ref || n != len || sci.send_length() != 0) error_out_("TEI", n);
+		tdr = sim.get_count(SCI::TDR.address());
+		scr = sim.get_count(SCI::SCR.address());
+		if(tdr.write != len) error_out_("TDR (TEI)", tdr.write);
+		if(scr.read != 1 || scr.write != 1) error_out_("SCR (TEI)", scr.write);
+		if(t.read != scr.read || t.write != (tdr.write + scr.write)) error_out_("total (TEI)", t.read + t.write);
+		check_cycle_(t, "cycle (TEI)");
+		std::printf("TEI:       %u chars, read %u, write %u, %u cycles\n",
+			n, t.read, t.write, static_cast<uint32_t>(t.cycle));
+
+		// 受信：エラーのある文字は捨てる
+		sim.clear_count();
+		static const struct {
+			char	ch;
+			uint8_t	ssr;
+		} rx[] = {
+			{ 'A', 0 }, { 'B', SCI::SSR.ORER.b() }, { 'C', 0 }, { 'D', SCI::SSR.FER.b() }, { 'E', 0 }
+		};
+		for(const auto& r : rx) {
+			sim.poke(SCI::RDR.address(), r.ch);
+			sim.poke(SCI::SSR.address(), sim.peek(SCI::SSR.address()) | r.ssr);
+			task_[static_cast<uint32_t>(SCI::get_rx_vec())]();
+			if(sim.peek(SCI::SSR.address()) & (SCI::SSR.ORER.b() | SCI::SSR.FER.b())) {
+				error_out_("RXI (error clear)", r.ch);
+			}
+		}
+		auto rdr = sim.get_count(SCI::RDR.address());
+		if(rdr.read != 5) error_out_("RDR (RXI)", rdr.read);
+		// 文字毎に ORER、FER/PER、RDR を読み、エラーのクリアは読んで書く
+		if(t.read != (5 * 3 + 3) || t.write != 3) error_out_("total (RXI)", t.read + t.write);
+		std::string in;
+		while(sci.recv_length() > 0) in += sci.getch();
+		if(in != "ACE") error_out_("RXI", in.size());
+		check_cycle_(t, "cycle (RXI)");
+		std::printf("RXI:       %u chars, read %u, write %u, %u cycles\n",
+			5, t.read, t.write, static_cast<uint32_t>(t.cycle));
+	}
+}
+
+extern "C" {
+	void set_interrupt_task(void (*task)(void), uint32_t idx)
+	{
+		task_[idx] = task;
+	}
+}
+
+int main()
+{
+	polling_();
+	interrupt_();
+
+	if(error_ == 0) std::printf("OK\n");
+	else std::printf("%d errors\n", error_);
+	return error_ == 0 ? 0 : 1;
+}
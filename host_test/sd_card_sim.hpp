@@ -0,0 +1,368 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	SD カード・シミュレーター（SDHC、SPI モード、ブロック・アドレス） @n
+			mmc_io を、ホスト（Linux）で動かす為の、SPI、選択ポートを含む。@n
+			・コマンド数、読み出しブロック数、プロトコル違反を数える @n
+			・遅延モデル：SPI のバイト毎の時間と、カードの待ち（読み出しの最初の @n
+			  ブロック、マルチ・ブロックの次のブロック、書き込みの busy）を積算する。@n
+			  待ちの間のポーリングは、mmc_io と同じ間隔（100us）で行うとする。@n
+			  ※カード内部の GC などによる、まれな長い busy はモデルに無い @n
+			※静的メンバーの実体を定義するので、一つの翻訳単位でインクルードする
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <deque>
+
+namespace host {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief	SD カード・シミュレーター
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	class sd_card {
+	public:
+		static const uint32_t SECTOR_SIZE = 512;
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief  遅延モデル（ナノ秒） @n
+					※初期値は、SPI 25MHz と、image_io と同じカードの待ち
+		*/
+		//-------------------------------------------------------------//
+		struct timing_t {
+			uint32_t	byte_ns;		///< SPI の１バイト
+			uint32_t	poll_ns;		///< 待ちの間の、ホストのポーリング間隔
+			uint32_t	access_ns;		///< 読み出し、最初のブロックまでの待ち
+			uint32_t	next_ns;		///< マルチ・ブロック読み出し、次のブロックまでの待ち
+			uint32_t	busy_ns;		///< 書き込みの完了待ち（シングル、又は、マルチの最後）
+			uint32_t	multi_busy_ns;	///< マルチ・ブロック書き込み、１ブロック毎の完了待ち
+
+			timing_t() noexcept : byte_ns(320), poll_ns(100000), access_ns(100000),
+				next_ns(10000), busy_ns(800000), multi_busy_ns(150000) { }
+		};
+
+	private:
+		// wait_ns の間は fill を送り、その後で data を送る
+		struct item_t {
+			uint8_t		data;
+			uint8_t		fill;
+			bool		end;		///< データ・ブロックの最後（CRC）
+			uint32_t	wait_ns;
+		};
+
+		std::deque<item_t>	out_;
+		uint64_t	ready_;		///< 待ちが終わる時間
+		uint8_t		fill_;
+		uint32_t	sectors_;
+		uint8_t		cmd_[6];
+		uint32_t	cmd_pos_;
+		bool		idle_;
+		bool		acmd_;
+		bool		multi_;		///< CMD18 中
+		uint32_t	read_lba_;
+		bool		write_;		///< CMD24/CMD25 中
+		bool		write_multi_;
+		bool		token_;
+		uint32_t	write_lba_;
+		std::vector<uint8_t>	wbuf_;
+
+		void push_(uint8_t d) { out_.push_back(item_t { d, 0xff, false, 0 }); }
+
+		void r1_(uint8_t r) { push_(0xff); push_(r); }
+
+		void busy_(uint32_t ns) { out_.push_back(item_t { 0xff, 0, false, ns }); }
+
+		void block_(uint32_t lba, uint32_t ns)
+		{
+			out_.push_back(item_t { 0xfe, 0xff, false, ns });
+			for(uint32_t i = 0; i < SECTOR_SIZE; ++i) push_(mem[lba * SECTOR_SIZE + i]);
+			push_(0);
+			out_.push_back(item_t { 0, 0xff, true, 0 });
+		}
+
+		void exec_()
+		{
+			++cmds;
+			uint8_t c = cmd_[0] & 0x3f;
+			uint32_t arg = (cmd_[1] << 24) | (cmd_[2] << 16) | (cmd_[3] << 8) | cmd_[4];
+			bool a = acmd_;
+			acmd_ = false;
+			if(c == 12) {
+				++stop;
+				if(!multi_) ++error;
+				multi_ = false;
+				out_.clear();
+				ready_ = 0;
+				push_(0xff);  // stuff byte
+				push_(0);
+				return;
+			}
+			if(multi_) ++error;  // ストリーム中のコマンド
+			out_.clear();
+			ready_ = 0;
+			switch(c) {
+			case 0:
+				idle_ = true;
+				r1_(1);
+				break;
+			case 8:
+				r1_(1);
+				push_(0); push_(0); push_(1); push_(0xaa);
+				break;
+			case 55:
+				r1_(idle_ ? 1 : 0);
+				acmd_ = true;
+				break;
+			case 41:
+				if(a) { idle_ = false; r1_(0); }
+				else r1_(4);
+				break;
+			case 58:
+				r1_(0);
+				push_(0xc0); push_(0xff); push_(0x80); push_(0);
+				break;
+			case 9:  // CSD ver 2.0
+				{
+					r1_(0);
+					push_(0xfe);
+					uint8_t csd[16] = { 0x40 };
+					uint32_t cs = sectors_ / 1024 - 1;
+					csd[7] = cs >> 16; csd[8] = cs >> 8; csd[9] = cs;
+					for(auto v : csd) push_(v);
+					push_(0); push_(0);
+				}
+				break;
+			case 16:
+			case 23:
+				r1_(0);
+				break;
+			case 17:
+				if(arg >= sectors_) { r1_(0x40); break; }
+				++single_read;
+				r1_(0);
+				block_(arg, timing.access_ns);
+				break;
+			case 18:
+				if(arg >= sectors_) { r1_(0x40); break; }
+				++multi_read;
+				r1_(0);
+				multi_ = true;
+				read_lba_ = arg;
+				block_(read_lba_++, timing.access_ns);
+				break;
+			case 24:
+			case 25:
+				if(arg >= sectors_) { r1_(0x40); break; }
+				r1_(0);
+				write_ = true;
+				write_multi_ = c == 25;
+				token_ = false;
+				write_lba_ = arg;
+				break;
+			default:
+				r1_(4);
+				break;
+			}
+		}
+
+		uint8_t out_byte_()
+		{
+			if(out_.empty() && multi_ && read_lba_ < sectors_) {  // 最後のセクターの先は、送らない
+				block_(read_lba_++, timing.next_ns);
+			}
+			if(out_.empty()) return 0xff;
+
+			auto& t = out_.front();
+			if(t.wait_ns > 0) {
+				ready_ = time_ns + t.wait_ns;
+				fill_ = t.fill;
+				t.wait_ns = 0;
+			}
+			if(time_ns < ready_) {
+				time_ns += timing.poll_ns;
+				return fill_;
+			}
+			uint8_t o = t.data;
+			if(t.end) ++blocks;
+			out_.pop_front();
+			return o;
+		}
+
+	public:
+		timing_t	timing;
+		std::vector<uint8_t>	mem;
+		bool		cs;			///< 選択（SEL が「０」）
+		uint64_t	time_ns;	///< 積算時間
+		uint32_t	bytes;
+		uint32_t	cmds;
+		uint32_t	single_read;
+		uint32_t	multi_read;
+		uint32_t	stop;		///< CMD12
+		uint32_t	blocks;		///< ホストが最後（CRC）まで受け取ったデータ・ブロック
+		uint32_t	write_blocks;
+		uint32_t	error;		///< プロトコル違反
+
+		sd_card() : ready_(0), fill_(0xff), sectors_(0), cmd_pos_(0), idle_(true), acmd_(false),
+			multi_(false), read_lba_(0), write_(false), write_multi_(false), token_(false),
+			write_lba_(0), timing(), cs(false), time_ns(0), bytes(0), cmds(0), single_read(0),
+			multi_read(0), stop(0), blocks(0), write_blocks(0), error(0) { }
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	インスタンス（SPI、選択ポートがつながるカード）
+			@return カード
+		*/
+		//-------------------------------------------------------------//
+		static sd_card& get() { static sd_card card; return card; }
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	カードを入れ替える（内容は０、遅延モデルはそのまま）
+			@param[in]	sectors	セクター数（1024 の倍数）
+		*/
+		//-------------------------------------------------------------//
+		void reset(uint32_t sectors)
+		{
+			auto t = timing;
+			*this = sd_card();
+			timing = t;
+			sectors_ = sectors;
+			mem.assign(static_cast<size_t>(sectors) * SECTOR_SIZE, 0);
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	カウンターと積算時間をクリア（プロトコル違反はクリアしない）
+		*/
+		//-------------------------------------------------------------//
+		void clear_count()
+		{
+			bytes = cmds = single_read = multi_read = stop = blocks = write_blocks = 0;
+			ready_ = ready_ > time_ns ? (ready_ - time_ns) : 0;
+			time_ns = 0;
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	SPI の１バイト交換
+			@param[in]	d	ホストからのデータ
+			@return カードからのデータ
+		*/
+		//-------------------------------------------------------------//
+		uint8_t xchg(uint8_t d)
+		{
+			++bytes;
+			time_ns += timing.byte_ns;
+			if(!cs) return 0xff;
+			uint8_t o = out_byte_();
+			if(write_) {
+				if(!token_) {
+					if(d == 0xfe || d == 0xfc) {
+						token_ = true;
+						wbuf_.clear();
+					} else if(d == 0xfd) {
+						write_ = false;
+						busy_(timing.busy_ns);
+					}
+					return o;
+				}
+				wbuf_.push_back(d);
+				if(wbuf_.size() == (SECTOR_SIZE + 2)) {
+					if(write_lba_ < sectors_) {
+						std::memcpy(&mem[write_lba_ * SECTOR_SIZE], wbuf_.data(), SECTOR_SIZE);
+					} else {
+						++error;
+					}
+					++write_lba_;
+					++write_blocks;
+					token_ = false;
+					out_.clear();
+					push_(0x05);  // data accepted
+					busy_(write_multi_ ? timing.multi_busy_ns : timing.busy_ns);
+					if(!write_multi_) write_ = false;
+				}
+				return o;
+			}
+			if(cmd_pos_ == 0 && (d & 0xc0) != 0x40) return o;
+			cmd_[cmd_pos_++] = d;
+			if(cmd_pos_ == 6) {
+				cmd_pos_ = 0;
+				exec_();
+			}
+			return o;
+		}
+	};
+
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief	mmc_io に渡す SPI（sd_card::get() のカードにつながる）
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	struct sd_spi {
+		uint8_t xchg(uint8_t d = 0xff) { return sd_card::get().xchg(d); }
+		void send(const void* src, uint32_t n) {
+			auto p = static_cast<const uint8_t*>(src);
+			while(n > 0) { xchg(*p++); --n; }
+		}
+		void recv(void* dst, uint32_t n) {
+			auto p = static_cast<uint8_t*>(dst);
+			while(n > 0) { *p++ = xchg(); --n; }
+		}
+		uint32_t get_max_speed() const { return 25000000; }
+		bool start_sdc(uint32_t speed) { return true; }
+		void destroy() { }
+	};
+
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief	mmc_io に渡す選択ポート（SEL）
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	struct sd_sel {
+		struct port_t {
+			void operator = (int v) { sd_card::get().cs = v == 0; }
+			int operator () () const { return sd_card::get().cs ? 0 : 1; }
+		};
+		static port_t P;
+		static int DIR;
+		static int PU;
+		static const uint32_t BIT_POS = 32;
+	};
+	sd_sel::port_t sd_sel::P;
+	int sd_sel::DIR;
+	int sd_sel::PU;
+
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief	mmc_io に渡す、使わないポート（電源、カード検出）
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	struct sd_null {
+		struct port_t {
+			void operator = (int v) { }
+			int operator () () const { return 0; }
+		};
+		static port_t P;
+		static int DIR;
+		static int PU;
+		static const uint32_t BIT_POS = 32;
+	};
+	sd_null::port_t sd_null::P;
+	int sd_null::DIR;
+	int sd_null::PU;
+}
@@ -0,0 +1,254 @@
+//=====================================================================//
+/*!	@file
+	@brief	sector_cache のテスト（image_io の前に置く） @n
+			・乱数でシングル／マルチ・セクターの読み書きを繰り返し、読み出しが @n
+			  モデルと一致し、sync の後は、image_io 上の内容もモデルと一致する事 @n
+			  （NUM が小さく、ハッシュのバケットを共有する場合と、NUM が大きい場合）@n
+			・キャッシュ経由で FatFs のファイルを書き、キャッシュ無しで開き直して @n
+			  内容が一致する事
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <random>
+#include "ff12b/image_io.hpp"
+#include "ff12b/sector_cache.hpp"
+#include "fat_image.hpp"
+
+namespace {
+
+	static const char* IMAGE = "sector_cache_test.img";
+	static const uint32_t SECTORS = 16384;	///< 8M バイト
+	static const uint32_t AREA = 400;		///< ブロック・テストで使うセクター（FAT 領域を含む）
+	static const uint32_t SECTOR_SIZE = 512;
+
+	typedef fatfs::sector_cache<fatfs::image_io, 16> CACHE;
+	typedef fatfs::sector_cache<fatfs::image_io, 300, 100> LARGE_CACHE;
+
+	fatfs::image_io	img_;
+	CACHE	cache_(img_);
+	LARGE_CACHE	large_cache_(img_);
+	bool	use_cache_ = true;
+	int		error_ = 0;
+
+	typedef std::vector<BYTE> sector_t;
+
+	void error_out_(const char* msg, uint32_t v)
+	{
+		if(error_ < 10) std::printf("%s: %u\n", msg, v);
+		++error_;
+	}
+
+
+	void fill_(BYTE* p, std::mt19937& rng)
+	{
+		for(uint32_t i = 0; i < SECTOR_SIZE; ++i) p[i] = rng();
+	}
+
+
+	// sync 後、image_io を直接読んで比較
+	void check_image_(const std::vector<sector_t>& model, const char* msg)
+	{
+		BYTE tmp[SECTOR_SIZE];
+		for(uint32_t i = 0; i < AREA; ++i) {
+			if(img_.disk_read(0, tmp, i, 1) != RES_OK
+				|| std::memcmp(tmp, model[i].data(), SECTOR_SIZE) != 0) {
+				error_out_(msg, i);
+			}
+		}
+	}
+
+
+	template <class C>
+	void block_(C& cache, uint32_t num, std::mt19937& rng)
+	{
+		// モデルは、イメージの内容から始める（ブート・セクターで FAT 領域がピンされる）
+		std::vector<sector_t> model(AREA, sector_t(SECTOR_SIZE));
+		for(uint32_t i = 0; i < AREA; ++i) {
+			img_.disk_read(0, model[i].data(), i, 1);
+		}
+
+		const sector_t boot = model[0];
+		static BYTE buff[SECTOR_SIZE * 8];
+		for(int i = 0; i < 200000; ++i) {
+			uint32_t count = (rng() % 4) == 0 ? (2 + rng() % 7) : 1;
+			// 半分は、FAT、ルート・ディレクトリ（先頭の 300 セクター）の周辺
+			uint32_t sector = (rng() & 1) ? rng() % 300 : rng() % (AREA - count + 1);
+			if(sector + count > AREA) sector = AREA - count;
+			switch(rng() % 8) {
+			case 0:
+			case 1:
+			case 2:
+				for(uint32_t j = 0; j < count; ++j) {
+					fill_(&buff[j * SECTOR_SIZE], rng);
+					std::memcpy(model[sector + j].data(), &buff[j * SECTOR_SIZE], SECTOR_SIZE);
+				}
+				// ブート・セクターの署名は残す（FAT 領域の判定が変わらないように）
+				if(sector == 0) {
+					std::memcpy(buff, boot.data(), SECTOR_SIZE);
+					model[0] = boot;
+				}
+				if(cache.disk_write(0, buff, sector, count) != RES_OK) error_out_("write", sector);
+				break;
+			case 7:
+				if((rng() % 64) == 0) {
+					if(cache.disk_ioctl(0, CTRL_SYNC, nullptr) != RES_OK) error_out_("sync", i);
+					check_image_(model, "image (sync)");
+				}
+				break;
+			default:
+				if(cache.disk_read(0, buff, sector, count) != RES_OK) error_out_("read", sector);
+				for(uint32_t j = 0; j < count; ++j) {
+					if(std::memcmp(&buff[j * SECTOR_SIZE], model[sector + j].data(), SECTOR_SIZE) != 0) {
+						error_out_("read data", sector + j);
+					}
+				}
+				break;
+			}
+		}
+		if(!cache.sync()) error_out_("sync (last)", 0);
+		check_image_(model, "image (last)");
+
+		auto st = cache.get_stat();
+		std::printf("block (%u): hit %u, miss %u, meta_hit %u, bypass %u, write_back %u\n",
+			num,
+			st.hit, st.miss, st.meta_hit, st.bypass, st.write_back);
+	}
+
+
+	void file_(std::mt19937& rng)
+	{
+		if(!host::make_fat16(IMAGE, SECTORS) || !img_.open(IMAGE)) {
+			error_out_("image", 0);
+			return;
+		}
+		cache_.invalidate();
+
+		static const uint32_t FILES = 20;
+		std::vector<std::vector<BYTE>> data(FILES);
+		{
+			FATFS fs;
+			use_cache_ = true;
+			if(f_mount(&fs, "", 1) != FR_OK) {
+				error_out_("mount", 0);
+				return;
+			}
+			f_mkdir("dir");
+			for(uint32_t i = 0; i < FILES; ++i) {
+				data[i].resize(rng() % 40000);
+				for(auto& c : data[i]) c = rng();
+				char name[32];
+				std::snprintf(name, sizeof(name), "dir/file_%02u.bin", i);
+				FIL fp;
+				if(f_open(&fp, name, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) error_out_("f_open", i);
+				// 色々な単位で書く（シングル、マルチ・セクター）
+				uint32_t n = 0;
+				while(n < data[i].size()) {
+					UINT l = 1 + rng() % 3000;
+					if(l > (data[i].size() - n)) l = data[i].size() - n;
+					UINT bw = 0;
+					f_write(&fp, &data[i][n], l, &bw);
+					if(bw != l) error_out_("f_write", i);
+					n += l;
+				}
+				if(f_close(&fp) != FR_OK) error_out_("f_close", i);
+			}
+			// 半分を書き直し、一部を削除する
+			for(uint32_t i = 0; i < FILES; i += 2) {
+				char name[32];
+				std::snprintf(name, sizeof(name), "dir/file_%02u.bin", i);
+				if((i % 4) == 0) {
+					f_unlink(name);
+					data[i].clear();
+					continue;
+				}
+				FIL fp;
+				f_open(&fp, name, FA_WRITE | FA_OPEN_EXISTING);
+				f_lseek(&fp, data[i].size() / 2);
+				for(uint32_t j = data[i].size() / 2; j < data[i].size(); ++j) data[i][j] ^= 0xff;
+				UINT bw = 0;
+				f_write(&fp, &data[i][data[i].size() / 2], data[i].size() - data[i].size() / 2, &bw);
+				f_close(&fp);
+			}
+			f_mount(nullptr, "", 0);
+		}
+		if(!cache_.sync()) error_out_("sync", 0);
+
+		// キャッシュ無しで、開き直して確認
+		img_.close();
+		use_cache_ = false;
+		if(!img_.open(IMAGE) || !img_.service()) {
+			error_out_("remount", 0);
+			return;
+		}
+		for(uint32_t i = 0; i < FILES; ++i) {
+			char name[32];
+			std::snprintf(name, sizeof(name), "dir/file_%02u.bin", i);
+			FIL fp;
+			auto ret = f_open(&fp, name, FA_READ);
+			if((i % 4) == 0) {
+				if(ret != FR_NO_FILE) error_out_("unlink", i);
+				continue;
+			}
+			if(ret != FR_OK) {
+				error_out_("f_open (read)", i);
+				continue;
+			}
+			std::vector<BYTE> tmp(data[i].size() + 1);
+			UINT br = 0;
+			f_read(&fp, tmp.data(), tmp.size(), &br);
+			if(br != data[i].size() || std::memcmp(tmp.data(), data[i].data(), br) != 0) {
+				error_out_("file data", i);
+			}
+			f_close(&fp);
+		}
+		img_.close();
+	}
+}
+
+extern "C" {
+
+	DSTATUS disk_initialize(BYTE drv) {
+		return use_cache_ ? cache_.disk_initialize(drv) : img_.disk_initialize(drv);
+	}
+	DSTATUS disk_status(BYTE drv) {
+		return use_cache_ ? cache_.disk_status(drv) : img_.disk_status(drv);
+	}
+	DRESULT disk_read(BYTE drv, BYTE* buff, DWORD sector, UINT count) {
+		return use_cache_ ? cache_.disk_read(drv, buff, sector, count)
+			: img_.disk_read(drv, buff, sector, count);
+	}
+	DRESULT disk_write(BYTE drv, const BYTE* buff, DWORD sector, UINT count) {
+		return use_cache_ ? cache_.disk_write(drv, buff, sector, count)
+			: img_.disk_write(drv, buff, sector, count);
+	}
+	DRESULT disk_ioctl(BYTE drv, BYTE ctrl, void* buff) {
+		return use_cache_ ? cache_.disk_ioctl(drv, ctrl, buff) : img_.disk_ioctl(drv, ctrl, buff);
+	}
+	DWORD get_fattime(void) { return 0x4c210000; }
+};
+
+int main()
+{
+	std::mt19937 rng(3);
+
+	if(!host::make_fat16(IMAGE, SECTORS) || !img_.open(IMAGE)) {
+		std::printf("image fail\n");
+		return 1;
+	}
+	block_(cache_, 16, rng);
+	block_(large_cache_, 300, rng);
+	img_.close();
+
+	file_(rng);
+	std::remove(IMAGE);
+
+	if(error_ == 0) std::printf("OK\n");
+	else std::printf("%d errors\n", error_);
+	return error_ == 0 ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+//=====================================================================//
+/*!	@file
+	@brief	CP932 変換のベンチマーク @n
+			二段テーブルの ff_convert（cc932t.c）と、以前の二分探索の @n
+			ff_convert（cc932.c）の、一回当たりの時間（ns）を比べる。@n
+			・OEM -> Unicode：全ての２バイト・コード（リード、トレイルの範囲）@n
+			・Unicode -> OEM：上の変換結果（ファイル名の変換と同じ使い方）@n
+			・ff_wtoupper：0x0000 ～ 0xFFFF
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdio>
+#include <chrono>
+#include <vector>
+#include "ff12b/src/option/unicode.c"
+
+namespace ref {
+#include "ff12b/src/option/cc932.c"
+}
+
+namespace {
+
+	static const int LOOP = 50;
+
+	volatile uint32_t sink_;
+
+	template <class FUNC>
+	double run_(const std::vector<WCHAR>& src, FUNC f)
+	{
+		uint32_t s = 0;
+		auto t0 = std::chrono::steady_clock::now();
+		for(int n = 0; n < LOOP; ++n) {
+			for(auto c : src) s += f(c);
+		}
+		auto t = std::chrono::steady_clock::now() - t0;
+		sink_ = s;
+		return std::chrono::duration<double, std::nano>(t).count() / (static_cast<double>(src.size()) * LOOP);
+	}
+
+
+	void print_(const char* title, double a, double b)
+	{
+		std::printf("%-16s %8.2fns %8.2fns %9.2f\n", title, a, b, a / b);
+	}
+}
+
+int main()
+{
+	std::vector<WCHAR> oem;
+	for(uint32_t hi = 0x81; hi <= 0xfc; ++hi) {
+		if(0xa0 <= hi && hi <= 0xdf) continue;
+		for(uint32_t lo = 0x40; lo <= 0xfc; ++lo) {
+			if(lo == 0x7f) continue;
+			oem.push_back((hi << 8) | lo);
+		}
+	}
+	std::vector<WCHAR> uni;
+	for(auto c : oem) {
+		auto u = ref::ff_convert(c, 1);
+		if(u != 0) uni.push_back(u);
+	}
+	std::vector<WCHAR> all;
+	for(uint32_t c = 0; c < 0x10000; ++c) all.push_back(c);
+
+	std::printf("%u OEM codes, %u Unicode codes\n",
+		static_cast<uint32_t>(oem.size()), static_cast<uint32_t>(uni.size()));
+	std::printf("%-16s %10s %10s %10s\n", "", "cc932", "cc932t", "ratio");
+	print_("OEM -> Unicode",
+		run_(oem, [](WCHAR c) { return ref::ff_convert(c, 1); }),
+		run_(oem, [](WCHAR c) { return ff_convert(c, 1); }));
+	print_("Unicode -> OEM",
+		run_(uni, [](WCHAR c) { return ref::ff_convert(c, 0); }),
+		run_(uni, [](WCHAR c) { return ff_convert(c, 0); }));
+	print_("ff_wtoupper",
+		run_(all, [](WCHAR c) { return ref::ff_wtoupper(c); }),
+		run_(all, [](WCHAR c) { return ff_wtoupper(c); }));
+}
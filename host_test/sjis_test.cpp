@@ -0,0 +1,70 @@
+//=====================================================================//
+/*!	@file
+	@brief	CP932 変換（cc932t.c の ff_convert）のテスト @n
+			・二段テーブルの ff_convert、ff_wtoupper が、cc932.c と @n
+			  全コードで一致する事 @n
+			・utils::str の UTF-8/Shift-JIS 変換が往復で元に戻る事
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdio>
+#include <cstring>
+#include "ff12b/src/option/unicode.c"
+
+namespace ref {
+#include "ff12b/src/option/cc932.c"
+}
+
+#include "common/string_utils.hpp"
+
+namespace {
+
+	int error_ = 0;
+
+	void error_out_(const char* msg, uint32_t code)
+	{
+		if(error_ < 10) std::printf("%s: 0x%04X\n", msg, code);
+		++error_;
+	}
+
+
+	void convert_()
+	{
+		for(uint32_t c = 0; c < 0x10000; ++c) {
+			if(ff_convert(c, 1) != ref::ff_convert(c, 1)) error_out_("OEM -> Unicode", c);
+			if(ff_convert(c, 0) != ref::ff_convert(c, 0)) error_out_("Unicode -> OEM", c);
+			if(ff_wtoupper(c) != ref::ff_wtoupper(c)) error_out_("upper", c);
+		}
+	}
+
+
+	void string_()
+	{
+		static const char* src[] = {
+			"", "abc", "ｱｲｳｴｵ", "漢字かなカナ、。①", "/dir/ファイル名.txt", "混在 mix ﾃｽﾄ 123"
+		};
+		for(auto s : src) {
+			char sjis[64];
+			char utf8[64];
+			utils::str::utf8_to_sjis(s, sjis, sizeof(sjis));
+			utils::str::sjis_to_utf8(sjis, utf8, sizeof(utf8));
+			if(std::strcmp(s, utf8) != 0) {
+				if(error_ < 10) std::printf("round trip: '%s' / '%s'\n", s, utf8);
+				++error_;
+			}
+		}
+	}
+}
+
+int main()
+{
+	convert_();
+	string_();
+
+	if(error_ == 0) std::printf("OK\n");
+	else std::printf("%d errors\n", error_);
+	return error_ == 0 ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+//=====================================================================//
+/*!	@file
+	@brief	static_format（UTILS_SFORMAT）のテスト @n
+			実行時解析の utils::sformat と、同じ出力になる事を確認する。@n
+			-DFAIL_FEW、-DFAIL_MANY、-DFAIL_TYPE では、コンパイル・エラーになる事
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include "common/format.hpp"
+
+namespace {
+
+	int error_ = 0;
+
+	void check_(const char* form, const char* a, const char* b)
+	{
+		if(std::strcmp(a, b) != 0) {
+			std::printf("'%s': '%s' / '%s'\n", form, a, b);
+			++error_;
+		}
+	}
+
+}
+
+int main()
+{
+	char a[256];
+	char b[256];
+
+#if defined(FAIL_FEW)
+	UTILS_SFORMAT("%d %d\n", a, sizeof(a), 1);
+#elif defined(FAIL_MANY)
+	UTILS_SFORMAT("%d\n", a, sizeof(a), 1, 2);
+#elif defined(FAIL_TYPE)
+	UTILS_SFORMAT("%s\n", a, sizeof(a), 1);
+#endif
+
+	static const int32_t ivals[] = { 0, 1, -1, 9, 10, 99, 100, 12345, -12345,
+		INT_MAX, INT_MIN, INT_MIN + 1 };
+	for(auto v : ivals) {
+		UTILS_SFORMAT("%d,%5d,%-3d,%05d,%+d|", a, sizeof(a), v, v, v, v, v);
+		utils::sformat("%d,%5d,%-3d,%05d,%+d|", b, sizeof(b)) % v % v % v % v % v;
+		check_("%d", a, b);
+		uint32_t u = v;
+		UTILS_SFORMAT("%u %x %X %08x %o %b", a, sizeof(a), u, u, u, u, u, u);
+		utils::sformat("%u %x %X %08x %o %b", b, sizeof(b)) % u % u % u % u % u % u;
+		check_("%u", a, b);
+		UTILS_SFORMAT("%6.3:8y", a, sizeof(a), v);
+		utils::sformat("%6.3:8y", b, sizeof(b)) % v;
+		check_("%y", a, b);
+	}
+
+	static const float fvals[] = { 0.0f, 1.0f, -1.5f, 3.14159f, 1234.5678f, 1e-5f, 6.02e23f };
+	for(auto v : fvals) {
+		UTILS_SFORMAT("%f %.3f %e %8.2e %g", a, sizeof(a), v, v, v, v, v);
+		utils::sformat("%f %.3f %e %8.2e %g", b, sizeof(b)) % v % v % v % v % v;
+		check_("%f", a, b);
+	}
+
+	{
+		const char* s = "abc";
+		int n = UTILS_SFORMAT("[%s] %c 100%%", a, sizeof(a), s, 'x');
+		check_("%s", a, "[abc] x 100%");
+		if(n != static_cast<int>(std::strlen(a))) {
+			std::printf("size: %d / %d\n", n, static_cast<int>(std::strlen(a)));
+			++error_;
+		}
+		UTILS_SFORMAT("literal only", a, sizeof(a));
+		check_("literal", a, "literal only");
+	}
+
+	// バッファが足りない場合
+	{
+		char c[8];
+		UTILS_SFORMAT("%d-%d", c, sizeof(c), 12345, 67890);
+		utils::sformat("%d-%d", b, sizeof(c)) % 12345 % 67890;
+		check_("short", c, b);
+	}
+
+	if(error_ == 0) std::printf("OK\n");
+	return error_ == 0 ? 0 : 1;
+}
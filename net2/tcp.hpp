@@ -717,9 +717,9 @@ debug_format("(EST) CMP:  SEQ: 0x%08X, ACK: 0x%08X\n")
 			}
 
 			// 同じポートがある場合は無効（ロック状態）
-			for(uint32_t i = 0; i < NMAX; ++i) {
-				if(!common_.at_blocks().is_alloc(i)) continue;
-				const context& ctx = common_.get_blocks().get(i);
+			const auto& blocks = common_.get_blocks();
+			for(uint32_t i = blocks.next(0); i < NMAX; i = blocks.next(i + 1)) {
+				const context& ctx = blocks.get(i);
 				uint16_t pp;
 				if(server) {
 					pp = ctx.src_port_;
@@ -1013,11 +1013,9 @@ debug_format("(EST) CMP:  SEQ: 0x%08X, ACK: 0x%08X\n")
 		bool process(const eth_h& eh, const ipv4_h& ih, const tcp_h* tcp, int32_t len) noexcept
 		{
 			// 該当するコンテキストを探す
-			uint32_t idx = NMAX;
-			for(uint32_t i = 0; i < NMAX; ++i) {
-				if(!probe(i)) continue;
-
-				context& ctx = common_.at_blocks().at(i);  // コンテキスト取得
+			auto& blocks = common_.at_blocks();
+			for(uint32_t i = blocks.next(0, true); i < NMAX; i = blocks.next(i + 1, true)) {
+				context& ctx = blocks.at(i);  // コンテキスト取得
 
 				uint16_t sum = tools::calc_sum(&ih, sizeof(ipv4_h));
 				if(sum != 0) {
@@ -1066,10 +1064,9 @@ debug_format("(EST) CMP:  SEQ: 0x%08X, ACK: 0x%08X\n")
 		//-----------------------------------------------------------------//
 		void service(ARP& arp) noexcept
 		{
-			for(uint32_t i = 0; i < NMAX; ++i) {
-				if(!probe(i)) continue;
-
-				context& ctx = common_.at_blocks().at(i);
+			auto& blocks = common_.at_blocks();
+			for(uint32_t i = blocks.next(0, true); i < NMAX; i = blocks.next(i + 1, true)) {
+				context& ctx = blocks.at(i);
 
 				switch(ctx.send_task_) {
 
@@ -27,7 +27,7 @@ namespace {
 
 	utils::command<64> command_;
 
-	typedef utils::log_man<device::standby_ram> LOG_MAN;
+	typedef utils::log_man<device::standby_ram, 64> LOG_MAN;
 	LOG_MAN		log_man_;
 }
 
@@ -91,6 +91,7 @@ int main(int argc, char** argv)
 				char ch;
 				while((ch = *p++) != 0) {
 					if(ch == ('C' - 0x40)) {
+						log_man_.flush();
 						utils::format("Stop LOG\n");
 						command_.set_prompt("# ");
 						loge = false;
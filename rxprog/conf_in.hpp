@@ -122,6 +122,20 @@ namespace utils {
 		*/
 		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 		struct device_t {
+			//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+			/*!
+				@brief	消去ブロック（ORG から END までを SIZE 単位で消去）
+			*/
+			//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+			struct block_t {
+				uint32_t	org_;
+				uint32_t	end_;
+				uint32_t	size_;
+				block_t(uint32_t org = 0, uint32_t end = 0, uint32_t size = 0) :
+					org_(org), end_(end), size_(size) { }
+			};
+			typedef std::vector<block_t> blocks;
+
 			std::string		group_;
 			std::string		clock_;
 			std::string		divide_sys_;
@@ -133,6 +147,34 @@ namespace utils {
 			utils::areas	ram_area_;
 			utils::areas	data_area_;
 			utils::areas	rom_area_;
+			blocks			erase_block_;
+
+			bool parse_block_(const std::string& s, blocks& bs) {
+				utils::strings ss = utils::split_text(s, ",");
+				if((ss.size() % 3) != 0) {
+					return false;
+				}
+				for(uint32_t i = 0; i < ss.size() / 3; ++i) {
+					uint32_t org = 0;
+					uint32_t end = 0;
+					uint32_t size = 0;
+					if(!utils::string_to_hex(ss[i * 3 + 0], org)) {
+						return false;
+					}
+					if(!utils::string_to_hex(ss[i * 3 + 1], end)) {
+						return false;
+					}
+					if(!utils::string_to_hex(ss[i * 3 + 2], size)) {
+						return false;
+					}
+					// ブロック・サイズは２のべき乗
+					if(size == 0 || (size & (size - 1)) != 0 || org > end) {
+						return false;
+					}
+					bs.emplace_back(org, end, size);
+				}
+				return true;
+			}
 
 			bool parse_area_(const std::string& s, utils::areas& a) {
 				utils::strings ss = utils::split_text(s, ",");
@@ -176,6 +218,10 @@ namespace utils {
 						if(!parse_area_(u.body_, ram_area_)) {
 							err = true;
 						}
+					} else if(u.symbol_ == "erase-block") {
+						if(!parse_block_(u.body_, erase_block_)) {
+							err = true;
+						}
 					} else {
 						err = true;
 					}
@@ -211,6 +257,9 @@ namespace utils {
 
 		utils::strings	device_list_;
 
+		typedef std::vector<std::pair<std::string, device_t> > device_map;
+		device_map		device_map_;
+
 		void reset_ana_() {
 			ana_mode_ = ana_mode::name;
 			name_.clear();
@@ -401,6 +450,7 @@ namespace utils {
 							ins += " (RAM: " + device_.ram_;
 							ins += ", Program-Flash: " + device_.rom_;
 							if(!device_.data_.empty()) ins += ", Data-Flash: " + device_.data_;
+							device_map_.emplace_back(name_, device_);
 						} else {
 							device_t device;
 							if(!device.analize(units_)) {
@@ -409,6 +459,7 @@ namespace utils {
 							ins += " (RAM: " + device.ram_;
 							ins += ", Program-Flash: " + device.rom_;
 							if(!device.data_.empty()) ins += ", Data-Flash: " + device.data_;
+							device_map_.emplace_back(name_, device);
 						}
 						device_list_.push_back(name_ + ins + ")");
 						reset_ana_();
@@ -448,6 +499,26 @@ namespace utils {
 		const device_t& get_device() const { return device_; }
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	デバイスの検索 @n
+					デバイス名（R5F564ML 等）が一致しなければ、グループ名（RX64M 等）@n
+					が一致する最初のデバイスを返す
+			@param[in]	name	デバイス名、又はグループ名
+			@return デバイス（見つからない場合「nullptr」）
+		*/
+		//-----------------------------------------------------------------//
+		const device_t* find_device(const std::string& name) const {
+			for(const auto& d : device_map_) {
+				if(d.first == name) return &d.second;
+			}
+			for(const auto& d : device_map_) {
+				if(d.second.group_ == name) return &d.second;
+			}
+			return nullptr;
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	デバイス・リストの取得
@@ -0,0 +1,129 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	RX 消去プラン・クラス @n
+			書き込みページのリストを、デバイスのブロック・マップ（rx_prog.conf @n
+			の「erase-block」）に従い、最小のブロック消去コマンドの列にまとめる。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include "rx_prog.hpp"
+#include "conf_in.hpp"
+#include <vector>
+#include <algorithm>
+
+namespace rx {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief	erase_plan クラス
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	class erase_plan {
+	public:
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief	消去ブロック
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct block_t {
+			uint32_t	org_;
+			uint32_t	size_;
+			block_t(uint32_t org = 0, uint32_t size = 0) : org_(org), size_(size) { }
+
+			bool is_in(uint32_t adr) const {
+				return org_ <= adr && (adr - org_) < size_;
+			}
+		};
+		typedef std::vector<block_t> blocks;
+		typedef std::vector<uint32_t> pages;
+
+	private:
+		const prog&		prog_;
+
+		utils::conf_in::device_t::blocks	map_;
+
+	public:
+		//-------------------------------------------------------------//
+		/*!
+			@brief	コンストラクター
+			@param[in]	p	rx::prog の参照（ブロック・マップが無い領域で利用）
+		*/
+		//-------------------------------------------------------------//
+		erase_plan(const prog& p) : prog_(p) { }
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	ブロック・マップの設定
+			@param[in]	map	ブロック・マップ
+		*/
+		//-------------------------------------------------------------//
+		void set_block_map(const utils::conf_in::device_t::blocks& map) { map_ = map; }
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	アドレスを含むブロックを取得
+			@param[in]	adr	アドレス
+			@return ブロック
+		*/
+		//-------------------------------------------------------------//
+		block_t find(uint32_t adr) const {
+			for(const auto& m : map_) {
+				if(m.org_ <= adr && adr <= m.end_) {
+					return block_t(m.org_ + ((adr - m.org_) & ~(m.size_ - 1)), m.size_);
+				}
+			}
+			auto bs = prog_.get_block_size(adr);
+			if(bs == 0) bs = 256;
+			return block_t(adr & ~(bs - 1), bs);
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	ページ（256 バイト）と重なる全てのブロックを追加 @n
+					※ブロックがページより小さい場合（RX64M のデータ・フラッシュ）、@n
+					一つのページに複数のブロックが含まれる
+			@param[in]	adr	ページ・アドレス
+			@param[out]	bs	追加先
+		*/
+		//-------------------------------------------------------------//
+		void add_page(uint32_t adr, blocks& bs) const {
+			uint32_t a = adr & 0xffffff00;
+			uint32_t end = a + 255;
+			for(;;) {
+				if(bs.empty() || !bs.back().is_in(a)) {
+					bs.push_back(find(a));
+				}
+				uint32_t next = bs.back().org_ + bs.back().size_;
+				if(next == 0 || next > end) break;  // アドレスの最後で一周する場合を含む
+				a = next;
+			}
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	ページ・リストから消去ブロックのリストを作成
+			@param[in]	list	ページ（アドレス）のリスト
+			@return 消去ブロックのリスト（アドレス順、重複無し）
+		*/
+		//-------------------------------------------------------------//
+		blocks make(const pages& list) const {
+			blocks bs;
+			for(auto adr : list) {
+				add_page(adr, bs);
+			}
+			std::sort(bs.begin(), bs.end(),
+				[](const block_t& a, const block_t& b) { return a.org_ < b.org_; });
+			bs.erase(std::unique(bs.begin(), bs.end(),
+				[](const block_t& a, const block_t& b) { return a.org_ == b.org_; }), bs.end());
+			return bs;
+		}
+	};
+}
@@ -92,6 +92,27 @@ namespace utils {
 	}
 
 
+	//-----------------------------------------------------------------//
+	/*!
+		@brief	ディレクトリーを、途中のディレクトリーも含めて作成する（UTF8）
+		@param[in]	dir	ディレクトリー名
+		@return 作成出来たか、既にあれば「true」
+	*/
+	//-----------------------------------------------------------------//
+	bool create_directories(const std::string& dir)
+	{
+		if(dir.empty()) return false;
+		for(std::string::size_type pos = 1; pos <= dir.size(); ++pos) {
+			if(pos < dir.size() && dir[pos] != '/' && dir[pos] != '\\') continue;
+			std::string sub = dir.substr(0, pos);
+			if(is_directory(sub)) continue;
+			if(!sub.empty() && sub.back() == ':') continue;  // ドライブ名
+			if(!create_directory(sub) && !is_directory(sub)) return false;
+		}
+		return true;
+	}
+
+
 	//-----------------------------------------------------------------//
 	/*!
 		@brief	ディレクトリーか調べる
@@ -374,7 +395,7 @@ namespace utils {
 			case 'F':
 				{
 					unsigned char t[4];
-					memcpy(p, t, 4);
+					memcpy(t, p, 4);
 					for(int i = 0; i < 4; ++i) {
 						*p++ = t[4 - 1 - i];
 					}
@@ -386,11 +407,11 @@ namespace utils {
 			case 'D':
 				{
 					unsigned char t[8];
-					memcpy(p, t, 8);
+					memcpy(t, p, 8);
 					for(int i = 0; i < 8; ++i) {
 						*p++ = t[8 - 1 - i];
 					}
-					s += 4;
+					s += 8;
 				}
 				break;
 			default:
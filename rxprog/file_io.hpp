@@ -36,6 +36,16 @@ namespace utils {
 	bool create_directory(const std::string& dir);
 
 
+	//-----------------------------------------------------------------//
+	/*!
+		@brief	ディレクトリーを、途中のディレクトリーも含めて作成する（UTF8）
+		@param[in]	dir	ディレクトリー名
+		@return 作成出来たか、既にあれば「true」
+	*/
+	//-----------------------------------------------------------------//
+	bool create_directories(const std::string& dir);
+
+
 	//-----------------------------------------------------------------//
 	/*!
 		@brief	ディレクトリーか調べる（UTF8）
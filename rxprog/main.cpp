@@ -9,10 +9,21 @@
 //=====================================================================//
 #include <iostream>
 #include "rx_prog.hpp"
+#include "write_pipe.hpp"
+#include "erase_plan.hpp"
 #include "conf_in.hpp"
 #include "motsx_io.hpp"
 #include "string_utils.hpp"
 #include "area.hpp"
+#include "page_cache.hpp"
+#include "speed_cache.hpp"
+#include <set>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#ifndef WIN32
+#include <glob.h>
+#endif
 
 namespace {
 
@@ -90,12 +101,30 @@ namespace {
 	}
 
 
+	rx::write_pipe::pages make_page_list_(const utils::motsx_io::areas& areas)
+	{
+		rx::write_pipe::pages list;
+		for(const auto& a : areas) {
+			uint32_t adr = a.min_ & 0xffffff00;
+			uint32_t end = a.max_ & 0xffffff00;
+			while(1) {
+				list.push_back(adr);
+				if(adr == end) break;
+				adr += 256;
+			}
+		}
+		return list;
+	}
+
+
 	struct options {
 		bool verbose = false;
 
 		std::string platform;
 
 		std::string	inp_file;
+		uint32_t	base = 0;
+		bool	base_set = false;
 
 		std::string	device;
 		bool	dv = false;
@@ -104,7 +133,6 @@ namespace {
 		bool	br = false;
 
 		std::string com_path;
-		std::string com_name;
 		bool	dp = false;
 
 		std::string id_val;
@@ -119,6 +147,11 @@ namespace {
 		bool	verify = false;
 		bool	device_list = false;
 		bool	progress = false;
+		uint32_t	pipe = 0;
+		bool	low_latency = false;
+		std::string	stats;
+		bool	diff = false;
+		bool	diff_read = false;
 		bool	erase_data = false;
 		bool	erase_rom = false;
 		bool	help = false;
@@ -175,6 +208,655 @@ namespace {
 	};
 
 
+	//-----------------------------------------------------------------//
+	/*!
+		@brief	差分ページの抽出 @n
+				キャッシュのハッシュが一致しないページをリードバックで比較し、@n
+				異なるページを含むブロックだけを、消去／書き込み対象とする。@n
+				キャッシュはポート毎で、チップ固有の識別が無い為、一致したページから @n
+				CACHE_CHECK ページを読み出して照合し、違えばキャッシュを使わない。@n
+				（同じポートに、別のボードを繋いだ場合など）
+	*/
+	//-----------------------------------------------------------------//
+	struct diff_t {
+		uint32_t	hit = 0;
+		uint32_t	read = 0;
+		uint32_t	blocks = 0;
+		bool		reject = false;	///< キャッシュを照合で棄却
+	};
+
+	static const uint32_t CACHE_CHECK = 8;
+
+	bool diff_pages_(rx::prog& prog, const rx::erase_plan& plan, const utils::page_cache& cache, bool progress,
+		const rx::write_pipe::pages& list,
+		rx::write_pipe::pages& erase_list, rx::write_pipe::pages& write_list, diff_t& t,
+		std::atomic<uint32_t>& pos)
+	{
+		std::set<uint32_t> blocks;
+
+		// キャッシュが一致するページの照合（先頭から最後まで、均等に選ぶ）
+		std::vector<uint32_t> hits;
+		for(auto adr : list) {
+			const auto& mem = motsx_.get_memory(adr);
+			if(cache.find(adr, utils::page_cache::hash(&mem[0]))) hits.push_back(adr);
+		}
+		std::set<uint32_t> checked;
+		for(uint32_t i = 0; i < CACHE_CHECK && i < hits.size(); ++i) {
+			uint32_t n = hits.size() > 1 ? i * (hits.size() - 1) / (std::min<uint32_t>(CACHE_CHECK, hits.size()) - 1) : 0;
+			auto adr = hits[n];
+			if(checked.find(adr) != checked.end()) continue;
+			uint8_t dev[256];
+			if(!prog.read_page(adr, dev)) {
+				return false;
+			}
+			++t.read;
+			checked.insert(adr);
+			if(std::memcmp(dev, &motsx_.get_memory(adr)[0], 256) != 0) {
+				t.reject = true;
+				break;
+			}
+		}
+
+		page_t page;
+		for(auto adr : list) {
+			if(progress) {
+				progress_(list.size(), page);
+			}
+			++page.n;
+			pos = page.n;
+			const auto& mem = motsx_.get_memory(adr);
+			if(!t.reject && cache.find(adr, utils::page_cache::hash(&mem[0]))) {
+				++t.hit;
+				continue;
+			}
+			uint8_t dev[256];
+			if(!prog.read_page(adr, dev)) {
+				return false;
+			}
+			++t.read;
+			if(std::memcmp(dev, &mem[0], 256) == 0) continue;
+			rx::erase_plan::blocks bs;
+			plan.add_page(adr, bs);
+			for(const auto& b : bs) blocks.insert(b.org_);
+		}
+
+		// 消去するブロックに重なるページは、全て書き直す
+		write_list.clear();
+		for(auto adr : list) {
+			rx::erase_plan::blocks bs;
+			plan.add_page(adr, bs);
+			for(const auto& b : bs) {
+				if(blocks.find(b.org_) != blocks.end()) {
+					write_list.push_back(adr);
+					break;
+				}
+			}
+		}
+		erase_list = write_list;
+		t.blocks = blocks.size();
+		return true;
+	}
+
+
+	typedef std::chrono::steady_clock phase_clock;
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief	書き込みプラン（全ポートで共有、読み出し専用）
+	*/
+	//-----------------------------------------------------------------//
+	struct plan_t {
+		rx::write_pipe::pages	list;		///< イメージの全ページ
+		rx::erase_plan::blocks	blocks;		///< 全ページの消去ブロック
+	};
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief	セッション（ポート毎の状態） @n
+				phase: ' ' 待機、'C' 接続、'D' 差分、'E' 消去、'W' 書き込み、@n
+				'V' ベリファイ、'+' 成功、'-' 失敗
+	*/
+	//-----------------------------------------------------------------//
+	struct session_t {
+		std::string				port;
+		std::atomic<char>		phase;
+		std::atomic<uint32_t>	pos;
+		std::atomic<uint32_t>	all;
+		char	fail = 0;
+		double	time = 0.0;
+		uint32_t	speed_hint = 0;	///< 自動ボーレート選択で、最初に試す速度
+		uint32_t	speed_hold = 0;	///< 一段上の速度を試さない残りセッション数
+		uint32_t	speed = 0;		///< 接続したボーレート
+
+		rx::prog::phases			phases;	///< フェーズ毎の計測
+		utils::rs232c_io::stat_t	stat;	///< 通信統計
+
+		session_t() : phase(' '), pos(0), all(0) { }
+
+		void set(char ph, uint32_t n) {
+			pos = 0;
+			all = n;
+			phase = ph;
+		}
+	};
+
+
+	bool session_main_(rx::prog& prog_, const options& opts, const rx::protocol::rx_t& rx, uint32_t speed,
+		const plan_t& plan, const rx::erase_plan& eplan, bool gang, session_t& s)
+	{
+		bool verbose = opts.verbose && !gang;
+		bool progress = opts.progress && !gang;
+
+		s.set('C', 0);
+		{
+			auto rxs = rx;
+			rxs.speed_hint_ = s.speed_hint;
+			rxs.speed_probe_ = s.speed_hold == 0;
+			if(!prog_.start(s.port, speed, rxs)) {
+				prog_.end();
+				return false;
+			}
+		}
+		s.speed = prog_.get_baud_rate();
+		if(verbose && speed == 0) {
+			std::cout << "# Serial port speed (auto): " << s.speed << std::endl;
+		}
+
+		const auto& list = plan.list;
+		auto erase_list = list;
+		auto write_list = list;
+		const rx::erase_plan::blocks* blocks = &plan.blocks;
+		rx::erase_plan::blocks diff_blocks;
+
+		//=====================================
+		// ページ・ハッシュ・キャッシュ（差分書き込み）
+		std::string cache_path;
+		if(opts.erase || opts.write) {
+			cache_path = utils::page_cache::make_path(prog_.get_device_id(), s.port);
+			if(cache_path.empty() && verbose) {
+				std::cout << "# Page hash cache disabled: can't create '"
+					<< utils::page_cache::cache_dir() << '\'' << std::endl;
+			}
+		}
+		if(opts.diff && opts.write) {
+			if(prog_.get_block_size(list.empty() ? 0 : list.front()) == 0) {
+				if(!gang) {
+					std::cout << "Differential write is not supported by '" << rx.cpu_type_
+						<< "' (erased on connection)" << std::endl;
+				}
+			} else {
+				s.set('D', list.size());
+				prog_.begin_phase("Diff");
+				utils::page_cache cache;
+				if(!opts.diff_read && !cache_path.empty() && cache.load(cache_path)) {
+					if(verbose) {
+						std::cout << "# Page hash cache: '" << cache_path << "' (" << cache.size()
+							<< " pages)" << std::endl;
+					}
+				}
+				if(progress) {
+					std::cout << "Diff:   " << std::flush;
+				}
+				diff_t t;
+				if(!diff_pages_(prog_, eplan, cache, progress, list, erase_list, write_list, t, s.pos)) {
+					prog_.end();
+					return false;
+				}
+				if(progress) {
+					std::cout << std::endl << std::flush;
+				}
+				if(verbose) {
+					if(t.reject) {
+						std::cout << "# Page hash cache does not match the device, ignored" << std::endl;
+					}
+					std::cout << boost::format("# Differential write: %d / %d pages, %d blocks (cache hit: %d, read back: %d)")
+						% write_list.size() % list.size() % t.blocks % t.hit % t.read << std::endl;
+				}
+				diff_blocks = eplan.make(erase_list);
+				blocks = &diff_blocks;
+				prog_.end_phase(t.read);
+			}
+		}
+		if(!cache_path.empty() && utils::probe_file(cache_path)) {  // 書き換え前に無効化
+			utils::remove_file(cache_path);
+		}
+
+		//=====================================
+		if(opts.erase) {  // erase
+			prog_.begin_phase("Erase");
+			s.set('E', blocks->size());
+			if(progress) {
+				std::cout << "Erase:  " << std::flush;
+			}
+
+			page_t page;
+			for(const auto& b : *blocks) {
+				if(progress) {
+					progress_(blocks->size(), page);
+				}
+				if(!prog_.erase_block(b.org_, b.size_)) {  // ブロック単位で消去要求を送る
+					prog_.end();
+					return false;
+				}
+				++page.n;
+				s.pos = page.n;
+			}
+			if(progress) {
+				std::cout << std::endl << std::flush;
+			}
+			if(verbose && prog_.get_block_size(list.empty() ? 0 : list.front()) != 0) {
+				std::cout << boost::format("# Erase plan: %d blocks (%d pages)") % blocks->size() % erase_list.size()
+					<< std::endl;
+			}
+			prog_.end_phase(erase_list.size());
+			if(verbose) {
+				prog_.get_phase().back().info("# ");
+			}
+		}
+
+		//=====================================
+		if(opts.write) {  // write
+			prog_.begin_phase("Write");
+			s.set('W', write_list.size());
+			if(!write_list.empty()) {
+				if(!prog_.start_write(true)) {
+					prog_.end();
+					return false;
+				}
+			}
+
+			if(progress) {
+				std::cout << "Write:  " << std::flush;
+			}
+			page_t page;
+			if(opts.pipe > 0) {  // パイプライン・ライト
+				rx::write_pipe pipe(prog_, opts.pipe);
+				if(!pipe.run(write_list, motsx_, [&](uint32_t n) {
+					s.pos = n;
+					if(progress) {
+						page.n = n;
+						progress_(write_list.size(), page);
+					}
+				})) {
+					prog_.end();
+					return false;
+				}
+				if(progress) {
+					std::cout << std::endl << std::flush;
+				}
+				if(verbose || progress) {
+					pipe.get_info().info("# ");
+				}
+			} else {
+				for(auto adr : write_list) {
+					if(progress) {
+						progress_(write_list.size(), page);
+					}
+					/// std::cout << boost::format("%08X to %08X") % adr % (adr + 255) << std::endl;
+					const auto& mem = motsx_.get_memory(adr);
+					if(!prog_.write(adr, &mem[0])) {
+						prog_.end();
+						return false;
+					}
+					++page.n;
+					s.pos = page.n;
+				}
+				if(progress) {
+					std::cout << std::endl << std::flush;
+				}
+			}
+			if(!write_list.empty()) {
+				if(!prog_.final_write()) {
+					prog_.end();
+					return false;
+				}
+			}
+			prog_.end_phase(write_list.size());
+			if(verbose) {
+				prog_.get_phase().back().info("# ");
+			}
+		}
+
+		//=====================================
+		if(opts.verify) {  // verify
+			prog_.begin_phase("Verify");
+			s.set('V', list.size());
+			if(progress) {
+				std::cout << "Verify: " << std::flush;
+			}
+			page_t page;
+			for(auto adr : list) {
+				if(progress) {
+					progress_(list.size(), page);
+				}
+				/// std::cout << boost::format("%08X to %08X") % adr % (adr + 255) << std::endl;
+				const auto& mem = motsx_.get_memory(adr);
+				if(!prog_.verify_page(adr, &mem[0])) {
+					prog_.end();
+					return false;
+				}
+				++page.n;
+				s.pos = page.n;
+			}
+			if(progress) {
+				std::cout << std::endl << std::flush;
+			}
+			prog_.end_phase(list.size());
+			if(verbose) {
+				prog_.get_phase().back().info("# ");
+			}
+		}
+
+		// 書き込んだイメージのページ・ハッシュを保存
+		if(opts.write && !cache_path.empty() && prog_.get_block_size(list.empty() ? 0 : list.front()) != 0) {
+			utils::page_cache cache;
+			for(auto adr : list) {
+				const auto& mem = motsx_.get_memory(adr);
+				cache.set(adr, utils::page_cache::hash(&mem[0]));
+			}
+			if(!cache.save(cache_path)) {
+				std::cerr << "Can't write page hash cache: '" << cache_path << '\'' << std::endl;
+			}
+		}
+
+		if(verbose) {
+			prog_.get_stat().info("# ");
+		}
+		prog_.end();
+		return true;
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief	自動選択したボーレートをキャッシュから取得
+	*/
+	//-----------------------------------------------------------------//
+	void load_speed_(const std::string& cpu, std::vector<session_t>& ss)
+	{
+		utils::speed_cache cache;
+		cache.load(utils::speed_cache::make_path());
+		for(auto& s : ss) {
+			auto v = cache.get(utils::speed_cache::make_key(cpu, s.port));
+			s.speed_hint = v.speed;
+			s.speed_hold = v.hold;
+		}
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief	自動選択したボーレートをキャッシュに保存
+	*/
+	//-----------------------------------------------------------------//
+	void save_speed_(const std::string& cpu, const std::vector<session_t>& ss)
+	{
+		auto path = utils::speed_cache::make_path();
+		utils::speed_cache cache;
+		cache.load(path);
+		bool mod = false;
+		for(const auto& s : ss) {
+			if(s.speed == 0) continue;
+			auto key = utils::speed_cache::make_key(cpu, s.port);
+			utils::speed_cache::value_t v;
+			v.speed = s.speed;
+			// 一段上の速度に上がれなかった場合は、暫く試さない
+			if(s.speed == s.speed_hint) {
+				v.hold = s.speed_hold > 0 ? (s.speed_hold - 1) : utils::speed_cache::PROBE_HOLD;
+			}
+			auto org = cache.get(key);
+			if(org.speed == v.speed && org.hold == v.hold) continue;
+			cache.set(key, v);
+			mod = true;
+		}
+		if(mod && !cache.save(path)) {
+			std::cerr << "Can't save speed cache: '" << path << '\'' << std::endl;
+		}
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief	セッションの実行（経過時間と結果を記録）
+	*/
+	//-----------------------------------------------------------------//
+	void session_(const options& opts, const rx::protocol::rx_t& rx, uint32_t speed,
+		const plan_t& plan, const rx::erase_plan& eplan, bool gang, session_t& s)
+	{
+		auto st = phase_clock::now();
+		rx::prog prog(opts.verbose && !gang);
+		bool ok = session_main_(prog, opts, rx, speed, plan, eplan, gang, s);
+		s.time = std::chrono::duration<double>(phase_clock::now() - st).count();
+		s.phases = prog.get_phase();
+		s.stat = prog.get_stat();
+		if(!ok) s.fail = s.phase;
+		s.phase = ok ? '+' : '-';
+	}
+
+
+	std::string json_str_(const std::string& src)
+	{
+		std::string dst = "\"";
+		for(auto ch : src) {
+			if(ch == '"' || ch == '\\') {
+				dst += '\\';
+				dst += ch;
+			} else if(static_cast<uint8_t>(ch) < 0x20) {
+				dst += (boost::format("\\u%04x") % static_cast<uint32_t>(ch)).str();
+			} else {
+				dst += ch;
+			}
+		}
+		dst += '"';
+		return dst;
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief	計測結果の表示（テキスト）
+	*/
+	//-----------------------------------------------------------------//
+	void stats_text_(const std::vector<session_t>& ss)
+	{
+		for(const auto& s : ss) {
+			std::cout << boost::format("# Stats: '%s' (%s, %d bps, %.3f sec)")
+				% s.port % (s.fail == 0 ? "PASS" : "FAIL") % s.speed % s.time << std::endl;
+			for(const auto& t : s.phases) {
+				t.info("#   ");
+				std::cout << boost::format("#     send %d, recv %d, round trip %d, retry %d, timeout %d")
+					% t.send_ % t.recv_ % t.round_ % t.retry_ % t.timeout_ << std::endl;
+			}
+			s.stat.info("#   ");
+		}
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief	計測結果の表示（JSON）
+	*/
+	//-----------------------------------------------------------------//
+	void stats_json_(const options& opts, const std::vector<session_t>& ss)
+	{
+		std::cout << "{" << std::endl;
+		std::cout << "  \"version\": " << json_str_(version_) << "," << std::endl;
+		std::cout << "  \"device\": " << json_str_(opts.device) << "," << std::endl;
+		std::cout << "  \"input\": " << json_str_(opts.inp_file) << "," << std::endl;
+		std::cout << "  \"sessions\": [" << std::endl;
+		for(uint32_t i = 0; i < ss.size(); ++i) {
+			const auto& s = ss[i];
+			std::cout << "    {" << std::endl;
+			std::cout << "      \"port\": " << json_str_(s.port) << "," << std::endl;
+			std::cout << "      \"result\": " << (s.fail == 0 ? "\"pass\"" : "\"fail\"") << "," << std::endl;
+			std::cout << boost::format("      \"speed\": %d,") % s.speed << std::endl;
+			std::cout << boost::format("      \"time\": %.6f,") % s.time << std::endl;
+			std::cout << "      \"phases\": [";
+			for(uint32_t j = 0; j < s.phases.size(); ++j) {
+				const auto& t = s.phases[j];
+				double kbps = t.time_ > 0.0 ? (static_cast<double>(t.pages_) * 256.0 / 1024.0 / t.time_) : 0.0;
+				std::cout << (j == 0 ? "" : ",") << std::endl;
+				std::cout << "        { \"name\": " << json_str_(t.name_);
+				std::cout << boost::format(", \"time\": %.6f, \"pages\": %d, \"kbps\": %.3f,")
+					% t.time_ % t.pages_ % kbps;
+				std::cout << boost::format(" \"send\": %d, \"recv\": %d, \"round_trips\": %d,")
+					% t.send_ % t.recv_ % t.round_;
+				std::cout << boost::format(" \"retries\": %d, \"timeouts\": %d }")
+					% t.retry_ % t.timeout_;
+			}
+			std::cout << std::endl << "      ]," << std::endl;
+			const auto& st = s.stat;
+			std::cout << boost::format("      \"serial\": { \"read\": %d, \"write\": %d, \"poll\": %d,"
+				" \"drain\": %d, \"timeouts\": %d, \"retries\": %d, \"round_trips\": %d,"
+				" \"recv\": %d, \"send\": %d },")
+				% st.read_ % st.write_ % st.poll_ % st.drain_ % st.timeout_ % st.retry_ % st.round_
+				% st.recv_ % st.send_ << std::endl;
+			std::cout << "      \"latency_us\": {";
+			bool first = true;
+			for(const auto& m : st.latency_) {
+				const auto& l = m.second;
+				std::cout << (first ? "" : ",") << std::endl;
+				first = false;
+				std::cout << boost::format("        \"%02X\": { \"count\": %d, \"min\": %d, \"mean\": %d,"
+					" \"max\": %d, \"log2_hist\": [") % static_cast<uint32_t>(m.first)
+					% l.count_ % l.min_ % l.mean() % l.max_;
+				// 末尾の「０」は省略
+				uint32_t n = utils::rs232c_io::latency_t::bucket_num;
+				while(n > 1 && l.bucket_[n - 1] == 0) --n;
+				for(uint32_t k = 0; k < n; ++k) {
+					std::cout << (k == 0 ? "" : ", ") << l.bucket_[k];
+				}
+				std::cout << "] }";
+			}
+			std::cout << std::endl << "      }" << std::endl;
+			std::cout << "    }" << (i + 1 < ss.size() ? "," : "") << std::endl;
+		}
+		std::cout << "  ]" << std::endl;
+		std::cout << "}" << std::endl;
+	}
+
+
+	void stats_(const options& opts, const std::vector<session_t>& ss)
+	{
+		if(opts.stats == "json") stats_json_(opts, ss);
+		else if(opts.stats == "text") stats_text_(ss);
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief	ギャング書き込みの進捗表示（全ポートの集計）
+	*/
+	//-----------------------------------------------------------------//
+	void gang_progress_(const std::vector<session_t>& ss)
+	{
+		std::string line;
+		uint32_t fin = 0;
+		for(const auto& s : ss) {
+			char ph = s.phase;
+			if(ph == '+' || ph == '-') {
+				++fin;
+				line += ph == '+' ? "[ OK ]" : "[ NG ]";
+			} else {
+				uint32_t all = s.all;
+				uint32_t pos = s.pos;
+				uint32_t per = all > 0 ? pos * 100 / all : 0;
+				line += (boost::format("[%c%3d]") % ph % per).str();
+			}
+		}
+		std::cout << boost::format("\rGang: %d/%d ") % fin % ss.size() << line << std::flush;
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief	ギャング書き込みの結果表示
+		@return 全てのポートが成功なら「true」
+	*/
+	//-----------------------------------------------------------------//
+	bool gang_summary_(const std::vector<session_t>& ss)
+	{
+		static const char* phase_name[] = {
+			"Connection", "Diff", "Erase", "Write", "Verify"
+		};
+		static const char phase_code[] = "CDEWV";
+
+		uint32_t pass = 0;
+		std::cout << "Gang summary:" << std::endl;
+		for(const auto& s : ss) {
+			if(s.fail == 0) {
+				++pass;
+				std::cout << boost::format("  %-20s  PASS  (%.2f sec)") % s.port % s.time << std::endl;
+			} else {
+				const char* name = "";
+				for(int i = 0; phase_code[i] != 0; ++i) {
+					if(phase_code[i] == s.fail) name = phase_name[i];
+				}
+				std::cout << boost::format("  %-20s  FAIL  (%.2f sec, %s)") % s.port % s.time % name << std::endl;
+			}
+		}
+		std::cout << boost::format("Pass: %d, Fail: %d") % pass % (ss.size() - pass) << std::endl;
+		return pass == ss.size();
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief	Windwos系シリアル・ポート（COMx）の変換
+	*/
+	//-----------------------------------------------------------------//
+	std::string convert_port_(const std::string& path, bool verbose)
+	{
+		if(path.empty() || path[0] == '/') return path;
+
+		std::string out = path;
+		std::string s = utils::to_lower_text(path);
+		if(s.size() > 3 && s[0] == 'c' && s[1] == 'o' && s[2] == 'm') {
+			int val;
+			if(utils::string_to_int(&s[3], val)) {
+				if(val >= 1 ) {
+					--val;
+					out = "/dev/ttyS" + (boost::format("%d") % val).str();
+				}
+			}
+		}
+		if(verbose) {
+			std::cout << "# Serial port alias: " << path << " ---> " << out << std::endl;
+		}
+		return out;
+	}
+
+
+	//-----------------------------------------------------------------//
+	/*!
+		@brief	シリアル・ポート・リストの作成 @n
+				「,」区切りで複数指定、ワイルドカード（*, ?, [...]）を展開
+	*/
+	//-----------------------------------------------------------------//
+	utils::strings make_port_list_(const std::string& path, bool verbose)
+	{
+		utils::strings ports;
+		for(const auto& t : utils::split_text(path, ",")) {
+#ifndef WIN32
+			if(t.find_first_of("*?[") != std::string::npos) {
+				glob_t g;
+				if(glob(t.c_str(), 0, nullptr, &g) == 0) {
+					for(size_t i = 0; i < g.gl_pathc; ++i) {
+						ports.push_back(g.gl_pathv[i]);
+					}
+				}
+				globfree(&g);
+				continue;
+			}
+#endif
+			ports.push_back(convert_port_(t, verbose));
+		}
+		return ports;
+	}
+
+
 	void help_(const std::string& cmd)
 	{
 		using namespace std;
@@ -184,11 +866,13 @@ namespace {
 		cout << "Renesas RX Series Programmer Version " << version_ << endl;
 		cout << "Copyright (C) 2016, Hiramatsu Kunihito (hira@rvf-rc45.net)" << endl;
 		cout << "usage:" << endl;
-		cout << c << " [options] [mot file] ..." << endl;
+		cout << c << " [options] [mot/hex/elf/bin file] ..." << endl;
 		cout << endl;
 		cout << "Options :" << endl;
 		cout << "    -P PORT,   --port=PORT     Specify serial port" << endl;
+		cout << "                               (PORT,PORT,... or wildcard: gang programming)" << endl;
 		cout << "    -s SPEED,  --speed=SPEED   Specify serial speed" << endl;
+		cout << "                               ('auto': fastest stable speed, cached per port)" << endl;
 		cout << "    -d DEVICE, --device=DEVICE Specify device name" << endl;
 		cout << "    -e, --erase                Perform a device erase to a minimum" << endl;
 ///		cout << "    --erase-all, --erase-chip\tPerform rom and data flash erase" << endl;
@@ -197,8 +881,14 @@ namespace {
 ///		cout << "    --id=ID[:,]ID[;,] ...      Specify protect ID (16bytes)" << endl;
 ///		cout << "    -r, --read                 Perform data read" << endl;
 ///		cout << "    --area=ORG[:,]END          Specify read area" << endl;
+		cout << "    --base=ADDR                Load input as raw binary at ADDR (hex)" << endl;
+		cout << "                               (*.bin without --base ends at FFFFFFFF)" << endl;
 		cout << "    -v, --verify               Perform data verify" << endl;
 		cout << "    -w, --write                Perform data write" << endl;
+		cout << "    --diff[=read]              Write only the blocks that differ (read: ignore hash cache)" << endl;
+		cout << "    --pipe[=N]                 Pipelined write, keep up to N frames queued (default 16)" << endl;
+		cout << "    --low-latency              Set serial port to low latency mode (Linux)" << endl;
+		cout << "    --stats=FORMAT             Display per-phase timing and serial statistics (text, json)" << endl;
 		cout << "    --progress                 display Progress output" << endl;
 		cout << "    --device-list              Display device list" << endl;
 		cout << "    --verbose                  Verbose output" << endl;
@@ -285,6 +975,33 @@ int main(int argc, char* argv[])
 				opts.verify = true;
 			} else if(p == "--progress") {
 				opts.progress = true;
+			} else if(p == "--diff") {
+				opts.diff = true;
+			} else if(p == "--diff=read") {
+				opts.diff = true;
+				opts.diff_read = true;
+			} else if(p == "--pipe") {
+				opts.pipe = 16;
+			} else if(p.find("--pipe=") == 0) {
+				int n;
+				if(utils::string_to_int(&p[std::strlen("--pipe=")], n) && n > 0) {
+					opts.pipe = n;
+				} else {
+					opterr = true;
+				}
+			} else if(p.find("--base=") == 0) {
+				if(utils::string_to_hex(&p[std::strlen("--base=")], opts.base)) {
+					opts.base_set = true;
+				} else {
+					opterr = true;
+				}
+			} else if(p == "--low-latency") {
+				opts.low_latency = true;
+			} else if(p.find("--stats=") == 0) {
+				opts.stats = &p[std::strlen("--stats=")];
+				if(opts.stats != "text" && opts.stats != "json") {
+					opterr = true;
+				}
 			} else if(p == "--device-list") {
 				opts.device_list = true;
 			} else if(p == "-e" || p == "--erase") {
@@ -339,47 +1056,39 @@ int main(int argc, char* argv[])
 	}
 
 	// 入力ファイルの読み込み
-	uint32_t pageall = 0;
 	if(!opts.inp_file.empty()) {
 		if(opts.verbose) {
 			std::cout << "# Input file path: '" << opts.inp_file << '\'' << std::endl;
 		}
-		if(!motsx_.load(opts.inp_file)) {
+		auto st = phase_clock::now();
+		bool ok;
+		if(opts.base_set) ok = motsx_.load_binary(opts.inp_file, opts.base);
+		else ok = motsx_.load(opts.inp_file);
+		if(!ok) {
 			std::cerr << "Can't open input file: '" << opts.inp_file << "'" << std::endl;
 			return -1;
 		}
-		pageall = motsx_.get_total_page();
 		if(opts.verbose) {
+			auto t = std::chrono::duration<double>(phase_clock::now() - st).count();
+			std::cout << boost::format("# Input file load: %.3f sec (%d pages)") % t % motsx_.get_total_page()
+				<< std::endl;
 			motsx_.list_area_map("# ");
 		}
 	}
 
-    // Windwos系シリアル・ポート（COMx）の変換
-    if(!opts.com_path.empty() && opts.com_path[0] != '/') {
-		std::string s = utils::to_lower_text(opts.com_path);
-        if(s.size() > 3 && s[0] == 'c' && s[1] == 'o' && s[2] == 'm') {
-            int val;
-            if(utils::string_to_int(&s[3], val)) {
-                if(val >= 1 ) {
-                    --val;
-                    opts.com_name = opts.com_path;
-                    opts.com_path = "/dev/ttyS" + (boost::format("%d") % val).str();
-                }
-            }
-        }
-		if(opts.verbose) {
-			std::cout << "# Serial port alias: " << opts.com_name << " ---> " << opts.com_path << std::endl;
-		}
-    }
-	if(opts.com_path.empty()) {
-		std::cerr << "Serial port path not found." << std::endl;
+	auto ports = make_port_list_(opts.com_path, opts.verbose);
+	if(ports.empty()) {
+		std::cerr << "Serial port path not found: '" << opts.com_path << '\'' << std::endl;
 		return -1;
 	}
 	if(opts.verbose) {
-		std::cout << "# Serial port path: '" << opts.com_path << '\'' << std::endl;
+		for(const auto& port : ports) {
+			std::cout << "# Serial port path: '" << port << '\'' << std::endl;
+		}
 	}
-	int com_speed = 0;
-	if(!utils::string_to_int(opts.com_speed, com_speed)) {
+	int com_speed = 0;  // 「０」なら自動選択
+	bool auto_speed = opts.com_speed == "auto";
+	if(!auto_speed && (!utils::string_to_int(opts.com_speed, com_speed) || com_speed <= 0)) {
 		std::cerr << "Serial speed conversion error: '" << opts.com_speed << '\'' << std::endl;
 		return -1;		
 	}
@@ -392,12 +1101,14 @@ int main(int argc, char* argv[])
 		rx.verbose_ = opts.verbose;
 
 		rx.cpu_type_ = opts.device;
+		rx.low_latency_ = opts.low_latency;
 
 		if(rx.cpu_type_ == "RX63T") {
 			// rx.master_ = 1200;  // 12.00MHz
 			// rx.sys_div_ = 8;    // x8 (96MHz)
 			// rx.ext_div_ = 4;    // x4 (48MHz)
-			auto devt = conf_in_.get_device();
+			auto pdev = conf_in_.find_device(opts.device);
+			auto devt = pdev != nullptr ? *pdev : conf_in_.get_device();
 			int32_t val = 0;;
 			if(!utils::string_to_int(devt.clock_, val)) {
 				std::cerr << "RX63T 'clock' tag conversion error: '" << devt.clock_ << '\'' << std::endl;
@@ -419,112 +1130,66 @@ int main(int argc, char* argv[])
 		}
 	}
 
-	rx::prog prog_(opts.verbose);
-	if(!prog_.start(opts.com_path, com_speed, rx)) {
-		prog_.end();
+	// イメージと消去ブロックは、一度だけ作成して全ポートで共有する
+	rx::prog planner;
+	if(!planner.select(rx.cpu_type_)) {
 		return -1;
 	}
-
-	//=====================================
-	if(opts.erase) {  // erase
-		auto areas = motsx_.create_area_map();
-
-		if(opts.progress) {
-			std::cout << "Erase:  " << std::flush;
-		}
-
-		page_t page;
-		for(const auto& a : areas) {
-			uint32_t adr = a.min_ & 0xffffff00;
-			uint32_t len = 0;
-			while(len < (a.max_ - a.min_ + 1)) {
-				if(opts.progress) {
-					progress_(pageall, page);
-				}
-				if(!prog_.erase_page(adr)) {  // 256 バイト単位で消去要求を送る
-					prog_.end();
-					return -1;
-				}
-				adr += 256;
-				len += 256;
-				++page.n;
-			}
-		}
-		if(opts.progress) {
-			std::cout << std::endl << std::flush;
+	rx::erase_plan eplan(planner);
+	{
+		auto devt = conf_in_.find_device(opts.device);
+		if(devt != nullptr) {
+			eplan.set_block_map(devt->erase_block_);
 		}
 	}
+	plan_t plan;
+	plan.list = make_page_list_(motsx_.create_area_map());
+	plan.blocks = eplan.make(plan.list);
 
-	//=====================================
-	if(opts.write) {  // write
-		auto areas = motsx_.create_area_map();
-		if(!areas.empty()) {
-			if(!prog_.start_write(true)) {
-				prog_.end();
-				return -1;
-			}
-		}
-		
-		if(opts.progress) {
-			std::cout << "Write:  " << std::flush;
-		}
-		page_t page;
-		for(const auto& a : areas) {
-			uint32_t adr = a.min_ & 0xffffff00;
-			uint32_t len = 0;
-			while(len < (a.max_ - a.min_ + 1)) {
-				if(opts.progress) {
-					progress_(pageall, page);
-				}
-				/// std::cout << boost::format("%08X to %08X") % adr % (adr + 255) << std::endl;
-				auto mem = motsx_.get_memory(adr);
-				if(!prog_.write(adr, &mem[0])) {
-					prog_.end();
-					return -1;
-				}
-				adr += 256;
-				len += 256;
-				++page.n;
-			}
-		}
-		if(opts.progress) {
-			std::cout << std::endl << std::flush;
-		}
-		if(!prog_.final_write()) {
-			prog_.end();
-			return -1;
-		}
+	if(ports.size() == 1) {
+		std::vector<session_t> ss(1);
+		ss[0].port = ports[0];
+		if(auto_speed) load_speed_(rx.cpu_type_, ss);
+		session_(opts, rx, com_speed, plan, eplan, false, ss[0]);
+		if(auto_speed) save_speed_(rx.cpu_type_, ss);
+		stats_(opts, ss);
+		return ss[0].fail == 0 ? 0 : -1;
 	}
 
 	//=====================================
-	if(opts.verify) {  // verify
-		auto areas = motsx_.create_area_map();
-		if(opts.progress) {
-			std::cout << "Verify: " << std::flush;
-		}
-		page_t page;
-		for(const auto& a : areas) {
-			uint32_t adr = a.min_ & 0xffffff00;
-			uint32_t len = 0;
-			while(len < (a.max_ - a.min_ + 1)) {
-				if(opts.progress) {
-					progress_(pageall, page);
-				}
-				/// std::cout << boost::format("%08X to %08X") % adr % (adr + 255) << std::endl;
-				auto mem = motsx_.get_memory(adr);
-				if(!prog_.verify_page(adr, &mem[0])) {
-					prog_.end();
-					return -1;
-				}
-				adr += 256;
-				len += 256;
-				++page.n;
-			}
+	// ギャング書き込み（ポート毎にスレッドを起動）
+	rx.verbose_ = false;
+	std::vector<session_t> ss(ports.size());
+	std::vector<std::thread> ths;
+	for(uint32_t i = 0; i < ports.size(); ++i) {
+		ss[i].port = ports[i];
+	}
+	if(auto_speed) load_speed_(rx.cpu_type_, ss);
+	for(uint32_t i = 0; i < ports.size(); ++i) {
+		ths.emplace_back(session_, std::cref(opts), std::cref(rx), com_speed,
+			std::cref(plan), std::cref(eplan), true, std::ref(ss[i]));
+	}
+	while(1) {
+		bool fin = true;
+		for(const auto& s : ss) {
+			char ph = s.phase;
+			if(ph != '+' && ph != '-') fin = false;
 		}
 		if(opts.progress) {
-			std::cout << std::endl << std::flush;
+			gang_progress_(ss);
 		}
+		if(fin) break;
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	}
+	if(opts.progress) {
+		std::cout << std::endl;
+	}
+	for(auto& th : ths) {
+		th.join();
 	}
+	if(auto_speed) save_speed_(rx.cpu_type_, ss);
 
-	prog_.end();
+	bool ok = gang_summary_(ss);
+	stats_(opts, ss);
+	return ok ? 0 : -1;
 }
@@ -0,0 +1,141 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	読み出し専用ファイル・マップ・クラス @n
+			POSIX 環境では mmap でファイルをメモリーに割り当て、それ以外では @n
+			ファイル全体をバッファに読み込む。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <string>
+#include <vector>
+#include "file_io.hpp"
+#ifndef WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace utils {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief	map_file クラス
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	class map_file {
+
+		const uint8_t*	top_;
+		size_t			size_;
+		void*			map_;
+		std::vector<uint8_t>	buff_;
+
+		map_file(const map_file&) = delete;
+		map_file& operator = (const map_file&) = delete;
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	コンストラクター
+		*/
+		//-----------------------------------------------------------------//
+		map_file() : top_(nullptr), size_(0), map_(nullptr) { }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	デストラクター
+		*/
+		//-----------------------------------------------------------------//
+		~map_file() { close(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	オープン
+			@param[in]	path	ファイル・パス
+			@return 成功なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool open(const std::string& path) {
+			close();
+#ifndef WIN32
+			int fd = ::open(path.c_str(), O_RDONLY);
+			if(fd < 0) return false;
+			struct stat st;
+			if(fstat(fd, &st) != 0) {
+				::close(fd);
+				return false;
+			}
+			size_ = st.st_size;
+			if(size_ > 0) {
+				map_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+				if(map_ == MAP_FAILED) {
+					map_ = nullptr;
+				}
+			}
+			::close(fd);
+			if(map_ != nullptr) {
+				top_ = static_cast<const uint8_t*>(map_);
+				return true;
+			}
+#endif
+			// mmap 出来ない場合は、全体を読み込む
+			utils::file_io fio;
+			if(!fio.open(path, "rb")) {
+				return false;
+			}
+			size_ = fio.get_file_size();
+			buff_.resize(size_ + 1);
+			if(size_ > 0 && fio.read(&buff_[0], size_) != size_) {
+				buff_.clear();
+				size_ = 0;
+				return false;
+			}
+			fio.close();
+			top_ = &buff_[0];
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	クローズ
+		*/
+		//-----------------------------------------------------------------//
+		void close() {
+#ifndef WIN32
+			if(map_ != nullptr) {
+				munmap(map_, size_);
+				map_ = nullptr;
+			}
+#endif
+			buff_.clear();
+			top_ = nullptr;
+			size_ = 0;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	先頭ポインターの取得
+			@return 先頭ポインター
+		*/
+		//-----------------------------------------------------------------//
+		const uint8_t* get() const { return top_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	サイズの取得
+			@return サイズ
+		*/
+		//-----------------------------------------------------------------//
+		size_t size() const { return size_; }
+	};
+}
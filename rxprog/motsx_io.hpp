@@ -1,7 +1,8 @@
 #pragma once
 //=====================================================================//
 /*!	@file
-	@brief	モトローラーＳフォーマット入出力
+	@brief	モトローラーＳフォーマット入出力 @n
+			インテル HEX、バイナリ、ELF（PT_LOAD セグメント）の入力にも対応
     @author 平松邦仁 (hira@rvf-rc45.net)
 	@copyright	Copyright (C) 2016, 2017 Kunihito Hiramatsu @n
 				Released under the MIT license @n
@@ -9,10 +10,11 @@
 */
 //=====================================================================//
 #include <vector>
-#include <map>
 #include <string>
 #include <array>
 #include "file_io.hpp"
+#include "page_store.hpp"
+#include "map_file.hpp"
 #include <iomanip>
 #include <boost/format.hpp>
 
@@ -25,197 +27,335 @@ namespace utils {
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	class motsx_io {
 	public:
-		typedef std::array<uint8_t, 256> array;
-
-		struct area_t {
-			uint32_t	min_;
-			uint32_t	max_;
-			area_t(uint32_t min = 0xffffffff, uint32_t max = 0) : min_(min), max_(max) { } 			
-		};
+		typedef page_store::array array;
+		typedef page_store::area_t area_t;
 		typedef std::vector<area_t> areas;
+		typedef page_store::page_t array_t;
 
-		struct array_t {
-			area_t	area_;
-			array	array_;
-
-			array_t() : area_(), array_() { array_.fill(0xff); }
-
-			void set(uint32_t adr, uint8_t data) {
-				if(area_.min_ > adr) area_.min_ = adr;
-				if(area_.max_ < adr) area_.max_ = adr;
-				array_[adr & 0xff] = data;
-			}
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	形式
+		*/
+		//-----------------------------------------------------------------//
+		enum class format {
+			MOTSX,	///< モトローラーＳフォーマット
+			IHEX,	///< インテル HEX
+			ELF,	///< ELF32
+			BINARY,	///< バイナリ
 		};
 
+
 	private:
 		area_t		area_;
 		uint32_t	exec_;
+		format		format_;
 
-		typedef std::map<uint32_t, array_t>	memory_map;
-
-		memory_map	memory_map_;
+		page_store	store_;
 
 		array		fill_array_;
 
-		void write_byte_(uint32_t address, uint8_t val) {
-			uint32_t base = address & 0xffff00;
-			memory_map::iterator it = memory_map_.find(base);
-			if(it == memory_map_.end()) {
-				array_t t;
-				t.set(address, val);
-				memory_map_.emplace(base, t);
+		//=============================================================//
+		// １６進数の変換テーブル（不正な文字は -1）
+		//=============================================================//
+		struct hex_table {
+			int8_t	tbl_[256];
+			hex_table() {
+				for(int i = 0; i < 256; ++i) tbl_[i] = -1;
+				for(int i = 0; i < 10; ++i) tbl_['0' + i] = i;
+				for(int i = 0; i < 6; ++i) {
+					tbl_['A' + i] = 10 + i;
+					tbl_['a' + i] = 10 + i;
+				}
+			}
+		};
+
+		static const int8_t* hex_() {
+			static hex_table t;
+			return t.tbl_;
+		}
+
+
+		static void illegal_char_(char ch) {
+			std::cerr << "S format illegual character: '";
+			if(ch >= 0x20 && ch <= 0x7f) {
+				std::cerr << ch;
 			} else {
-				array_t& t = it->second;
-				t.set(address, val);
+				std::cerr << boost::format("0x%02X") % static_cast<int>(static_cast<uint8_t>(ch));
 			}
+			std::cerr << "'" << std::endl;
 		}
 
 
-		bool load_(utils::file_io& fio) {
-			area_.min_ = 0xffffffff;
-			area_.max_ = 0x00000000;
+		static uint32_t address_length_(uint32_t type) {
+			static const uint8_t tbl[10] = { 2, 2, 3, 4, 0, 2, 0, 4, 3, 2 };
+			if(type >= 10) return 0;
+			return tbl[type];
+		}
+
+
+		//-------------------------------------------------------------//
+		// １レコード（「S」の次の文字から行末まで）の解析
+		//-------------------------------------------------------------//
+		bool record_(const char*& p, const char* end, bool& toend) {
+			const int8_t* hex = hex_();
+
+			if(p >= end || hex[static_cast<uint8_t>(*p)] < 0) {
+				illegal_char_(p < end ? *p : ' ');
+				return false;
+			}
+			uint32_t type = hex[static_cast<uint8_t>(*p++)];
+			uint32_t alen = address_length_(type);
+			if(alen == 0) {
+				std::cerr << boost::format("S format illegual type: S%d") % type << std::endl;
+				return false;
+			}
+
+			// 16 進数ペアを、まとめてバイト列へ変換
+			uint8_t rec[1 + 255];
+			uint32_t n = 0;
+			while(p < end && *p != 0x0d && *p != 0x0a) {
+				if(*p == ' ') {
+					++p;
+					continue;
+				}
+				if((end - p) < 2) {
+					illegal_char_(*p);
+					return false;
+				}
+				int hi = hex[static_cast<uint8_t>(p[0])];
+				int lo = hex[static_cast<uint8_t>(p[1])];
+				if((hi | lo) < 0) {
+					illegal_char_(hi < 0 ? p[0] : p[1]);
+					return false;
+				}
+				if(n >= sizeof(rec)) {
+					std::cerr << "S format record too long" << std::endl;
+					return false;
+				}
+				rec[n++] = (hi << 4) | lo;
+				p += 2;
+			}
+
+			if(n < 1 || n != (static_cast<uint32_t>(rec[0]) + 1) || rec[0] < (alen + 1)) {
+				std::cerr << boost::format("S format length error: S%d") % type << std::endl;
+				return false;
+			}
 
-			uint32_t value = 0;
-			uint32_t type = 0;
-			uint32_t length = 0;
-			uint32_t address = 0;
 			uint32_t sum = 0;
-			int vcnt = 0;
+			for(uint32_t i = 0; i < (n - 1); ++i) {
+				sum += rec[i];
+			}
+			sum ^= 0xff;
+			sum &= 0xff;
+			if(sum != rec[n - 1]) {	// SUM エラー
+				std::cerr << "S format SUM error: ";
+				std::cerr << boost::format("0x%02X -> %02X")
+					% static_cast<int>(rec[n - 1])
+					% static_cast<int>(sum)
+					<< std::endl;
+				return false;
+			}
+
+			uint32_t address = 0;
+			for(uint32_t i = 0; i < alen; ++i) {
+				address <<= 8;
+				address |= rec[1 + i];
+			}
+			uint32_t len = rec[0] - alen - 1;
 
+			if(type >= 1 && type <= 3) {
+				if(area_.min_ > address) area_.min_ = address;
+				if(len > 0) {
+					store_.write(address, &rec[1 + alen], len);
+					if(area_.max_ < (address + len - 1)) area_.max_ = address + len - 1;
+				}
+			} else if(type >= 7 && type <= 9) {
+				exec_ = address;
+				toend = true;
+			}
+			return true;
+		}
+
+
+		bool load_motsx_(const char* p, const char* end) {
 			bool toend = false;
-			int mode = 0;
+			while(p < end) {
+				char ch = *p++;
+				if(ch == ' ') {
+				} else if(ch == 0x0d || ch == 0x0a) {
+					if(toend) break;
+				} else if(ch == 'S') {
+					if(!record_(p, end, toend)) {
+						return false;
+					}
+				} else {
+					illegal_char_(ch);
+					return false;
+				}
+			}
+			return true;
+		}
+
 
-			while(1) {
-				char ch;
-				if(!fio.get_char(ch)) {
+		//-------------------------------------------------------------//
+		// インテル HEX フォーマット
+		//-------------------------------------------------------------//
+		bool load_ihex_(const char* p, const char* end) {
+			const int8_t* hex = hex_();
+			uint32_t base = 0;
+			while(p < end) {
+				char ch = *p++;
+				if(ch == ' ' || ch == 0x0d || ch == 0x0a) continue;
+				if(ch != ':') {
+					std::cerr << "Intel HEX illegual character: '" << ch << "'" << std::endl;
+					return false;
+				}
+				uint8_t rec[5 + 255 + 1];
+				uint32_t n = 0;
+				while(p < end && *p != 0x0d && *p != 0x0a) {
+					if((end - p) < 2 || n >= sizeof(rec)) {
+						std::cerr << "Intel HEX record error" << std::endl;
+						return false;
+					}
+					int hi = hex[static_cast<uint8_t>(p[0])];
+					int lo = hex[static_cast<uint8_t>(p[1])];
+					if((hi | lo) < 0) {
+						std::cerr << "Intel HEX illegual character: '" << (hi < 0 ? p[0] : p[1]) << "'" << std::endl;
+						return false;
+					}
+					rec[n++] = (hi << 4) | lo;
+					p += 2;
+				}
+				if(n < 5 || n != (static_cast<uint32_t>(rec[0]) + 5)) {
+					std::cerr << "Intel HEX length error" << std::endl;
+					return false;
+				}
+				uint8_t sum = 0;
+				for(uint32_t i = 0; i < n; ++i) sum += rec[i];
+				if(sum != 0) {
+					std::cerr << boost::format("Intel HEX SUM error: 0x%02X") % static_cast<int>(rec[n - 1])
+						<< std::endl;
+					return false;
+				}
+				uint32_t len = rec[0];
+				uint32_t ofs = (static_cast<uint32_t>(rec[1]) << 8) | rec[2];
+				const uint8_t* dat = &rec[4];
+				switch(rec[3]) {
+				case 0x00:  // データ
+					if(len > 0) {
+						uint32_t adr = base + ofs;
+						store_.write(adr, dat, len);
+						if(area_.min_ > adr) area_.min_ = adr;
+						if(area_.max_ < (adr + len - 1)) area_.max_ = adr + len - 1;
+					}
+					break;
+				case 0x01:  // 終端
+					return true;
+				case 0x02:  // 拡張セグメント・アドレス
+					if(len != 2) return false;
+					base = ((static_cast<uint32_t>(dat[0]) << 8) | dat[1]) << 4;
 					break;
+				case 0x03:  // 開始セグメント・アドレス
+					if(len != 4) return false;
+					exec_ = (((static_cast<uint32_t>(dat[0]) << 8) | dat[1]) << 4)
+						+ ((static_cast<uint32_t>(dat[2]) << 8) | dat[3]);
+					break;
+				case 0x04:  // 拡張リニア・アドレス
+					if(len != 2) return false;
+					base = ((static_cast<uint32_t>(dat[0]) << 8) | dat[1]) << 16;
+					break;
+				case 0x05:  // 開始リニア・アドレス
+					if(len != 4) return false;
+					exec_ = (static_cast<uint32_t>(dat[0]) << 24) | (static_cast<uint32_t>(dat[1]) << 16)
+						| (static_cast<uint32_t>(dat[2]) << 8) | dat[3];
+					break;
+				default:
+					std::cerr << boost::format("Intel HEX illegual type: %02X") % static_cast<int>(rec[3])
+						<< std::endl;
+					return false;
+				}
+			}
+			return true;
+		}
+
+
+		//-------------------------------------------------------------//
+		// ELF32（PT_LOAD セグメントを、物理アドレスへ配置）
+		//-------------------------------------------------------------//
+		static uint32_t elf_get16_(const uint8_t* p, bool big) {
+			if(big) return (static_cast<uint32_t>(p[0]) << 8) | p[1];
+			else return (static_cast<uint32_t>(p[1]) << 8) | p[0];
+		}
+
+
+		static uint32_t elf_get32_(const uint8_t* p, bool big) {
+			if(big) return (elf_get16_(p, true) << 16) | elf_get16_(p + 2, true);
+			else return (elf_get16_(p + 2, false) << 16) | elf_get16_(p, false);
+		}
+
+
+		bool load_elf_(const uint8_t* top, size_t size) {
+			if(size < 52 || top[4] != 1) {  // EI_CLASS: ELFCLASS32
+				std::cerr << "ELF format error: not ELF32" << std::endl;
+				return false;
+			}
+			bool big = top[5] == 2;  // EI_DATA: ELFDATA2MSB
+			exec_ = elf_get32_(&top[24], big);
+			uint32_t phoff = elf_get32_(&top[28], big);
+			uint32_t phentsize = elf_get16_(&top[42], big);
+			uint32_t phnum = elf_get16_(&top[44], big);
+			if(phnum == 0 || phentsize < 32 || phoff > size || (size - phoff) < (phentsize * phnum)) {
+				std::cerr << "ELF format error: program header" << std::endl;
+				return false;
+			}
+			for(uint32_t i = 0; i < phnum; ++i) {
+				const uint8_t* ph = &top[phoff + i * phentsize];
+				if(elf_get32_(&ph[0], big) != 1) continue;  // PT_LOAD
+				uint32_t offset = elf_get32_(&ph[4], big);
+				uint32_t paddr = elf_get32_(&ph[12], big);
+				uint32_t filesz = elf_get32_(&ph[16], big);
+				if(filesz == 0) continue;
+				if(offset > size || (size - offset) < filesz) {
+					std::cerr << boost::format("ELF format error: segment %d out of file") % i << std::endl;
+					return false;
 				}
+				store_.write(paddr, &top[offset], filesz);
+				if(area_.min_ > paddr) area_.min_ = paddr;
+				if(area_.max_ < (paddr + filesz - 1)) area_.max_ = paddr + filesz - 1;
+			}
+			return true;
+		}
+
+
+		//-------------------------------------------------------------//
+		// バイナリ
+		//-------------------------------------------------------------//
+		bool load_binary_(const uint8_t* top, size_t size, uint32_t base) {
+			if(size == 0) return true;
+			if(size > (0xffffffffULL - base + 1)) {
+				std::cerr << boost::format("Binary image over the address space: %08X (%d bytes)")
+					% base % size << std::endl;
+				return false;
+			}
+			store_.write(base, top, size);
+			area_.min_ = base;
+			area_.max_ = base + size - 1;
+			return true;
+		}
 
-			   	if(ch == ' ') {
-			   	} else if(ch == 0x0d || ch == 0x0a) {
-				   	if(toend) break;
-			   	} else if(mode == 0 && ch == 'S') {
-			   		mode = 1;
-			   		value = vcnt = 0;
-			   	} else if(ch >= '0' && ch <= '9') {
-			   		value <<= 4;
-			   		value |= ch - '0';
-			   		++vcnt;
-			   	} else if(ch >= 'A' && ch <= 'F') {
-			   		value <<= 4;
-			   		value |= ch - 'A' + 10;
-			   		++vcnt;
-			   	} else {
-					std::cerr << "S format illegual character: '";
-			   		if(ch >= 0x20 && ch <= 0x7f) {
-						std::cerr << ch;
-			   		} else {
-						std::cerr << boost::format("0x%02X") % static_cast<int>(ch);
-			   		}
-					std::cerr << "'" << std::endl;
-			   		return false;
-			   	}
-
-			   	if(mode == 1) {		// タイプ取得
-			   		if(vcnt == 1) {
-			   			type = value;
-			   			mode = 2;
-			   			value = vcnt = 0;
-			   		}
-			   	} else if(mode == 2) {	// レングス取得
-			   		if(vcnt == 2) {
-			   			length = value;
-			   			sum = value;
-			   			mode = 3;
-			   			value = vcnt = 0;
-			   		}
-			   	} else if(mode == 3) {	// アドレス取得
-			   		int alen = 0;
-			   		if(type == 0) {
-			   			alen = 4;
-			   		} else if(type == 1) {
-			   			alen = 4;
-			   		} else if(type == 2) {
-			   			alen = 6;
-			   		} else if(type == 3) {
-			   			alen = 8;
-			   		} else if(type == 5) {
-			   			alen = 4;
-			   		} else if(type == 7) {
-			   			alen = 8;
-			   		} else if(type == 8) {
-			   			alen = 6;
-			   		} else if(type == 9) {
-			   			alen = 4;
-			   		} else {
-			   			return false;
-			   		}
-
-			   		if(vcnt == alen) {
-			   			address = value;
-			   			if(type >= 1 && type <= 3) {
-			   				if(area_.min_ > address) area_.min_ = address;
-			   			}
-			   			alen >>= 1;
-			   			length -= alen;
-			   			length -= 1;	// SUM の分サイズを引く
-			   			while(alen > 0) {
-			   				sum += value;
-			   				value >>= 8;
-			   				--alen;
-			   			}
-				   		if(type >= 1 && type <= 3) {
-				   			mode = 4;
-				   		} else if(type >= 7 && type <= 9) {
-							exec_ = value;
-				   			mode = 5;
-				   		} else {
-				   			mode = 4;
-				   		}
-				   		value = vcnt = 0;
-				   	}
-			   	} else if(mode == 4) {	// データ・レコード
-			   		if(vcnt >= 2) {
-			   			if(type >= 1 && type <= 3) {
-			   				write_byte_(address, value);
-			   				if(area_.max_ < address) area_.max_ = address;
-			   				++address;
-			   			}
-			   			sum += value;
-			   			value = vcnt = 0;
-			   			--length;
-			   			if(length == 0) {
-			   				mode = 5;
-			   			}
-			   		}
-			   	} else if(mode == 5) {	// SUM
-			   		if(vcnt >= 2) {
-			   			value &= 0xff;
-			   			sum ^= 0xff;
-			   			sum &= 0xff;
-			   			if(sum != value) {	// SUM エラー
-							std::cerr << "S format SUM error: ";
-							std::cerr << boost::format("0x%02X -> %02X")
-							    % static_cast<int>(value)
-								% static_cast<int>(sum)
-								<< std::endl;
-			   				return false;
-			   			} else {
-			   				if(type >= 7 && type <= 9) {
-			   					toend = true;
-			   				}
-			   				mode = 0;
-			   				value = vcnt = 0;
-			   			}
-			   		}
-			   	}
-		   	}
-		   	return true;
+
+		static bool is_ext_(const std::string& path, const char* ext) {
+			auto pos = path.rfind('.');
+			if(pos == std::string::npos) return false;
+			std::string e = path.substr(pos + 1);
+			for(auto& ch : e) {
+				if(ch >= 'A' && ch <= 'Z') ch += 'a' - 'A';
+			}
+			return e == ext;
 		}
 
 
-		bool save_(utils::file_io& fio, const memory_map::value_type& m) {
-			const array_t& a = m.second;
+		bool save_(utils::file_io& fio, const array_t& a) {
 			fio.put_char('S');
 
 			uint8_t sum = 0;
@@ -254,33 +394,101 @@ namespace utils {
 			@brief	コンストラクター
 		*/
 		//-----------------------------------------------------------------//
-		motsx_io() : area_(), exec_(0x000000) {
+		motsx_io() : area_(), exec_(0x000000), format_(format::MOTSX) {
 			fill_array_.fill(0xff);
 		}
 
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief	ロード
+			@brief	ロード @n
+					ファイルの先頭で形式を判別する（ELF、「:」インテル HEX、@n
+					「S」モトローラー）、拡張子が「.bin」ならバイナリとし、@n
+					最後のバイトが 0xFFFFFFFF になるように配置する。
 			@param[in]	path	ファイルパス
 			@return エラー無しなら「true」
 		*/
 		//-----------------------------------------------------------------//
 		bool load(const std::string& path) {
-			utils::file_io fio;
-			if(!fio.open(path, "rb")) {
+			utils::map_file mf;
+			if(!mf.open(path)) {
 				return false;
 			}
 
-			memory_map_.clear();
+			store_.clear();
+			exec_ = 0;
+			area_.min_ = 0xffffffff;
+			area_.max_ = 0x00000000;
 
-			if(!load_(fio)) {
+			const uint8_t* top = mf.get();
+			size_t size = mf.size();
+			if(is_ext_(path, "bin")) {
+				format_ = format::BINARY;
+				return load_binary_(top, size, 0 - static_cast<uint32_t>(size));
+			}
+			const char* p = reinterpret_cast<const char*>(top);
+			if(size >= 4 && top[0] == 0x7f && top[1] == 'E' && top[2] == 'L' && top[3] == 'F') {
+				format_ = format::ELF;
+				return load_elf_(top, size);
+			}
+			size_t i = 0;
+			while(i < size && (p[i] == ' ' || p[i] == 0x0d || p[i] == 0x0a)) ++i;
+			if(i < size && p[i] == ':') {
+				format_ = format::IHEX;
+				return load_ihex_(p, p + size);
+			}
+			format_ = format::MOTSX;
+			return load_motsx_(p, p + size);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	バイナリ・ロード
+			@param[in]	path	ファイルパス
+			@param[in]	base	配置アドレス
+			@return エラー無しなら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool load_binary(const std::string& path, uint32_t base) {
+			utils::map_file mf;
+			if(!mf.open(path)) {
 				return false;
 			}
 
-			fio.close();
+			store_.clear();
+			exec_ = 0;
+			area_.min_ = 0xffffffff;
+			area_.max_ = 0x00000000;
+			format_ = format::BINARY;
 
-			return true;
+			return load_binary_(mf.get(), mf.size(), base);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ロードした形式の取得
+			@return 形式
+		*/
+		//-----------------------------------------------------------------//
+		format get_format() const { return format_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	形式名の取得
+			@return 形式名
+		*/
+		//-----------------------------------------------------------------//
+		const char* get_format_name() const {
+			switch(format_) {
+			case format::IHEX:   return "Intel HEX";
+			case format::ELF:    return "ELF32";
+			case format::BINARY: return "Binary";
+			default: break;
+			}
+			return "Motolola Sx";
 		}
 
 
@@ -292,17 +500,19 @@ namespace utils {
 		*/
 		//-----------------------------------------------------------------//
 		bool save(const std::string& path) {
-			if(memory_map_.empty()) return false;
+			if(store_.empty()) return false;
 
 			utils::file_io fio;
 			if(!fio.open(path, "wb")) {
 				return false;
 			}
 
-			for(const auto& m : memory_map_) {
-				if(!save_(fio, m)) {
-					return false;
-				}
+			bool ok = true;
+			store_.for_each([&](uint32_t org, const array_t& a) {
+				if(ok && !save_(fio, a)) ok = false;
+			});
+			if(!ok) {
+				return false;
 			}
 
 			fio.close();
@@ -320,9 +530,7 @@ namespace utils {
 		*/
 		//-----------------------------------------------------------------//
 		void write(uint32_t address, const uint8_t* data, uint32_t len) {
-			for(uint32_t i = 0; i < len; ++i) {
-				write_byte_(address + i, data[i]);
-			}
+			store_.write(address, data, len);
 		}
 
 
@@ -333,7 +541,7 @@ namespace utils {
 		*/
 		//-----------------------------------------------------------------//
 		uint32_t get_total_page() const {
-			return memory_map_.size();
+			return store_.size();
 		}
 
 
@@ -345,17 +553,13 @@ namespace utils {
 		//-----------------------------------------------------------------//
 		areas create_area_map() const {
 			areas as;
-			for(const auto& m : memory_map_) {
-				if(as.empty()) {
-					as.emplace_back(m.second.area_);
+			store_.for_each([&](uint32_t org, const array_t& a) {
+				if(!as.empty() && (as.back().max_ + 1) == a.area_.min_) {
+					as.back().max_ = a.area_.max_;
 				} else {
-					if((as.back().max_ + 1) == m.second.area_.min_) {
-						as.back().max_ = m.second.area_.max_;
-					} else {
-						as.emplace_back(m.second.area_);
-					}
+					as.emplace_back(a.area_);
 				}
-			}
+			});
 			return as;
 		}
 
@@ -367,7 +571,7 @@ namespace utils {
 		*/
 		//-----------------------------------------------------------------//
 		void list_area_map(const std::string& head) const {
-			std::cout << head << boost::format("Motolola Sx format load map: (exec: 0x%08X)") % exec_;
+			std::cout << head << boost::format("%s format load map: (exec: 0x%08X)") % get_format_name() % exec_;
 			std::cout << std::endl;
 
 			auto as = create_area_map();
@@ -408,7 +612,7 @@ namespace utils {
 		*/
 		//-----------------------------------------------------------------//
 		bool find_page(uint32_t address) const {
-			return memory_map_.find(address & 0xffff00) != memory_map_.end();
+			return store_.find(address) != nullptr;
 		}
 
 
@@ -421,11 +625,11 @@ namespace utils {
 		*/
 		//-----------------------------------------------------------------//
 		const array& get_memory(uint32_t address) const {
-			memory_map::const_iterator cit = memory_map_.find(address & 0xffff00);
-			if(cit == memory_map_.end()) {
+			auto p = store_.find(address);
+			if(p == nullptr) {
 				return fill_array_;
 			}
-			return cit->second.array_;
+			return p->array_;
 		}
 	};
 }
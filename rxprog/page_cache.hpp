@@ -0,0 +1,200 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	ページ・ハッシュ・キャッシュ・クラス @n
+			最後に書き込んだイメージの、ページ毎ハッシュをホスト側に保存し、@n
+			差分書き込み時のリードバックを省略する。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <map>
+#include <string>
+#include <cstdlib>
+#include "file_io.hpp"
+#include "string_utils.hpp"
+#include <boost/format.hpp>
+
+namespace utils {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief	page_cache クラス
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	class page_cache {
+
+		typedef std::map<uint32_t, uint64_t> hash_map;
+		hash_map	hash_map_;
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ページ・ハッシュの計算（FNV-1a 64 bits）
+			@param[in]	src	ページ・データ
+			@param[in]	len	長さ
+			@return ハッシュ
+		*/
+		//-----------------------------------------------------------------//
+		static uint64_t hash(const uint8_t* src, uint32_t len = 256) {
+			uint64_t h = 0xcbf29ce484222325ULL;
+			for(uint32_t i = 0; i < len; ++i) {
+				h ^= src[i];
+				h *= 0x100000001b3ULL;
+			}
+			return h;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	キャッシュ・ディレクトリーのパス @n
+					「$HOME/.rx_prog」（HOME が無い場合は「./.rx_prog」）
+			@return キャッシュ・ディレクトリー・パス
+		*/
+		//-----------------------------------------------------------------//
+		static std::string cache_dir() {
+			std::string base;
+			const char* home = getenv("HOME");
+			if(home != nullptr) base = home;
+			else base = ".";
+			return base + "/.rx_prog";
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	キャッシュ・ファイルのパスを生成 @n
+					「$HOME/.rx_prog/」以下に、デバイス識別とポート毎に作成 @n
+					ディレクトリーを作れない場合は、空を返す（キャッシュ無しで、@n
+					差分書き込みは全ページをリードバックする）
+			@param[in]	id		デバイス識別文字列
+			@param[in]	port	シリアル・ポート・パス
+			@return キャッシュ・ファイル・パス
+		*/
+		//-----------------------------------------------------------------//
+		static std::string make_path(const std::string& id, const std::string& port) {
+			auto base = cache_dir();
+			if(!utils::probe_file(base, true)) {
+				if(!utils::create_directories(base)) return std::string();
+			}
+			std::string name = id + '_' + port;
+			for(auto& ch : name) {
+				if(ch == '/' || ch == '\\' || ch == ':' || ch == ' ') ch = '_';
+			}
+			return base + '/' + name + ".hash";
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	コンストラクター
+		*/
+		//-----------------------------------------------------------------//
+		page_cache() { }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	クリア
+		*/
+		//-----------------------------------------------------------------//
+		void clear() { hash_map_.clear(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	登録数を取得
+			@return 登録数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t size() const { return hash_map_.size(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ページ・ハッシュを登録
+			@param[in]	adr	ページ・アドレス
+			@param[in]	h	ハッシュ
+		*/
+		//-----------------------------------------------------------------//
+		void set(uint32_t adr, uint64_t h) { hash_map_[adr & 0xffffff00] = h; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ページ・ハッシュの一致を検査
+			@param[in]	adr	ページ・アドレス
+			@param[in]	h	ハッシュ
+			@return 一致するなら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool find(uint32_t adr, uint64_t h) const {
+			auto it = hash_map_.find(adr & 0xffffff00);
+			if(it == hash_map_.end()) return false;
+			return it->second == h;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ロード
+			@param[in]	path	ファイル・パス
+			@return 成功なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool load(const std::string& path) {
+			hash_map_.clear();
+
+			utils::file_io fio;
+			if(!fio.open(path, "rb")) {
+				return false;
+			}
+			while(!fio.eof()) {
+				auto line = fio.get_line();
+				if(line.empty()) continue;
+				utils::strings ss = utils::split_text(line, " ");
+				if(ss.size() != 2) {
+					hash_map_.clear();
+					return false;
+				}
+				uint32_t adr;
+				if(!utils::string_to_hex(ss[0], adr)) {
+					hash_map_.clear();
+					return false;
+				}
+				char* end = nullptr;
+				uint64_t h = std::strtoull(ss[1].c_str(), &end, 16);
+				if(end == nullptr || *end != 0) {
+					hash_map_.clear();
+					return false;
+				}
+				hash_map_[adr] = h;
+			}
+			fio.close();
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	セーブ
+			@param[in]	path	ファイル・パス
+			@return 成功なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool save(const std::string& path) const {
+			utils::file_io fio;
+			if(!fio.open(path, "wb")) {
+				return false;
+			}
+			for(const auto& m : hash_map_) {
+				fio.put_line((boost::format("%08X %016X") % m.first % m.second).str());
+			}
+			fio.close();
+			return true;
+		}
+	};
+}
@@ -0,0 +1,184 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	ページ・ストア・クラス @n
+			２５６バイト単位のページを、３２ビット・アドレス空間に疎に配置する。@n
+			ページの検索は、２段のテーブルで O(1) で行う。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <deque>
+#include <array>
+#include <algorithm>
+
+namespace utils {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief	page_store クラス
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	class page_store {
+	public:
+		typedef std::array<uint8_t, 256> array;
+
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief	領域
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct area_t {
+			uint32_t	min_;
+			uint32_t	max_;
+			area_t(uint32_t min = 0xffffffff, uint32_t max = 0) : min_(min), max_(max) { }
+		};
+
+
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief	ページ（書き込まれた範囲と、データ）
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct page_t {
+			area_t	area_;
+			array	array_;
+
+			page_t() : area_(), array_() { array_.fill(0xff); }
+
+			void set(uint32_t adr, const uint8_t* src, uint32_t len) {
+				if(area_.min_ > adr) area_.min_ = adr;
+				if(area_.max_ < (adr + len - 1)) area_.max_ = adr + len - 1;
+				std::memcpy(&array_[adr & 0xff], src, len);
+			}
+		};
+
+	private:
+		typedef std::array<uint32_t, 256> table;
+
+		// 上位１６ビット -> tables_ のインデックス + 1、中位８ビット -> pages_ のインデックス + 1
+		std::vector<uint32_t>	top_;
+		std::vector<table>		tables_;
+		std::deque<page_t>		pages_;		///< 参照が移動しないように deque とする
+
+		uint32_t index_(uint32_t adr) const {
+			auto t = top_[adr >> 16];
+			if(t == 0) return 0;
+			return tables_[t - 1][(adr >> 8) & 0xff];
+		}
+
+		page_t& alloc_(uint32_t adr) {
+			auto& t = top_[adr >> 16];
+			if(t == 0) {
+				tables_.emplace_back();
+				tables_.back().fill(0);
+				t = tables_.size();
+			}
+			auto& i = tables_[t - 1][(adr >> 8) & 0xff];
+			if(i == 0) {
+				pages_.emplace_back();
+				i = pages_.size();
+			}
+			return pages_[i - 1];
+		}
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	コンストラクター
+		*/
+		//-----------------------------------------------------------------//
+		page_store() : top_(65536, 0) { }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	クリア
+		*/
+		//-----------------------------------------------------------------//
+		void clear() {
+			std::fill(top_.begin(), top_.end(), 0);
+			tables_.clear();
+			pages_.clear();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ページ数の取得
+			@return ページ数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t size() const { return pages_.size(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	空か検査
+			@return 空なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool empty() const { return pages_.empty(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	範囲の書き込み（ページ境界をまたいでも良い）
+			@param[in]	adr	開始アドレス
+			@param[in]	src	データ
+			@param[in]	len	長さ
+		*/
+		//-----------------------------------------------------------------//
+		void write(uint32_t adr, const uint8_t* src, uint32_t len) {
+			while(len > 0) {
+				uint32_t n = 256 - (adr & 0xff);
+				if(n > len) n = len;
+				alloc_(adr).set(adr, src, n);
+				src += n;
+				len -= n;
+				adr += n;
+				if(adr == 0) break;  // アドレス空間の終端
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ページを探す
+			@param[in]	adr	アドレス
+			@return ページ（無い場合「nullptr」）
+		*/
+		//-----------------------------------------------------------------//
+		const page_t* find(uint32_t adr) const {
+			auto i = index_(adr);
+			if(i == 0) return nullptr;
+			return &pages_[i - 1];
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	アドレス順に全ページを走査
+			@param[in]	func	関数（ページ先頭アドレス、ページ）
+		*/
+		//-----------------------------------------------------------------//
+		template <class FUNC>
+		void for_each(FUNC func) const {
+			for(uint32_t h = 0; h < top_.size(); ++h) {
+				auto t = top_[h];
+				if(t == 0) continue;
+				const auto& tbl = tables_[t - 1];
+				for(uint32_t m = 0; m < 256; ++m) {
+					auto i = tbl[m];
+					if(i == 0) continue;
+					func((h << 16) | (m << 8), pages_[i - 1]);
+				}
+			}
+		}
+	};
+}
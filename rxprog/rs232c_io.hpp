@@ -1,7 +1,9 @@
 #pragma once
 //=====================================================================//
 /*!	@file
-	@brief	RS232C 入出力クラス
+	@brief	RS232C 入出力クラス @n
+			受信はリング・バッファにまとめて読み込み（poll）、小さな受信要求は @n
+			バッファから返す。タイムアウトは、要求全体の期限として扱う。
     @author 平松邦仁 (hira@rvf-rc45.net)
 	@copyright	Copyright (C) 2016, 2017 Kunihito Hiramatsu @n
 				Released under the MIT license @n
@@ -15,11 +17,20 @@
 #include <unistd.h>
 #include <limits.h>
 #include <sys/ioctl.h>
+#include <poll.h>
+#ifdef __linux__
+#include <linux/serial.h>
+#endif
+#include <cerrno>
+#include <chrono>
 
 #include <string>
+#include <map>
+#include <vector>
 #include <iostream>
 #include <cstring>
 #include <cstdio>
+#include <boost/format.hpp>
 
 namespace utils {
 
@@ -64,16 +75,152 @@ namespace utils {
 			two		///< ２ビット
 		};
 
+
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief	往復遅延のヒストグラム @n
+					bucket_[n] は、2^n 〜 2^(n+1) - 1 [us] の回数（最後は、それ以上）
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct latency_t {
+			static const uint32_t bucket_num = 24;
+
+			uint32_t	bucket_[bucket_num] = { 0 };
+			uint32_t	count_ = 0;		///< 回数
+			uint32_t	min_ = 0;		///< 最小 [us]
+			uint32_t	max_ = 0;		///< 最大 [us]
+			uint64_t	sum_ = 0;		///< 合計 [us]
+
+			void add(uint32_t us) {
+				uint32_t n = 0;
+				while(n < (bucket_num - 1) && (us >> (n + 1)) != 0) ++n;
+				++bucket_[n];
+				if(count_ == 0 || min_ > us) min_ = us;
+				if(max_ < us) max_ = us;
+				sum_ += us;
+				++count_;
+			}
+
+			uint32_t mean() const { return count_ > 0 ? sum_ / count_ : 0; }
+		};
+
+		typedef std::map<uint8_t, latency_t> latency_map;
+
+
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief	統計（システムコール回数、転送バイト数、往復遅延）
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct stat_t {
+			uint32_t	read_ = 0;		///< read 回数
+			uint32_t	write_ = 0;		///< write 回数
+			uint32_t	poll_ = 0;		///< poll 回数
+			uint32_t	drain_ = 0;		///< tcdrain 回数
+			uint32_t	timeout_ = 0;	///< 受信タイムアウト回数
+			uint32_t	retry_ = 0;		///< プロトコルの再試行回数
+			uint32_t	round_ = 0;		///< 往復（送信から最初の応答まで）回数
+			uint64_t	recv_ = 0;		///< 受信バイト数
+			uint64_t	send_ = 0;		///< 送信バイト数
+			latency_map	latency_;		///< コマンド毎の往復遅延
+
+			void info(const std::string& head = "") const {
+				std::cout << head << boost::format("Serial syscall: read %d, write %d, poll %d, drain %d")
+					% read_ % write_ % poll_ % drain_ << std::endl;
+				std::cout << head << boost::format("Serial bytes: recv %d, send %d (timeout: %d, retry: %d)")
+					% recv_ % send_ % timeout_ % retry_ << std::endl;
+				for(const auto& t : latency_) {
+					const auto& l = t.second;
+					std::cout << head << boost::format("Latency %02X: %d times, min %d, mean %d, max %d [us]")
+						% static_cast<uint32_t>(t.first) % l.count_ % l.min_ % l.mean() % l.max_ << std::endl;
+				}
+			}
+		};
+
 	private:
+		typedef std::chrono::steady_clock clock;
+
+		static const uint32_t ring_size_ = 4096;	///< 受信リング・バッファ（２のべき乗）
+
 		int    fd_;
+		bool	modem_;		///< モデム制御線（RTS/DTR 等）の有無（擬似端末では無い）
 
 		termios		attr_back_;
 		termios		attr_;
 
+		std::vector<uint8_t>	ring_;	///< ヒープに置く（プロトコルは variant に値で入る為）
+		uint32_t	ring_get_;
+		uint32_t	ring_put_;
+
+		stat_t		stat_;
+
+		uint8_t				tag_;		///< 往復遅延を記録するコマンド
+		bool				round_;		///< 応答待ち
+		uint8_t				round_tag_;
+		clock::time_point	round_org_;
+
 		void close_() {
 			tcsetattr(fd_, TCSANOW, &attr_back_);
 			::close(fd_);
 			fd_ = -1;
+			ring_get_ = ring_put_ = 0;
+		}
+
+
+		uint32_t ring_len_() const { return ring_put_ - ring_get_; }
+
+
+		uint32_t ring_copy_(uint8_t* dst, uint32_t len) {
+			uint32_t n = ring_len_();
+			if(n > len) n = len;
+			for(uint32_t i = 0; i < n; ++i) {
+				dst[i] = ring_[(ring_get_ + i) & (ring_size_ - 1)];
+			}
+			ring_get_ += n;
+			return n;
+		}
+
+
+		// リングの空き（連続領域）に、読める分だけ読み込む
+		bool ring_fill_() {
+			uint32_t free = ring_size_ - ring_len_();
+			if(free == 0) return true;
+			uint32_t pos = ring_put_ & (ring_size_ - 1);
+			uint32_t n = ring_size_ - pos;
+			if(n > free) n = free;
+			++stat_.read_;
+			auto rl = ::read(fd_, &ring_[pos], n);
+			if(rl <= 0) return false;
+			ring_put_ += rl;
+			stat_.recv_ += rl;
+			if(round_) {
+				round_ = false;
+				++stat_.round_;
+				auto us = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - round_org_);
+				stat_.latency_[round_tag_].add(us.count());
+			}
+			return true;
+		}
+
+
+		// 期限まで、受信を待つ
+		bool wait_(short events, const clock::time_point& limit) {
+			while(1) {
+				auto now = clock::now();
+				int ms = 0;
+				if(limit > now) {
+					ms = std::chrono::duration_cast<std::chrono::milliseconds>(limit - now).count() + 1;
+				}
+				pollfd pfd;
+				pfd.fd = fd_;
+				pfd.events = events;
+				pfd.revents = 0;
+				++stat_.poll_;
+				int ret = poll(&pfd, 1, ms);
+				if(ret > 0) return true;
+				if(ret == 0) return false;
+				if(errno != EINTR) return false;
+			}
 		}
 
 	public:
@@ -82,7 +229,8 @@ namespace utils {
 			@brief	コンストラクター
 		*/
 		//-----------------------------------------------------------------//
-		rs232c_io() : fd_(-1) { }
+		rs232c_io() : fd_(-1), modem_(true), attr_back_(), attr_(), ring_(ring_size_), ring_get_(0), ring_put_(0),
+			tag_(0), round_(false), round_tag_(0) { }
 
 
 		//-----------------------------------------------------------------//
@@ -146,6 +294,10 @@ namespace utils {
 			if(fd_ < 0) {
 				return false;
 			}
+			ring_get_ = ring_put_ = 0;
+			stat_ = stat_t();
+			tag_ = 0;
+			round_ = false;
 
 			if(tcgetattr(fd_, &attr_back_) == -1) {
 				::close(fd_);
@@ -174,10 +326,15 @@ namespace utils {
 				return false;
 			}
 
+			modem_ = true;
 			int status;
 			if(ioctl(fd_, TIOCMGET, &status) == -1) {
-				close_();
-				return false;
+				if(errno == ENOTTY || errno == EINVAL) {  // 擬似端末（pty）
+					modem_ = false;
+				} else {
+					close_();
+					return false;
+				}
 			}
 
 			return true;
@@ -216,6 +373,11 @@ namespace utils {
 		bool close() {
 			if(fd_ < 0) return false;
 
+			if(!modem_) {
+				close_();
+				return true;
+			}
+
 			int status;
 			if(ioctl(fd_, TIOCMGET, &status) == -1) {
 				close_();
@@ -236,15 +398,40 @@ namespace utils {
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	低レイテンシー設定（Linux の ASYNC_LOW_LATENCY） @n
+					USB シリアル変換器の受信バッファリング時間を最小にする
+			@param[in]	ena	有効にする場合「true」
+			@return 設定出来たら「true」（未対応のデバイスでは「false」）
+		*/
+		//-----------------------------------------------------------------//
+		bool set_low_latency(bool ena = true) {
+			if(fd_ < 0) return false;
+#ifdef __linux__
+			serial_struct ser;
+			if(ioctl(fd_, TIOCGSERIAL, &ser) == -1) {
+				return false;
+			}
+			if(ena) ser.flags |= ASYNC_LOW_LATENCY;
+			else ser.flags &= ~ASYNC_LOW_LATENCY;
+			return ioctl(fd_, TIOCSSERIAL, &ser) != -1;
+#else
+			return false;
+#endif
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	送信同期
 			@return 正常なら「true」
 		*/
 		//-----------------------------------------------------------------//
-		bool sync_send() const {
+		bool sync_send() {
 			if(fd_ < 0) return false;
 
+			++stat_.drain_;
 			tcdrain(fd_);
 			return true;
 		}
@@ -252,7 +439,34 @@ namespace utils {
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief	受信
+			@brief	統計の取得
+			@return 統計
+		*/
+		//-----------------------------------------------------------------//
+		const stat_t& get_stat() const { return stat_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	往復遅延を記録するコマンドの設定 @n
+					以降の送信から最初の受信までの時間を、このコマンドで集計する
+			@param[in]	tag	コマンド
+		*/
+		//-----------------------------------------------------------------//
+		void set_tag(uint8_t tag) { tag_ = tag; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	再試行の記録（プロトコル層から呼ぶ）
+		*/
+		//-----------------------------------------------------------------//
+		void retry() { ++stat_.retry_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	受信（受信済みの分だけ）
 			@param[out]	dst	受信データ転送先
 			@param[in]	len	受信最大長さ
 			@return 受信した長さ
@@ -261,7 +475,11 @@ namespace utils {
 		size_t recv(void* dst, size_t len) {
 			if(fd_ < 0) return 0;
 
-			return ::read(fd_, dst, len);
+			uint8_t* p = static_cast<uint8_t*>(dst);
+			if(ring_len_() == 0) {
+				ring_fill_();
+			}
+			return ring_copy_(p, len);
 		}
 
 
@@ -270,29 +488,26 @@ namespace utils {
 			@brief	受信
 			@param[out]	dst	受信データ転送先
 			@param[in]	len	受信最大長さ
-			@param[in]	tv	タイムアウト指定
+			@param[in]	tv	タイムアウト指定（要求全体の期限）
 			@return 受信した長さ
 		*/
 		//-----------------------------------------------------------------//
 		size_t recv(void* dst, size_t len, const timeval& tv) {
 			if(fd_ < 0) return 0;
 
+			auto limit = clock::now() + std::chrono::seconds(tv.tv_sec)
+				+ std::chrono::microseconds(tv.tv_usec);
 			size_t total = 0;
 			uint8_t* p = static_cast<uint8_t*>(dst);
-			while(total < len) {
-				fd_set fds;
-				FD_ZERO(&fds);
-				FD_SET(fd_, &fds);
-				timeval t;
-				t = tv;
-				int ret = select(fd_ + 1, &fds, NULL, NULL, &t);
-				if(ret == -1) {  // for error..
+			while(1) {
+				total += ring_copy_(p + total, len - total);
+				if(total >= len) break;
+				if(!wait_(POLLIN, limit)) {
+					++stat_.timeout_;
+					round_ = false;
 					break;
-				} else if(ret > 0) {
-					size_t rl = ::read(fd_, p, len - total);
-					total += rl;
-					p += rl;
-				} else {
+				}
+				if(!ring_fill_()) {
 					break;
 				}
 			}
@@ -327,7 +542,28 @@ namespace utils {
 		size_t send(const void* src, size_t len) {
 			if(fd_ < 0) return 0;
 
-			return ::write(fd_, src, len);
+			// 全てを書き終えるまで繰り返す（ノンブロッキングの為）
+			auto limit = clock::now() + std::chrono::seconds(5);
+			if(!round_) {
+				round_ = true;
+				round_tag_ = tag_;
+				round_org_ = clock::now();
+			}
+			const uint8_t* p = static_cast<const uint8_t*>(src);
+			size_t total = 0;
+			while(total < len) {
+				++stat_.write_;
+				auto wl = ::write(fd_, p + total, len - total);
+				if(wl > 0) {
+					total += wl;
+					stat_.send_ += wl;
+				} else if(wl < 0 && (errno == EAGAIN || errno == EINTR)) {
+					if(!wait_(POLLOUT, limit)) break;
+				} else {
+					break;
+				}
+			}
+			return total;
 		}
 
 
@@ -355,6 +591,7 @@ namespace utils {
 		//-----------------------------------------------------------------//
 		bool flush()
 		{
+			ring_get_ = ring_put_ = 0;
 			return tcflush(fd_, TCIOFLUSH) == 0;
 		}
 
@@ -444,6 +681,7 @@ namespace utils {
 		//-----------------------------------------------------------------//
 		bool enable_DTR(bool ena = true) {
 			if(fd_ < 0) return false;
+			if(!modem_) return true;
 
 			int status;
 			if(ioctl(fd_, TIOCMGET, &status) == -1) {
@@ -470,6 +708,7 @@ namespace utils {
 		//-----------------------------------------------------------------//
 		bool enable_RTS(bool ena = true) {
 			if(fd_ < 0) return false;
+			if(!modem_) return true;
 
 			int status;
 			if(ioctl(fd_, TIOCMGET, &status) == -1) {
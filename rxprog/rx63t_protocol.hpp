@@ -22,6 +22,7 @@ namespace rx63t {
 	class protocol {
 
 		utils::rs232c_io	rs232c_;
+		std::string			path_;
 
 		bool				verbose_ = false;
 
@@ -48,9 +49,8 @@ namespace rx63t {
 		uint8_t						last_error_ = 0;
 
 		bool command_(uint8_t cmd) {
-			bool f = rs232c_.send(static_cast<char>(cmd));
-			rs232c_.sync_send();
-			return f;
+			rs232c_.set_tag(cmd);
+			return rs232c_.send(static_cast<char>(cmd));
 		}
 
 		bool read_(void* buff, uint32_t len, const timeval& tv) {
@@ -65,12 +65,11 @@ namespace rx63t {
 		}
 
 		bool write_(const void* buff, uint32_t len) {
-			uint32_t wr = rs232c_.send(buff, len);
-			rs232c_.sync_send();
-			return wr == len;
+			if(len > 0) rs232c_.set_tag(static_cast<const uint8_t*>(buff)[0]);
+			return rs232c_.send(buff, len) == len;
 		} 
 
-		uint32_t get32_(const uint8_t* p) {
+		static uint32_t get32_(const uint8_t* p) {
 			uint32_t v;
 			v = p[0];
 			v |= p[1] << 8;
@@ -79,14 +78,14 @@ namespace rx63t {
 			return v;
 		}
 
-		uint32_t get16_big_(const uint8_t* p) {
+		static uint32_t get16_big_(const uint8_t* p) {
 			uint32_t v;
 			v = p[1];
 			v |= p[0] << 8;
 			return v;
 		}
 
-		uint32_t get32_big_(const uint8_t* p) {
+		static uint32_t get32_big_(const uint8_t* p) {
 			uint32_t v;
 			v = p[3];
 			v |= p[2] << 8;
@@ -95,19 +94,19 @@ namespace rx63t {
 			return v;
 		}
 
-		void put16_big_(uint8_t* p, uint32_t val) {
+		static void put16_big_(uint8_t* p, uint32_t val) {
 			p[0] = (val >> 8) & 0xff;
 			p[1] = val & 0xff;
 		}
 
-		void put32_big_(uint8_t* p, uint32_t val) {
+		static void put32_big_(uint8_t* p, uint32_t val) {
 			p[0] = (val >> 24) & 0xff;
 			p[1] = (val >> 16) & 0xff;
 			p[2] = (val >> 8) & 0xff;
 			p[3] =  val & 0xff;
 		}
 
-		uint8_t sum_(const uint8_t* buff, uint32_t len) {
+		static uint8_t sum_(const uint8_t* buff, uint32_t len) {
 			uint16_t sum = 0;
 			for(uint32_t i = 0; i < len; ++i) {
 				sum += *buff++;
@@ -119,6 +118,89 @@ namespace rx63t {
 			return (boost::format("#%02d/%02d: ") % n % num).str();
 		}
 
+		bool response_write_() {
+			timeval tv;
+			tv.tv_sec  = 10;
+			tv.tv_usec = 0;
+			uint8_t head[1];
+			if(!read_(head, 1, tv)) {
+				select_write_area_ = false;
+				return false;
+			}
+			if(head[0] != 0x06) {
+				std::cout << "Respons error" << std::endl;
+				select_write_area_ = false;
+				if(head[0] != 0xd0) {
+					return false;
+				}
+				if(!read_(head, 1, tv)) {
+					return false;
+				}
+				last_error_ = head[0];
+///				std::cout << boost::format("Write error code: %02X") % static_cast<uint32_t>(head[0]) << std::endl;
+				return false;
+			}
+
+			return true;
+		}
+
+
+		// 問い合わせを数回往復させて、通信速度を確認する
+		bool check_speed_() {
+			for(int i = 0; i < 3; ++i) {
+				if(!inquiry_data()) return false;
+			}
+			return true;
+		}
+
+		// 接続時の速度（9600）に戻す
+		bool restore_speed_() {
+			baud_speed_ = 9600;
+			baud_rate_ = B9600;
+			usleep(25000);	// 25[ms]
+			if(!rs232c_.change_speed(baud_rate_)) {
+				return false;
+			}
+			rs232c_.flush();
+			return check_speed_();
+		}
+
+		// 変更後の速度のまま応答が無い場合、デバイスのリセットを促して、接続からやり直す
+		bool resync_() {
+			connection_ = false;
+			baud_speed_ = 9600;
+			baud_rate_ = B9600;
+			if(!rs232c_.change_speed(baud_rate_)) {
+				return false;
+			}
+			std::cerr << "Lost sync, reset the device (boot mode): '" << path_ << "'" << std::endl;
+			for(int i = 0; i < 100; ++i) {  // 約３０秒
+				rs232c_.flush();
+				if(!connection()) continue;
+				if(devices_.empty() || !select_device(devices_[0].code_)) break;
+				if(clock_modes_.empty() || !select_clock_mode(clock_modes_[0])) break;
+				return true;
+			}
+			connection_ = false;
+			return false;
+		}
+
+		// 速度の変更を試す（失敗したら、接続時の速度に戻す）
+		bool try_speed_(const rx::protocol::rx_t& rx, uint32_t speed) {
+			if(change_speed(rx, speed) && check_speed_()) {
+				return true;
+			}
+			if(verbose_) {
+				auto sect = out_section_(1, 1);
+				std::cout << sect << boost::format("Baud rate %d: fail") % speed << std::endl;
+			}
+			rs232c_.retry();
+			if(!restore_speed_()) {
+				resync_();
+			}
+			return false;
+		}
+
 	public:
 		//-----------------------------------------------------------------//
 		/*!
@@ -140,11 +222,17 @@ namespace rx63t {
 		bool bind(const std::string& path, uint32_t brate, const rx::protocol::rx_t& rx)
 		{
 			verbose_ = rx.verbose_;
+			path_ = path;
 
 			if(!start(path)) {
 				std::cerr << "Can't open path: '" << path << "'" << std::endl;
 				return false;
 			}
+			if(rx.low_latency_ && !rs232c_.set_low_latency()) {
+				if(verbose_) {
+					std::cout << "# Low latency mode not supported: '" << path << "'" << std::endl;
+				}
+			}
 
 			// コネクション
 			if(!connection()) {
@@ -231,13 +319,19 @@ namespace rx63t {
 
 			// ボーレート変更
 			{
-				if(!change_speed(rx, brate)) {
+				if(brate == 0) {
+					brate = change_speed_auto(rx);
+					if(brate == 0) {
+						std::cerr << "Can't find available speed." << std::endl;
+						return false;
+					}
+				} else if(!change_speed(rx, brate)) {
 					std::cerr << "Can't change speed." << std::endl;
 					return false;
 				}
 				if(verbose_) {
 					auto sect = out_section_(1, 1);
-					std::cout << sect << "Change baud rate: " << std::endl;
+					std::cout << sect << boost::format("Change baud rate: %d") % brate << std::endl;
 				}
 			}
 
@@ -386,6 +480,7 @@ namespace rx63t {
 		bool connection() {
 			bool ok = false;
 			for(int i = 0; i < 30; ++i) {
+				if(i > 0) rs232c_.retry();
 				if(!command_(0x00)) {
 					return false;
 				}
@@ -756,6 +851,45 @@ namespace rx63t {
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ボーレートの自動選択 @n
+					速い順に変更を試み、確認の往復に成功した最初の速度を採用する。@n
+					失敗した場合は、接続時の速度に戻して次の速度を試す（戻せない場合は、@n
+					デバイスのリセットを待って、接続からやり直す）。
+			@param[in]	rx		マイコン設定（speed_hint_ があれば、その速度から試す、@n
+								speed_probe_ なら、その一段上の速度を最初に試す）
+			@return 選択したボーレート（失敗なら「０」）
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t change_speed_auto(const rx::protocol::rx_t& rx) {
+			static const uint32_t list[] = { 230400, 115200, 57600, 38400, 19200 };
+			static const uint32_t num = sizeof(list) / sizeof(list[0]);
+			uint32_t top = 0;
+			if(rx.speed_hint_ != 0) {
+				while(top < num && list[top] > rx.speed_hint_) ++top;
+				if(rx.speed_probe_ && top > 0) {
+					if(try_speed_(rx, list[top - 1])) return list[top - 1];
+					if(!connection_) return 0;
+				}
+			}
+			for(uint32_t i = top; i < num; ++i) {
+				if(try_speed_(rx, list[i])) return list[i];
+				if(!connection_) return 0;
+			}
+			return 0;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ボーレートの取得
+			@return ボーレート
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_speed() const { return baud_speed_; }
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	ユーザー・ブート領域問い合わせ
@@ -1077,6 +1211,44 @@ namespace rx63t {
 		bool get_protect() const { return id_protect_; }
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	デバイス識別文字列を取得
+			@return デバイス識別文字列
+		*/
+		//-----------------------------------------------------------------//
+		std::string get_device_id() const {
+			if(devices_.empty()) return std::string();
+			return (boost::format("%s_%08X") % devices_[0].name_ % devices_[0].code_).str();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	消去ブロック・サイズを取得 @n
+					※ブートモードで P/E ステータスへ移行した時点でユーザー領域は @n
+					全消去されており、個別のブロック消去は無い為「０」を返す
+			@param[in]	address	アドレス
+			@return 消去ブロック・サイズ
+		*/
+		//-----------------------------------------------------------------//
+		static uint32_t get_block_size(uint32_t address) { return 0; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	イレース・ブロック @n
+					※ P/E ステータス移行時に全消去されている
+			@param[in]	org		ブロック先頭アドレス
+			@param[in]	size	ブロック・サイズ
+			@return エラー無ければ「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool erase_block(uint32_t org, uint32_t size) {
+			return true;
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	イレース・ページ
@@ -1094,7 +1266,7 @@ namespace rx63t {
 			buff[1] = (address >> 8) & 0xff;
 			buff[2] = (address >> 16) & 0xff;
 			buff[3] = 0xD0;
-			if(rs232c_.send(buff, 4) != 4) {
+			if(!write_(buff, 4)) {
 				return false;
 			}
 			rs232c_.sync_send();
@@ -1219,28 +1391,12 @@ namespace rx63t {
 			if(!pe_turn_on_) return false;
 			if(!select_write_area_) return false;
 
-			uint8_t cmd[5 + 256 + 1];
+			uint8_t cmd[5 + 1];
 			cmd[0] = 0x50;
-///			std::cout << boost::format("Address: %08X") % address << std::endl;			
 			if(address != 0xffffffff) {
-				put32_big_(&cmd[1], address);
-				std::memcpy(&cmd[5], src, 256);
-				cmd[5 + 256] = sum_(cmd, 5 + 256);
-
-				if(!write_(cmd, 5)) {
-					select_write_area_ = false;
-					return false;
-				}
-				for(uint32_t i = 0; i < 16; ++i) {
-					if(!write_(&cmd[5 + i * 16], 16)) {
-						select_write_area_ = false;
-						return false;
-					}
-				}
-				if(!write_(&cmd[5 + 256], 1)) {  // SUM
-				  	select_write_area_ = false;
-					return false;
-				}
+				rx::protocol::page_frame f;
+				make_frame(address, src, f);
+				return write_frame(f);
 			} else {
 				put32_big_(&cmd[1], address);
 				select_write_area_ = false;
@@ -1250,33 +1406,64 @@ namespace rx63t {
 				}
 			}
 
-			// レスポンス
-			timeval tv;
-			tv.tv_sec  = 10;
-			tv.tv_usec = 0;
-			uint8_t head[1];
-			if(!read_(head, 1, tv)) {
-				select_write_area_ = false;
-				return false;
-			}
-			if(head[0] != 0x06) {
-				std::cout << "Respons error" << std::endl;
+			return response_write_();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ライト・ページ・フレームの組み立て（通信を伴わない）
+			@param[in]	address	アドレス
+			@param[in]	src	ライト・データ
+			@param[out]	f	フレーム
+		*/
+		//-----------------------------------------------------------------//
+		static void make_frame(uint32_t address, const uint8_t* src, rx::protocol::page_frame& f) {
+			f.adr_ = address;
+			f.cmd_[0] = 0x50;
+			put32_big_(&f.cmd_[1], address);
+			f.cmd_len_ = 5;
+			std::memcpy(&f.dat_[0], src, 256);
+			f.dat_[256] = (sum_(f.cmd_, 5) + sum_(f.dat_, 256)) & 0xff;
+			f.dat_len_ = 256 + 1;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ライト・ページ・フレームの送信
+			@param[in]	f	フレーム
+			@return エラー無ければ「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool write_frame(const rx::protocol::page_frame& f) {
+			if(!connection_) return false;
+			if(!pe_turn_on_) return false;
+			if(!select_write_area_) return false;
+
+			// コマンド、データ、SUM を一度に送る
+			uint8_t tmp[sizeof(f.cmd_) + sizeof(f.dat_)];
+			std::memcpy(tmp, f.cmd_, f.cmd_len_);
+			std::memcpy(&tmp[f.cmd_len_], f.dat_, f.dat_len_);
+			if(!write_(tmp, f.length())) {
 				select_write_area_ = false;
-				if(head[0] != 0xd0) {
-					return false;
-				}
-				if(!read_(head, 1, tv)) {
-					return false;
-				}
-				last_error_ = head[0];
-///				std::cout << boost::format("Write error code: %02X") % static_cast<uint32_t>(head[0]) << std::endl;
 				return false;
 			}
 
-			return true;
+			return response_write_();
 		}
 
 
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	シリアル通信の統計を取得
+			@return 統計
+		*/
+		//-----------------------------------------------------------------//
+		const utils::rs232c_io::stat_t& get_stat() const { return rs232c_.get_stat(); }
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	終了
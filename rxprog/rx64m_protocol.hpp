@@ -24,6 +24,7 @@ namespace rx64m {
 	class protocol {
 
 		utils::rs232c_io	rs232c_;
+		std::string			path_;
 
 		bool				verbose_ = false;
 
@@ -104,25 +105,31 @@ namespace rx64m {
 
 
 		bool write_(const void* buff, uint32_t len) {
-			uint32_t wr = rs232c_.send(buff, len);
-			rs232c_.sync_send();
-			return wr == len;
+			// フレーム（SOH/SOD、長さ、コマンド、...）のコマンドで集計
+			if(len > 3) rs232c_.set_tag(static_cast<const uint8_t*>(buff)[3]);
+			return rs232c_.send(buff, len) == len;
 		}
 
 
-		bool com_(uint8_t soh, uint8_t cmd, uint8_t ext, const uint8_t* src = nullptr, uint32_t len = 0) {
-			uint8_t tmp[1 + 2 + 1 + len + 1 + 1];
-			tmp[0] = soh;
-			put16_big_(&tmp[1], 1 + len);
-			tmp[3] = cmd;
+		static uint32_t frame_(uint8_t* dst, uint8_t soh, uint8_t cmd, uint8_t ext,
+			const uint8_t* src, uint32_t len) {
+			dst[0] = soh;
+			put16_big_(&dst[1], 1 + len);
+			dst[3] = cmd;
 			if(len > 0) {
-				std::memcpy(&tmp[4], src, len);
+				std::memcpy(&dst[4], src, len);
 			}
-			tmp[4 + len] = sum_(&tmp[1], 3 + len);
-			tmp[4 + len + 1] = ext;
-			uint32_t l = rs232c_.send(tmp, sizeof(tmp));
-			rs232c_.sync_send();
-			return l == sizeof(tmp);
+			dst[4 + len] = sum_(&dst[1], 3 + len);
+			dst[4 + len + 1] = ext;
+			return 1 + 2 + 1 + len + 1 + 1;
+		}
+
+
+		bool com_(uint8_t soh, uint8_t cmd, uint8_t ext, const uint8_t* src = nullptr, uint32_t len = 0) {
+			uint8_t tmp[1 + 2 + 1 + len + 1 + 1];
+			frame_(tmp, soh, cmd, ext, src, len);
+			rs232c_.set_tag(cmd);
+			return rs232c_.send(tmp, sizeof(tmp)) == sizeof(tmp);
 		}
 
 
@@ -216,7 +223,9 @@ namespace rx64m {
 				return false;
 			}
 
-			if(!write_(tmp, sizeof(tmp))) {
+			// 受信したステータス・フレームと同じ長さを返送する
+			uint32_t len = 4 + (get16_big_(&tmp[1]) - 1) + 2;
+			if(!write_(tmp, len)) {
 				return false;
 			}
 			return true;
@@ -252,10 +261,113 @@ namespace rx64m {
 		}
 
 
+		bool erase_(uint32_t chk_org, uint32_t chk_end, uint32_t org) {
+			if(!connection_) return false;
+			if(!pe_turn_on_) return false;
+
+			// ブランク・チェックを行う
+			uint8_t tmp[8];
+			put32_big_(&tmp[0], chk_org);
+			put32_big_(&tmp[4], chk_end);
+			if(!command_(0x10, tmp, sizeof(tmp))) {
+				return false;
+			}
+			uint8_t res;
+			uint8_t err;
+			if(!response_(res, err)) {
+				return false;
+			}
+			if(res == 0x10) return true;  // erase OK
+			else if(res != 0x90) {
+				return false;
+			} else {
+				if(err != 0xe0) { // do erase
+					return false;
+				}
+				// erase NG;
+				put32_big_(&tmp[0], org);
+				if(!command_(0x12, tmp, 4)) {  // erase command
+					return false;
+				}
+				if(!response_(res, err)) {
+					return false;
+				}
+				if(res == 0x12) ;
+				else if(res == 0x92) {
+					std::cout << boost::format("Erase response: %02X") % static_cast<uint32_t>(err)
+						<< std::endl;
+					return false;
+				} else {
+					return false;
+				}
+			}
+			return true;
+		}
+
+
 		std::string out_section_(uint32_t n, uint32_t num) const {
 			return (boost::format("#%02d/%02d: ") % n % num).str();
 		}
 
+
+		// 同期コマンドを数回往復させて、通信速度を確認する
+		bool check_speed_() {
+			for(int i = 0; i < 3; ++i) {
+				if(!command_(0x00)) return false;
+				if(!status_(0x00)) return false;
+			}
+			return true;
+		}
+
+		// 接続時の速度（9600）に戻す
+		bool restore_speed_() {
+			baud_speed_ = 9600;
+			baud_rate_ = B9600;
+			usleep(25000);	// 25[ms]
+			if(!rs232c_.change_speed(baud_rate_)) {
+				return false;
+			}
+			rs232c_.flush();
+			return check_speed_();
+		}
+
+		// 変更後の速度のまま応答が無い場合、デバイスのリセットを促して、接続からやり直す
+		bool resync_() {
+			connection_ = false;
+			baud_speed_ = 9600;
+			baud_rate_ = B9600;
+			if(!rs232c_.change_speed(baud_rate_)) {
+				return false;
+			}
+			std::cerr << "Lost sync, reset the device (boot mode): '" << path_ << "'" << std::endl;
+			for(int i = 0; i < 100; ++i) {  // 約３０秒
+				rs232c_.flush();
+				if(!connection()) continue;
+				if(!inquiry_device_type()) break;
+				select_endian(0x01);
+				select_frequency();
+				return true;
+			}
+			connection_ = false;
+			return false;
+		}
+
+		// 速度の変更を試す（失敗したら、接続時の速度に戻す）
+		bool try_speed_(const rx::protocol::rx_t& rx, uint32_t speed) {
+			if(change_speed(rx, speed) && check_speed_()) {
+				return true;
+			}
+			if(verbose_) {
+				auto sect = out_section_(1, 1);
+				std::cout << sect << boost::format("Baud rate %d: fail") % speed << std::endl;
+			}
+			rs232c_.retry();
+			if(!restore_speed_()) {
+				resync_();
+			}
+			return false;
+		}
+
 	public:
 		//-----------------------------------------------------------------//
 		/*!
@@ -277,11 +389,17 @@ namespace rx64m {
 		bool bind(const std::string& path, uint32_t brate, const rx::protocol::rx_t& rx)
 		{
 			verbose_ = rx.verbose_;
+			path_ = path;
 
 			if(!start(path)) {
 				std::cerr << "Can't open path: '" << path << "'" << std::endl;
 				return false;
 			}
+			if(rx.low_latency_ && !rs232c_.set_low_latency()) {
+				if(verbose_) {
+					std::cout << "# Low latency mode not supported: '" << path << "'" << std::endl;
+				}
+			}
 
 			// コネクション
 			if(!connection()) {
@@ -330,7 +448,13 @@ namespace rx64m {
 
 			// ボーレート変更
 			{
-				if(!change_speed(rx, brate)) {
+				if(brate == 0) {
+					brate = change_speed_auto(rx);
+					if(brate == 0) {
+						std::cerr << "Can't find available speed." << std::endl;
+						return false;
+					}
+				} else if(!change_speed(rx, brate)) {
 					std::cerr << "Can't change speed." << std::endl;
 					return false;
 				}
@@ -394,6 +518,7 @@ namespace rx64m {
 		bool connection() {
 			bool ok = false;
 			for(int i = 0; i < 30; ++i) {
+				if(i > 0) rs232c_.retry();
 				if(!rs232c_.send(0x00)) {
 					return false;
 				}
@@ -466,6 +591,21 @@ namespace rx64m {
 		const rx::protocol::device_type& get_device_type() const { return device_type_; }
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	デバイス識別文字列を取得
+			@return デバイス識別文字列
+		*/
+		//-----------------------------------------------------------------//
+		std::string get_device_id() const {
+			std::string s = "RX64M_";
+			for(uint32_t i = 0; i < sizeof(device_type_.TYP); ++i) {
+				s += (boost::format("%02X") % static_cast<uint32_t>(device_type_.TYP[i])).str();
+			}
+			return s;
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	エンディアン通知コマンド
@@ -592,6 +732,45 @@ namespace rx64m {
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ボーレートの自動選択 @n
+					速い順に変更を試み、確認の往復に成功した最初の速度を採用する。@n
+					失敗した場合は、接続時の速度に戻して次の速度を試す（戻せない場合は、@n
+					デバイスのリセットを待って、接続からやり直す）。
+			@param[in]	rx		マイコン設定（speed_hint_ があれば、その速度から試す、@n
+								speed_probe_ なら、その一段上の速度を最初に試す）
+			@return 選択したボーレート（失敗なら「０」）
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t change_speed_auto(const rx::protocol::rx_t& rx) {
+			static const uint32_t list[] = { 576000, 500000, 460800, 230400, 115200, 57600, 38400, 19200 };
+			static const uint32_t num = sizeof(list) / sizeof(list[0]);
+			uint32_t top = 0;
+			if(rx.speed_hint_ != 0) {
+				while(top < num && list[top] > rx.speed_hint_) ++top;
+				if(rx.speed_probe_ && top > 0) {
+					if(try_speed_(rx, list[top - 1])) return list[top - 1];
+					if(!connection_) return 0;
+				}
+			}
+			for(uint32_t i = top; i < num; ++i) {
+				if(try_speed_(rx, list[i])) return list[i];
+				if(!connection_) return 0;
+			}
+			return 0;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ボーレートの取得
+			@return ボーレート
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_speed() const { return baud_speed_; }
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	ID 認証モード取得コマンド
@@ -625,6 +804,24 @@ namespace rx64m {
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	消去ブロック・サイズを取得
+			@param[in]	address	アドレス
+			@return 消去ブロック・サイズ
+		*/
+		//-----------------------------------------------------------------//
+		static uint32_t get_block_size(uint32_t address) {
+			if(address >= 0xFFFF0000) {  // 8K block
+				return 8192;
+			} else if(address >= 0xFFC00000) {  // 32K block
+				return 32768;
+			} else {  // 64 bytes block (data flash)
+				return 64;
+			}
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	イレース・ページ
@@ -633,56 +830,32 @@ namespace rx64m {
 		*/
 		//-----------------------------------------------------------------//
 		bool erase_page(uint32_t address) {
-			if(!connection_) return false;
-			if(!pe_turn_on_) return false;
-
-			// ブランク・チェックを行う
-			uint8_t tmp[8];
 			auto org = address & 0xffffff00;
-			put32_big_(&tmp[0], org);
-			put32_big_(&tmp[4], org + 255);
-			if(!command_(0x10, tmp, sizeof(tmp))) {
-				return false;
-			}
-			uint8_t res;
-			uint8_t err;
-			if(!response_(res, err)) {
-				return false;
+			auto bs = get_block_size(org);
+			if(bs >= 256) {
+				return erase_(org, org + 255, org & ~(bs - 1));
 			}
-			if(res == 0x10) return true;  // erase OK
-			else if(res != 0x90) {
-				return false;
-			} else {
-				if(err != 0xe0) { // do erase
-					return false;
-				}
-				// erase NG;
-				// std::cout << boost::format("Erase NG: %08X") % address << std::endl;
-				if(address >= 0xFFFF0000) {  // 8K block
-					org = address & 0xFFFFE000;
-				} else if(address >= 0xFFC00000) {  // 32K block
-					org = address & 0xFFFF8000;
-				}
-				put32_big_(&tmp[0], org);
-				if(!command_(0x12, tmp, 4)) {  // erase command
-					return false;
-				}
-				if(!response_(res, err)) {
-					return false;
-				}
-				if(res == 0x12) ;
-				else if(res == 0x92) {
-					std::cout << boost::format("Erase response: %02X") % static_cast<uint32_t>(err)
-						<< std::endl;
-					return false;
-				} else {
-					return false;
-				}
+			for(uint32_t a = org; a < (org + 256); a += bs) {  // ページ内の全ブロック
+				if(!erase_(a, a + bs - 1, a)) return false;
 			}
 			return true;
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	イレース・ブロック @n
+					ブロック全体のブランク・チェックを行い、ブランクで無い場合に消去
+			@param[in]	org		ブロック先頭アドレス
+			@param[in]	size	ブロック・サイズ
+			@return エラー無ければ「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool erase_block(uint32_t org, uint32_t size) {
+			return erase_(org, org + size - 1, org);
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	ユーザー・ブート／データ領域書き込み選択
@@ -719,10 +892,43 @@ namespace rx64m {
 				return true;
 			}
 
+			rx::protocol::page_frame f;
+			make_frame(address, src, f);
+			return write_frame(f);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ライト・ページ・フレームの組み立て（通信を伴わない）
+			@param[in]	address	アドレス
+			@param[in]	src	ライト・データ
+			@param[out]	f	フレーム
+		*/
+		//-----------------------------------------------------------------//
+		static void make_frame(uint32_t address, const uint8_t* src, rx::protocol::page_frame& f) {
+			f.adr_ = address;
 			uint8_t tmp[8];
 			put32_big_(&tmp[0], address);
 			put32_big_(&tmp[4], address + 255);
-			if(!command_(0x13, tmp, sizeof(tmp))) {
+			f.cmd_len_ = frame_(f.cmd_, 0x01, 0x13, 0x03, tmp, sizeof(tmp));
+			f.dat_len_ = frame_(f.dat_, 0x81, 0x13, 0x03, src, 256);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ライト・ページ・フレームの送信
+			@param[in]	f	フレーム
+			@return エラー無ければ「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool write_frame(const rx::protocol::page_frame& f) {
+			if(!connection_) return false;
+			if(!pe_turn_on_) return false;
+			if(!select_write_area_) return false;
+
+			if(!write_(f.cmd_, f.cmd_len_)) {
 				return false;
 			}
 
@@ -730,7 +936,7 @@ namespace rx64m {
 				return false;
 			}
 
-			if(!com_(0x81, 0x13, 0x03, src, 256)) {
+			if(!write_(f.dat_, f.dat_len_)) {
 				return false;
 			}
 
@@ -744,7 +950,7 @@ namespace rx64m {
 			} else if(res == 0x93) { // write error
 				std::cerr << std::endl;
 				std::cerr << boost::format("Write error (%08X), status: %02X")
-					% address % static_cast<uint32_t>(err) << std::endl;
+					% f.adr_ % static_cast<uint32_t>(err) << std::endl;
 			}
 			return false;
 		}
@@ -784,6 +990,16 @@ namespace rx64m {
 		}
 
 
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	シリアル通信の統計を取得
+			@return 統計
+		*/
+		//-----------------------------------------------------------------//
+		const utils::rs232c_io::stat_t& get_stat() const { return rs232c_.get_stat(); }
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	終了
@@ -11,6 +11,8 @@
 #include "rx63t_protocol.hpp"
 #include "rx24t_protocol.hpp"
 #include "rx64m_protocol.hpp"
+#include <vector>
+#include <chrono>
 #include <boost/format.hpp>
 #include <boost/variant.hpp>
 
@@ -22,7 +24,41 @@ namespace rx {
 	 */
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	class prog {
+	public:
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief	フェーズ毎の計測（接続、消去、書き込み、ベリファイ等）
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct phase_t {
+			std::string	name_;
+			double		time_ = 0.0;	///< 経過時間 [sec]
+			uint32_t	pages_ = 0;		///< 処理ページ数
+			uint64_t	send_ = 0;		///< 送信バイト数
+			uint64_t	recv_ = 0;		///< 受信バイト数
+			uint32_t	round_ = 0;		///< 往復回数
+			uint32_t	retry_ = 0;		///< 再試行回数
+			uint32_t	timeout_ = 0;	///< 受信タイムアウト回数
+
+			void info(const std::string& head = "") const {
+				std::cout << head << boost::format("%s time: %d pages, %.3f sec") % name_ % pages_ % time_;
+				if(time_ > 0.0 && (send_ + recv_) > 0) {
+					std::cout << boost::format(", %.1f KB/s") % (static_cast<double>(pages_) * 256.0 / 1024.0 / time_);
+				}
+				std::cout << std::endl;
+			}
+		};
+		typedef std::vector<phase_t> phases;
+
+	private:
+		typedef std::chrono::steady_clock clock;
+
 		bool		verbose_;
+		uint32_t	brate_;
+
+		phases		phases_;
+		bool		phase_open_;
+		clock::time_point	phase_org_;
 
 		utils::rs232c_io	rs232c_;
 
@@ -63,6 +99,20 @@ namespace rx {
 		};
 
 
+		struct erase_block_visitor {
+			using result_type = bool;
+
+			uint32_t org_;
+			uint32_t size_;
+			erase_block_visitor(uint32_t org, uint32_t size) : org_(org), size_(size) { }
+
+    		template <class T>
+    		bool operator()(T& x) {
+				return x.erase_block(org_, size_);
+			}
+		};
+
+
 		struct read_page_visitor {
 			using result_type = bool;
 
@@ -104,6 +154,58 @@ namespace rx {
 		};
 
 
+		struct make_frame_visitor {
+			using result_type = void;
+
+			uint32_t adr_;
+			const uint8_t* src_;
+			rx::protocol::page_frame& f_;
+			make_frame_visitor(uint32_t adr, const uint8_t* src, rx::protocol::page_frame& f) :
+				adr_(adr), src_(src), f_(f) { }
+
+    		template <class T>
+    		void operator()(const T& x) const {
+				T::make_frame(adr_, src_, f_);
+			}
+		};
+
+
+		struct write_frame_visitor {
+			using result_type = bool;
+
+			const rx::protocol::page_frame& f_;
+			write_frame_visitor(const rx::protocol::page_frame& f) : f_(f) { }
+
+    		template <class T>
+    		bool operator()(T& x) {
+				return x.write_frame(f_);
+			}
+		};
+
+
+		struct device_id_visitor {
+			using result_type = std::string;
+
+    		template <class T>
+    		std::string operator()(const T& x) const {
+				return x.get_device_id();
+			}
+		};
+
+
+		struct block_size_visitor {
+			using result_type = uint32_t;
+
+			uint32_t adr_;
+			block_size_visitor(uint32_t adr) : adr_(adr) { }
+
+    		template <class T>
+    		uint32_t operator()(const T& x) const {
+				return T::get_block_size(adr_);
+			}
+		};
+
+
 		struct end_visitor {
 			using result_type = void;
 
@@ -113,38 +215,76 @@ namespace rx {
 			}
 		};
 
+		struct speed_visitor {
+			using result_type = uint32_t;
+
+			template <class T>
+			uint32_t operator()(const T& x) const {
+				return x.get_speed();
+			}
+		};
+
+		struct stat_visitor {
+			using result_type = const utils::rs232c_io::stat_t&;
+
+			template <class T>
+			const utils::rs232c_io::stat_t& operator()(const T& x) const {
+				return x.get_stat();
+			}
+		};
+
 	public:
 		//-------------------------------------------------------------//
 		/*!
 			@brief	コンストラクター
 		*/
 		//-------------------------------------------------------------//
-		prog(bool verbose = false) : verbose_(verbose) { }
+		prog(bool verbose = false) : verbose_(verbose), brate_(0), phase_open_(false) { }
 
 
 		//-------------------------------------------------------------//
 		/*!
-			@brief	接続速度を変更する
-			@param[in]	path	シリアル・デバイス・パス
-			@param[in]	brate	ボーレート
-			@param[in]	rx		CPU 設定
+			@brief	プロトコルの選択（通信を伴わない） @n
+					接続前に、ブロック・サイズ等の静的な情報を得る場合に使う
+			@param[in]	cpu_type	CPU タイプ
 			@return エラー無ければ「true」
 		*/
 		//-------------------------------------------------------------//
-		bool start(const std::string& path, uint32_t brate, const rx::protocol::rx_t& rx)
+		bool select(const std::string& cpu_type)
 		{
-			if(rx.cpu_type_ == "RX63T") {
+			if(cpu_type == "RX63T") {
 				protocol_ = rx63t::protocol();
-			} else if(rx.cpu_type_ == "RX24T") {
+			} else if(cpu_type == "RX24T") {
 				protocol_ = rx24t::protocol();
-			} else if(rx.cpu_type_ == "RX64M") {
+			} else if(cpu_type == "RX64M") {
 				protocol_ = rx64m::protocol();
 			} else {
-				std::cerr << "CPU type missmatch: '" << rx.cpu_type_ << "'" << std::endl;
+				std::cerr << "CPU type missmatch: '" << cpu_type << "'" << std::endl;
+				return false;
+			}
+			return true;
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	接続速度を変更する
+			@param[in]	path	シリアル・デバイス・パス
+			@param[in]	brate	ボーレート（「０」なら自動選択）
+			@param[in]	rx		CPU 設定
+			@return エラー無ければ「true」
+		*/
+		//-------------------------------------------------------------//
+		bool start(const std::string& path, uint32_t brate, const rx::protocol::rx_t& rx)
+		{
+			if(!select(rx.cpu_type_)) {
 				return false;
 			}
 
+			brate_ = brate;
 
+			phases_.clear();
+			begin_phase("Connect");
 			{  // 開始
 				bind_visitor vis(path, brate, rx);
             	if(!boost::apply_visitor(vis, protocol_)) {
@@ -152,6 +292,12 @@ namespace rx {
 					return false;
 				}
 			}
+			end_phase(0);
+
+			{  // 実際に選択されたボーレート
+				speed_visitor vis;
+				brate_ = boost::apply_visitor(vis, protocol_);
+			}
 
 			return true;
 		}
@@ -175,6 +321,25 @@ namespace rx {
 		}
 
 
+		//-------------------------------------------------------------//
+		/*!
+			@brief	ブロック消去（ブランクなら消去しない）
+			@param[in]	org		ブロック先頭アドレス
+			@param[in]	size	ブロック・サイズ
+			@return 成功なら「true」
+		*/
+		//-------------------------------------------------------------//
+		bool erase_block(uint32_t org, uint32_t size) {
+			erase_block_visitor vis(org, size);
+           	if(!boost::apply_visitor(vis, protocol_)) {
+				end();
+				std::cerr << std::endl << boost::format("Erase block error: %08X (%d)") % org % size << std::endl;
+				return false;
+			}
+			return true;
+		}
+
+
 		//-------------------------------------------------------------//
 		/*!
 			@brief	リード・ページ（２５６バイト）
@@ -264,6 +429,84 @@ namespace rx {
 		}
 
 
+		//-------------------------------------------------------------//
+		/*!
+			@brief	ライト・フレームの組み立て（通信を伴わない、スレッド・セーフ）
+			@param[in]	adr	開始アドレス
+			@param[in]	src	書き込みアドレス
+			@param[out]	f	フレーム
+		*/
+		//-------------------------------------------------------------//
+		void make_frame(uint32_t adr, const uint8_t* src, rx::protocol::page_frame& f) const {
+			make_frame_visitor vis(adr, src, f);
+			boost::apply_visitor(vis, protocol_);
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	ライト・フレームの送信（２５６バイト）
+			@param[in]	f	フレーム
+			@return 成功なら「true」
+		*/
+		//-------------------------------------------------------------//
+		bool write_frame(const rx::protocol::page_frame& f) {
+			write_frame_visitor vis(f);
+           	if(!boost::apply_visitor(vis, protocol_)) {
+				end();
+				std::cerr << "Write body error." << std::endl;
+				return false;
+			}
+			return true;
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	接続ボーレートの取得
+			@return 接続ボーレート
+		*/
+		//-------------------------------------------------------------//
+		uint32_t get_baud_rate() const { return brate_; }
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	デバイス識別文字列の取得
+			@return デバイス識別文字列
+		*/
+		//-------------------------------------------------------------//
+		std::string get_device_id() const {
+			device_id_visitor vis;
+			return boost::apply_visitor(vis, protocol_);
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	シリアル通信の統計を取得
+			@return 統計
+		*/
+		//-------------------------------------------------------------//
+		const utils::rs232c_io::stat_t& get_stat() const {
+			stat_visitor vis;
+			return boost::apply_visitor(vis, protocol_);
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	消去ブロック・サイズの取得
+			@param[in]	adr	アドレス
+			@return 消去ブロック・サイズ（「０」の場合、ブロック消去無し）
+		*/
+		//-------------------------------------------------------------//
+		uint32_t get_block_size(uint32_t adr) const {
+			block_size_visitor vis(adr);
+			return boost::apply_visitor(vis, protocol_);
+		}
+
+
 		//-------------------------------------------------------------//
 		/*!
 			@brief	ライト終了
@@ -287,8 +530,61 @@ namespace rx {
 		*/
 		//-------------------------------------------------------------//
 		void end() {
+			end_phase(0);
 			end_visitor vis;
            	boost::apply_visitor(vis, protocol_);
 		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	フェーズ計測の開始（前のフェーズが終了していなければ終了させる）
+			@param[in]	name	フェーズ名
+		*/
+		//-------------------------------------------------------------//
+		void begin_phase(const std::string& name) {
+			end_phase(0);
+			const auto& st = get_stat();
+			phase_t t;
+			t.name_ = name;
+			t.send_ = st.send_;
+			t.recv_ = st.recv_;
+			t.round_ = st.round_;
+			t.retry_ = st.retry_;
+			t.timeout_ = st.timeout_;
+			phases_.push_back(t);
+			phase_open_ = true;
+			phase_org_ = clock::now();
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	フェーズ計測の終了
+			@param[in]	pages	処理ページ数
+		*/
+		//-------------------------------------------------------------//
+		void end_phase(uint32_t pages) {
+			if(!phase_open_) return;
+			phase_open_ = false;
+			const auto& st = get_stat();
+			auto& t = phases_.back();
+			t.time_ = std::chrono::duration<double>(clock::now() - phase_org_).count();
+			t.pages_ = pages;
+			t.send_ = st.send_ - t.send_;
+			t.recv_ = st.recv_ - t.recv_;
+			t.round_ = st.round_ - t.round_;
+			t.retry_ = st.retry_ - t.retry_;
+			t.timeout_ = st.timeout_ - t.timeout_;
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	フェーズ計測の取得
+			@return フェーズ計測
+		*/
+		//-------------------------------------------------------------//
+		const phases& get_phase() const { return phases_; }
 	};
 }
@@ -153,6 +153,24 @@ namespace rx {
 		typedef std::vector<block> blocks;
 
 
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief	page_frame 構造体 @n
+					送信前に組み立て済みの、ライト・ページ（２５６バイト）フレーム @n
+					cmd_ はコマンド部、dat_ はデータ部（SUM を含む）
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct page_frame {
+			uint32_t	adr_ = 0;
+			uint32_t	cmd_len_ = 0;
+			uint32_t	dat_len_ = 0;
+			uint8_t		cmd_[16];
+			uint8_t		dat_[4 + 256 + 2];
+
+			uint32_t length() const { return cmd_len_ + dat_len_; }
+		};
+
+
 		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 		/*!
 			@brief	rx_t 構造体 @n
@@ -167,6 +185,11 @@ namespace rx {
 			uint32_t	master_ = 1200;	///< マスター・クロック（MHz 単位で、小数第２位、１００倍）
 			uint32_t	sys_div_ = 8;	///< システム・ディバイダー設定
 			uint32_t	ext_div_ = 4;	///< 周辺ディバイダー設定
+
+			bool	low_latency_ = false;	///< シリアル・ポートの低レイテンシー設定
+
+			uint32_t	speed_hint_ = 0;	///< 自動ボーレート選択で、最初に試す速度（０なら最速から）
+			bool		speed_probe_ = false;	///< speed_hint_ の一段上の速度を、最初に試す
 		};
 	};
 }
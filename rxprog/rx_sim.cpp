@@ -0,0 +1,168 @@
+//=====================================================================//
+/*!	@file
+	@brief	Renesas RX Series Boot Mode Simulator @n
+			擬似端末上で RX のブートモードに応答し、rx_prog の転送性能を @n
+			実機無しで測定する。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <iostream>
+#include <csignal>
+#include "rx_sim.hpp"
+#include "string_utils.hpp"
+
+namespace {
+
+	const std::string version_ = "0.10";
+
+	volatile sig_atomic_t stop_ = 0;
+
+	void signal_(int sig)
+	{
+		stop_ = 1;
+	}
+
+
+	struct options {
+		bool	verbose = false;
+		bool	help = false;
+		bool	dv = false;
+		std::string	device = "RX64M";
+		std::string	link;
+		rx::sim::timing_t	timing;
+		uint32_t	max_baud = 0;
+		uint32_t	drop_baud = 0;
+
+		bool set_str(const std::string& t) {
+			if(dv) {
+				device = t;
+				dv = false;
+				return true;
+			}
+			return false;
+		}
+	};
+
+
+	bool get_us_(const std::string& s, uint32_t& val)
+	{
+		int n;
+		if(!utils::string_to_int(s, n) || n < 0) return false;
+		val = n;
+		return true;
+	}
+
+
+	void help_(const std::string& cmd)
+	{
+		using namespace std;
+
+		std::string c = utils::get_file_base(cmd);
+
+		cout << "Renesas RX Series Boot Mode Simulator Version " << version_ << endl;
+		cout << "usage:" << endl;
+		cout << c << " [options]" << endl;
+		cout << endl;
+		cout << "Options :" << endl;
+		cout << "    -d DEVICE, --device=DEVICE Specify device type (RX24T, RX63T, RX64M)" << endl;
+		cout << "    --byte-latency=US          Time per byte on the wire (default: from baud rate)" << endl;
+		cout << "    --write-time=US            Time per 256 bytes page write (default 1000)" << endl;
+		cout << "    --erase-time=US            Time per block erase (default 20000)" << endl;
+		cout << "    --max-speed=SPEED          Reject baud rate above SPEED (default: no limit)" << endl;
+		cout << "    --drop-speed=SPEED         Lose sync on baud rate above SPEED, until reset (2 sec)" << endl;
+		cout << "    --link=PATH                Make symbolic link to the pseudo terminal" << endl;
+		cout << "    --verbose                  Verbose output" << endl;
+		cout << "    -h, --help                 Display this" << endl;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	options opts;
+
+	bool opterr = false;
+	for(int i = 1; i < argc; ++i) {
+		const std::string p = argv[i];
+		if(p[0] == '-') {
+			if(p == "--verbose") opts.verbose = true;
+			else if(p == "-d") opts.dv = true;
+			else if(p.find("--device=") == 0) {
+				opts.device = &p[std::strlen("--device=")];
+			} else if(p.find("--byte-latency=") == 0) {
+				uint32_t v;
+				if(get_us_(&p[std::strlen("--byte-latency=")], v)) opts.timing.byte_us = v;
+				else opterr = true;
+			} else if(p.find("--write-time=") == 0) {
+				if(!get_us_(&p[std::strlen("--write-time=")], opts.timing.write_us)) opterr = true;
+			} else if(p.find("--erase-time=") == 0) {
+				if(!get_us_(&p[std::strlen("--erase-time=")], opts.timing.erase_us)) opterr = true;
+			} else if(p.find("--max-speed=") == 0) {
+				if(!get_us_(&p[std::strlen("--max-speed=")], opts.max_baud)) opterr = true;
+			} else if(p.find("--drop-speed=") == 0) {
+				if(!get_us_(&p[std::strlen("--drop-speed=")], opts.drop_baud)) opterr = true;
+			} else if(p.find("--link=") == 0) {
+				opts.link = &p[std::strlen("--link=")];
+			} else if(p == "-h" || p == "--help") {
+				opts.help = true;
+			} else {
+				opterr = true;
+			}
+		} else {
+			if(!opts.set_str(p)) {
+				opterr = true;
+			}
+		}
+		if(opterr) {
+			std::cerr << "Option error: '" << p << "'" << std::endl;
+			opts.help = true;
+			opterr = false;
+		}
+	}
+
+	if(opts.help) {
+		help_(argv[0]);
+		return 0;
+	}
+
+	rx::sim::type t;
+	if(opts.device == "RX24T") t = rx::sim::type::RX24T;
+	else if(opts.device == "RX63T") t = rx::sim::type::RX63T;
+	else if(opts.device == "RX64M") t = rx::sim::type::RX64M;
+	else {
+		std::cerr << "Unsupported device: '" << opts.device << "'" << std::endl;
+		return -1;
+	}
+
+	rx::sim sim(t, opts.timing, opts.verbose);
+	sim.set_max_baud(opts.max_baud);
+	sim.set_drop_baud(opts.drop_baud);
+	std::string path;
+	if(!sim.open(path)) {
+		std::cerr << "Can't open pseudo terminal" << std::endl;
+		return -1;
+	}
+	if(!opts.link.empty()) {
+		unlink(opts.link.c_str());
+		if(symlink(path.c_str(), opts.link.c_str()) != 0) {
+			std::cerr << "Can't make link: '" << opts.link << "'" << std::endl;
+			return -1;
+		}
+	}
+	std::cout << "# " << opts.device << " simulator: '" << path << '\'' << std::endl;
+	std::cout.flush();
+
+	signal(SIGINT, signal_);
+	signal(SIGTERM, signal_);
+	while(stop_ == 0) {
+		if(!sim.service()) break;
+	}
+
+	sim.get_count().info("# ");
+	if(!opts.link.empty()) {
+		unlink(opts.link.c_str());
+	}
+	return 0;
+}
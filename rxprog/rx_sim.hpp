@@ -0,0 +1,737 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	RX ブートモード・シミュレーター・クラス @n
+			擬似端末（pty）のマスター側で、RX24T、RX63T、RX64M のブートモード @n
+			プロトコルに応答する。（rx_prog の性能測定、動作確認用）
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <poll.h>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <array>
+#include <map>
+#include <chrono>
+#include <iostream>
+#include <boost/format.hpp>
+
+namespace rx {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief	RX ブートモード・シミュレーター・クラス
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	class sim {
+	public:
+		static const int RESET_MS = 2000;	///< 同期を失ってから、リセットされるまでの時間
+
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief	デバイス・タイプ
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		enum class type {
+			RX24T,
+			RX63T,
+			RX64M,
+		};
+
+
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief	タイミング（マイクロ秒）
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct timing_t {
+			int32_t		byte_us  = -1;		///< １バイト転送時間（負ならボーレートから算出）
+			uint32_t	write_us = 1000;	///< ２５６バイト書き込み時間
+			uint32_t	erase_us = 20000;	///< ブロック消去時間
+			uint32_t	blank_us = 100;		///< ブランク・チェック時間
+			uint32_t	read_us  = 100;		///< ２５６バイト読み出し時間
+		};
+
+
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief	カウンター
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct count_t {
+			uint32_t	session_ = 0;
+			uint32_t	erase_ = 0;
+			uint32_t	blank_ = 0;
+			uint32_t	write_ = 0;
+			uint32_t	read_ = 0;
+			uint64_t	recv_ = 0;
+			uint64_t	send_ = 0;
+
+			void info(const std::string& head = "") const {
+				std::cout << head << boost::format("Session: %d, Erase: %d, Blank: %d, Write: %d, Read: %d")
+					% session_ % erase_ % blank_ % write_ % read_ << std::endl;
+				std::cout << head << boost::format("Recv: %d bytes, Send: %d bytes") % recv_ % send_
+					<< std::endl;
+			}
+		};
+
+	private:
+		type		type_;
+		timing_t	timing_;
+		bool		verbose_;
+
+		int			fd_;
+		int			slave_;
+		uint32_t	baud_;
+		uint32_t	max_baud_;
+		uint32_t	drop_baud_;
+
+		typedef std::chrono::steady_clock clock;
+		bool		lost_;		///< 同期喪失（リセット待ち）
+		bool		connect_;	///< 接続確認済み
+		clock::time_point	lost_time_;
+
+		typedef std::array<uint8_t, 256> page;
+		typedef std::map<uint32_t, page> flash_map;
+		flash_map	flash_;
+
+		count_t		count_;
+
+		//=============================================================//
+		// 入出力
+		//=============================================================//
+		void wait_(uint32_t bytes) const {
+			uint32_t t;
+			if(timing_.byte_us >= 0) t = timing_.byte_us;
+			else t = 10000000 / baud_;
+			if(t > 0 && bytes > 0) usleep(t * bytes);
+		}
+
+
+		bool get_(void* dst, uint32_t len, int timeout = 5000) {
+			uint8_t* p = static_cast<uint8_t*>(dst);
+			uint32_t n = 0;
+			while(n < len) {
+				pollfd pfd;
+				pfd.fd = fd_;
+				pfd.events = POLLIN;
+				int ret = poll(&pfd, 1, timeout);
+				if(ret <= 0) return false;
+				auto rl = ::read(fd_, p + n, len - n);
+				if(rl <= 0) return false;
+				n += rl;
+			}
+			count_.recv_ += len;
+			wait_(len);
+			return true;
+		}
+
+
+		bool put_(const void* src, uint32_t len) {
+			wait_(len);
+			const uint8_t* p = static_cast<const uint8_t*>(src);
+			uint32_t n = 0;
+			while(n < len) {
+				auto wl = ::write(fd_, p + n, len - n);
+				if(wl <= 0) return false;
+				n += wl;
+			}
+			count_.send_ += len;
+			return true;
+		}
+
+
+		bool put_(uint8_t ch) { return put_(&ch, 1); }
+
+
+		static uint32_t get32_big_(const uint8_t* p) {
+			return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16)
+				| (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+		}
+
+
+		static void put16_big_(uint8_t* p, uint32_t val) {
+			p[0] = (val >> 8) & 0xff;
+			p[1] = val & 0xff;
+		}
+
+
+		static void put32_big_(uint8_t* p, uint32_t val) {
+			p[0] = (val >> 24) & 0xff;
+			p[1] = (val >> 16) & 0xff;
+			p[2] = (val >> 8) & 0xff;
+			p[3] =  val & 0xff;
+		}
+
+
+		static void put32_(uint8_t* p, uint32_t val) {
+			p[0] =  val & 0xff;
+			p[1] = (val >> 8) & 0xff;
+			p[2] = (val >> 16) & 0xff;
+			p[3] = (val >> 24) & 0xff;
+		}
+
+
+		static uint8_t sum_(const uint8_t* buff, uint32_t len) {
+			uint32_t sum = 0;
+			for(uint32_t i = 0; i < len; ++i) {
+				sum += buff[i];
+			}
+			return (0 - sum) & 0xff;
+		}
+
+		//=============================================================//
+		// フラッシュ
+		//=============================================================//
+		bool blank_(uint32_t org, uint32_t end) {
+			++count_.blank_;
+			usleep(timing_.blank_us);
+			for(uint32_t a = org; ; ++a) {
+				auto it = flash_.find(a & 0xffffff00);
+				if(it != flash_.end() && it->second[a & 0xff] != 0xff) return false;
+				if(a == end) break;
+			}
+			return true;
+		}
+
+
+		void erase_(uint32_t org, uint32_t size) {
+			++count_.erase_;
+			usleep(timing_.erase_us);
+			for(uint32_t i = 0; i < size; ++i) {
+				auto a = org + i;
+				auto it = flash_.find(a & 0xffffff00);
+				if(it == flash_.end()) continue;
+				it->second[a & 0xff] = 0xff;
+			}
+		}
+
+
+		bool write_(uint32_t adr, const uint8_t* src) {
+			++count_.write_;
+			usleep(timing_.write_us);
+			auto it = flash_.find(adr);
+			if(it != flash_.end()) {
+				for(auto v : it->second) {
+					if(v != 0xff) return false;  // 未消去への書き込み
+				}
+			}
+			page p;
+			std::memcpy(&p[0], src, 256);
+			flash_[adr] = p;
+			return true;
+		}
+
+
+		void read_(uint32_t adr, uint8_t* dst, uint32_t len) {
+			count_.read_ += (len + 255) / 256;
+			usleep(timing_.read_us * ((len + 255) / 256));
+			for(uint32_t i = 0; i < len; ++i) {
+				auto a = adr + i;
+				auto it = flash_.find(a & 0xffffff00);
+				if(it == flash_.end()) dst[i] = 0xff;
+				else dst[i] = it->second[a & 0xff];
+			}
+		}
+
+
+		static uint32_t block_size_rx64m_(uint32_t adr) {
+			if(adr >= 0xFFFF0000) return 8192;
+			else if(adr >= 0xFFC00000) return 32768;
+			else return 64;
+		}
+
+
+		void reset_() {
+			++count_.session_;
+		}
+
+		// 速度を変更する（drop_baud_ を超える速度では、同期を失う）
+		void set_baud_(uint32_t baud) {
+			baud_ = baud;
+			if(drop_baud_ != 0 && baud > drop_baud_) {
+				lost_ = true;
+				lost_time_ = clock::now();
+				connect_ = false;
+			}
+		}
+
+		//=============================================================//
+		// RX24T, RX63T（１バイト・コマンド・プロトコル）
+		//=============================================================//
+		bool reply_area_(uint8_t res, uint32_t org, uint32_t end, bool rx63t) {
+			uint8_t tmp[3 + 8 + 1];
+			tmp[0] = res;
+			tmp[1] = 1 + 8;
+			tmp[2] = 1;
+			put32_big_(&tmp[3], org);
+			put32_big_(&tmp[7], end);
+			if(rx63t) {
+				tmp[1] = 8 + 1;
+				tmp[11] = sum_(&tmp[3], 8);
+			} else {
+				tmp[11] = sum_(tmp, 11);
+			}
+			return put_(tmp, sizeof(tmp));
+		}
+
+
+		bool service_cmd_(uint8_t cmd) {
+			bool rx63t = type_ == type::RX63T;
+			switch(cmd) {
+			case 0x20:  // サポート・デバイス問い合わせ
+				{
+					const char* name = rx63t ? "R5F563T6" : "R5F524TA";
+					uint32_t nl = std::strlen(name);
+					uint8_t tmp[64];
+					if(rx63t) {
+						tmp[0] = 0x30;
+						tmp[1] = 1 + 4 + nl + 1;
+						tmp[2] = 1;
+						tmp[3] = 4 + nl;
+						put32_(&tmp[4], 0x0000563A);
+						std::memcpy(&tmp[8], name, nl);
+						tmp[8 + nl] = sum_(&tmp[3], 5 + nl);
+						return put_(tmp, 9 + nl);
+					} else {
+						tmp[0] = 0x30;
+						tmp[1] = 2 + 4 + nl;
+						tmp[2] = 1;
+						tmp[3] = 4 + nl;
+						put32_(&tmp[4], 0x00005424);
+						std::memcpy(&tmp[8], name, nl);
+						tmp[8 + nl] = sum_(tmp, 8 + nl);
+						return put_(tmp, 9 + nl);
+					}
+				}
+			case 0x21:  // クロック・モード問い合わせ
+				{
+					uint8_t tmp[4] = { 0x31, 1, 0x00, 0 };
+					tmp[3] = sum_(&tmp[2], 1);
+					return put_(tmp, 4);
+				}
+			case 0x22:  // 逓倍比問い合わせ
+				{
+					uint8_t tmp[3 + 10 + 1] = { 0x32, 10 + 1, 2, 4, 1, 2, 4, 8, 4, 1, 2, 4, 8, 0 };
+					tmp[13] = sum_(&tmp[3], 10);
+					return put_(tmp, sizeof(tmp));
+				}
+			case 0x23:  // 動作周波数問い合わせ
+				{
+					uint8_t tmp[3 + 8 + 1];
+					tmp[0] = 0x33;
+					tmp[1] = 8 + 1;
+					tmp[2] = 2;
+					put16_big_(&tmp[3], 800);
+					put16_big_(&tmp[5], 10000);
+					put16_big_(&tmp[7], 800);
+					put16_big_(&tmp[9], 5000);
+					tmp[11] = sum_(&tmp[3], 8);
+					return put_(tmp, sizeof(tmp));
+				}
+			case 0x24:  // ユーザー・ブート領域問い合わせ
+				return reply_area_(0x34, 0xFF7FC000, 0xFF7FFFFF, true);
+			case 0x25:  // ユーザー領域問い合わせ
+				if(rx63t) return reply_area_(0x35, 0xFFFF0000, 0xFFFFFFFF, true);
+				else return reply_area_(0x35, 0xFFFC0000, 0xFFFFFFFF, false);
+			case 0x26:  // ブロック情報問い合わせ
+				if(rx63t) {
+					uint8_t tmp[4 + 16 * 8 + 1];
+					tmp[0] = 0x36;
+					put16_big_(&tmp[1], 1 + 16 * 8);
+					tmp[3] = 16;
+					for(uint32_t i = 0; i < 16; ++i) {
+						put32_big_(&tmp[4 + i * 8], 0xFFFF0000 + i * 4096);
+						put32_big_(&tmp[4 + i * 8 + 4], 0xFFFF0000 + i * 4096 + 4095);
+					}
+					tmp[4 + 16 * 8] = sum_(tmp, 4 + 16 * 8);
+					return put_(tmp, sizeof(tmp));
+				} else {
+					uint8_t tmp[4 + 24 + 1];
+					tmp[0] = 0x36;
+					put16_big_(&tmp[1], 1 + 24);
+					tmp[3] = 2;
+					put32_big_(&tmp[4], 0xFFFC0000);
+					put32_big_(&tmp[8], 2048);
+					put32_big_(&tmp[12], 128);
+					put32_big_(&tmp[16], 0x00100000);
+					put32_big_(&tmp[20], 1024);
+					put32_big_(&tmp[24], 8);
+					tmp[28] = sum_(tmp, 28);
+					return put_(tmp, sizeof(tmp));
+				}
+			case 0x27:  // プログラム・サイズ問い合わせ
+				{
+					uint8_t tmp[5] = { 0x37, 2, 0x01, 0x00, 0 };
+					tmp[4] = sum_(tmp, 4);
+					return put_(tmp, 5);
+				}
+			case 0x2A:  // データ量域有無問い合わせ
+				{
+					uint8_t tmp[4] = { 0x3A, 1, static_cast<uint8_t>(rx63t ? 0x21 : 0x1D), 0 };
+					tmp[3] = sum_(tmp, 3);
+					return put_(tmp, 4);
+				}
+			case 0x2B:  // データ量域情報問い合わせ
+				return reply_area_(0x3B, 0x00100000, 0x00101FFF, rx63t);
+			case 0x10:  // デバイス選択
+			case 0x11:  // クロック・モード選択
+			case 0x3F:  // ボーレート選択
+				{
+					uint8_t tmp[256 + 2];
+					if(!get_(tmp, 1)) return false;
+					if(!get_(&tmp[1], tmp[0] + 1)) return false;
+					if(cmd == 0x10 && !rx63t) return put_(0x46);
+					uint32_t baud = ((static_cast<uint32_t>(tmp[1]) << 8) | tmp[2]) * 100;
+					if(cmd == 0x3F && max_baud_ != 0 && baud > max_baud_) {
+						uint8_t err[2] = { 0xBF, 0x24 };  // ビットレート選択エラー
+						return put_(err, 2);
+					}
+					if(!put_(0x06)) return false;
+					if(cmd == 0x3F) {
+						usleep(1000);
+						set_baud_(baud);
+					}
+					return true;
+				}
+			case 0x06:  // ボーレート確認
+				return put_(0x06);
+			case 0x40:  // P/E ステータス遷移（ユーザー領域、データ領域を全消去）
+				flash_.clear();
+				++count_.erase_;
+				usleep(timing_.erase_us);
+				return put_(0x26);
+			case 0x42:
+			case 0x43:  // ユーザー・ブート／ユーザー領域プログラム準備
+				return put_(0x06);
+			case 0x50:  // ２５６バイト・プログラム
+				{
+					uint8_t tmp[4 + 256 + 1];
+					if(!get_(tmp, 4)) return false;
+					auto adr = get32_big_(tmp);
+					if(adr == 0xffffffff) {
+						if(!get_(&tmp[4], 1)) return false;
+						return put_(0x06);
+					}
+					if(!get_(&tmp[4], 256 + 1)) return false;
+					if(!write_(adr, &tmp[4])) {
+						uint8_t err[2] = { 0xD0, 0x2A };
+						return put_(err, 2);
+					}
+					return put_(0x06);
+				}
+			case 0x52:  // メモリー・リード
+				{
+					uint8_t tmp[11];
+					if(!get_(tmp, 11)) return false;
+					auto adr = get32_big_(&tmp[2]);
+					auto len = get32_big_(&tmp[6]);
+					if(len > 0x10000) len = 0x10000;
+					uint8_t res[5 + 0x10000 + 1];
+					res[0] = 0x52;
+					put32_big_(&res[1], len);
+					read_(adr, &res[5], len);
+					res[5 + len] = sum_(res, 5 + len);
+					return put_(res, 5 + len + 1);
+				}
+			default:
+				if(verbose_) {
+					std::cout << boost::format("Unknown command: %02X") % static_cast<uint32_t>(cmd)
+						<< std::endl;
+				}
+				break;
+			}
+			return true;
+		}
+
+		//=============================================================//
+		// RX64M（フレーム・プロトコル）
+		//=============================================================//
+		bool status_(uint8_t res) {
+			uint8_t tmp[6] = { 0x81, 0x00, 0x01, res, 0, 0x03 };
+			tmp[4] = sum_(&tmp[1], 3);
+			return put_(tmp, 6);
+		}
+
+
+		bool status_err_(uint8_t res, uint8_t err) {
+			uint8_t tmp[7] = { 0x81, 0x00, 0x02, res, err, 0, 0x03 };
+			tmp[5] = sum_(&tmp[1], 4);
+			return put_(tmp, 7);
+		}
+
+
+		bool data_(uint8_t res, const uint8_t* src, uint32_t len) {
+			uint8_t tmp[4 + len + 2];
+			tmp[0] = 0x81;
+			put16_big_(&tmp[1], len + 1);
+			tmp[3] = res;
+			std::memcpy(&tmp[4], src, len);
+			tmp[4 + len] = sum_(&tmp[1], 3 + len);
+			tmp[4 + len + 1] = 0x03;
+			return put_(tmp, sizeof(tmp));
+		}
+
+
+		bool frame_(uint8_t soh, uint8_t* dst, uint32_t& len) {
+			uint8_t head[2];
+			if(!get_(head, 2)) return false;
+			len = (static_cast<uint32_t>(head[0]) << 8) | head[1];
+			if(len == 0 || len > 1024) return false;
+			uint8_t tmp[3 + len + 2];
+			tmp[0] = soh;
+			tmp[1] = head[0];
+			tmp[2] = head[1];
+			if(!get_(&tmp[3], len + 2)) return false;
+			if(sum_(&tmp[1], 2 + len) != tmp[3 + len]) return false;
+			if(tmp[3 + len + 1] != 0x03) return false;
+			std::memcpy(dst, &tmp[3], len);
+			return true;
+		}
+
+
+		bool data_request_(uint8_t cmd) {
+			int ch;
+			do {
+				uint8_t c;
+				if(!get_(&c, 1)) return false;
+				ch = c;
+			} while(ch != 0x81) ;
+			uint8_t tmp[1024];
+			uint32_t len;
+			if(!frame_(0x81, tmp, len)) return false;
+			return tmp[0] == cmd;
+		}
+
+
+		bool service_frame_(uint8_t soh) {
+			uint8_t tmp[1024];
+			uint32_t len;
+			if(!frame_(soh, tmp, len)) return true;  // 同期を取り直す
+			if(soh != 0x01) return true;
+
+			uint8_t cmd = tmp[0];
+			const uint8_t* p = &tmp[1];
+			switch(cmd) {
+			case 0x38:  // デバイス種別取得
+				{
+					if(!status_(0x38)) return false;
+					if(!data_request_(0x38)) return false;
+					uint8_t d[24];
+					std::memcpy(d, "RX64M   ", 8);
+					put32_big_(&d[8],   24000000);
+					put32_big_(&d[12],   8000000);
+					put32_big_(&d[16], 120000000);
+					put32_big_(&d[20],  60000000);
+					return data_(0x38, d, sizeof(d));
+				}
+			case 0x36:  // エンディアン通知
+				return status_(0x36);
+			case 0x32:  // 周波数設定
+				{
+					if(!status_(0x32)) return false;
+					if(!data_request_(0x32)) return false;
+					uint8_t d[8];
+					put32_big_(&d[0], 120000000);
+					put32_big_(&d[4],  60000000);
+					return data_(0x32, d, sizeof(d));
+				}
+			case 0x34:  // ボーレート変更
+				if(max_baud_ != 0 && get32_big_(p) > max_baud_) {
+					return status_err_(0xB4, 0xD4);
+				}
+				if(!status_(0x34)) return false;
+				set_baud_(get32_big_(p));
+				return true;
+			case 0x00:  // 同期
+				return status_(0x00);
+			case 0x2C:  // ID 認証モード取得
+				{
+					if(!status_(0x2C)) return false;
+					if(!data_request_(0x2C)) return false;
+					uint8_t d[1] = { 0xFF };
+					return data_(0x2C, d, 1);
+				}
+			case 0x10:  // ブランク・チェック
+				if(blank_(get32_big_(p), get32_big_(p + 4))) return status_(0x10);
+				else return status_err_(0x90, 0xE0);
+			case 0x12:  // ブロック消去
+				{
+					auto adr = get32_big_(p);
+					auto bs = block_size_rx64m_(adr);
+					erase_(adr & ~(bs - 1), bs);
+					return status_(0x12);
+				}
+			case 0x13:  // 書き込み
+				{
+					auto org = get32_big_(p);
+					if(!status_(0x13)) return false;
+					uint8_t c;
+					do {
+						if(!get_(&c, 1)) return false;
+					} while(c != 0x81) ;
+					uint8_t d[1024];
+					uint32_t l;
+					if(!frame_(0x81, d, l)) return false;
+					if(l != 257 || !write_(org, &d[1])) {
+						return status_err_(0x93, 0xE2);
+					}
+					return status_(0x13);
+				}
+			case 0x15:  // 読み出し
+				{
+					auto org = get32_big_(p);
+					auto end = get32_big_(p + 4);
+					if(!status_(0x15)) return false;
+					if(!data_request_(0x15)) return false;
+					uint32_t l = end - org + 1;
+					if(l > 1000) l = 1000;
+					uint8_t d[1000];
+					read_(org, d, l);
+					return data_(0x15, d, l);
+				}
+			default:
+				if(verbose_) {
+					std::cout << boost::format("Unknown command: %02X") % static_cast<uint32_t>(cmd)
+						<< std::endl;
+				}
+				return status_err_(static_cast<uint8_t>(cmd | 0x80), 0xC0);
+			}
+			return true;
+		}
+
+	public:
+		//-------------------------------------------------------------//
+		/*!
+			@brief	コンストラクター
+			@param[in]	t		デバイス・タイプ
+			@param[in]	tm		タイミング
+			@param[in]	verbose	詳細表示
+		*/
+		//-------------------------------------------------------------//
+		sim(type t, const timing_t& tm, bool verbose = false) : type_(t), timing_(tm),
+			verbose_(verbose), fd_(-1), slave_(-1), baud_(9600), max_baud_(0), drop_baud_(0),
+			lost_(false), connect_(false) { }
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	受け付ける最大ボーレートの設定 @n
+					これを超えるボーレート変更はエラーとする（０なら制限無し）
+			@param[in]	baud	最大ボーレート
+		*/
+		//-------------------------------------------------------------//
+		void set_max_baud(uint32_t baud) { max_baud_ = baud; }
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	同期を失うボーレートの設定 @n
+					これを超えるボーレート変更は受け付けるが、以後の受信を捨てる @n
+					（RESET_MS 後に、リセットされたものとして接続待ちに戻る）
+			@param[in]	baud	ボーレート（０なら同期を失わない）
+		*/
+		//-------------------------------------------------------------//
+		void set_drop_baud(uint32_t baud) { drop_baud_ = baud; }
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	デストラクター
+		*/
+		//-------------------------------------------------------------//
+		~sim() {
+			if(slave_ >= 0) ::close(slave_);
+			if(fd_ >= 0) ::close(fd_);
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	擬似端末のオープン
+			@param[out]	path	スレーブ側のパス（rx_prog のポートに指定）
+			@return 成功なら「true」
+		*/
+		//-------------------------------------------------------------//
+		bool open(std::string& path) {
+			fd_ = posix_openpt(O_RDWR | O_NOCTTY);
+			if(fd_ < 0) return false;
+			if(grantpt(fd_) != 0 || unlockpt(fd_) != 0) return false;
+			const char* name = ptsname(fd_);
+			if(name == nullptr) return false;
+			path = name;
+
+			// スレーブを保持して、rx_prog のクローズで EIO にならないようにする
+			slave_ = ::open(name, O_RDWR | O_NOCTTY);
+			if(slave_ < 0) return false;
+			termios attr;
+			if(tcgetattr(slave_, &attr) == 0) {
+				cfmakeraw(&attr);
+				tcsetattr(slave_, TCSANOW, &attr);
+			}
+			return true;
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	サービス（１コマンド処理）
+			@return 継続可能なら「true」
+		*/
+		//-------------------------------------------------------------//
+		bool service() {
+			uint8_t ch;
+			if(!get_(&ch, 1, -1)) return false;
+
+			if(lost_) {  // リセットされるまで、受信を捨てる
+				auto t = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - lost_time_);
+				if(t.count() < RESET_MS) return true;
+				lost_ = false;
+				if(verbose_) std::cout << "Reset" << std::endl;
+			}
+
+			if(ch == 0x00) {  // ビットレート自動調整（リセット後の接続）
+				baud_ = 9600;
+				return put_(0x00);
+			} else if(ch == 0x55) {  // 接続確認
+				reset_();
+				connect_ = true;
+				return put_(type_ == type::RX64M ? 0xC1 : 0xE6);
+			}
+
+			if(!connect_) return true;  // 接続確認の前のコマンドは無視
+
+			if(verbose_) {
+				std::cout << boost::format("CMD: %02X (%d bps)") % static_cast<uint32_t>(ch) % baud_
+					<< std::endl;
+			}
+
+			if(type_ == type::RX64M) {
+				if(ch == 0x01 || ch == 0x81) {
+					return service_frame_(ch);
+				}
+				return true;
+			} else {
+				return service_cmd_(ch);
+			}
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	カウンターを取得
+			@return カウンター
+		*/
+		//-------------------------------------------------------------//
+		const count_t& get_count() const { return count_; }
+	};
+}
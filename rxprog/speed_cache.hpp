@@ -0,0 +1,225 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	ボーレート・キャッシュ・クラス @n
+			自動選択で決定したボーレートを、CPU タイプ、ポート、アダプター毎に @n
+			ホスト側に保存し、次回は、その速度（と一段上の速度）から試す。 @n
+			一段上の速度に上がれなかった場合は、PROBE_HOLD 回、上の速度を試さない。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <map>
+#include <string>
+#include <cstdlib>
+#include "file_io.hpp"
+#include "string_utils.hpp"
+#ifdef __linux__
+#include <climits>
+#include <unistd.h>
+#endif
+
+namespace utils {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief	speed_cache クラス
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	class speed_cache {
+	public:
+		static const uint32_t PROBE_HOLD = 8;	///< 上の速度を試さないセッション数
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	登録値
+		*/
+		//-----------------------------------------------------------------//
+		struct value_t {
+			uint32_t	speed = 0;	///< ボーレート
+			uint32_t	hold = 0;	///< 上の速度を試さない残りセッション数
+		};
+
+	private:
+		typedef std::map<std::string, value_t> speed_map;
+		speed_map	speed_map_;
+
+#ifdef __linux__
+		static std::string real_path_(const std::string& path) {
+			char tmp[PATH_MAX];
+			if(realpath(path.c_str(), tmp) == nullptr) return std::string();
+			return std::string(tmp);
+		}
+
+		static std::string read_line_(const std::string& path) {
+			utils::file_io fio;
+			if(!fio.open(path, "rb")) return std::string();
+			auto s = fio.get_line();
+			fio.close();
+			return s;
+		}
+#endif
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	アダプター識別文字列の取得 @n
+					USB シリアル変換の場合「VID:PID:シリアル番号」を返す @n
+					（識別出来ない場合は空文字列）
+			@param[in]	port	シリアル・ポート・パス
+			@return アダプター識別文字列
+		*/
+		//-----------------------------------------------------------------//
+		static std::string adapter_id(const std::string& port) {
+#ifdef __linux__
+			auto dev = real_path_(port);
+			if(dev.empty()) return std::string();
+			auto name = utils::get_file_name(dev);
+			auto sys = real_path_("/sys/class/tty/" + name + "/device");
+			// USB デバイスのディレクトリまで遡る
+			while(!sys.empty() && sys != "/sys") {
+				auto vid = read_line_(sys + "/idVendor");
+				if(!vid.empty()) {
+					auto s = vid + ':' + read_line_(sys + "/idProduct");
+					auto ser = read_line_(sys + "/serial");
+					if(!ser.empty()) s += ':' + ser;
+					return s;
+				}
+				auto pos = sys.rfind('/');
+				if(pos == std::string::npos) break;
+				sys = sys.substr(0, pos);
+			}
+#endif
+			return std::string();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	キャッシュ・キーの生成
+			@param[in]	cpu		CPU タイプ
+			@param[in]	port	シリアル・ポート・パス
+			@return キャッシュ・キー
+		*/
+		//-----------------------------------------------------------------//
+		static std::string make_key(const std::string& cpu, const std::string& port) {
+			std::string key = cpu + ',' + port + ',' + adapter_id(port);
+			for(auto& ch : key) {
+				if(ch == ' ' || ch == '\t') ch = '_';
+			}
+			return key;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	キャッシュ・ファイルのパスを生成 @n
+					「$HOME/.rx_prog/speed」
+			@return キャッシュ・ファイル・パス
+		*/
+		//-----------------------------------------------------------------//
+		static std::string make_path() {
+			std::string base;
+			const char* home = getenv("HOME");
+			if(home != nullptr) base = home;
+			else base = ".";
+			base += "/.rx_prog";
+			if(!utils::probe_file(base, true)) {
+				utils::create_directory(base);
+			}
+			return base + "/speed";
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	コンストラクター
+		*/
+		//-----------------------------------------------------------------//
+		speed_cache() { }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	登録値を取得
+			@param[in]	key	キャッシュ・キー
+			@return 登録値（登録が無い場合、ボーレートが「０」）
+		*/
+		//-----------------------------------------------------------------//
+		value_t get(const std::string& key) const {
+			auto it = speed_map_.find(key);
+			if(it == speed_map_.end()) return value_t();
+			return it->second;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	登録
+			@param[in]	key		キャッシュ・キー
+			@param[in]	v		登録値
+		*/
+		//-----------------------------------------------------------------//
+		void set(const std::string& key, const value_t& v) { speed_map_[key] = v; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ロード
+			@param[in]	path	ファイル・パス
+			@return 成功なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool load(const std::string& path) {
+			speed_map_.clear();
+
+			utils::file_io fio;
+			if(!fio.open(path, "rb")) {
+				return false;
+			}
+			while(!fio.eof()) {
+				auto line = fio.get_line();
+				if(line.empty()) continue;
+				utils::strings ss = utils::split_text(line, " ");
+				int speed;
+				if(ss.size() < 2 || ss.size() > 3 || !utils::string_to_int(ss[1], speed) || speed <= 0) {
+					continue;
+				}
+				int hold = 0;
+				if(ss.size() == 3 && (!utils::string_to_int(ss[2], hold) || hold < 0)) {
+					continue;
+				}
+				value_t v;
+				v.speed = speed;
+				v.hold = hold;
+				speed_map_[ss[0]] = v;
+			}
+			fio.close();
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	セーブ
+			@param[in]	path	ファイル・パス
+			@return 成功なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool save(const std::string& path) const {
+			utils::file_io fio;
+			if(!fio.open(path, "wb")) {
+				return false;
+			}
+			for(const auto& m : speed_map_) {
+				auto line = m.first + ' ' + std::to_string(m.second.speed);
+				if(m.second.hold > 0) line += ' ' + std::to_string(m.second.hold);
+				fio.put_line(line);
+			}
+			fio.close();
+			return true;
+		}
+	};
+}
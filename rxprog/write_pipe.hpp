@@ -0,0 +1,172 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	RX パイプライン・ライト・クラス @n
+			フレームの組み立て（アドレス、SUM 計算）を別スレッドで先行して行い、@n
+			送信側は、前フレームの ACK 受信後、直ちに次のフレームを送信する。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include "rx_prog.hpp"
+#include "motsx_io.hpp"
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+
+namespace rx {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief	write_pipe クラス
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	class write_pipe {
+	public:
+		typedef std::vector<uint32_t> pages;
+		typedef std::function<void (uint32_t)> progress_func;
+
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief	info_t 構造体（転送結果）
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct info_t {
+			uint32_t	pages_ = 0;		///< 送信ページ数
+			uint64_t	bytes_ = 0;		///< 送信バイト数（フレーム）
+			double		time_ = 0.0;	///< 経過時間（秒）
+			uint32_t	baud_ = 0;		///< ボーレート
+			uint32_t	depth_ = 0;		///< 最大キュー数
+
+			double pages_per_sec() const {
+				if(time_ <= 0.0) return 0.0;
+				return static_cast<double>(pages_) / time_;
+			}
+
+			/// 回線利用率（1 キャラクター 10 ビット換算、0.0 to 1.0）
+			double utilization() const {
+				if(time_ <= 0.0 || baud_ == 0) return 0.0;
+				return (static_cast<double>(bytes_) * 10.0 / static_cast<double>(baud_)) / time_;
+			}
+
+			void info(const std::string& head = "") const {
+				std::cout << head << boost::format("Pipe write: %d pages, %d bytes, %.3f sec (queue: %d)")
+					% pages_ % bytes_ % time_ % depth_ << std::endl;
+				std::cout << head << boost::format("Pipe write: %.1f pages/s, link utilization %.1f %%")
+					% pages_per_sec() % (utilization() * 100.0) << std::endl;
+			}
+		};
+
+	private:
+		prog&		prog_;
+		uint32_t	depth_;
+
+		std::deque<rx::protocol::page_frame>	queue_;
+		std::mutex					mutex_;
+		std::condition_variable		cond_put_;
+		std::condition_variable		cond_get_;
+		bool		fin_;
+		bool		abort_;
+
+		info_t		info_;
+
+		void producer_(const pages& list, const utils::motsx_io& mot) {
+			for(auto adr : list) {
+				rx::protocol::page_frame f;
+				const auto& mem = mot.get_memory(adr);
+				prog_.make_frame(adr, &mem[0], f);
+
+				std::unique_lock<std::mutex> lock(mutex_);
+				cond_put_.wait(lock, [this] { return queue_.size() < depth_ || abort_; });
+				if(abort_) break;
+				queue_.push_back(f);
+				cond_get_.notify_one();
+			}
+			std::lock_guard<std::mutex> lock(mutex_);
+			fin_ = true;
+			cond_get_.notify_one();
+		}
+
+	public:
+		//-------------------------------------------------------------//
+		/*!
+			@brief	コンストラクター
+			@param[in]	p		rx::prog の参照
+			@param[in]	depth	ホスト側で保持する最大フレーム数
+		*/
+		//-------------------------------------------------------------//
+		write_pipe(prog& p, uint32_t depth = 16) : prog_(p), depth_(depth == 0 ? 1 : depth),
+			fin_(false), abort_(false) { }
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	パイプライン書き込み @n
+					※事前に「start_write」を行い、終了後「final_write」を行う事
+			@param[in]	list	書き込みページ（アドレス）のリスト
+			@param[in]	mot		イメージ
+			@param[in]	func	進捗関数（送信完了したページ数）
+			@return 成功なら「true」
+		*/
+		//-------------------------------------------------------------//
+		bool run(const pages& list, const utils::motsx_io& mot, progress_func func = nullptr)
+		{
+			queue_.clear();
+			fin_ = false;
+			abort_ = false;
+			info_ = info_t();
+			info_.baud_ = prog_.get_baud_rate();
+			info_.depth_ = depth_;
+
+			auto st = std::chrono::steady_clock::now();
+
+			std::thread th(&write_pipe::producer_, this, std::cref(list), std::cref(mot));
+
+			bool ok = true;
+			while(1) {
+				rx::protocol::page_frame f;
+				{
+					std::unique_lock<std::mutex> lock(mutex_);
+					cond_get_.wait(lock, [this] { return !queue_.empty() || fin_; });
+					if(queue_.empty()) break;
+					f = queue_.front();
+					queue_.pop_front();
+					cond_put_.notify_one();
+				}
+				if(!prog_.write_frame(f)) {
+					ok = false;
+					break;
+				}
+				++info_.pages_;
+				info_.bytes_ += f.length();
+				if(func) func(info_.pages_);
+			}
+
+			if(!ok) {
+				std::lock_guard<std::mutex> lock(mutex_);
+				abort_ = true;
+				cond_put_.notify_one();
+			}
+			th.join();
+
+			auto et = std::chrono::steady_clock::now();
+			info_.time_ = std::chrono::duration<double>(et - st).count();
+
+			return ok;
+		}
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief	転送結果の取得
+			@return 転送結果
+		*/
+		//-------------------------------------------------------------//
+		const info_t& get_info() const { return info_; }
+	};
+}
@@ -121,15 +121,23 @@ namespace utils {
 		//-----------------------------------------------------------------//
 		void service(uint32_t num) noexcept
 		{
-			if(fifo_.length() < num) return;
-
-			for(uint32_t i = 0; i < num; ++i) {
-				wave_[w_put_] = fifo_.get();
-				wave_[w_put_].l_ch ^= 0x8000;
-				wave_[w_put_].r_ch ^= 0x8000;
-				++w_put_;
-				w_put_ &= (OUTS - 1);
+			typename FIFO::span_t sp[2];
+			if(fifo_.get_span(sp[0], sp[1]) < num) return;
+
+			uint32_t n = num;
+			for(const auto& s : sp) {
+				uint32_t l = std::min(n, s.len);
+				for(uint32_t i = 0; i < l; ++i) {
+					auto& w = wave_[w_put_];
+					w = s.org[i];
+					w.l_ch ^= 0x8000;
+					w.r_ch ^= 0x8000;
+					++w_put_;
+					w_put_ &= (OUTS - 1);
+				}
+				n -= l;
 			}
+			fifo_.get_go(num);
 		}
 	};
 }